@@ -13,6 +13,9 @@
  */
 #include <iostream>
 #include <fstream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "arg_reader.h"
 #include "doc_vect.h"
 
@@ -20,26 +23,37 @@ using namespace Portage;
 using namespace std;
 
 static char help_message[] = "\n\
-cosine_distances [-v][-n nl] models vocfile [infile [outfile]]\n\
+cosine_distances [-v][-df d][-j n] models vocfile [vocfile2 ...]\n\
+cosine_distances [-v][-df d][-j n] -pairs models\n\
 \n\
 For each model listed in the file <models>, calculate the cosine score to\n\
 <vocfile>. Both <models> and <vocfile> must contain, per line: any string,\n\
 followed by whitespace, followed by a real number (the string may contain\n\
 whitespace). Output is written to stdout, one number per line in <models>.\n\
 \n\
+If several vocfiles are given, the models are read only once, and each output\n\
+line contains one score per vocfile, in the order given. Each score is the same\n\
+as with the vocfile alone.\n\
+\n\
 Options:\n\
 \n\
 -v  Write progress reports to cerr.\n\
 -df Smoothing term on inverse doc frequencies: augment number of docs by this amount\n\
     (higher is smoother; -1 means don't apply IDF's at all) [-1]\n\
+-j  Number of threads to use for computing scores [1]\n\
+-pairs  Instead, calculate the cosine score between each pair of models: line i\n\
+    contains the scores of model i to each model, in order. IDF's, if any, are\n\
+    calculated over the models.\n\
 ";
 
 // globals
 
 static bool verbose = false;
 static string models;
-static string vocfile;
+static vector<string> vocfiles;
 static double df = -1;
+static Uint num_threads = 1;
+static bool pairs = false;
 
 static void getArgs(int argc, char* argv[]);
 
@@ -48,6 +62,9 @@ static void getArgs(int argc, char* argv[]);
 int main(int argc, char* argv[])
 {
    getArgs(argc, argv);
+#ifdef _OPENMP
+   omp_set_num_threads(num_threads);
+#endif
 
    vector<string> model_list;
    iSafeMagicStream ifs(models);
@@ -59,16 +76,38 @@ int main(int argc, char* argv[])
 
    if (verbose) cerr << "reading source files" << endl;
    dvs.read(model_list);
-   dvs.addDocVect(vocfile);
+   Uint K = model_list.size(); 
 
-   if (df != -1) 
-      dvs.tfidf(df); // possibly revisit this (works on ALL doc vects)
+   if (pairs) {
+      if (df != -1)
+         dvs.tfidf(df);
+      if (verbose) cerr << "writing pairwise distances" << endl;
+      vector< vector<double> > prox;
+      dvs.allPairsCosines(prox);
+      for (Uint k = 0; k < K; ++k) {
+         for (Uint l = 0; l < K; ++l)
+            cout << (l ? " " : "") << prox[k][l];
+         cout << endl;
+      }
+      if (verbose) cerr << "done" << endl;
+      return 0;
+   }
+
+   // Each vocfile in turn takes the place of doc K, the last one, so the doc
+   // frequencies are the same as when it is the only one.
+   vector< vector<double> > dists(vocfiles.size());
+   for (Uint v = 0; v < vocfiles.size(); ++v) {
+      if (verbose) cerr << "scoring " << vocfiles[v] << endl;
+      dvs.addDocVect(vocfiles[v], K);
+      dvs.cosines(K, K, dists[v], df); // df == -1 means raw values
+   }
 
    if (verbose) cerr << "writing phrase-table distances" << endl;
-   Uint K = model_list.size(); 
-   const DocVectSet::DocVect& srcfile_vect = dvs.getDocVect(K);
-   for (Uint k = 0; k < K; ++k)
-      cout << dvs.cosine(srcfile_vect, dvs.getDocVect(k)) << endl;
+   for (Uint k = 0; k < K; ++k) {
+      for (Uint v = 0; v < vocfiles.size(); ++v)
+         cout << (v ? " " : "") << dists[v][k];
+      cout << endl;
+   }
 
    if (verbose) cerr << "done" << endl;
 }
@@ -77,13 +116,24 @@ int main(int argc, char* argv[])
 
 void getArgs(int argc, char* argv[])
 {
-   const char* switches[] = {"v", "df:"};
-   ArgReader arg_reader(ARRAY_SIZE(switches), switches, 2, 2, help_message);
+   const char* switches[] = {"v", "df:", "j:", "pairs"};
+   ArgReader arg_reader(ARRAY_SIZE(switches), switches, 1, -1, help_message);
    arg_reader.read(argc-1, argv+1);
 
    arg_reader.testAndSet("v", verbose);
    arg_reader.testAndSet("df", df);
+   arg_reader.testAndSet("j", num_threads);
+   arg_reader.testAndSet("pairs", pairs);
 
    arg_reader.testAndSet(0, "models", models);
-   arg_reader.testAndSet(1, "vocfile", vocfile);
+   arg_reader.getVars(1, vocfiles);
+
+   if (df < 0 && df != -1)
+      error(ETFatal, "-df must be -1 or at least 0");
+   if (num_threads == 0)
+      error(ETFatal, "-j must be at least 1");
+   if (pairs && !vocfiles.empty())
+      error(ETFatal, "-pairs takes no vocfile");
+   if (!pairs && vocfiles.empty())
+      error(ETFatal, "Missing argument: vocfile");
 }
@@ -12,6 +12,7 @@
  * Copyright 2005, Her Majesty in Right of Canada
  */
 
+#include <algorithm>
 #include <str_utils.h>
 #include <file_utils.h>
 #include <gfstats.h>
@@ -19,12 +20,30 @@
 
 using namespace Portage;
 
-Uint DocVectSet::numVals()
+void DocVectSet::SparseVect::assign(const DocVect& dv)
 {
-   Uint nv = 0;
-   for (Uint i = 0; i < vals.size(); ++i)
-      nv += vals[i].size();
-   return nv;
+   feats.clear();
+   vals.clear();
+   for (DocVect::const_iterator p = dv.begin(); p != dv.end(); ++p) {
+      feats.push_back(p->first);
+      vals.push_back(p->second);
+   }
+   norm = DocVectSet::norm(vals.empty() ? NULL : &vals[0], vals.size());
+}
+
+void DocVectSet::SparseVect::get(DocVect& dv) const
+{
+   dv.clear();
+   for (Uint j = 0; j < feats.size(); ++j)
+      dv.insert(dv.end(), make_pair(feats[j], vals[j]));
+}
+
+DocVectSet::DocVect DocVectSet::getDocVect(Uint i) const
+{
+   DocVect dv;
+   for (Uint j = rows[i]; j < rows[i+1]; ++j)
+      dv.insert(dv.end(), make_pair(feats[j], vals[j]));
+   return dv;
 }
 
 Uint DocVectSet::addKeyToFmap(const string& key)
@@ -55,22 +74,25 @@ Uint DocVectSet::getFeature(const string& name)
    return (found && f != 0) ? f-1 : numFeatures();
 }
 
+static bool lessFeature(const pair<Uint,float>& x, const pair<Uint,float>& y)
+{
+   return x.first < y.first;
+}
+
 void DocVectSet::addDocVect(const string& dv_file, Uint pos)
 {
    iSafeMagicStream in(dv_file);
 
-   DocVect* dv;
    if (pos < numDocs()) {
       doc_names[pos] = dv_file;
-      vals[pos].clear();
-      dv = &vals[pos];
+      for (Uint j = rows[pos]; j < rows[pos+1]; ++j)
+         --doc_freqs[feats[j]];
    } else {
+      pos = numDocs();
       doc_names.push_back(dv_file);
-      DocVect empty;
-      vals.push_back(empty);
-      dv = &vals.back();
    }
 
+   vector< pair<Uint,float> > dv;
    string line;
    while (getline(in, line)) {
 
@@ -98,18 +120,56 @@ void DocVectSet::addDocVect(const string& dv_file, Uint pos)
       }
 
       Uint f = addKeyToFmap(key);
-      (*dv)[f] = conv<float>(val);
+      dv.push_back(make_pair(f, conv<float>(val)));
 
       if (f >= doc_freqs.size()) doc_freqs.resize(f+1);
-      ++doc_freqs[f];
    }
+
+   // sort by feature; the last value read for a feature is the one kept, and
+   // the doc counts once in its doc freq
+   stable_sort(dv.begin(), dv.end(), lessFeature);
+   vector<Uint> fs;
+   vector<float> vs;
+   for (Uint j = 0; j < dv.size(); ++j) {
+      if (!fs.empty() && fs.back() == dv[j].first)
+         vs.back() = dv[j].second;
+      else {
+         fs.push_back(dv[j].first);
+         vs.push_back(dv[j].second);
+      }
+   }
+   for (Uint j = 0; j < fs.size(); ++j)
+      ++doc_freqs[fs[j]];
+   setRow(pos, fs, vs);
+}
+
+void DocVectSet::setRow(Uint pos, const vector<Uint>& fs, const vector<float>& vs)
+{
+   if (pos == numDocs()) {
+      feats.insert(feats.end(), fs.begin(), fs.end());
+      vals.insert(vals.end(), vs.begin(), vs.end());
+      rows.push_back(feats.size());
+      norms.push_back(0);
+   } else {
+      const Uint beg = rows[pos], end = rows[pos+1];
+      feats.erase(feats.begin()+beg, feats.begin()+end);
+      feats.insert(feats.begin()+beg, fs.begin(), fs.end());
+      vals.erase(vals.begin()+beg, vals.begin()+end);
+      vals.insert(vals.begin()+beg, vs.begin(), vs.end());
+      for (Uint i = pos+1; i < rows.size(); ++i)
+         rows[i] = rows[i] - (end-beg) + fs.size();
+   }
+   norms[pos] = norm(vs.empty() ? NULL : &vs[0], vs.size());
 }
 
 void DocVectSet::clear() {
    word_voc.clear();
    fmap.clear();
    doc_names.clear();
+   rows.assign(1, 0);
+   feats.clear();
    vals.clear();
+   norms.clear();
    doc_freqs.clear();
 }
 
@@ -118,15 +178,17 @@ void DocVectSet::dump()
    for (Uint i = 0; i < doc_names.size(); ++i) {
       string newname = doc_names[i] + ".dump";
       oSafeMagicStream out(newname);
-      writeDocVect(vals[i], out);
+      writeDocVect(getDocVect(i), out);
    }
 }
 
 void DocVectSet::tfidf(double smooth)
 {
+   for (Uint j = 0; j < vals.size(); ++j)
+      vals[j] *= idf(feats[j], smooth);
    for (Uint i = 0; i < numDocs(); ++i)
-      for (DocVect::iterator p = vals[i].begin(); p != vals[i].end(); ++p)
-	 p->second *= idf(p->first, smooth);
+      if (rows[i] < rows[i+1])
+         norms[i] = norm(&vals[0] + rows[i], rows[i+1]-rows[i]);
 }
 
 double DocVectSet::cosine(const DocVect& dv1, const DocVect& dv2)
@@ -151,6 +213,118 @@ double DocVectSet::cosine(const DocVect& dv1, const DocVect& dv2)
    return (ds1 > 0 && ds2 > 0) ? s / (ds1 * ds2) : 0.0;
 }
 
+double DocVectSet::dot(const Uint* f1, const float* v1, Uint n1,
+                       const Uint* f2, const float* v2, Uint n2)
+{
+   if (n1 > n2) {
+      swap(f1, f2);
+      swap(v1, v2);
+      swap(n1, n2);
+   }
+
+   double s = 0.0;
+   if (n2 / 8 > n1) {
+      // v2 is much longer: look up each feature of v1 in it instead
+      const Uint* p = f2;
+      const Uint* const end = f2 + n2;
+      for (Uint i = 0; i < n1; ++i) {
+         p = lower_bound(p, end, f1[i]);
+         if (p == end) break;
+         if (*p == f1[i])
+            s += v1[i] * v2[p-f2];
+      }
+   } else {
+      Uint i = 0, j = 0;
+      while (i < n1 && j < n2) {
+         if (f1[i] < f2[j]) ++i;
+         else if (f2[j] < f1[i]) ++j;
+         else s += v1[i++] * v2[j++];
+      }
+   }
+   return s;
+}
+
+double DocVectSet::norm(const float* v, Uint n)
+{
+   double s = 0.0;
+   for (Uint j = 0; j < n; ++j)
+      s += v[j] * v[j];
+   return sqrt(s);
+}
+
+double DocVectSet::cosine(Uint i, Uint j) const
+{
+   if (rows[i] == rows[i+1] || rows[j] == rows[j+1]) return 0.0;
+   const double s = dot(&feats[0] + rows[i], &vals[0] + rows[i], rows[i+1]-rows[i],
+                        &feats[0] + rows[j], &vals[0] + rows[j], rows[j+1]-rows[j]);
+   return cosine(s, norms[i], norms[j]);
+}
+
+double DocVectSet::cosine(Uint i, const SparseVect& v) const
+{
+   if (v.feats.empty() || rows[i] == rows[i+1]) return 0.0;
+   const double s = dot(&feats[0] + rows[i], &vals[0] + rows[i], rows[i+1]-rows[i],
+                        &v.feats[0], &v.vals[0], v.feats.size());
+   return cosine(s, norms[i], v.norm);
+}
+
+void DocVectSet::cosines(Uint q, Uint n, vector<double>& prox, double smooth) const
+{
+   const bool weighted = smooth != -1;
+   vector<double> idfs;
+   if (weighted) {
+      idfs.resize(numFeatures());
+      for (Uint f = 0; f < idfs.size(); ++f)
+         idfs[f] = idf(f, smooth);
+   }
+
+   // Scatter q into a dense vector; each doc then gathers from it over its own
+   // row, with no searching.
+   vector<float> dense(numFeatures(), 0.0f);
+   double qs = 0.0;
+   for (Uint j = rows[q]; j < rows[q+1]; ++j) {
+      const float w = weighted ? float(vals[j] * idfs[feats[j]]) : vals[j];
+      dense[feats[j]] = w;
+      qs += w * w;
+   }
+   const double qsize = sqrt(qs);
+
+   prox.assign(n, 0.0);
+#pragma omp parallel for schedule(dynamic, 16)
+   for (int i = 0; i < int(n); ++i) {
+      double s = 0.0, ss = 0.0;
+      for (Uint j = rows[i]; j < rows[i+1]; ++j) {
+         const float w = weighted ? float(vals[j] * idfs[feats[j]]) : vals[j];
+         s += w * dense[feats[j]];
+         ss += w * w;
+      }
+      prox[i] = cosine(s, qsize, weighted ? sqrt(ss) : norms[i]);
+   }
+}
+
+void DocVectSet::allPairsCosines(vector< vector<double> >& prox) const
+{
+   const Uint N = numDocs();
+   prox.assign(N, vector<double>(N, 0.0));
+#pragma omp parallel
+   {
+      vector<float> dense(numFeatures(), 0.0f);
+#pragma omp for schedule(dynamic)
+      for (int i = 0; i < int(N); ++i) {
+         for (Uint j = rows[i]; j < rows[i+1]; ++j)
+            dense[feats[j]] = vals[j];
+         for (Uint k = i; k < N; ++k) {
+            double s = 0.0;
+            for (Uint j = rows[k]; j < rows[k+1]; ++j)
+               s += vals[j] * dense[feats[j]];
+            prox[i][k] = prox[k][i] = cosine(s, norms[i], norms[k]);
+         }
+         for (Uint j = rows[i]; j < rows[i+1]; ++j)
+            dense[feats[j]] = 0.0f;
+      }
+   }
+}
+
 void DocVectSet::setToOnes(DocVect& dv) {
    for (DocVect::iterator p = dv.begin(); p != dv.end(); ++p)
       p->second = 1;
@@ -192,26 +366,37 @@ double DocVectSet::kmeans(Uint K, vector<Uint>& clusters, vector<DocVect>& means
 {
    // check if this is a hard constraint
    assert(K <= numDocs());
+   const Uint N = numDocs();
 
    // initialize with K random means
-   vector<Uint> ind(numDocs());
-   for (Uint i = 0; i < numDocs(); ++i) ind[i] = i;
+   vector<Uint> ind(N);
+   for (Uint i = 0; i < N; ++i) ind[i] = i;
    random_shuffle(ind.begin(), ind.end());
-   means.clear();
-   for (Uint k = 0; k < K; ++k)
-      means.push_back(vals[ind[k]]);
+   vector<SparseVect> mns(K);
+   for (Uint k = 0; k < K; ++k) {
+      const Uint i = ind[k];
+      mns[k].feats.assign(feats.begin()+rows[i], feats.begin()+rows[i+1]);
+      mns[k].vals.assign(vals.begin()+rows[i], vals.begin()+rows[i+1]);
+      mns[k].norm = norms[i];
+   }
 
-   clusters.resize(numDocs());
-   vector<Uint> old_clusters(numDocs(), K);
+   // means are sums of docs scaled to unit length
+   vector<double> scales(N);
+   for (Uint i = 0; i < N; ++i)
+      scales[i] = 1.0 / norms[i];
+
+   clusters.resize(N);
+   vector<Uint> old_clusters(N, K);
 
    bool done = false;
    do {
       // calculate cluster membership for each doc
-      for (Uint i = 0; i < numDocs(); ++i) {
+#pragma omp parallel for schedule(dynamic, 16)
+      for (int i = 0; i < int(N); ++i) {
 	 double max_cosine = 0;
 	 Uint best_k = 0;
 	 for (Uint k = 0; k < K; ++k) {
-	    double cos = cosine(vals[i], means[k]);
+	    double cos = cosine(i, mns[k]);
 	    if (cos > max_cosine) {
 	       max_cosine = cos;
 	       best_k = k;
@@ -225,19 +410,23 @@ double DocVectSet::kmeans(Uint K, vector<Uint>& clusters, vector<DocVect>& means
       if (verbose) {dumpClusters(K, clusters, cerr);}
 
       // calculate new means
-      // !!! merge this with calcClusterMeans - just settle the scaling part
-      for (Uint k = 0; k < K; ++k)
-	 means[k].clear();
-      for (Uint i = 0; i < numDocs(); ++i)
-	 addScaled(means[clusters[i]], vals[i], 1.0 / vsize(vals[i]));
+      sumClusters(K, clusters, scales, mns);
       
    } while (!done);
 
    // compute objective
 
+   vector<double> prox(N);
+#pragma omp parallel for schedule(dynamic, 16)
+   for (int i = 0; i < int(N); ++i)
+      prox[i] = cosine(i, mns[clusters[i]]);
    double obj = 0;
-   for (Uint i = 0; i < numDocs(); ++i)
-      obj += cosine(vals[i], means[clusters[i]]);
+   for (Uint i = 0; i < N; ++i)
+      obj += prox[i];
+
+   means.resize(K);
+   for (Uint k = 0; k < K; ++k)
+      mns[k].get(means[k]);
    return obj;
 }
 
@@ -262,21 +451,68 @@ double DocVectSet::kmeans(Uint K, vector<Uint>& cluster_map, vector<DocVect>& me
 }
 
 void DocVectSet::calcDocProximities(Uint K, const vector<Uint>& cluster_map, 
-				    const vector<DocVect>& means, vector<float>& prox)
+				    const vector<DocVect>& means, vector<float>& prox) const
 {
-   prox.clear();
-   for (Uint i = 0; i < cluster_map.size(); ++i)
-      prox.push_back(cosine(vals[i], means[cluster_map[i]]));
+   vector<SparseVect> mns(means.size());
+   for (Uint k = 0; k < means.size(); ++k)
+      mns[k].assign(means[k]);
+   prox.resize(cluster_map.size());
+#pragma omp parallel for schedule(dynamic, 16)
+   for (int i = 0; i < int(cluster_map.size()); ++i)
+      prox[i] = cosine(i, mns[cluster_map[i]]);
 }
 
 void DocVectSet::calcClusterMeans(Uint K, const vector<Uint>& cluster_map, 
-				  const vector<float>& wts, vector<DocVect>& means)
+				  const vector<float>& wts, vector<DocVect>& means) const
 {
+   vector<double> scales(wts.begin(), wts.begin() + numDocs());
+   vector<SparseVect> mns;
+   sumClusters(K, cluster_map, scales, mns);
    means.resize(K);
    for (Uint k = 0; k < K; ++k)
-      means[k].clear();
+      mns[k].get(means[k]);
+}
+
+void DocVectSet::sumClusters(Uint K, const vector<Uint>& cluster_map, 
+			     const vector<double>& scales, vector<SparseVect>& sums) const
+{
+   vector< vector<Uint> > members(K);
    for (Uint i = 0; i < numDocs(); ++i)
-      addScaled(means[cluster_map[i]], vals[i], wts[i]);
+      members[cluster_map[i]].push_back(i);
+
+   sums.resize(K);
+#pragma omp parallel
+   {
+      // dense accumulator, and the features set in it
+      vector<float> acc(numFeatures(), 0.0f);
+      vector<bool> used(numFeatures(), false);
+      vector<Uint> fs;
+#pragma omp for schedule(dynamic)
+      for (int k = 0; k < int(K); ++k) {
+	 fs.clear();
+	 for (Uint m = 0; m < members[k].size(); ++m) {
+	    const Uint i = members[k][m];
+	    for (Uint j = rows[i]; j < rows[i+1]; ++j) {
+	       const Uint f = feats[j];
+	       if (!used[f]) {
+		  used[f] = true;
+		  fs.push_back(f);
+	       }
+	       acc[f] += vals[j] * scales[i];
+	    }
+	 }
+	 sort(fs.begin(), fs.end());
+	 SparseVect& sum = sums[k];
+	 sum.feats = fs;
+	 sum.vals.resize(fs.size());
+	 for (Uint j = 0; j < fs.size(); ++j) {
+	    sum.vals[j] = acc[fs[j]];
+	    acc[fs[j]] = 0.0f;
+	    used[fs[j]] = false;
+	 }
+	 sum.norm = norm(sum.vals.empty() ? NULL : &sum.vals[0], sum.vals.size());
+      }
+   }
 }
 
 void DocVectSet::writeClusterMeans(const vector<DocVect>& means, const string& pref, const string& suff)
@@ -289,7 +525,7 @@ void DocVectSet::writeClusterMeans(const vector<DocVect>& means, const string& p
    }
 }
 
-void DocVectSet::dumpClusters(Uint K, const vector<Uint>& cluster_map, ostream& out, bool human)
+void DocVectSet::dumpClusters(Uint K, const vector<Uint>& cluster_map, ostream& out, bool human) const
 {
    for (Uint k = 0; k < K; ++k) {
       if (!human) out << "[";
@@ -45,20 +45,60 @@ private:
    FeatureMap fmap;             ///< feature (word sequence) -> index
 
    vector<string> doc_names;    ///< doc -> name
-   vector<DocVect> vals;        ///< doc -> (feature -> value)
+
+   // The doc vects, in compressed sparse row (CSR) form: the values of doc i
+   // are vals[rows[i]..rows[i+1]), for features feats[rows[i]..rows[i+1]),
+   // which are in increasing order. This makes dot products sorted merges over
+   // contiguous arrays rather than walks through a tree per doc.
+   vector<Uint> rows;           ///< doc -> start of its row; numDocs()+1 entries
+   vector<Uint> feats;          ///< value index -> feature
+   vector<float> vals;          ///< value index -> value
+   vector<double> norms;        ///< doc -> vector size (L2)
    vector<Uint> doc_freqs;      ///< feature -> # of docs
 
+   /**
+    * A sparse vector stored like a CSR row, used for cluster means.
+    */
+   struct SparseVect {
+      vector<Uint> feats;       ///< features, in increasing order
+      vector<float> vals;       ///< value of each feature
+      double norm;              ///< vector size (L2)
+      SparseVect() : norm(0) {}
+      void assign(const DocVect& dv);
+      void get(DocVect& dv) const;
+   };
+
    Uint addKeyToFmap(const string& key);
+   void setRow(Uint pos, const vector<Uint>& fs, const vector<float>& vs);
    void writeDocVect(const DocVect& dv, ostream& out,
       FeatureMap::iterator it, FeatureMap::iterator end, vector<Uint>& prefix);
 
    void getFeatureNames(vector<string>& names,
       FeatureMap::iterator it, FeatureMap::iterator end, vector<Uint>& prefix);
 
+   /**
+    * Dot product of two sparse vectors with sorted features: a merge, or a
+    * binary search of the longer one's features when it is much longer.
+    */
+   static double dot(const Uint* f1, const float* v1, Uint n1,
+                     const Uint* f2, const float* v2, Uint n2);
+   static double norm(const float* v, Uint n);
+   static double cosine(double s, double size1, double size2) {
+      return (size1 > 0 && size2 > 0) ? s / (size1 * size2) : 0.0;
+   }
+   double cosine(Uint i, const SparseVect& v) const;
+
+   /**
+    * Set sums[k] to the sum of the docs in cluster k, each scaled by
+    * scales[doc]. Clusters are summed in parallel.
+    */
+   void sumClusters(Uint K, const vector<Uint>& cluster_map,
+                    const vector<double>& scales, vector<SparseVect>& sums) const;
+
 public:
 
-   DocVectSet() {}
-   DocVectSet(const vector<string>& files) {read(files);}
+   DocVectSet() : rows(1, 0) {}
+   DocVectSet(const vector<string>& files) : rows(1, 0) {read(files);}
 
    void read(const vector<string>& files) {
       for (Uint i = 0; i < files.size(); ++i) addDocVect(files[i]);
@@ -66,12 +106,16 @@ public:
 
    void clear();
    
-   Uint numDocs() {return vals.size();}
-   Uint numFeatures() {return doc_freqs.size();}
-   Uint numVals();		// number of non-zero values
-   const string& docName(Uint i) {return doc_names[i];}
-   DocVect& getDocVect(Uint i) {return vals[i];}
-   Uint docFreq(Uint feature) {return doc_freqs[feature];}
+   Uint numDocs() const {return rows.size()-1;}
+   Uint numFeatures() const {return doc_freqs.size();}
+   Uint numVals() const {return vals.size();} // number of non-zero values
+   const string& docName(Uint i) const {return doc_names[i];}
+   Uint docFreq(Uint feature) const {return doc_freqs[feature];}
+
+   /**
+    * Get a copy of the ith doc vect.
+    */
+   DocVect getDocVect(Uint i) const;
 
    /**
     * Find a feature by its name; return numFeatures() if not found.
@@ -92,7 +136,8 @@ public:
     * blanks. 
     * @param pos if < size(), new vect will replace existing one at index pos,
     * otherwise it just gets appended. Using pos < size() does not erase any
-    * features added by the replaced doc.
+    * features added by the replaced doc, but it does remove the replaced doc
+    * from their doc frequencies.
     */
    void addDocVect(const string& dv_file, Uint pos=numeric_limits<Uint>::max());
 
@@ -100,7 +145,7 @@ public:
    /**
     * Return the inverse doc freq weight that will be applied to a given feature.
     */
-   double idf(Uint feature, double smooth) {
+   double idf(Uint feature, double smooth) const {
       return log((numDocs()+smooth) / (double) doc_freqs[feature]);
    }
 
@@ -116,6 +161,27 @@ public:
     */
    static double cosine(const DocVect& dv1, const DocVect& dv2);
 
+   /**
+    * Compute cosine proximity between docs i and j.
+    */
+   double cosine(Uint i, Uint j) const;
+
+   /**
+    * Compute the cosine proximity of doc q to each of docs 0..n-1, in parallel.
+    * @param q
+    * @param n
+    * @param prox doc index -> proximity to q, for the first n docs
+    * @param smooth unless -1, weight values as tfidf(smooth) would, without
+    * modifying the set
+    */
+   void cosines(Uint q, Uint n, vector<double>& prox, double smooth = -1) const;
+
+   /**
+    * Compute the cosine proximity between all pairs of docs, in parallel.
+    * @param prox set to numDocs() rows of numDocs() proximities
+    */
+   void allPairsCosines(vector< vector<double> >& prox) const;
+
    /**
     * Compute sigmoid transformation on proximity.
     * @name prox proximity metric, eg cosine, in [0,1]
@@ -153,7 +219,8 @@ public:
    /**
     * Cluster docs using kmeans algorithm with cosine proximity metric. The
     * first version is the basic algorithm; the 2nd iterates it using different
-    * randomly-chosen starting points. Use the 2nd, generally.
+    * randomly-chosen starting points. Use the 2nd, generally. Docs are
+    * assigned to clusters, and means are summed, in parallel.
     * @param K the eponymous (desired number of clusters)
     * @param cluster_map doc index -> cluster index, in 0..K-1
     * @param means cluster index -> mean vector for that cluster
@@ -175,7 +242,7 @@ public:
     * @param prox doc index -> proximity
     */
    void calcDocProximities(Uint K, const vector<Uint>& cluster_map, 
-			   const vector<DocVect>& means, vector<float>& prox);
+			   const vector<DocVect>& means, vector<float>& prox) const;
 
    /**
     * Calculate weighted cluster mean vectors - a weighted, non-normalized
@@ -186,7 +253,7 @@ public:
     * @param means cluster index -> mean vector for cluster
     */
    void calcClusterMeans(Uint K, const vector<Uint>& cluster_map, 
-			 const vector<float>& wts, vector<DocVect>& means);
+			 const vector<float>& wts, vector<DocVect>& means) const;
 
    /**
     * Write a doc vect on a stream, in the same format as it was read.
@@ -212,7 +279,7 @@ public:
     * false, write file indexes in each cluster surrounded by [], and put ALL
     * clusters on a single line.
     */
-   void dumpClusters(Uint K, const vector<Uint>& cluster_map, ostream& out, bool human=false);
+   void dumpClusters(Uint K, const vector<Uint>& cluster_map, ostream& out, bool human=false) const;
 
    /**
     * Write contents of each doc vect to "<fname>".dump, where "<fname>" is the
@@ -29,7 +29,8 @@ usage() {
    done
    cat <<==EOF== >&2
 
-mx-calc-distances.sh [-v][-a args][-d pfx][-e ext] metric components textfile 
+mx-calc-distances.sh [-v][-a args][-d pfx][-e ext] metric components textfile
+                     [textfile2 ...]
 
 Calculate text distances, according to some metric, from a given list of corpus
 components to a given text file. NB: higher values indicate a better match.
@@ -48,7 +49,10 @@ files whose complete paths are specified by -d and -e). <metric> is one of:
              get_voc -c <textfile> > vocfile
              cosine_distances <args> <models> vocfile
 
-Output is written to stdout, one distance per line in <components>.
+Output is written to stdout, one distance per line in <components>. If several
+textfiles are given, each line contains one distance per textfile, in the order
+given. The tfidf metric then computes all the distances in one pass, reading the
+components only once (add -j N to <args> to use N threads).
 
 Options:
 
@@ -84,18 +88,21 @@ while [ $# -gt 0 ]; do
    shift
 done
 
-if [ $# -ne 3 ]; then
-   error_exit "Expecting 3 arguments!"
+if [ $# -lt 3 ]; then
+   error_exit "Expecting at least 3 arguments!"
 fi
 
 metric=$1
 components=$2
-textfile=$3
+shift 2
+textfiles="$@"
 
 # Check arguments
 
 if [ ! -r $components ]; then error_exit "Can't read file $components"; fi
-if [ ! -r $textfile ]; then error_exit "Can't read file $textfile"; fi
+for textfile in $textfiles; do
+   if [ ! -r $textfile ]; then error_exit "Can't read file $textfile"; fi
+done
 
 tmp=`/usr/bin/uuidgen`
 models="models.$tmp"
@@ -109,22 +116,50 @@ models="models.$tmp"
 
 export LC_ALL=C
 
+# Distances to a single text file
+calc_distances() {
+   textfile=$1
+   case $metric in
+      ppx)
+           eval multi-ngram-ppx $args $models $textfile |
+               perl -ne 's/.*ppl1=\s*(\S+).*/$1/;
+	                 $x=1.0/(1e-10+$_);
+                         print "$x\n"' ;;
+      em-sri)
+           eval train-lm-mixture $args $models $textfile ;;
+      em)
+           eval train_lm_mixture $args $models $textfile ;;
+   esac
+}
+
 case $metric in
    uniform)
-        cat $components | perl -ne 'print "1\n";' ;;
-   ppx)
-        eval multi-ngram-ppx $args $models $textfile |
-            perl -ne 's/.*ppl1=\s*(\S+).*/$1/;
-	              $x=1.0/(1e-10+$_);
-                      print "$x\n"' ;;
-   em-sri)
-        eval train-lm-mixture $args $models $textfile ;;
-   em)
-        eval train_lm_mixture $args $models $textfile ;;
+        n=`echo $textfiles | wc -w`
+        cat $components | perl -ne "print join(' ', (1) x $n), \"\n\";" ;;
+   ppx|em-sri|em)
+        if [ `echo $textfiles | wc -w` -eq 1 ]; then
+           calc_distances $textfiles
+        else
+           dists=
+           i=0
+           for textfile in $textfiles; do
+              i=$(( $i + 1 ))
+              calc_distances $textfile > dist.$i.$tmp
+              dists="$dists dist.$i.$tmp"
+           done
+           paste -d' ' $dists
+           rm $dists
+        fi ;;
    tfidf)
-        get_voc -c $textfile > voc.$tmp
-        eval cosine_distances $args $models voc.$tmp
-        rm voc.$tmp ;;
+        vocs=
+        i=0
+        for textfile in $textfiles; do
+           i=$(( $i + 1 ))
+           get_voc -c $textfile > voc.$i.$tmp
+           vocs="$vocs voc.$i.$tmp"
+        done
+        eval cosine_distances $args $models $vocs
+        rm $vocs ;;
 
    *)        error_exit "Unknown metric <$metric>!"
 esac
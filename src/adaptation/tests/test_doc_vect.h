@@ -0,0 +1,267 @@
+/**
+ * @file test_doc_vect.h
+ * @brief Test suite for DocVectSet: the CSR kernels against the map-based
+ *        DocVectSet::cosine().
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "doc_vect.h"
+#include "file_utils.h"
+#include <algorithm>
+#include <sstream>
+#include <cstdlib>
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestDocVect : public CxxTest::TestSuite
+{
+   typedef DocVectSet::DocVect DocVect;
+
+   static const Uint numDocs = 12;
+   string tmpdir;
+   vector<string> docs;      // doc vect files
+   vector<string> vocfiles;  // query doc vect files, as for cosine_distances
+
+   /// Write a random doc vect to a new file in tmpdir.
+   string writeRandomDoc(const string& name, Uint maxFeatures) {
+      const string file = tmpdir + "/" + name;
+      oSafeMagicStream out(file);
+      const Uint n = rand(maxFeatures);
+      for (Uint i = 0; i < n; ++i) {
+         // phrase features from a small vocabulary, so that docs overlap
+         out << "w" << rand(30);
+         if (rand(3) == 0) out << " w" << rand(5);
+         out << " " << 1 + rand(9) << endl;
+      }
+      return file;
+   }
+
+   /// @return the doc vect of doc i, as feature name -> value
+   static map<string,float> namedDocVect(DocVectSet& dvs, Uint i) {
+      vector<string> names;
+      dvs.getFeatureNames(names);
+      map<string,float> named;
+      const DocVect dv = dvs.getDocVect(i);
+      for (DocVect::const_iterator p = dv.begin(); p != dv.end(); ++p)
+         named[names[p->first]] = p->second;
+      return named;
+   }
+
+   /// Scores of each model to each vocfile, as computed by cosine_distances.
+   void vocfileCosines(const vector<string>& vocs, double df,
+                       vector< vector<double> >& dists) {
+      DocVectSet dvs(docs);
+      dists.resize(vocs.size());
+      for (Uint v = 0; v < vocs.size(); ++v) {
+         dvs.addDocVect(vocs[v], docs.size());
+         dvs.cosines(docs.size(), docs.size(), dists[v], df);
+      }
+   }
+
+public:
+   void setUp() {
+      srand(17);
+      char tmpdirname[] = "/tmp/testDocVect.XXXXXX";
+      tmpdir = mkdtemp(tmpdirname);
+      docs.clear();
+      vocfiles.clear();
+      for (Uint i = 0; i < numDocs; ++i)
+         // doc 3 is empty, and doc 5 much longer than the others
+         docs.push_back(writeRandomDoc("doc" + toString(i),
+                                       i == 3 ? 1 : i == 5 ? 400 : 40));
+      for (Uint i = 0; i < 3; ++i)
+         vocfiles.push_back(writeRandomDoc("voc" + toString(i), 60));
+   }
+
+   void tearDown() {
+      if (system(("rm -rf " + tmpdir).c_str()) != 0)
+         TS_FAIL("cannot remove " + tmpdir);
+   }
+
+   void testCosines() {
+      DocVectSet dvs(docs);
+      vector<double> prox;
+      for (Uint q = 0; q < numDocs; ++q) {
+         dvs.cosines(q, numDocs, prox);
+         TS_ASSERT_EQUALS(prox.size(), numDocs);
+         for (Uint i = 0; i < numDocs; ++i) {
+            const double expected =
+               DocVectSet::cosine(dvs.getDocVect(i), dvs.getDocVect(q));
+            TS_ASSERT_DELTA(prox[i], expected, 1e-6);
+            TS_ASSERT_DELTA(dvs.cosine(i, q), expected, 1e-6);
+         }
+      }
+      dvs.cosines(0, 4, prox);
+      TS_ASSERT_EQUALS(prox.size(), 4u);
+   }
+
+   void testWeightedCosines() {
+      const double smooths[] = { 0, 0.5, 3 };
+      for (Uint s = 0; s < ARRAY_SIZE(smooths); ++s) {
+         DocVectSet dvs(docs), weighted(docs);
+         weighted.tfidf(smooths[s]);
+         vector<double> prox;
+         for (Uint q = 0; q < numDocs; ++q) {
+            dvs.cosines(q, numDocs, prox, smooths[s]);
+            for (Uint i = 0; i < numDocs; ++i)
+               TS_ASSERT_DELTA(prox[i], DocVectSet::cosine(weighted.getDocVect(i),
+                                                           weighted.getDocVect(q)), 1e-6);
+         }
+      }
+   }
+
+   void testAllPairsCosines() {
+      DocVectSet dvs(docs);
+      vector< vector<double> > prox;
+      dvs.allPairsCosines(prox);
+      TS_ASSERT_EQUALS(prox.size(), numDocs);
+      for (Uint i = 0; i < numDocs; ++i) {
+         TS_ASSERT_EQUALS(prox[i].size(), numDocs);
+         for (Uint j = 0; j < numDocs; ++j)
+            TS_ASSERT_DELTA(prox[i][j], DocVectSet::cosine(dvs.getDocVect(i),
+                                                           dvs.getDocVect(j)), 1e-6);
+      }
+      TS_ASSERT_EQUALS(prox[3][3], 0.0);
+      TS_ASSERT_DELTA(prox[0][0], 1.0, 1e-6);
+   }
+
+   void testClusterMeans() {
+      DocVectSet dvs(docs);
+      const Uint K = 4;
+      vector<Uint> cluster_map(numDocs);
+      vector<float> wts(numDocs);
+      for (Uint i = 0; i < numDocs; ++i) {
+         cluster_map[i] = (i * 7) % K;
+         wts[i] = 0.5 + i;
+      }
+      vector<DocVect> means;
+      dvs.calcClusterMeans(K, cluster_map, wts, means);
+      TS_ASSERT_EQUALS(means.size(), K);
+
+      vector<DocVect> expected(K);
+      for (Uint i = 0; i < numDocs; ++i)
+         DocVectSet::addScaled(expected[cluster_map[i]], dvs.getDocVect(i), wts[i]);
+      for (Uint k = 0; k < K; ++k) {
+         TS_ASSERT_EQUALS(means[k].size(), expected[k].size());
+         for (DocVect::const_iterator p = expected[k].begin(); p != expected[k].end(); ++p) {
+            DocVect::const_iterator m = means[k].find(p->first);
+            TS_ASSERT(m != means[k].end());
+            if (m != means[k].end())
+               TS_ASSERT_DELTA(m->second, p->second, 1e-4);
+         }
+      }
+
+      vector<float> prox;
+      dvs.calcDocProximities(K, cluster_map, means, prox);
+      TS_ASSERT_EQUALS(prox.size(), numDocs);
+      for (Uint i = 0; i < numDocs; ++i)
+         TS_ASSERT_DELTA(prox[i], DocVectSet::cosine(dvs.getDocVect(i),
+                                                     expected[cluster_map[i]]), 1e-5);
+   }
+
+   void testKmeans() {
+      DocVectSet dvs;
+      for (Uint i = 0; i < numDocs; ++i)
+         if (i != 3) dvs.addDocVect(docs[i]);  // kmeans needs non-empty docs
+      const Uint N = dvs.numDocs(), K = 3;
+      vector<Uint> cluster_map;
+      vector<DocVect> means;
+      const double obj = dvs.kmeans(K, cluster_map, means, Uint(4));
+      TS_ASSERT_EQUALS(cluster_map.size(), N);
+      TS_ASSERT_EQUALS(means.size(), K);
+
+      // The means are the sums of their docs scaled to unit length, each doc
+      // is in the cluster of the closest mean, and the objective is the sum
+      // of their proximities.
+      vector<DocVect> expected(K);
+      for (Uint i = 0; i < N; ++i) {
+         const DocVect dv = dvs.getDocVect(i);
+         DocVectSet::addScaled(expected[cluster_map[i]], dv, 1.0 / DocVectSet::vsize(dv));
+      }
+      double expected_obj = 0;
+      for (Uint i = 0; i < N; ++i) {
+         const DocVect dv = dvs.getDocVect(i);
+         const double prox = DocVectSet::cosine(dv, expected[cluster_map[i]]);
+         TS_ASSERT_DELTA(prox, DocVectSet::cosine(dv, means[cluster_map[i]]), 1e-5);
+         for (Uint k = 0; k < K; ++k)
+            TS_ASSERT(DocVectSet::cosine(dv, means[k]) <= prox + 1e-5);
+         expected_obj += prox;
+      }
+      TS_ASSERT_DELTA(obj, expected_obj, 1e-4);
+   }
+
+   void testReplaceDocVect() {
+      // Replacing doc 1 by a vocfile gives the same set as reading the
+      // vocfile in its place, except for features nothing uses any more.
+      DocVectSet replaced(docs);
+      replaced.addDocVect(vocfiles[0], 1);
+      vector<string> files(docs);
+      files[1] = vocfiles[0];
+      DocVectSet fresh(files);
+
+      TS_ASSERT_EQUALS(replaced.numDocs(), numDocs);
+      TS_ASSERT_EQUALS(replaced.docName(1), vocfiles[0]);
+      TS_ASSERT_EQUALS(replaced.numVals(), fresh.numVals());
+      for (Uint i = 0; i < numDocs; ++i)
+         TS_ASSERT(namedDocVect(replaced, i) == namedDocVect(fresh, i));
+
+      vector<string> names;
+      replaced.getFeatureNames(names);
+      for (Uint f = 0; f < names.size(); ++f) {
+         const Uint ff = fresh.getFeature(names[f]);
+         TS_ASSERT_EQUALS(replaced.docFreq(f),
+                          ff < fresh.numFeatures() ? fresh.docFreq(ff) : 0u);
+      }
+
+      vector<double> prox, fresh_prox;
+      for (double smooth = -1; smooth < 2; ++smooth)
+         for (Uint q = 0; q < numDocs; ++q) {
+            replaced.cosines(q, numDocs, prox, smooth);
+            fresh.cosines(q, numDocs, fresh_prox, smooth);
+            for (Uint i = 0; i < numDocs; ++i)
+               TS_ASSERT_DELTA(prox[i], fresh_prox[i], 1e-6);
+         }
+   }
+
+   void testSeveralVocfiles() {
+      // As in cosine_distances: the scores of each vocfile, when it replaces
+      // the previous one, are the same as with that vocfile alone.
+      const double dfs[] = { -1, 0, 0.5 };
+      for (Uint d = 0; d < ARRAY_SIZE(dfs); ++d) {
+         vector< vector<double> > dists;
+         vocfileCosines(vocfiles, dfs[d], dists);
+         TS_ASSERT_EQUALS(dists.size(), vocfiles.size());
+         for (Uint v = 0; v < vocfiles.size(); ++v) {
+            vector< vector<double> > single;
+            vocfileCosines(vector<string>(1, vocfiles[v]), dfs[d], single);
+            TS_ASSERT_EQUALS(dists[v].size(), numDocs);
+            for (Uint k = 0; k < numDocs; ++k)
+               TS_ASSERT_DELTA(dists[v][k], single[0][k], 1e-9);
+         }
+      }
+   }
+
+   void testPairs() {
+      // As in cosine_distances -pairs -df 0.5
+      DocVectSet dvs(docs);
+      dvs.tfidf(0.5);
+      vector< vector<double> > prox;
+      dvs.allPairsCosines(prox);
+      for (Uint i = 0; i < numDocs; ++i)
+         for (Uint j = 0; j < numDocs; ++j) {
+            TS_ASSERT_DELTA(prox[i][j], prox[j][i], 1e-12);
+            TS_ASSERT_DELTA(prox[i][j], DocVectSet::cosine(dvs.getDocVect(i),
+                                                           dvs.getDocVect(j)), 1e-6);
+         }
+   }
+};
+
+} // namespace Portage
@@ -15,6 +15,7 @@
 #include "alignment_freqs.h"
 
 Voc AlignmentAnnotation::alignmentVoc;
+AlignmentAnnotation::SetsCache AlignmentAnnotation::mainCache;
 Uint AlignmentAnnotation::emptyAlignmentID = AlignmentAnnotation::alignmentVoc.add("");
 const string AlignmentAnnotation::name = "a";
 
@@ -43,41 +44,47 @@ void AlignmentAnnotation::updateValue(const char* value)
    alignmentID = alignmentVoc.add(value);
 }
 
-const vector<vector<Uint> >* AlignmentAnnotation::getAlignmentSets(Uint alignmentID, Uint src_len)
+const vector<vector<Uint> >* AlignmentAnnotation::getAlignmentSets(Uint alignmentID, Uint src_len,
+                                                                  SetsCache& cache)
 {
-   static vector< vector<Uint> > sets;
-   static Uint prev_alignmentID = Uint(-1);
-   static Uint prev_src_len = Uint(-1);
+   vector< vector<Uint> >* sets = &cache.sets;
 
    // Cache the last query to this function, because it's likely to be called
    // multiple times in a row for the same decoder state, i.e., with the same
    // arguments.
-   if (alignmentID == prev_alignmentID && src_len == prev_src_len)
-      return &sets;
+   if (alignmentID == cache.alignmentID && src_len == cache.src_len)
+      return sets;
 
-   AlignmentFreqs<float> alignment_freqs;
-   const char* alignment_string = alignmentVoc.word(alignmentID);
-   parseAndTallyAlignments(alignment_freqs, alignmentVoc, alignment_string);
-   if (alignment_freqs.empty()) {
-      sets.clear();
-   }  else if (!alignment_freqs.empty()) {
-      const char* top_alignment_string =
-         alignmentVoc.word(alignment_freqs.max()->first);
-      GreenReader('_').operator()(top_alignment_string, sets);
-      if (!sets.empty() && sets.size() < src_len)
-         sets.resize(src_len); // pad with empty sets if some are missing.
+   // parseAndTallyAlignments() can add to alignmentVoc.
+#ifdef _OPENMP
+#pragma omp critical (AlignmentAnnotation_alignmentVoc)
+#endif
+   {
+      AlignmentFreqs<float> alignment_freqs;
+      const char* alignment_string = alignmentVoc.word(alignmentID);
+      parseAndTallyAlignments(alignment_freqs, alignmentVoc, alignment_string);
+      if (alignment_freqs.empty()) {
+         sets->clear();
+      }  else if (!alignment_freqs.empty()) {
+         const char* top_alignment_string =
+            alignmentVoc.word(alignment_freqs.max()->first);
+         GreenReader('_').operator()(top_alignment_string, *sets);
+         if (!sets->empty() && sets->size() < src_len)
+            sets->resize(src_len); // pad with empty sets if some are missing.
+      }
    }
 
-   prev_alignmentID = alignmentID;
-   prev_src_len = src_len;
+   cache.alignmentID = alignmentID;
+   cache.src_len = src_len;
 
-   return &sets;
+   return sets;
 }
 
-const vector<vector<Uint> >* AlignmentAnnotation::getSets(const AnnotationList& list, Uint src_len) {
+const vector<vector<Uint> >* AlignmentAnnotation::getSets(const AnnotationList& list, Uint src_len,
+                                                          SetsCache& cache) {
    AlignmentAnnotation* ann = get(list);
    if (ann)
-      return getAlignmentSets(ann->getAlignmentID(), src_len);
+      return getAlignmentSets(ann->getAlignmentID(), src_len, cache);
    else
       return NULL;
 }
@@ -61,11 +61,40 @@ public:
    /// Get the alignment ID from this annotation
    Uint getAlignmentID() const { return alignmentID; }
 
+   /**
+    * Holds the set representation of the last alignment requested through
+    * it, since getAlignmentSets() tends to be called several times in a row
+    * for the same phrase pair.  Code that may run while phrase partial scores
+    * are precomputed in parallel must use its own SetsCache, e.g., a member of
+    * a PRECOMPUTE_OWN_THREAD feature, or a local variable.
+    */
+   struct SetsCache {
+      vector<vector<Uint> > sets; ///< src pos -> links
+      Uint alignmentID;           ///< alignment ID of sets
+      Uint src_len;               ///< source phrase length of sets
+      SetsCache() : alignmentID(Uint(-1)), src_len(Uint(-1)) {}
+   };
+
+private:
+   /// cache used by getAlignmentSets() and getSets() without a SetsCache
+   static SetsCache mainCache;
+
+public:
+
    /**
     * Get the set representation of the alignment
     * @param src_len      length of the source phrase having this alignment
+    * @param cache        where to keep the result
+    * @return &cache.sets
     */
-   static const vector<vector<Uint> >* getAlignmentSets(Uint alignID, Uint src_len);
+   static const vector<vector<Uint> >* getAlignmentSets(Uint alignID, Uint src_len,
+                                                        SetsCache& cache);
+
+   /// Same, using a cache shared by all callers: only call this from the
+   /// main thread.
+   static const vector<vector<Uint> >* getAlignmentSets(Uint alignID, Uint src_len) {
+      return getAlignmentSets(alignID, src_len, mainCache);
+   }
 
    /// Get an alignment ID from a possibly NULL annotation
    static Uint getID(const AlignmentAnnotation* value) {
@@ -81,7 +110,14 @@ public:
    /// Convenient wrapper around get() and getAlignmentSets()
    /// Return NULL if the list has no AlignmentAnnotation or does not
    /// define an alignment.
-   static const vector<vector<Uint> >* getSets(const AnnotationList& list, Uint src_len);
+   static const vector<vector<Uint> >* getSets(const AnnotationList& list, Uint src_len,
+                                               SetsCache& cache);
+
+   /// Same, using a cache shared by all callers: only call this from the
+   /// main thread.
+   static const vector<vector<Uint> >* getSets(const AnnotationList& list, Uint src_len) {
+      return getSets(list, src_len, mainCache);
+   }
 }; // class AlignmentAnnotation
 
 } // namespace Portage
@@ -27,6 +27,11 @@
 #include "sparsemodel.h" // for describeModel()
 #include "new_src_sent_info.h"
 #include "lazy_stl.h"
+#include "length_feature.h"
+#include <typeinfo>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace Portage;
 using namespace std;
@@ -62,6 +67,19 @@ void BasicModelGenerator::InitDecoderFeatures(const CanoeConfig& c)
    for (vector<string>::const_iterator it(c.filterFeatures.begin()),
         end(c.filterFeatures.end()); it != end; ++it)
       filter_features.push_back(DecoderFeature::create(this, "DistortionModel", *it));
+
+   // Exact types only: subclasses may override score() and friends.
+   feature_recomb_hash_factor = 1;
+   for (Uint k = 0; k < decoder_features.size(); ++k) {
+      const type_info& type = typeid(*decoder_features[k]);
+      if (type == typeid(LengthFeature))
+         decoder_feature_dispatch.push_back(DISPATCH_LENGTH);
+      else if (type == typeid(WordDisplacement))
+         decoder_feature_dispatch.push_back(DISPATCH_WORD_DISPLACEMENT);
+      else
+         decoder_feature_dispatch.push_back(DISPATCH_VIRTUAL);
+      feature_recomb_hash_factor *= 17;
+   }
 }
 
 
@@ -181,12 +199,14 @@ BasicModelGenerator::BasicModelGenerator(const CanoeConfig& c) :
    c(&c),
    verbosity(c.verbosity),
    tgt_vocab(0),
+   metrics(NULL),
    limitPhrases(false),
    lm_numwords(1),
    lm_min_context(1),
    futureScoreLMHeuristic(lm_heuristic_type_from_string(c.futLMHeuristic)),
    cubePruningLMHeuristic(lm_heuristic_type_from_string(c.cubeLMHeuristic)),
    vocab_read_from_TPPTs(true),
+   doc_sents(0),
    addWeightMarked(log(c.weightMarked))
 {
    LOG_VERBOSE1(bmgLogger, "BasicModelGenerator constructor with 2 args");
@@ -210,12 +230,14 @@ BasicModelGenerator::BasicModelGenerator(
    c(&c),
    verbosity(c.verbosity),
    tgt_vocab(c.loadFirst ? 0 : sents.size()),
+   metrics(NULL),
    limitPhrases(!c.loadFirst),
    lm_numwords(1),
    lm_min_context(1),
    futureScoreLMHeuristic(lm_heuristic_type_from_string(c.futLMHeuristic)),
    cubePruningLMHeuristic(lm_heuristic_type_from_string(c.cubeLMHeuristic)),
    vocab_read_from_TPPTs(true),
+   doc_sents(0),
    addWeightMarked(log(c.weightMarked))
 {
    LOG_VERBOSE1(bmgLogger, "BasicModelGenerator construtor with 5 args");
@@ -274,6 +296,8 @@ BasicModelGenerator::~BasicModelGenerator()
 
    GlobalVoc::clear();
 
+   delete metrics;
+
    // if the user doesn't want to clean up, exit.
    if (c != NULL && c->final_cleanup) {
       for ( vector<DecoderFeature *>::iterator it = decoder_features.begin();
@@ -333,7 +357,12 @@ void BasicModelGenerator::loadVoc(const char *vocFile)
    // word<->index map as was in place when the vocab was generated.
    tgt_vocab.clear();
 
-   tgt_vocab.read(vocFile);
+   // A memory mapped vocabulary is shared with other processes using the
+   // same file; words not in it go into tgt_vocab's in-memory overlay.
+   if (MMVoc::isMMVoc(vocFile))
+      tgt_vocab.mapFile(vocFile);
+   else
+      tgt_vocab.read(vocFile);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -455,14 +484,23 @@ BasicModel *BasicModelGenerator::createModel(
          it != filter_features.end(); ++it)
       (*it)->newSrcSent(info);
 
+   // In -doc-mode, the caches are kept until the end of the document, or for
+   // 1000 sentences at most, to bound their size.
+   if (c->docMode) {
+      if (doc_sents == 1000)
+         newDocument();
+      ++doc_sents;
+   }
+
    // Inform all LM models that we are about to process a new source sentence.
    for (Uint i=0;i<lms.size();++i) {
-      lms[i]->clearCache();
+      if (!c->docMode)
+         lms[i]->clearCache();
       lms[i]->newSrcSent(info.src_sent, info.external_src_sent_id);
    }
 
    // Clear the phrase table caches every 10 sentences
-   if ( info.internal_src_sent_seq % 10 == 0 )
+   if ( !c->docMode && info.internal_src_sent_seq % 10 == 0 )
       phraseTable->clearCache();
 
    // Compute and save the phrase heuristic for all phrase pairs kept
@@ -479,6 +517,20 @@ BasicModel *BasicModelGenerator::createModel(
    return info.model;
 } // createModel
 
+void BasicModelGenerator::newDocument()
+{
+   doc_sents = 0;
+   for (Uint i = 0; i < lms.size(); ++i)
+      lms[i]->clearCache();
+   phraseTable->clearCache();
+   for ( vector<DecoderFeature *>::iterator it = decoder_features.begin();
+         it != decoder_features.end(); ++it)
+      (*it)->newDocument();
+   for ( vector<DecoderFeature *>::iterator it = filter_features.begin();
+         it != filter_features.end(); ++it)
+      (*it)->newDocument();
+} // newDocument
+
 vector<PhraseInfo *> **BasicModelGenerator::createAllPhraseInfos(
    const newSrcSentInfo& info,
    bool alwaysTryDefault)
@@ -632,9 +684,25 @@ PhraseInfo *BasicModelGenerator::makeNoTransPhraseInfo(
    return newPI;
 } // makeNoTransPhraseInfo
 
+Uint BasicModelGenerator::numPrecomputeThreads() const
+{
+#ifdef _OPENMP
+   if (c->verbosity >= 4) return 1; // keep the verbose output in order
+   return c->precomputeThreads ? c->precomputeThreads : omp_get_max_threads();
+#else
+   return 1;
+#endif
+}
+
 void BasicModelGenerator::computePhrasePartialScores(
    vector<PhraseInfo *> **phrases, Uint sentLength)
 {
+   const Uint num_threads = numPrecomputeThreads();
+   if (num_threads > 1) {
+      computePhrasePartialScoresInParallel(phrases, sentLength, num_threads);
+      return;
+   }
+
    for (Uint i = 0; i < sentLength; ++i) {
       for (int j = i; j >= 0; j--) {
          for ( vector<PhraseInfo*>::const_iterator it = phrases[j][i-j].begin();
@@ -645,6 +713,155 @@ void BasicModelGenerator::computePhrasePartialScores(
    }
 }
 
+namespace {
+   /// A unit of work for computePhrasePartialScoresInParallel(): the LM
+   /// heuristic of one LM, or one feature's precomputeFutureScore(), for
+   /// phrase options [begin, end).
+   struct PartialScoreTask {
+      bool is_lm;
+      Uint index;       ///< index in lms or decoder_features
+      Uint begin, end;
+      PartialScoreTask(bool is_lm, Uint index, Uint begin, Uint end)
+         : is_lm(is_lm), index(index), begin(begin), end(end) {}
+   };
+}
+
+void BasicModelGenerator::computePhrasePartialScoresInParallel(
+   vector<PhraseInfo *> **phrases, Uint sentLength, Uint num_threads)
+{
+   // All phrase options, in the order used by computePhrasePartialScores().
+   vector<PhraseInfo*> options;
+   for (Uint i = 0; i < sentLength; ++i)
+      for (int j = i; j >= 0; j--)
+         options.insert(options.end(), phrases[j][i-j].begin(), phrases[j][i-j].end());
+
+   // Filter features are cheap and no other feature may see a phrase they
+   // reject, so they are applied first, here.
+   vector<PhraseInfo*> kept;
+   kept.reserve(options.size());
+   for (Uint p = 0; p < options.size(); ++p) {
+      bool keep = true;
+      for (Uint k(0), k_end(filter_features.size()); keep && k < k_end; ++k)
+         if (filter_features[k]->precomputeFutureScore(*options[p]) < 0.0)
+            keep = false;
+      if (keep)
+         kept.push_back(options[p]);
+      else
+         options[p]->partial_score = -INFINITY;
+   }
+   const Uint num_kept = kept.size();
+   if (num_kept == 0) return;
+
+   // Storage for the raw LM and feature values, which get combined below.
+   vector<Uint> word_offset(num_kept + 1, 0);
+   for (Uint p = 0; p < num_kept; ++p)
+      word_offset[p+1] = word_offset[p] + kept[p]->phrase.size();
+   const Uint num_words = word_offset[num_kept];
+   const Uint num_lms = cubePruningLMHeuristic == LMH_NONE ? 0 : lms.size();
+   const Uint num_features = decoder_features.size();
+   vector<float> lm_probs(num_lms * num_words, 0.0);
+   vector<double> feature_scores(num_features * num_kept, 0.0);
+
+   // LMs and PRECOMPUTE_OWN_THREAD features get one task each, listed first
+   // since they are the longest ones; PRECOMPUTE_CONCURRENT features are split
+   // into chunks of consecutive source ranges; PRECOMPUTE_SERIAL features are
+   // handled after the parallel section.
+   vector<PartialScoreTask> tasks;
+   for (Uint j = 0; j < num_lms; ++j)
+      tasks.push_back(PartialScoreTask(true, j, 0, num_kept));
+   vector<Uint> concurrent_features, serial_features;
+   for (Uint k = 0; k < num_features; ++k) {
+      switch (decoder_features[k]->precomputeThreading()) {
+         case DecoderFeature::PRECOMPUTE_OWN_THREAD:
+            tasks.push_back(PartialScoreTask(false, k, 0, num_kept)); break;
+         case DecoderFeature::PRECOMPUTE_CONCURRENT:
+            concurrent_features.push_back(k); break;
+         default:
+            serial_features.push_back(k); break;
+      }
+   }
+   const Uint chunk_size = max(Uint(64), num_kept / (4 * num_threads) + 1);
+   for (Uint begin = 0; begin < num_kept; begin += chunk_size)
+      for (Uint f = 0; f < concurrent_features.size(); ++f)
+         tasks.push_back(PartialScoreTask(false, concurrent_features[f],
+                                          begin, min(begin + chunk_size, num_kept)));
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+   for (int t = 0; t < int(tasks.size()); ++t) {
+      const PartialScoreTask& task(tasks[t]);
+      if (task.is_lm) {
+         float* probs = &lm_probs[task.index * num_words];
+         for (Uint p = task.begin; p < task.end; ++p)
+            lmHeuristicProbs(task.index, kept[p]->phrase, probs + word_offset[p]);
+      } else {
+         DecoderFeature* feature = decoder_features[task.index];
+         double* scores = &feature_scores[task.index * num_kept];
+         for (Uint p = task.begin; p < task.end; ++p)
+            scores[p] = feature->precomputeFutureScore(*kept[p]);
+      }
+   }
+
+   for (Uint f = 0; f < serial_features.size(); ++f) {
+      const Uint k = serial_features[f];
+      for (Uint p = 0; p < num_kept; ++p)
+         feature_scores[k * num_kept + p] = decoder_features[k]->precomputeFutureScore(*kept[p]);
+   }
+
+   // Combine everything exactly as phrasePartialScore() does.
+   for (Uint p = 0; p < num_kept; ++p) {
+      PhraseInfo* phrase = kept[p];
+      double score = phrase->phrase_trans_prob;
+      score += phrase->forward_trans_prob;
+      score += phrase->adir_prob;
+
+      const Uint phrase_size = phrase->phrase.size();
+      double lmScore = 0;
+      if ( cubePruningLMHeuristic == LMH_UNIGRAM ) {
+         for ( Uint i(0); i < phrase_size; ++i )
+            for ( Uint k(0); k < num_lms; ++k )
+               lmScore += lm_probs[k * num_words + word_offset[p] + i] * lmWeightsV[k];
+      } else if ( cubePruningLMHeuristic == LMH_INCREMENTAL ||
+                  cubePruningLMHeuristic == LMH_SIMPLE ) {
+         for ( Uint j(0); j < num_lms; ++j ) {
+            const Uint num_probs = cubePruningLMHeuristic == LMH_INCREMENTAL ? phrase_size :
+               phrase_size + 1 > lms[j]->getOrder() ? phrase_size + 1 - lms[j]->getOrder() : 0;
+            for ( Uint i(0); i < num_probs; ++i )
+               lmScore += lm_probs[j * num_words + word_offset[p] + i] * lmWeightsV[j];
+         }
+      }
+      score += lmScore;
+
+      for (Uint k(0); k < num_features; ++k)
+         score += feature_scores[k * num_kept + p] * featureWeightsV[k];
+
+      phrase->partial_score = score;
+   }
+} // computePhrasePartialScoresInParallel
+
+void BasicModelGenerator::lmHeuristicProbs(Uint j, const Phrase& phrase, float probs[])
+{
+   const Uint phrase_size(phrase.size());
+   if ( cubePruningLMHeuristic == LMH_UNIGRAM ) {
+      for ( Uint i(0); i < phrase_size; ++i )
+         probs[i] = lms[j]->cachedWordProb(phrase[i], NULL, 0);
+   } else if ( cubePruningLMHeuristic == LMH_INCREMENTAL ||
+               cubePruningLMHeuristic == LMH_SIMPLE ) {
+      Uint reversed_phrase[phrase_size];
+      for ( Uint i(0); i < phrase_size; ++i )
+         reversed_phrase[i] = phrase[phrase_size - i - 1];
+      for ( Uint i(0); i < phrase_size; ++i ) {
+         // the simple heuristic ignores words with insufficient context
+         if ( cubePruningLMHeuristic == LMH_SIMPLE &&
+              i + lms[j]->getOrder() > phrase_size )
+            break;
+         probs[i] = lms[j]->cachedWordProb(reversed_phrase[i],
+                                           &(reversed_phrase[i+1]), phrase_size-i-1);
+      }
+   }
+}
+
 void BasicModelGenerator::displaySPI(const char* msg, PhraseInfo* pi) {
    cerr << "\t" << msg << " " << pi->src_words << " "
         << getStringPhrase(pi->phrase) << " "
@@ -662,66 +879,74 @@ void BasicModelGenerator::applyPhraseTablePruning(
    const double logThreshold = log(threshold);
    PhraseTable::PhraseScorePairLessThan pplt;
 
-   for (Uint i = 0; i < sentLength; ++i) {
-      for (int j = i; j >= 0; j--) {
-         vector<PhraseInfo*>& in_phrases(phrases[j][i-j]);
-         if (in_phrases.empty()) continue;
-
-         // If required, apply the -ttable-threshold pruning criterion
-         if (threshold) {
-            vector<PhraseInfo*> to_delete, kept_phrases;
-            to_delete.reserve(in_phrases.size());
-            kept_phrases.reserve(min(in_phrases.size(),32));
-            for (Uint k = 0; k < in_phrases.size(); ++k) {
-               PhraseInfo* pi = in_phrases[k];
-               if (pi->partial_score > logThreshold) {
-                  kept_phrases.push_back(pi);
-                  if (verbosity >= 4) displaySPI("Keeping(T)", pi);
-               } else {
-                  to_delete.push_back(pi);
-                  //if (verbosity >= 4) displaySPI("Discarding(T)", pi);
-               }
-            }
-            if (kept_phrases.empty()) {
-               // Make sure we don't filter everything out - in particular, we don't want to
-               // delete the no-trans phrase info added before this method is called.
-               vector<PhraseInfo*>::iterator top_phrase =
-                  std::max_element(in_phrases.begin(), in_phrases.end(), pplt);
-               assert(top_phrase != in_phrases.end());
-               kept_phrases.push_back(*top_phrase);
-               if (verbosity >= 4) displaySPI("No phrase passed threshold, keeping top candidate", *top_phrase);
-               // delete the rest here
-               *top_phrase = NULL; // make sure the one we keep does not get deleted
-               for (vector<PhraseInfo*>::iterator it = in_phrases.begin(); it < in_phrases.end(); ++it)
-                  delete *it;
+   // Each source range is pruned independently of the others.
+   vector<vector<PhraseInfo*>*> ranges;
+   for (Uint i = 0; i < sentLength; ++i)
+      for (int j = i; j >= 0; j--)
+         if (!phrases[j][i-j].empty())
+            ranges.push_back(&phrases[j][i-j]);
+
+   const Uint num_threads = numPrecomputeThreads();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads) if(num_threads > 1)
+#endif
+   for (int r = 0; r < int(ranges.size()); ++r) {
+      vector<PhraseInfo*>& in_phrases(*ranges[r]);
+
+      // If required, apply the -ttable-threshold pruning criterion
+      if (threshold) {
+         vector<PhraseInfo*> to_delete, kept_phrases;
+         to_delete.reserve(in_phrases.size());
+         kept_phrases.reserve(min(in_phrases.size(),32));
+         for (Uint k = 0; k < in_phrases.size(); ++k) {
+            PhraseInfo* pi = in_phrases[k];
+            if (pi->partial_score > logThreshold) {
+               kept_phrases.push_back(pi);
+               if (verbosity >= 4) displaySPI("Keeping(T)", pi);
             } else {
-               for (Uint k = 0; k < to_delete.size(); ++k)
-                  delete to_delete[k];
+               to_delete.push_back(pi);
+               //if (verbosity >= 4) displaySPI("Discarding(T)", pi);
             }
-            // Put the results on top of the original phrase list
-            in_phrases.swap(kept_phrases);
          }
+         if (kept_phrases.empty()) {
+            // Make sure we don't filter everything out - in particular, we don't want to
+            // delete the no-trans phrase info added before this method is called.
+            vector<PhraseInfo*>::iterator top_phrase =
+               std::max_element(in_phrases.begin(), in_phrases.end(), pplt);
+            assert(top_phrase != in_phrases.end());
+            kept_phrases.push_back(*top_phrase);
+            if (verbosity >= 4) displaySPI("No phrase passed threshold, keeping top candidate", *top_phrase);
+            // delete the rest here
+            *top_phrase = NULL; // make sure the one we keep does not get deleted
+            for (vector<PhraseInfo*>::iterator it = in_phrases.begin(); it < in_phrases.end(); ++it)
+               delete *it;
+         } else {
+            for (Uint k = 0; k < to_delete.size(); ++k)
+               delete to_delete[k];
+         }
+         // Put the results on top of the original phrase list
+         in_phrases.swap(kept_phrases);
+      }
 
-         // If required, apply the -ttable-limit pruning criterion
-         if (limit != NO_SIZE_LIMIT && in_phrases.size() > limit) {
-            vector<PhraseInfo*> kept_phrases;
-            kept_phrases.reserve(limit);
-            make_heap(in_phrases.begin(), in_phrases.end(), pplt);
-            for (Uint k = 0; k < limit; ++k)
-            {
-               PhraseInfo* pi = lazy::pop_heap(in_phrases, pplt);
-               if (verbosity >= 4) displaySPI("Keeping(L)", pi);
-               kept_phrases.push_back(pi);
-            }
-            // Delete the rest
-            for (Uint k = 0; k < in_phrases.size(); ++k) {
-               if (verbosity >= 4 && threshold) displaySPI("Discarding(L)", in_phrases[k]);
-               delete in_phrases[k];
-            }
-
-            // Put the results on top of the original phrase list
-            in_phrases.swap(kept_phrases);
+      // If required, apply the -ttable-limit pruning criterion
+      if (limit != NO_SIZE_LIMIT && in_phrases.size() > limit) {
+         vector<PhraseInfo*> kept_phrases;
+         kept_phrases.reserve(limit);
+         make_heap(in_phrases.begin(), in_phrases.end(), pplt);
+         for (Uint k = 0; k < limit; ++k)
+         {
+            PhraseInfo* pi = lazy::pop_heap(in_phrases, pplt);
+            if (verbosity >= 4) displaySPI("Keeping(L)", pi);
+            kept_phrases.push_back(pi);
          }
+         // Delete the rest
+         for (Uint k = 0; k < in_phrases.size(); ++k) {
+            if (verbosity >= 4 && threshold) displaySPI("Discarding(L)", in_phrases[k]);
+            delete in_phrases[k];
+         }
+
+         // Put the results on top of the original phrase list
+         in_phrases.swap(kept_phrases);
       }
    }
 }
@@ -854,7 +1079,7 @@ double BasicModelGenerator::phrasePartialScore(const PhraseInfo* phrase)
       for ( Uint i(0); i < phrase_size; ++i )
          reversed_phrase[i] = phrase->phrase[phrase_size - i - 1];
       for ( Uint j(0); j < lms.size(); ++j )
-         for ( Uint i(0); i < phrase_size - (lms[j]->getOrder()-1); ++i )
+         for ( Uint i(0); i + lms[j]->getOrder() <= phrase_size; ++i )
             lmScore += lms[j]->cachedWordProb(reversed_phrase[i],
                      &(reversed_phrase[i+1]), phrase_size-i-1)
                    * lmWeightsV[j];
@@ -899,10 +1124,17 @@ void BasicModelGenerator::getRawLM(
    vector<double> &lmVals,
    const PartialTranslation &trans)
 {
-   // this method is called millions of times, so keep this endPhrase buffer
-   // static, to avoid reallocating it constantly for nothing.
-   // caveat: as a consequence, this method is not re-entrant
-   static VectorPhrase endPhrase;
+   VectorPhrase endPhrase;
+   getRawLM(lmVals, trans, endPhrase);
+}
+
+void BasicModelGenerator::getRawLM(
+   vector<double> &lmVals,
+   const PartialTranslation &trans,
+   VectorPhrase &endPhrase)
+{
+   // this method is called millions of times, so the caller provides the
+   // endPhrase buffer, to avoid reallocating it constantly for nothing.
    endPhrase.clear();
 
    const Uint last_phrase_size = trans.lastPhrase->phrase.size();
@@ -1160,6 +1392,61 @@ void BasicModelGenerator::displayLMHits(ostream& out) {
    hits.display(out);
 }
 
+void BasicModelGenerator::enableMetrics()
+{
+   if (metrics) return;
+   vector<string> names;
+   for (Uint k = 0; k < decoder_features.size(); ++k)
+      names.push_back(decoder_features[k]->describeFeature());
+   metrics = new DecoderMetrics(names);
+}
+
+void BasicModelGenerator::getMetricsCounts(vector<Ulong>& lm_hits,
+      vector<DecoderMetrics::CacheCounts>& caches)
+{
+   PLM::Hits hits;
+   DecoderMetrics::CacheCounts lm_cache("lm");
+   for (Uint i = 0; i < lms.size(); ++i) {
+      hits += lms[i]->getHits();
+      Ulong h, l;
+      lms[i]->getCacheCounts(h, l);
+      lm_cache.hits += h;
+      lm_cache.lookups += l;
+   }
+   lm_hits.assign(hits.getValues().begin(), hits.getValues().end());
+
+   caches.clear();
+   caches.push_back(lm_cache);
+   Ulong h, l;
+   if (phraseTable->getTMCacheCounts(h, l))
+      caches.push_back(DecoderMetrics::CacheCounts("tppt", h, l));
+   if (phraseTable->getLDMCacheCounts(h, l))
+      caches.push_back(DecoderMetrics::CacheCounts("tpldm", h, l));
+   for (Uint k = 0; k < decoder_features.size(); ++k) {
+      if (decoder_features[k]->getCacheCounts(h, l))
+         caches.push_back(DecoderMetrics::CacheCounts(
+               decoder_features[k]->describeFeature(), h, l));
+   }
+}
+
+void BasicModelGenerator::startSentenceMetrics(Uint sent_id, Uint src_len)
+{
+   if (!metrics) return;
+   vector<Ulong> lm_hits;
+   vector<DecoderMetrics::CacheCounts> caches;
+   getMetricsCounts(lm_hits, caches);
+   metrics->startSentence(sent_id, src_len, lm_hits, caches);
+}
+
+void BasicModelGenerator::endSentenceMetrics()
+{
+   if (!metrics) return;
+   vector<Ulong> lm_hits;
+   vector<DecoderMetrics::CacheCounts> caches;
+   getMetricsCounts(lm_hits, caches);
+   metrics->endSentence(lm_hits, caches);
+}
+
 
 BasicModel::BasicModel(const newSrcSentInfo& info,
                        double **futureScore,
@@ -1219,13 +1506,12 @@ double BasicModel::scoreTranslation(const PartialTranslation &trans, Uint verbos
    }
 
    // LM score
-   static vector<double> lmVals;
-   lmVals.clear();
-   parent.getRawLM(lmVals, trans);
-   const double lmScore = dotProduct(lmVals, lmWeights, lmWeights.size());
+   lmValsScratch.clear();
+   parent.getRawLM(lmValsScratch, trans, endPhraseScratch);
+   const double lmScore = dotProduct(lmValsScratch, lmWeights, lmWeights.size());
    if (verbosity >= 3) {
       cerr << "\tlanguage model score  " << lmScore;
-      cerr << "  [ " << join(lmVals) << " ]" << endl;
+      cerr << "  [ " << join(lmValsScratch) << " ]" << endl;
    }
 
    // (Backward) translation model score
@@ -1340,13 +1626,109 @@ double BasicModel::computePartialFutureScore(const PartialTranslation &trans)
    return precomputedScore + ffPartialFutureScore;
 } // computePartialFutureScore
 
+void BasicModel::scoreAndFutureScore(const PartialTranslation &trans,
+      double &score, double &dFutureScore, Uint verbosity)
+{
+   // The verbose output is produced by the separate functions.
+   if (verbosity >= 3) {
+      score = scoreTranslation(trans, verbosity);
+      dFutureScore = computeFutureScore(trans);
+      return;
+   }
+
+   assert(trans.lastPhrase != NULL);
+   assert(trans.back != NULL);
+   assert(trans.back->lastPhrase != NULL);
+
+   // Filter feature scores - done first because if the result is negative,
+   // the score is -INFINITY and we skip the rest of the scoring.
+   for (Uint k(0), k_end(parent.filter_features.size()); k < k_end; ++k) {
+      if (parent.filter_features[k]->score(trans) < 0.0) {
+         if (c->minimizeLmContextSize) trans.setLmContextSize(0);
+         score = -INFINITY;
+         dFutureScore = computeFutureScore(trans);
+         return;
+      }
+   }
+
+   // Other features: score, future score and recombination hash, in one pass
+   double ffScore = 0;
+   double ffFutureScore = 0;
+   Uint featureRecombHash = 0;
+   DecoderFeature::Evaluation eval;
+   // With metrics enabled, time each step from the end of the previous one.
+   DecoderMetrics* const metrics = parent.metrics;
+   double start = metrics ? DecoderMetrics::now() : 0;
+   for (Uint k = 0, k_end = parent.decoder_features.size(); k < k_end; ++k) {
+      DecoderFeature* f = parent.decoder_features[k];
+      switch (parent.decoder_feature_dispatch[k]) {
+         case BasicModelGenerator::DISPATCH_LENGTH:
+            static_cast<LengthFeature*>(f)->LengthFeature::evaluate(trans, eval);
+            break;
+         case BasicModelGenerator::DISPATCH_WORD_DISPLACEMENT:
+            static_cast<WordDisplacement*>(f)->WordDisplacement::evaluate(trans, eval);
+            break;
+         default:
+            f->evaluate(trans, eval);
+      }
+      ffScore += eval.score * featureWeights[k];
+      ffFutureScore += eval.futureScore * featureWeights[k];
+      featureRecombHash = (featureRecombHash + eval.recombHash) * 17;
+      if (metrics) {
+         const double end = DecoderMetrics::now();
+         metrics->features[k].add(end - start);
+         start = end;
+      }
+   }
+   trans.featureRecombHash = featureRecombHash;
+   trans.featureRecombHashSet = true;
+
+   // LM score
+   lmValsScratch.clear();
+   parent.getRawLM(lmValsScratch, trans, endPhraseScratch);
+   const double lmScore = dotProduct(lmValsScratch, lmWeights, lmWeights.size());
+   if (metrics) {
+      const double end = DecoderMetrics::now();
+      metrics->lms.add(end - start);
+      start = end;
+   }
+
+   // Translation model scores
+   const double transScore = parent.dotProductTrans(trans);
+   const double forwardScore = parent.dotProductForwardTrans(trans);
+   const double adirScore = parent.dotProductAdirTrans(trans);
+   if (metrics)
+      metrics->tms.add(DecoderMetrics::now() - start);
+
+   score = transScore + forwardScore + adirScore + lmScore + ffScore;
+
+   // Future score, as in computeFutureScore()
+   for (Uint k(0), k_end(parent.filter_features.size()); k < k_end; ++k) {
+      if (parent.filter_features[k]->futureScore(trans) < 0.0) {
+         dFutureScore = -INFINITY;
+         return;
+      }
+   }
+
+   double precomputedScore = 0;
+   for (UintSet::const_iterator it = trans.sourceWordsNotCovered.begin(); it !=
+         trans.sourceWordsNotCovered.end(); it++)
+      precomputedScore += futureScore[it->start][it->end - it->start - 1];
+
+   // Let computeFutureScore() report any illegal non-zero future score
+   if (trans.sourceWordsNotCovered.empty() && ffFutureScore != 0.0)
+      dFutureScore = computeFutureScore(trans);
+   else
+      dFutureScore = precomputedScore + ffFutureScore;
+} // scoreAndFutureScore
+
 Uint BasicModel::computeRecombHash(const PartialTranslation &trans)
 {
    // This might overflow result, but who cares.
    Uint result = 0;
-   // make this endPhrase static so we don't have to reallocate this vector
-   // millions of times.  (this method gets called ridiculously often...)
-   static VectorPhrase endPhrase;
+   // reuse the endPhraseScratch buffer so we don't have to reallocate this
+   // vector millions of times.  (this method gets called ridiculously often...)
+   VectorPhrase& endPhrase(endPhraseScratch);
    endPhrase.clear();
    if (c->minimizeLmContextSize) {
       assert(trans.isLmContextSizeSet() && "lm context size not properly initialized before calling computeRecombHash()");
@@ -1374,10 +1756,17 @@ Uint BasicModel::computeRecombHash(const PartialTranslation &trans)
       result *= 17;
    }
 
-   for (vector<DecoderFeature *>::iterator it = parent.decoder_features.begin();
-         it != parent.decoder_features.end(); ++it) {
-      result += (*it)->computeRecombHash(trans);
-      result *= 17;
+   // Since the hash is updated as result = (result + hash_k) * 17, the
+   // decoder features' part cached by scoreAndFutureScore() is combined as
+   // result * 17^n + featureRecombHash.
+   if (trans.featureRecombHashSet) {
+      result = result * parent.feature_recomb_hash_factor + trans.featureRecombHash;
+   } else {
+      for (vector<DecoderFeature *>::iterator it = parent.decoder_features.begin();
+            it != parent.decoder_features.end(); ++it) {
+         result += (*it)->computeRecombHash(trans);
+         result *= 17;
+      }
    }
 
    for (vector<DecoderFeature *>::iterator it = parent.filter_features.begin();
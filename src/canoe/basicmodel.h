@@ -22,6 +22,7 @@
 #include "phrasetable.h"
 #include "distortionmodel.h"
 #include "decoder_feature.h"
+#include "decoder_metrics.h"
 #include "config_io.h"
 #include "vocab_filter.h"
 #include "marked_translation.h"
@@ -116,6 +117,29 @@ namespace Portage
       virtual void computePhrasePartialScores(vector<PhraseInfo *> **phrases,
             Uint sentLength);
 
+      /**
+       * Same as computePhrasePartialScores(), with num_threads threads.
+       * Each LM, and each decoder feature that requires it, gets all its
+       * queries for the sentence on one thread; the other features are split
+       * across source ranges.  The results are identical to the serial
+       * version's since every partial score is summed in the same order.
+       */
+      void computePhrasePartialScoresInParallel(vector<PhraseInfo *> **phrases,
+            Uint sentLength, Uint num_threads);
+
+      /**
+       * Heuristic LM log probs of the words of phrase according to lms[j],
+       * in the order in which phrasePartialScore() adds them up.
+       * @param j       index of the LM
+       * @param phrase  target phrase
+       * @param probs   output: one value per word of phrase
+       */
+      void lmHeuristicProbs(Uint j, const Phrase& phrase, float probs[]);
+
+      /// Number of threads to use for the per-sentence precomputations:
+      /// always 1 without OpenMP or at verbosity 4 and more.
+      Uint numPrecomputeThreads() const;
+
       /// Verbose logging helper for applyPhraseTablePruning
       /// SPI stands for scored phrase info.
       void displaySPI(const char* msg, PhraseInfo* pi);
@@ -218,6 +242,34 @@ namespace Portage
        */
       vector<DecoderFeature*> filter_features;
 
+      /**
+       * How BasicModel calls evaluate() on each decoder feature: the common
+       * word penalty and word displacement features are called directly,
+       * without virtual dispatch; all others through DecoderFeature.
+       */
+      enum FeatureDispatch {
+         DISPATCH_VIRTUAL,
+         DISPATCH_LENGTH,
+         DISPATCH_WORD_DISPLACEMENT
+      };
+
+      /// Dispatch type for each element of decoder_features
+      vector<FeatureDispatch> decoder_feature_dispatch;
+
+      /**
+       * 17^decoder_features.size() (mod 2^32): combines a cached
+       * PartialTranslation::featureRecombHash with the rest of the hash in
+       * BasicModel::computeRecombHash().
+       */
+      Uint feature_recomb_hash_factor;
+
+      /// Per-sentence performance metrics, if enabled by enableMetrics()
+      DecoderMetrics* metrics;
+
+      /// Cumulative LM n-gram hits and cache counts, for metrics
+      void getMetricsCounts(vector<Ulong>& lm_hits,
+                            vector<DecoderMetrics::CacheCounts>& caches);
+
       /**
        * The language model(s)
        */
@@ -308,6 +360,15 @@ namespace Portage
        */
       virtual void getRawLM(vector<double> &lmVals,
             const PartialTranslation &trans);
+      /**
+       * @brief Get raw language models probabilities, using the caller's
+       *        scratch buffer, so that concurrent calls are safe.
+       * @param lmVals        vector to which will be appended the probs
+       * @param trans         partial translation to score
+       * @param endPhrase     scratch buffer for the words queried
+       */
+      void getRawLM(vector<double> &lmVals,
+            const PartialTranslation &trans, VectorPhrase &endPhrase);
       /**
        * @brief Get raw translation models probabilities
        * @param transVals     vector to which will be appended the probs
@@ -416,6 +477,9 @@ namespace Portage
        */
       bool vocab_read_from_TPPTs;
 
+      /// Number of sentences in the current document, in -doc-mode
+      Uint doc_sents;
+
       friend class BasicModel;
    public:
       /**
@@ -568,6 +632,12 @@ namespace Portage
       virtual BasicModel *createModel(newSrcSentInfo& new_src_sent_info,
             bool alwaysTryDefault = false);
 
+      /**
+       * Start a new document, in -doc-mode: clear the caches that
+       * createModel() keeps across the sentences of a document.
+       */
+      void newDocument();
+
       /**
        * Gets a reference to the phrase table object of this model.
        * @return the phrase table.
@@ -629,6 +699,24 @@ namespace Portage
       /// @param out  where to display the hits
       void displayLMHits(ostream& out = cerr);
 
+      /// Start collecting per-sentence performance metrics; see
+      /// decoder_metrics.h.
+      void enableMetrics();
+
+      /// Metrics being collected, or NULL if enableMetrics() wasn't called.
+      DecoderMetrics* getMetrics() { return metrics; }
+
+      /**
+       * Reset the metrics for a new sentence, if enabled; call before
+       * createModel().
+       * @param sent_id  external source sentence id
+       * @param src_len  source sentence length
+       */
+      void startSentenceMetrics(Uint sent_id, Uint src_len);
+
+      /// Finalize the metrics for the current sentence, if enabled.
+      void endSentenceMetrics();
+
    }; // BasicModelGenerator
 
    /// Decoder model for one sentence.
@@ -678,6 +766,11 @@ namespace Portage
       /// Model generator which was used to create this model instance
       BasicModelGenerator &parent;
 
+      /// Scratch buffers: per model rather than static, so that models for
+      /// different sentences can be used in different threads.
+      vector<double> lmValsScratch;
+      VectorPhrase endPhraseScratch;
+
    protected:
       /**
        * @brief Constructor, creates a BasicModel.
@@ -721,6 +814,9 @@ namespace Portage
       /// Get the max LM order in effect currently
       Uint getLMNumWords() { return parent.lm_numwords; }
 
+      /// Per-sentence performance metrics, or NULL if not enabled.
+      DecoderMetrics* getMetrics() { return parent.metrics; }
+
       /**
        * Get the target sentence
        * @return pointer to target sentence of available, NULL otherwise.
@@ -768,6 +864,15 @@ namespace Portage
        */
       virtual double computePartialFutureScore(const PartialTranslation &trans);
 
+      /**
+       * Score trans and estimate its future score, with a single pass over
+       * the decoder features using DecoderFeature::evaluate().  Also caches
+       * the decoder features' contribution to computeRecombHash(trans).
+       * Equivalent to calling scoreTranslation() and computeFutureScore().
+       */
+      virtual void scoreAndFutureScore(const PartialTranslation &trans,
+            double &score, double &futureScore, Uint verbosity = 1);
+
       /// See BasicModelGenerator::rangePartialScore() for documentation
       double rangePartialScore(const PartialTranslation& trans) {
          return parent.rangePartialScore(trans);
@@ -52,6 +52,10 @@ public:
    virtual void finalizeInitialization(); // the real loading is done here, since we need TMs first
    virtual void newSrcSent(const newSrcSentInfo& info);
    virtual double precomputeFutureScore(const PhraseInfo& phrase_info);
+   // Queries bilm, which this feature does not share.
+   virtual PrecomputeThreading precomputeThreading() const {
+      return PRECOMPUTE_OWN_THREAD;
+   }
    virtual double futureScore(const PartialTranslation &trans);
    virtual double score(const PartialTranslation& pt);
    virtual double partialScore(const PartialTranslation &trans);
@@ -0,0 +1,132 @@
+/**
+ * @file canoe-dispatcher.cc
+ * @brief Translate one input with many long-lived canoe workers.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "sentence_dispatcher.h"
+#include "file_utils.h"
+#include "arg_reader.h"
+#include "printCopyright.h"
+#include "exception_dump.h"  // MAIN
+#include <unistd.h>          // gethostname()
+
+using namespace Portage;
+using namespace std;
+
+static char help_message[] = "\n\
+canoe-dispatcher [options] [INFILE [OUTFILE]]\n\
+\n\
+  Translate INFILE [-] with canoe workers, writing the 1-best translations\n\
+  to OUTFILE [-] in input order.  The workers are canoe processes started\n\
+  with -dispatcher HOST:PORT, locally with -n and -cmd, or on any node that\n\
+  can reach this one, e.g., by canoe-parallel.sh -dispatch.  Each worker\n\
+  loads its models once, then translates batches of sentences until the end\n\
+  of the input; workers may join or leave at any time.\n\
+\n\
+  The other outputs requested by the workers' configuration (n-best lists,\n\
+  ffvals, sfvals, pal and lattices) are written by the dispatcher, in input\n\
+  order, to the files canoe would write in -append mode.\n\
+\n\
+  Batches are sized by source tokens: each gets about 1/(2W) of the tokens not\n\
+  yet dispatched to W workers, so batches get smaller towards the end of the\n\
+  input.  Once all the input is dispatched, idle workers get a second copy of\n\
+  the oldest unfinished batch, so a slow worker does not hold up the job.\n\
+\n\
+Options:\n\
+\n\
+  -v             Write progress reports to cerr.\n\
+  -n N           Start N local workers [0].\n\
+  -cmd CMD       canoe command for the local workers, e.g., \"canoe -f\n\
+                 canoe.ini\"; \" -dispatcher localhost:PORT\" is appended to\n\
+                 it [canoe -f canoe.ini].\n\
+  -port P        Listen on TCP port P [0: any free port].\n\
+  -port-file F   Write HOST:PORT to F once listening, for remote workers.\n\
+  -min-tokens T  Minimum batch size, in source tokens [1].\n\
+  -max-tokens T  Maximum batch size, in source tokens [500].\n\
+  -reissue-after S  Only reissue batches issued at least S seconds ago [0].\n\
+  -no-reissue    Never give a batch to more than one worker at a time.\n\
+";
+
+static bool verbose = false;
+static Uint num_local = 0;
+static string cmd = "canoe -f canoe.ini";
+static Uint port = 0;
+static string port_file;
+static SentenceDispatcher::Options opts;
+static string infile("-");
+static string outfile("-");
+static void getArgs(int argc, const char* const argv[]);
+
+int MAIN(argc, argv)
+{
+   printCopyright(2026, "canoe-dispatcher");
+   getArgs(argc, argv);
+
+   vector<string> sents;
+   {
+      iSafeMagicStream in(infile);
+      string line;
+      while (getline(in, line))
+         sents.push_back(line);
+   }
+   oSafeMagicStream out(outfile);
+   if (sents.empty()) return 0;
+   if (verbose) cerr << "Read " << sents.size() << " sentences from " << infile << endl;
+
+   SentenceDispatcher dispatcher(sents, opts);
+   port = dispatcher.listen(port);
+   if (!port_file.empty()) {
+      char hostname[256] = "";
+      gethostname(hostname, sizeof(hostname) - 1);
+      // Write then rename, so that whoever waits for it never reads half a file.
+      const string tmp = port_file + ".tmp";
+      {
+         oSafeMagicStream pf(tmp);
+         pf << hostname << ":" << port << endl;
+      }
+      if (rename(tmp.c_str(), port_file.c_str()) != 0)
+         error(ETFatal, "Can't create %s", port_file.c_str());
+   }
+   if (verbose) cerr << "Listening on port " << port << endl;
+   if (num_local > 0)
+      dispatcher.startLocalWorkers(num_local, cmd);
+
+   dispatcher.run(out);
+   return 0;
+}
+END_MAIN
+
+// arg processing
+
+void getArgs(int argc, const char* const argv[])
+{
+   const char* switches[] = {"v", "n:", "cmd:", "port:", "port-file:",
+                             "min-tokens:", "max-tokens:", "reissue-after:",
+                             "no-reissue"};
+   ArgReader arg_reader(ARRAY_SIZE(switches), switches, 0, 2, help_message);
+   arg_reader.read(argc-1, argv+1);
+
+   arg_reader.testAndSet("v", verbose);
+   opts.verbose = verbose;
+   arg_reader.testAndSet("n", num_local);
+   arg_reader.testAndSet("cmd", cmd);
+   arg_reader.testAndSet("port", port);
+   arg_reader.testAndSet("port-file", port_file);
+   arg_reader.testAndSet("min-tokens", opts.minBatchTokens);
+   arg_reader.testAndSet("max-tokens", opts.maxBatchTokens);
+   arg_reader.testAndSet("reissue-after", opts.reissueAfter);
+   opts.reissue = !arg_reader.getSwitch("no-reissue");
+   arg_reader.testAndSet(0, "infile", infile);
+   arg_reader.testAndSet(1, "outfile", outfile);
+
+   if (opts.minBatchTokens > opts.maxBatchTokens)
+      error(ETFatal, "-min-tokens must not exceed -max-tokens");
+   if (port > 65535)
+      error(ETFatal, "-port must be at most 65535");
+}
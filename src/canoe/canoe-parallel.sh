@@ -67,7 +67,16 @@ Options:
                 reads all input sentences, but defers to a demon to get one
                 sentence ID to translate at a time.
 
-  -no-lb        Disable all load balancing: negates -lb and -lb-by-sent.
+  -dispatch     Run with canoe-dispatcher: N long-lived canoe workers load
+                their models once, then receive batches of sentences over TCP,
+                sized by sentence length and smaller towards the end of the
+                input; batches of slow or lost workers are reissued.  The
+                dispatcher writes all outputs in order as they come back, as
+                with canoe -append, so nothing is merged at the end; with
+                -nbest or -lattice, -append is therefore required.
+
+  -no-lb        Disable all load balancing: negates -lb, -lb-by-sent and
+                -dispatch.
                 Split input into roughly equal-sized contiguous blocks.
 
                 [-lb-by-sent, but -no-lb if -f or canoe -append is used.]
@@ -149,12 +158,14 @@ SAVE_ARGS="$@"
 REF=
 LOAD_BALANCING=default
 RESUME=
+DISPATCHER_PID=
 while [ $# -gt 0 ]; do
    case "$1" in
    -noc|-nocluster)RUN_PARALLEL_OPTS="$RUN_PARALLEL_OPTS -nocluster";;
    -resume)        arg_check 1 $# $1; RESUME=$2; shift;;
    -lb)            LOAD_BALANCING=byblock;;
    -lb-by-sent)    LOAD_BALANCING=bysent;;
+   -dispatch)      LOAD_BALANCING=dispatch;;
    -no-lb)         LOAD_BALANCING=;;
    -ref)           arg_check 1 $# $1; REF=$2; shift;;
    -n|-num)        arg_check 1 $# $1; NUM=$2; shift;;
@@ -210,6 +221,14 @@ if [[ $VERBOSE == 1 && $LOAD_BALANCING == bysent ]]; then
    RUN_PARALLEL_OPTS="$RUN_PARALLEL_OPTS -quiet-daemon"
 fi
 
+[[ $LOAD_BALANCING == dispatch && $RESUME ]] &&
+   error_exit "-resume is not supported with -dispatch."
+NBEST_OR_LATTICE_RE='(^| )-(nbest|lattice) '
+[[ $LOAD_BALANCING == dispatch && ! $APPEND &&
+   "${CANOEOPTS[*]}" =~ $NBEST_OR_LATTICE_RE ]] &&
+   error_exit "-dispatch with -nbest or -lattice requires -append:" \
+              "the dispatcher writes each of those outputs as a single file."
+
 # EJJ This breaks the resume mode, but is necessary on the GPSC to avoid file
 # name clashes between different jobs running in similarly-initialized
 # containers
@@ -255,6 +274,8 @@ if [[ $VERBOSE -gt 0 ]]; then
    echo "" >&2
    if [[ $LOAD_BALANCING == bysent ]]; then
       echo "Using by-sentence load balancing" >&2
+   elif [[ $LOAD_BALANCING == dispatch ]]; then
+      echo "Using canoe-dispatcher" >&2
    elif [[ $LOAD_BALANCING ]]; then
       echo "Using load balancing" >&2
    else
@@ -417,6 +438,26 @@ function full_translation
             debug "LB canoe cmd: $CMD"
             echo "test -f $CANOE_INPUT.done || ($CMD && mv $CANOE_INPUT ${CANOE_INPUT}.done)"
          done > $CMDS_FILE
+      elif [[ $LOAD_BALANCING == dispatch ]]; then
+         # The dispatcher holds the input and writes all the outputs; the
+         # workers only need to know where to find it.
+         PORT_FILE=$WORK_DIR/dispatcher.port
+         DISPATCHER_CMD="canoe-dispatcher -port-file $PORT_FILE"
+         [[ $VERBOSE -gt 1 ]] && DISPATCHER_CMD="$DISPATCHER_CMD -v"
+         debug "dispatcher cmd: $DISPATCHER_CMD"
+         $DISPATCHER_CMD $INPUT $WORK_DIR/out.dispatcher 2> $WORK_DIR/err.dispatcher &
+         DISPATCHER_PID=$!
+         while [[ ! -s $PORT_FILE ]]; do
+            kill -0 $DISPATCHER_PID 2> /dev/null ||
+               error_exit "canoe-dispatcher failed; see $WORK_DIR/err.dispatcher."
+            sleep 1
+         done
+         DISPATCHER=`cat $PORT_FILE`
+         for (( i = 0 ; i < $NUM ; ++i )); do
+            CMD="time $CANOE ${CONFIGARG[@]} $APPEND -dispatcher $DISPATCHER"
+            test -n "$REF" && CMD="$CMD -ref $REF"
+            echo "$CMD > $WORK_DIR/out.$i 2> $WORK_DIR/err.$i"
+         done > $CMDS_FILE
       else
          # load balancing sentence by sentence
          seq 0 $((INPUT_LINES - 1)) > $CMDS_FILE
@@ -551,6 +592,15 @@ else
    eval run-parallel.sh $RUN_PARALLEL_OPTS $CMDS_FILE $PARNUM
 fi
 RC=$?
+if [[ $DISPATCHER_PID ]]; then
+   # The workers exit once the dispatcher has all the outputs.
+   if (( $RC != 0 )); then
+      kill $DISPATCHER_PID 2> /dev/null
+   else
+      wait $DISPATCHER_PID
+      RC=$?
+   fi
+fi
 if (( $RC != 0 )); then
    echo "problems with run-parallel.sh(RC=$RC) - quitting!" >&2
    echo "The temp output files will not be merged or deleted to give" \
@@ -560,7 +610,10 @@ fi
 
 
 # Reassemble the program's STDOUT
-if [[ $LOAD_BALANCING ]]; then
+if [[ $LOAD_BALANCING == dispatch ]]; then
+   cat $WORK_DIR/out.dispatcher
+   TOTAL_LINES_OUTPUT=`wc -l < $WORK_DIR/out.dispatcher`
+elif [[ $LOAD_BALANCING ]]; then
    # Sort translation by src sent id and then remove id
    echo "Rebuilding STDOUT" >&2
    time { cat $WORK_DIR/out.* | sort -n | cut -f2; }
@@ -603,8 +656,9 @@ if [ $TOTAL_LINES_OUTPUT -ne $INPUT_LINES ]; then
 fi
 
 
-# Merging output chunks (nbest, ffvals, sfvals, pal, and lattice)
-if [ -n "$APPEND" ]; then
+# Merging output chunks (nbest, ffvals, sfvals, pal, and lattice); the
+# dispatcher already wrote them in order.
+if [ -n "$APPEND" ] && [[ $LOAD_BALANCING != dispatch ]]; then
    FFVALS_CREATED=`echo ${CANOEOPTS[*]} | egrep -oe '-ffvals'`
    SFVALS_CREATED=`echo ${CANOEOPTS[*]} | egrep -oe '-sfvals'`
    PAL_CREATED=`echo ${CANOEOPTS[*]} | egrep -oe '-palign' -e '-t ' -e '-trace'`
@@ -34,6 +34,7 @@
 #include "str_utils.h"
 #include "simple_overlay.h"
 #include "socket_utils.h"
+#include "sentence_dispatcher.h"
 #include "tpt_error.h"
 #include <boost/optional/optional.hpp>
 #include <cstring>
@@ -107,44 +108,59 @@ class IFileInfo : private NonCopyable {
          f_lattice_state = NULL;
       }
 
+      /// Whether outputs are written to files, which doOutput() can check.
+      virtual bool onDisk() const { return true; }
+
+      /// Output file specification for the nbest list, through nbestProcessor
+      /// if there is one.
+      string nbestSpec() const {
+         if (c.nbestProcessor.empty())
+            return s_nbest;
+         return "| " + c.nbestProcessor
+                + (isSuffix(".gz", s_nbest) ? "| gzip > " : ">")
+                + s_nbest;
+      }
+
       /// Did the user request a single file
       /// @return Returns true if the user requested one file
-      oSafeMagicStream* nbest() {
-         if (f_nbest == NULL) {
-            if (!c.nbestProcessor.empty()) {
-               const string filename =
-                  "| "
-                  + c.nbestProcessor
-                  + (isSuffix(".gz", s_nbest) ? "| gzip > " : ">")
-                  + s_nbest;
-               f_nbest = new oSafeMagicStream(filename);
-            }
-            else {
-               f_nbest = new oSafeMagicStream(s_nbest);
-            }
-         }
+      virtual ostream* nbest() {
+         if (f_nbest == NULL) f_nbest = new oSafeMagicStream(nbestSpec());
          return f_nbest;
       }
-      oSafeMagicStream* ffvals() {
+      virtual ostream* ffvals() {
          if (c.ffvals && f_ffvals == NULL) f_ffvals = new oSafeMagicStream(s_ffvals);
          return f_ffvals;
       }
-      oSafeMagicStream* sfvals() {
+      virtual ostream* sfvals() {
          if (c.sfvals && f_sfvals == NULL) f_sfvals = new oSafeMagicStream(s_sfvals);
          return f_sfvals;
       }
-      oSafeMagicStream* pal() {
+      virtual ostream* pal() {
          if (c.trace && f_pal == NULL) f_pal = new oSafeMagicStream(s_pal);
          return f_pal;
       }
-      oSafeMagicStream* lattice() {
+      virtual ostream* lattice() {
          if (c.latticeOut && f_lattice == NULL) f_lattice = new oSafeMagicStream(s_lattice);
          return f_lattice;
       }
-      oSafeMagicStream* lattice_state() {
+      virtual ostream* lattice_state() {
          if (c.latticeOut && f_lattice_state == NULL) f_lattice_state = new oSafeMagicStream(s_lattice_state);
          return f_lattice_state;
       }
+
+   protected:
+      /// Set the file names used in -append mode.
+      void setAppendNames() {
+         ostringstream ext;
+         ext << "." << c.nbestSize << "best";
+         s_nbest  = addExtension(c.nbestFilePrefix, ext.str());
+         s_ffvals = addExtension(s_nbest, ".ffvals");
+         s_sfvals = addExtension(s_nbest, ".sfvals");
+         s_pal    = addExtension(s_nbest, ".pal");
+
+         s_lattice       = c.latticeFilePrefix;
+         s_lattice_state = addExtension(s_lattice, ".state");
+      }
 };
 
 class OneFileInfo : public IFileInfo {
@@ -161,16 +177,68 @@ class OneFileInfo : public IFileInfo {
       , append(c.bAppendOutput)
       {
          assert(append);
+         setAppendNames();
+      }
+};
 
-         ostringstream ext;
-         ext << "." << c.nbestSize << "best";
-         s_nbest  = addExtension(c.nbestFilePrefix, ext.str());
-         s_ffvals = addExtension(s_nbest, ".ffvals");
-         s_sfvals = addExtension(s_nbest, ".sfvals");
-         s_pal    = addExtension(s_nbest, ".pal");
 
-         s_lattice       = c.latticeFilePrefix;
-         s_lattice_state = addExtension(s_lattice, ".state");
+/**
+ * Outputs of a canoe -dispatcher worker: the outputs of each batch, including
+ * canoe's standard output, are collected in memory and sent back to the
+ * dispatcher, which writes them to the -append mode files.
+ */
+class DispatchFileInfo : public IFileInfo {
+      ostringstream streams[SentenceDispatch::NUM_STREAMS];
+      streambuf* coutBuf;  ///< cout's buffer, restored by the destructor
+
+   public:
+      /**
+       * Default constructor.
+       * @param  c  canoe config to get the file names.
+       */
+      DispatchFileInfo(const CanoeConfig& c)
+      : IFileInfo(c)
+      {
+         setAppendNames();
+         coutBuf = cout.rdbuf(streams[SentenceDispatch::OUT].rdbuf());
+      }
+      virtual ~DispatchFileInfo() {
+         cout.rdbuf(coutBuf);
+      }
+
+      virtual bool onDisk() const { return false; }
+
+      virtual ostream* nbest()         { return &streams[SentenceDispatch::NBEST]; }
+      virtual ostream* ffvals()        { return &streams[SentenceDispatch::FFVALS]; }
+      virtual ostream* sfvals()        { return &streams[SentenceDispatch::SFVALS]; }
+      virtual ostream* pal()           { return &streams[SentenceDispatch::PAL]; }
+      virtual ostream* lattice()       { return &streams[SentenceDispatch::LATTICE]; }
+      virtual ostream* lattice_state() { return &streams[SentenceDispatch::LATTICE_STATE]; }
+
+      /// Files the dispatcher is to write, for the outputs canoe produces.
+      vector<string> files() const {
+         vector<string> f(SentenceDispatch::NUM_STREAMS);
+         if (c.nbestOut) {
+            f[SentenceDispatch::NBEST] = nbestSpec();
+            if (c.ffvals) f[SentenceDispatch::FFVALS] = s_ffvals;
+            if (c.sfvals) f[SentenceDispatch::SFVALS] = s_sfvals;
+            if (c.trace)  f[SentenceDispatch::PAL] = s_pal;
+         }
+         if (c.latticeOut) {
+            f[SentenceDispatch::LATTICE] = s_lattice;
+            if (c.latticeOutputOptions == "carmel")
+               f[SentenceDispatch::LATTICE_STATE] = s_lattice_state;
+         }
+         return f;
+      }
+
+      /// Move the outputs collected so far into outputs.
+      void takeOutputs(vector<string>& outputs) {
+         outputs.resize(SentenceDispatch::NUM_STREAMS);
+         for (Uint k = 0; k < SentenceDispatch::NUM_STREAMS; ++k) {
+            outputs[k] = streams[k].str();
+            streams[k].str("");
+         }
       }
 };
 
@@ -510,7 +578,7 @@ static string doOutput(HypothesisStack &h,
          }
       }
 
-      for (Uint i(0); i<openedFile.size(); ++i) {
+      for (Uint i(0); i<openedFile.size() && file_info.onDisk(); ++i) {
          if (!check_if_exists(openedFile[i])) {
             error(ETWarn, "Looks like %s wasn't written on disk at iter %d/%d",
                   openedFile[i].c_str(), iteration+1, maxTries);
@@ -791,7 +859,11 @@ int MAIN(argc, argv)
    // If the user request a single file, this object will keep track of the
    // required files
    IFileInfo* file_info = NULL;
-   if (c.bAppendOutput) {
+   DispatchFileInfo* dispatch_info = NULL;
+   if (!c.dispatcher.empty()) {
+      file_info = dispatch_info = new DispatchFileInfo(c);
+   }
+   else if (c.bAppendOutput) {
       file_info = new OneFileInfo(c);
    }
    else {
@@ -857,7 +929,12 @@ int MAIN(argc, argv)
                 : "Forced decoding cannot work without!");
       ref.safe_open(c.refFile);
 
-      if (!c.loadFirst && !c.describeModelOnly)
+      if (dispatch_info)
+      {
+         // Workers get sentences out of order, so they need all the references.
+         readRefSentences(ref, tgt_sents);
+      }
+      else if (!c.loadFirst && !c.describeModelOnly)
       {
          // Read reference (target) sentences.
          readRefSentences(ref, tgt_sents);
@@ -893,10 +970,24 @@ int MAIN(argc, argv)
       readFileLines(c.sentWeights, sent_weights);
 
 
+   // In worker mode, connect once the models are loaded, to get work.
+   DispatchWorker* worker = NULL;
+   if (dispatch_info)
+      worker = new DispatchWorker(c.dispatcher, dispatch_info->files());
+   string batch;              ///< current batch, in worker mode
+   istringstream batchIn;     ///< stream to parse batch
+   InputParser* batchReader = NULL;
+
    oSafeMagicStream* nssiStream = NULL;     ///< Stream to write the newSrcSentInfo;
    if (!c.nssiFilename.empty())
       nssiStream = new oSafeMagicStream(c.nssiFilename);
 
+   oSafeMagicStream* metricsStream = NULL;     ///< Stream to write per-sentence performance metrics;
+   if (!c.metricsFilename.empty()) {
+      metricsStream = new oSafeMagicStream(c.metricsFilename);
+      gen->enableMetrics();
+   }
+
    oSafeMagicStream* triangularArrayAsCPTStream = NULL;     ///< Stream to write the triangular array as a CPT;
    if (!c.triangularArrayFilename.empty())
       triangularArrayAsCPTStream = new oSafeMagicStream(c.triangularArrayFilename);
@@ -954,11 +1045,35 @@ int MAIN(argc, argv)
                ++save_i;
             }
          }
-         nss = reader.getMarkedSent();
+         if (worker) {
+            // Next sentence of the current batch; at the end of a batch,
+            // send its outputs and get the next one.
+            while (!(batchReader && (nss = batchReader->getMarkedSent()))) {
+               if (batchReader) {
+                  vector<string> outputs;
+                  dispatch_info->takeOutputs(outputs);
+                  worker->sendResult(outputs);
+                  delete batchReader;
+                  batchReader = NULL;
+               }
+               if (!worker->getBatch(batch))
+                  break;
+               batchIn.clear();
+               batchIn.str(batch);
+               batchReader = new InputParser(batchIn, true, c.quietEmptyLines);
+            }
+         } else {
+            nss = reader.getMarkedSent();
+         }
          if (!nss)
             break;
 
-         if (needRef) {
+         if (worker && needRef) {
+            if (nss->external_src_sent_id >= tgt_sents.size())
+               error(ETFatal, "Unexpected end of reference file before sentence %u.",
+                     nss->external_src_sent_id);
+            nss->tgt_sent = &tgt_sents[nss->external_src_sent_id];
+         } else if (needRef) {
             string line;
             if (!getline(ref, line))
                error(ETFatal, "Unexpected end of reference file before end of source file.");
@@ -1005,7 +1120,11 @@ int MAIN(argc, argv)
       }
 
       nss->external_src_sent_id = sourceSentenceId;
+      // In -doc-mode, an empty line ends a document.
+      if (c.docMode && nss->src_sent.empty())
+         gen->newDocument();
       if (forcedDecoding) gen->lm_numwords = nss->tgt_sent->size() + 1;
+      gen->startSentenceMetrics(sourceSentenceId, nss->src_sent.size());
       BasicModel *model = gen->createModel(*nss, false);
 
       const double createTime = centisecondTimer.secsElapsed(1);
@@ -1086,6 +1205,15 @@ int MAIN(argc, argv)
       const double outputTime = centisecondTimer.secsElapsed(1) - createTime - decodeTime;
       outputStats.add(outputTime);
 
+      if (metricsStream != NULL) {
+         gen->endSentenceMetrics();
+         DecoderMetrics* metrics = gen->getMetrics();
+         metrics->create_seconds = createTime;
+         metrics->decode_seconds = decodeTime;
+         metrics->output_seconds = outputTime;
+         metrics->toJSON(*metricsStream) << endl;
+      }
+
       if (c.verbosity > 1 || c.timing)
          cerr << "Timing: create models + decode + output = total: "
               << createTime << " + " << decodeTime << " + " << outputTime << " = "
@@ -1119,8 +1247,11 @@ int MAIN(argc, argv)
    }
 
    delete gen;
+   delete batchReader;
+   delete worker;
    delete file_info;
    delete nssiStream;
+   delete metricsStream;
    delete triangularArrayAsCPTStream;
 
    if (c.verbosity >= 1) logTime("done");
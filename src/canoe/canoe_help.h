@@ -87,6 +87,10 @@ Options (in command-line format):\n\
      each phrase table, among:\n\
       - TPPT:  directory name ending in .tppt\n\
       - MixTM: file name ending in .mixtm\n\
+      - incremental TM: file name ending in .incrtm (joint counts updated in\n\
+        place; see incremental_tm_feature.h for the file format)\n\
+      - suffix-array TM: file name ending in .satm (phrase pairs extracted\n\
+        at decoding time from an indexed bitext; see suffix_array_tm_feature.h)\n\
      Requires backward, forward and adir weights matching the ttable contents.\n\
 \n\
  -ttable-tppt FILE1[:FILE2[:..]]        Tightly Packed phrase table(s)\n\
@@ -500,9 +504,21 @@ Options (in command-line format):\n\
      sentences whose ID (0-based) is returned by the daemon running on\n\
      HOST:PORT.\n\
 \n\
- -Voc-file FILE                         Precompiled vocabulary (experimental)  [none]\n\
-     Provides a precompiled vocabulary file.  Don't use this.\n\
-     Kept around for some stuff in development that needed it at some point.\n\
+ -dispatcher HOST:PORT                  Worker mode for canoe-dispatcher\n\
+     Instead of reading its input, canoe loads its models, then translates\n\
+     batches of sentences received from canoe-dispatcher on HOST:PORT until\n\
+     it says all the work is done.  All the outputs, including n-best lists\n\
+     and lattices, go back to the dispatcher, which writes them in input order\n\
+     to the files canoe would write in -append mode, so -nbest and -lattice\n\
+     require -append.  Implies -load-first.\n\
+\n\
+ -Voc-file FILE                         Precompiled vocabulary  [none]\n\
+     Provides a precompiled target vocabulary file.  If FILE is a memory\n\
+     mapped vocabulary built by voc2mmvoc, e.g., from the target vocabularies\n\
+     of all the models, it is used in place and shared by all the canoe\n\
+     processes using it, and words it does not contain are added to a small\n\
+     in-memory overlay.  Best used with -load-first.  A text FILE, with one\n\
+     word per line, is read instead.\n\
 \n\
  -palign|-trace|-t                      Output alignment and OOV info  [don't]\n\
      Produce alignment and OOV output. If -lattice is given, this info\n\
@@ -641,12 +657,37 @@ Options (in command-line format):\n\
  -quiet-empty-lines                     Don't report empty input lines  pdo]\n\
 \n\
  -timing                                Show per-sentence timing  [don't unless V >= 2]\n\
+\n\
+ -precompute-threads N                  Threads for per-sentence precomputation  [1]\n\
+     Use N threads to compute the partial and future scores of the phrase\n\
+     options of each sentence, to prune them and to precompute future scores.\n\
+     Expensive features (e.g., NNJM, BiLM) and LMs each run on their own\n\
+     thread, while simple features are split across source ranges.  The\n\
+     output is identical to N=1.  0 means use OMP_NUM_THREADS or all cores.\n\
+\n\
+ -doc-mode                              Keep caches across documents' sentences  [don't]\n\
+     Treat the input as documents separated by empty lines, which are still\n\
+     translated as empty lines.  The phrase table (TPPT) caches, the NNJM\n\
+     score caches and the caches of LMs with #CACHING are kept across the\n\
+     sentences of a document and cleared at its end, rather than after each\n\
+     sentence (every 10 for TPPTs); #CACHING,X then counts documents.  Within\n\
+     longer documents, they are still cleared every 1000 sentences.  Repeated\n\
+     phrases, e.g., in headers and boilerplate, are then looked up and scored\n\
+     once per document.  The output is the same as without -doc-mode.\n\
 \n\
  -options                               Show the brief help message\n\
      Produce a shorter help message with one line per option\n\
 \n\
  -nssiFilename <F>                      Write Source Sentence Info to <F> [don't]\n\
      For every source sentence, write its newSrcSentInfo into <F> in json format.\n\
+\n\
+ -metricsFilename <F>                   Write performance metrics to <F> [don't]\n\
+     For every source sentence, write one line to <F> with, in json format:\n\
+     the model creation, decoding and output times (CPU seconds, as for\n\
+     -timing); the calls to and wall-clock time spent in each decoder feature,\n\
+     in the LMs and in the TMs; the hypotheses pushed, pruned and recombined on\n\
+     each stack; LM n-gram hits per order; LM, TPPT, TPLDM and feature cache\n\
+     hit rates; and the peak memory (RSS) so far.  Adds a small cost to every hypothesis.\n\
 \n\
  -triangularArrayFilename <F>           Write each triangular array [don't]\n\
      For every source sentence, write to <F> canoe's triangular array as a CPT.\
@@ -174,6 +174,7 @@ CanoeConfig::CanoeConfig()
    backwards              = false;
    loadFirst              = false;
    canoeDaemon            = "";
+   dispatcher             = "";
    input                  = "-";
    vocFile                = "";
    bAppendOutput          = false;
@@ -190,6 +191,8 @@ CanoeConfig::CanoeConfig()
    final_cleanup          = false;  // for speed reason we don't normally delete the bmg
    bind_pid               = -1;
    timing                 = false;
+   precomputeThreads      = 1;
+   docMode                = false;
    need_lock              = false;
 
    // Parameter information, used for input and output. NB: doesn't necessarily
@@ -280,6 +283,7 @@ CanoeConfig::CanoeConfig()
    param_infos.push_back(ParamInfo("backwards", "bool", &backwards));
    param_infos.push_back(ParamInfo("load-first", "bool", &loadFirst));
    param_infos.push_back(ParamInfo("canoe-daemon", "string", &canoeDaemon));
+   param_infos.push_back(ParamInfo("dispatcher", "string", &dispatcher));
    param_infos.push_back(ParamInfo("input", "string", &input));
    param_infos.push_back(ParamInfo("append", "bool", &bAppendOutput));
    param_infos.push_back(ParamInfo("stack-decoding", "bool", &bStackDecoding));
@@ -297,9 +301,12 @@ CanoeConfig::CanoeConfig()
    param_infos.push_back(ParamInfo("forced-nz", "bool", &forcedDecodingNZ));
    param_infos.push_back(ParamInfo("maxlen", "Uint", &maxlen));
    param_infos.push_back(ParamInfo("nssiFilename", "string", &nssiFilename));
+   param_infos.push_back(ParamInfo("metricsFilename", "string", &metricsFilename));
    param_infos.push_back(ParamInfo("final-cleanup", "bool", &final_cleanup));
    param_infos.push_back(ParamInfo("bind", "int", &bind_pid));
    param_infos.push_back(ParamInfo("timing", "bool", &timing));
+   param_infos.push_back(ParamInfo("precompute-threads", "Uint", &precomputeThreads));
+   param_infos.push_back(ParamInfo("doc-mode", "bool", &docMode));
    param_infos.push_back(ParamInfo("triangularArrayFilename", "string", &triangularArrayFilename));
    param_infos.push_back(ParamInfo("lock", "bool", &need_lock));
 
@@ -798,6 +805,21 @@ void CanoeConfig::check()
    if (bLoadBalancing && bAppendOutput)
       error(ETFatal, "Load Balancing cannot run in append mode");
 
+   if (!dispatcher.empty()) {
+      if (bLoadBalancing || !canoeDaemon.empty())
+         error(ETFatal, "-dispatcher cannot be combined with -lb or -canoe-daemon");
+      if (hierarchy)
+         error(ETFatal, "-dispatcher cannot be combined with -hierarchy: the dispatcher writes outputs as in -append mode");
+      if ((nbestOut || latticeOut) && !bAppendOutput)
+         error(ETFatal, "-dispatcher with -nbest or -lattice requires -append: the dispatcher writes each of those outputs as a single file");
+      // Workers translate batches as they come, from models loaded up front.
+      loadFirst = true;
+   }
+
+   // In document mode, empty lines are document boundaries, not anomalies.
+   if (docMode)
+      quietEmptyLines = true;
+
    //if (latticeOut && nbestOut)
    //   error(ETFatal, "Lattice and nbest output cannot be generated simultaneously.");
 
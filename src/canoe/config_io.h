@@ -235,6 +235,7 @@ public:
    bool backwards;                  ///< Whether to translate backwards
    bool loadFirst;                  ///< Whether to load models before input
    string canoeDaemon;              ///< Sentence by sentence mode specifications
+   string dispatcher;               ///< HOST:PORT of canoe-dispatcher, in worker mode
    string input;                    ///< Source sentences input file name
    string srctags;                  ///< Source sentences tags file name
    string refFile;                  ///< Reference file name
@@ -252,11 +253,14 @@ public:
    string triangularArrayFilename;  ///< Where should we write each triangular array.
 
    string nssiFilename;             ///< Triggers outputing, for every input sentence, the newSrcSentInfo into a file in a json format.
+   string metricsFilename;          ///< Triggers outputing, for every input sentence, performance metrics into a file in a json format.
 
    // how to run the software
    bool final_cleanup;              ///< Indicates if canoe should delete its bmg.
    int  bind_pid;                   ///< What pid to monitor.
    bool timing;                     ///< Show per-sentence timing information
+   Uint precomputeThreads;          ///< Threads for phrase partial scores (0 means OpenMP default)
+   bool docMode;                    ///< Keep caches across the sentences of a document
    bool need_lock;                  ///< Require a shared lock on config file
 
    /**
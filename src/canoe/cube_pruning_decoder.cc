@@ -292,6 +292,17 @@ HypothesisStack* runCubePruningDecoder(BasicModel &model, const CanoeConfig& c,
       stacks[s]->KBest(c.maxStackSize, threshold, s, c.verbosity);
    }
 
+   if (DecoderMetrics* metrics = model.getMetrics()) {
+      metrics->stack(0).pushed = 1;
+      for ( Uint s(1); s <= sourceLength; ++s ) {
+         DecoderMetrics::StackCounts& counts = metrics->stack(s);
+         counts.pushed = stacks[s]->getNumEvaluatedStates();
+         counts.recombined = stacks[s]->getNumRecombined();
+         const Ulong survived = counts.recombined + stacks[s]->size();
+         counts.pruned = counts.pushed > survived ? counts.pushed - survived : 0;
+      }
+   }
+
    if ( c.verbosity >= 2 ) {
       Uint hyperedge_count(0), potential_states(0), evaluated_states(0),
            kept_states(0), recomb_states(0);
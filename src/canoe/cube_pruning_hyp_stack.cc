@@ -69,8 +69,9 @@ void HyperedgeItem::CreateDecoderState()
    }
 
    // We fully score ds here, since extendDecoderState doesn't do so
-   ds->score = ds0->score + e->model.scoreTranslation(*ds->trans, e->verbosity);
-   double dFutureScore = e->model.computeFutureScore(*ds->trans);
+   double dScore, dFutureScore;
+   e->model.scoreAndFutureScore(*ds->trans, dScore, dFutureScore, e->verbosity);
+   ds->score = ds0->score + dScore;
    ds->futureScore = ds->score + dFutureScore;
 
    if (e->verbosity >= 3) {
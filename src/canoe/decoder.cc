@@ -22,6 +22,7 @@
 #include "phrasefinder.h"
 #include "forced_phrase_finder.h"
 #include "cube_pruning_decoder.h"
+#include "decoder_metrics.h"
 #include <vector>
 #include <iostream>
 
@@ -75,7 +76,8 @@ namespace Portage
       } // for
 
       // Run the decoder algorithm
-      runStackDecoder(model, hStacks, sourceLength, *finder, usingLev, usingSR, c.verbosity);
+      runStackDecoder(model, hStacks, sourceLength, *finder, usingLev, usingSR, c.verbosity,
+                      model.getMetrics());
 
       // Keep the final hypothesis stack
       HypothesisStack *result = hStacks[sourceLength];
@@ -95,11 +97,12 @@ namespace Portage
 
    void runStackDecoder(PhraseDecoderModel &model, HypothesisStack **hStacks,
          Uint sourceLength, PhraseFinder &finder,
-         bool usingLev, bool usingSR, Uint verbosity)
+         bool usingLev, bool usingSR, Uint verbosity, DecoderMetrics* metrics)
    {
       // Put the empty hypothesis on the first stack
       //assert(hStacks[0]->isEmpty());
       hStacks[0]->push(makeEmptyState(sourceLength, usingLev, usingSR));
+      if (metrics) ++metrics->stack(0).pushed;
       Uint numStates = 1;
       Uint numPrunedAtPush = 0;
       Uint numPrunedAtPop = 0;
@@ -146,14 +149,16 @@ namespace Portage
                } // if
 
                // Score the new state
-               newState->score = state->score + model.scoreTranslation(*newState->trans, verbosity);
-               const double dFutureScore = model.computeFutureScore(*newState->trans);
+               double dScore, dFutureScore;
+               model.scoreAndFutureScore(*newState->trans, dScore, dFutureScore, verbosity);
+               newState->score = state->score + dScore;
                newState->futureScore = newState->score + dFutureScore;
                if (verbosity >= 3)
                   cerr << "\tscore " << newState->score << " + future score " <<
                      dFutureScore << " = " << newState->futureScore << endl;
 
                // Add the new state to the appropriate hypothesis stack
+               if (metrics) ++metrics->stack(newState->trans->numSourceWordsCovered).pushed;
                hStacks[newState->trans->numSourceWordsCovered]->push(newState);
             } // while
          } // while
@@ -165,6 +170,10 @@ namespace Portage
          numUnrecombined += hStacks[i]->getNumUnrecombined();
          numCovPruned += hStacks[i]->getNumCovPruned();
          numRecombCovPruned += hStacks[i]->getNumRecombCovPruned();
+         if (metrics) {
+            metrics->stack(i).pruned = hStacks[i]->getNumPruned();
+            metrics->stack(i).recombined = hStacks[i]->getNumRecombined();
+         }
          delete hStacks[i];
          hStacks[i] = NULL;
 
@@ -189,6 +198,10 @@ namespace Portage
       numRecombined += hStacks[sourceLength]->getNumRecombined();
       numPrunedAtPush += hStacks[sourceLength]->getNumPrunedAtPush();
       Uint numInFinalStack = hStacks[sourceLength]->size();
+      if (metrics) {
+         metrics->stack(sourceLength).pruned = hStacks[sourceLength]->getNumPruned();
+         metrics->stack(sourceLength).recombined = hStacks[sourceLength]->getNumRecombined();
+      }
 
       if (verbosity >= 2) {
          streamsize saved_precision = cerr.precision();
@@ -30,6 +30,7 @@ namespace Portage
    class HypothesisStack;
    class PhraseFinder;
    class CanoeConfig;
+   class DecoderMetrics;
 
    /**
     * A structure representing a state in the phrase graph.  This consists of
@@ -206,10 +207,12 @@ namespace Portage
     * @param phraseFinder Phrases that can be added to the current source 
     * @param usingLev Specifies if the decoder is using levenshtein
     * @param verbosity  Indicates the level of verbosity
+    * @param metrics  If not NULL, where to count hypotheses per stack
     */
    void runStackDecoder(PhraseDecoderModel &model, HypothesisStack **hStacks,
                         Uint sourceLength, PhraseFinder &phraseFinder,
-                        bool usingLev, bool usingSR, Uint verbosity);
+                        bool usingLev, bool usingSR, Uint verbosity,
+                        DecoderMetrics* metrics = NULL);
 
 } // Portage
 
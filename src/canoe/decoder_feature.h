@@ -105,6 +105,15 @@ class BasicModelGenerator;
        */
       virtual void newSrcSent(const newSrcSentInfo& info) {}
 
+      /**
+       * Start a new document, in canoe -doc-mode.
+       *
+       * This function is called by the decoder before the first sentence of
+       * each document after the first one.  Features that keep caches across
+       * sentences in -doc-mode should clear them here.
+       */
+      virtual void newDocument() {}
+
       /**
        * Precompute this feature's score for a single phrase pair.
        * 
@@ -120,6 +129,29 @@ class BasicModelGenerator;
        */
       virtual double precomputeFutureScore(const PhraseInfo& phrase_info) = 0;
 
+      /// How precomputeFutureScore() may be called when the phrase partial
+      /// scores are computed with several threads (canoe -precompute-threads).
+      enum PrecomputeThreading {
+         PRECOMPUTE_SERIAL,     ///< only from the main thread, alone
+         PRECOMPUTE_OWN_THREAD, ///< from one thread at a time, while other
+                                ///< features run on other threads
+         PRECOMPUTE_CONCURRENT  ///< from several threads at once
+      };
+
+      /**
+       * Declare how precomputeFutureScore() may be called from threads.
+       *
+       * With PRECOMPUTE_OWN_THREAD, all calls for a sentence are made in the
+       * usual phrase order, from a single thread, so the feature may update
+       * its own caches and scratch buffers, but must not modify anything it
+       * shares with other features or models.  PRECOMPUTE_CONCURRENT further
+       * requires precomputeFutureScore() not to modify any state at all.
+       * The default, PRECOMPUTE_SERIAL, is always safe.
+       * @return this feature's threading constraint
+       */
+      virtual PrecomputeThreading precomputeThreading() const
+      { return PRECOMPUTE_SERIAL; }
+
       /**
        * Compute this feature's future score for a partial translation.
        *
@@ -202,6 +234,36 @@ class BasicModelGenerator;
        */
       virtual Uint computeRecombHash(const PartialTranslation &pt) = 0;
 
+      /// Results of evaluate() for one partial translation
+      struct Evaluation {
+         double score;        ///< score(pt)
+         double futureScore;  ///< futureScore(pt)
+         Uint recombHash;     ///< computeRecombHash(pt)
+      };
+
+      /**
+       * Fused evaluation of a new partial translation.
+       *
+       * Compute score(), futureScore() and computeRecombHash() for pt in one
+       * call.  BasicModel calls this once per feature for each new
+       * hypothesis, instead of making three separate passes over the
+       * features.
+       *
+       * The default implementation simply calls the three methods; override
+       * it when they can share work.  A subclass that overrides any of the
+       * three methods must make sure an inherited evaluate() is still
+       * consistent with them.
+       *
+       * @param pt    partial translation to evaluate
+       * @param eval  results
+       */
+      virtual void evaluate(const PartialTranslation &pt, Evaluation& eval)
+      {
+         eval.score = score(pt);
+         eval.futureScore = futureScore(pt);
+         eval.recombHash = computeRecombHash(pt);
+      }
+
       /**
        * @brief Determine if two partial translations are recombinable or not.
        *
@@ -236,6 +298,17 @@ class BasicModelGenerator;
        */
       virtual Uint lmLikeContextNeeded() { return 0; }
 
+      /**
+       * Report the counts of any cache kept by this feature, for canoe's
+       * -metricsFilename output.
+       *
+       * @param hits     cumulative number of lookups found in the cache
+       * @param lookups  cumulative number of lookups
+       * @return false if this feature keeps no cache (the default)
+       */
+      virtual bool getCacheCounts(Ulong& hits, Ulong& lookups) const
+      { return false; }
+
       /**
        * @brief Get a human readable description of the feature.
        *
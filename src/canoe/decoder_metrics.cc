@@ -0,0 +1,131 @@
+/**
+ * @file decoder_metrics.cc
+ * @brief Optional per-sentence performance metrics for canoe.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "decoder_metrics.h"
+#include "toJSON.h"
+#include <sys/resource.h>
+
+using namespace Portage;
+
+ostream& DecoderMetrics::Timing::toJSON(ostream& out) const
+{
+   out << '{';
+   out << to_JSON("name", name);
+   out << ',';
+   out << to_JSON("calls", calls);
+   out << ',';
+   out << to_JSON("seconds", seconds);
+   out << '}';
+   return out;
+}
+
+ostream& DecoderMetrics::StackCounts::toJSON(ostream& out) const
+{
+   out << '{';
+   out << to_JSON("pushed", pushed);
+   out << ',';
+   out << to_JSON("pruned", pruned);
+   out << ',';
+   out << to_JSON("recombined", recombined);
+   out << '}';
+   return out;
+}
+
+ostream& DecoderMetrics::CacheCounts::toJSON(ostream& out) const
+{
+   out << '{';
+   out << to_JSON("name", name);
+   out << ',';
+   out << to_JSON("hits", hits);
+   out << ',';
+   out << to_JSON("lookups", lookups);
+   out << ',';
+   out << to_JSON("hit_rate", lookups ? double(hits) / lookups : 0.0);
+   out << '}';
+   return out;
+}
+
+DecoderMetrics::DecoderMetrics(const vector<string>& feature_names)
+   : sent_id(0), src_len(0)
+   , create_seconds(0), decode_seconds(0), output_seconds(0)
+   , lms("lms"), tms("tms")
+{
+   for (Uint i = 0; i < feature_names.size(); ++i)
+      features.push_back(Timing(feature_names[i]));
+}
+
+long DecoderMetrics::peakRSSKB()
+{
+   struct rusage usage;
+   if (getrusage(RUSAGE_SELF, &usage) != 0)
+      return 0;
+   return usage.ru_maxrss;
+}
+
+void DecoderMetrics::startSentence(Uint id, Uint len, const vector<Ulong>& lm_hits,
+                                   const vector<CacheCounts>& cache_totals)
+{
+   sent_id = id;
+   src_len = len;
+   create_seconds = decode_seconds = output_seconds = 0;
+   for (Uint i = 0; i < features.size(); ++i)
+      features[i].clear();
+   lms.clear();
+   tms.clear();
+   stacks.clear();
+   lm_ngram_hits.clear();
+   caches.clear();
+   lm_hits_start = lm_hits;
+   caches_start = cache_totals;
+}
+
+void DecoderMetrics::endSentence(const vector<Ulong>& lm_hits,
+                                 const vector<CacheCounts>& cache_totals)
+{
+   lm_ngram_hits = lm_hits;
+   for (Uint i = 0; i < lm_ngram_hits.size() && i < lm_hits_start.size(); ++i)
+      lm_ngram_hits[i] -= lm_hits_start[i];
+   caches = cache_totals;
+   for (Uint i = 0; i < caches.size() && i < caches_start.size(); ++i) {
+      caches[i].hits -= caches_start[i].hits;
+      caches[i].lookups -= caches_start[i].lookups;
+   }
+}
+
+ostream& DecoderMetrics::toJSON(ostream& out) const
+{
+   out << '{';
+   out << to_JSON("sent_id", sent_id);
+   out << ',';
+   out << to_JSON("src_len", src_len);
+   out << ',';
+   out << to_JSON("create_seconds", create_seconds);
+   out << ',';
+   out << to_JSON("decode_seconds", decode_seconds);
+   out << ',';
+   out << to_JSON("output_seconds", output_seconds);
+   out << ',';
+   out << to_JSON("features", features);
+   out << ',';
+   out << to_JSON("lms", lms);
+   out << ',';
+   out << to_JSON("tms", tms);
+   out << ',';
+   out << to_JSON("stacks", stacks);
+   out << ',';
+   out << to_JSON("lm_ngram_hits", lm_ngram_hits);
+   out << ',';
+   out << to_JSON("caches", caches);
+   out << ',';
+   out << to_JSON("peak_rss_kb", peakRSSKB());
+   out << '}';
+   return out;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file decoder_metrics.h
+ * @brief Optional per-sentence performance metrics for canoe.
+ *
+ * When canoe is run with -metricsFilename, the decoder counts, for each
+ * sentence, the calls to and time spent in each decoder feature, the LMs and
+ * the TMs, the hypotheses pushed, pruned and recombined on each stack, and the
+ * hits of the LM, phrase table and feature caches; canoe writes them, with the
+ * per-sentence model creation, decoding and output times and the peak memory
+ * so far, as one JSON object per line.  When metrics are not requested, the
+ * only cost to the decoder is a NULL pointer test per hypothesis.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef __DECODER_METRICS_H__
+#define __DECODER_METRICS_H__
+
+#include "portage_defs.h"
+#include <ctime>
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace Portage {
+
+/// Per-sentence performance metrics of the decoder.
+class DecoderMetrics : private NonCopyable {
+public:
+   /// Calls to, and cumulative time spent in, one component of the decoder.
+   struct Timing {
+      string name;      ///< component name, e.g., the feature description
+      Ulong calls;      ///< number of calls
+      double seconds;   ///< cumulative wall-clock time, in seconds
+      explicit Timing(const string& name = "")
+         : name(name), calls(0), seconds(0) {}
+      void add(double secs) { ++calls; seconds += secs; }
+      void clear() { calls = 0; seconds = 0; }
+      ostream& toJSON(ostream& out) const;
+   };
+
+   /// Hypothesis counts for one stack, i.e., one number of covered words.
+   struct StackCounts {
+      Ulong pushed;     ///< hypotheses pushed onto the stack
+      Ulong pruned;     ///< hypotheses pruned, at push or at pop time
+      Ulong recombined; ///< hypotheses recombined into a better one
+      StackCounts() : pushed(0), pruned(0), recombined(0) {}
+      ostream& toJSON(ostream& out) const;
+   };
+
+   /// Hits and lookups of one cache.
+   struct CacheCounts {
+      string name;      ///< cache name
+      Ulong hits;       ///< lookups that found their answer in the cache
+      Ulong lookups;    ///< all lookups
+      explicit CacheCounts(const string& name = "", Ulong hits = 0,
+                           Ulong lookups = 0)
+         : name(name), hits(hits), lookups(lookups) {}
+      ostream& toJSON(ostream& out) const;
+   };
+
+   Uint sent_id;                 ///< external source sentence id
+   Uint src_len;                 ///< source sentence length
+   double create_seconds;        ///< time to create the sentence's model
+   double decode_seconds;        ///< time to decode
+   double output_seconds;        ///< time to write the output
+   vector<Timing> features;      ///< one per decoder feature, in model order
+   Timing lms;                   ///< all language models together
+   Timing tms;                   ///< all translation models together
+   vector<StackCounts> stacks;   ///< indexed by number of covered words
+   vector<Ulong> lm_ngram_hits;  ///< LM queries answered by each n-gram order
+   vector<CacheCounts> caches;   ///< cache hits for this sentence
+
+   /**
+    * Constructor.
+    * @param feature_names  description of each decoder feature
+    */
+   explicit DecoderMetrics(const vector<string>& feature_names);
+
+   /// Current monotonic wall-clock time, in seconds.
+   static double now() {
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec + ts.tv_nsec * 1e-9;
+   }
+
+   /// Peak resident set size of this process so far, in kilobytes.
+   static long peakRSSKB();
+
+   /**
+    * Start collecting metrics for a new sentence.
+    * @param id           external source sentence id
+    * @param len          source sentence length
+    * @param lm_hits      cumulative LM n-gram hits so far
+    * @param cache_totals cumulative cache counts so far
+    */
+   void startSentence(Uint id, Uint len, const vector<Ulong>& lm_hits,
+                      const vector<CacheCounts>& cache_totals);
+
+   /**
+    * Finish collecting metrics for the current sentence: turn cumulative
+    * counts into counts for this sentence.
+    * @param lm_hits      cumulative LM n-gram hits so far
+    * @param cache_totals cumulative cache counts so far, in the same order
+    *                     as given to startSentence()
+    */
+   void endSentence(const vector<Ulong>& lm_hits,
+                    const vector<CacheCounts>& cache_totals);
+
+   /// Counts for stack i, which is created if needed.
+   StackCounts& stack(Uint i) {
+      if (i >= stacks.size()) stacks.resize(i + 1);
+      return stacks[i];
+   }
+
+   /// Write the current sentence's metrics as a single-line JSON object.
+   ostream& toJSON(ostream& out) const;
+
+private:
+   vector<Ulong> lm_hits_start;        ///< cumulative LM hits at sentence start
+   vector<CacheCounts> caches_start;   ///< cumulative cache counts at start
+};
+
+} // namespace Portage
+
+#endif // __DECODER_METRICS_H__
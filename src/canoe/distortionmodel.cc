@@ -306,6 +306,15 @@ double WordDisplacement::futureScore(const PartialTranslation &pt)
    return distScore;
 }
 
+void WordDisplacement::evaluate(const PartialTranslation &pt, Evaluation& eval)
+{
+   // Same as score(), futureScore() and computeRecombHash(), without the
+   // virtual calls.
+   eval.score = WordDisplacement::score(pt);
+   eval.futureScore = WordDisplacement::futureScore(pt);
+   eval.recombHash = pt.lastPhrase->src_words.end;
+}
+
 /************************** LeftDistance ******************************/
 
 double LeftDistance::score(const PartialTranslation& pt)
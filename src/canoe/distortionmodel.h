@@ -53,6 +53,12 @@ public:
       sentLength = new_src_sent_info.src_sent.size();
    }
 
+   // Distortion models, walls and zones only read the phrase pair and their
+   // per-sentence data in precomputeFutureScore().
+   virtual PrecomputeThreading precomputeThreading() const {
+      return PRECOMPUTE_CONCURRENT;
+   }
+
    /**
     * Helper that factors name extraction out of create()
     * @param name_and_arg name of derived type, with optional argument
@@ -204,6 +210,7 @@ public:
    virtual bool isRecombinable(const PartialTranslation &pt1, const PartialTranslation &pt2);
    virtual double precomputeFutureScore(const PhraseInfo& phrase_info);
    virtual double futureScore(const PartialTranslation &trans);
+   virtual void evaluate(const PartialTranslation &pt, Evaluation& eval);
 };
 
 /**
@@ -283,6 +290,12 @@ public:
 
    virtual double futureScore(const PartialTranslation &trans);
 
+   // WordDisplacement::evaluate() assumes WordDisplacement's score() and
+   // futureScore(), so fall back to the generic implementation.
+   virtual void evaluate(const PartialTranslation &pt, Evaluation& eval) {
+      DecoderFeature::evaluate(pt, eval);
+   }
+
    // same implementation as WordDisplacement
    //virtual double partialScore(const PartialTranslation& trans);
    //virtual Uint computeRecombHash(const PartialTranslation &pt);
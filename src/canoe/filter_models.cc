@@ -24,6 +24,13 @@
 #include "lm.h"
 #include "lmtext.h"  // LMText::isA
 #include <sstream>
+#include <fstream>
+#include <set>
+#include <algorithm>
+#include <cerrno>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <dirent.h>
 
 
 using namespace std;
@@ -60,6 +67,230 @@ using namespace Portage::filter_models;
 Logging::logger filter_models_Logger(Logging::getLogger("verbose.canoe.filter_models"));
 
 
+/**
+ * Runs filtering jobs in child processes, at most max_jobs at a time, or in
+ * this process when max_jobs is 1.  Usage:
+ *    if (jobs.start()) { filter one model; jobs.finish(); }
+ *    ...
+ *    jobs.wait();
+ * A job must only write its own output files: changes it makes to memory,
+ * e.g., to the vocabulary, are lost when it runs in a child process.
+ */
+class FilterJobs : private NonCopyable {
+   const Uint max_jobs;   ///< maximum number of children at a time
+   Uint running;          ///< number of children running
+   Uint failed;           ///< number of children that failed
+   bool in_child;         ///< whether this is a child process
+
+   /// Wait for one child to exit.
+   void waitOne() {
+      int status;
+      if (::wait(&status) < 0) {
+         running = 0;
+         return;
+      }
+      --running;
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+         ++failed;
+   }
+
+public:
+   /// Constructor.
+   /// @param max_jobs  maximum number of jobs running at a time
+   FilterJobs(Uint max_jobs)
+   : max_jobs(max_jobs), running(0), failed(0), in_child(false)
+   {}
+
+   /**
+    * Start a job.
+    * @return true in the process that must do the job, i.e., in the child
+    *         process, or in this process when max_jobs is 1.
+    */
+   bool start() {
+      if (max_jobs <= 1) return true;
+      while (running >= max_jobs)
+         waitOne();
+      cerr << flush;
+      const pid_t pid = fork();
+      if (pid < 0)
+         error(ETFatal, "Can't fork a filtering job: %s", strerror(errno));
+      if (pid == 0) {
+         in_child = true;
+         return true;
+      }
+      ++running;
+      return false;
+   }
+
+   /// End a job: exits if this is a child process.
+   void finish() {
+      if (in_child) {
+         cerr << flush;
+         _exit(0);
+      }
+   }
+
+   /// Wait for all the jobs to finish; fatal error if any of them failed.
+   void wait() {
+      while (running > 0)
+         waitOne();
+      if (failed > 0)
+         error(ETFatal, "%u filtering job(s) failed.", failed);
+   }
+};
+
+
+/// FNV-1a hash of s, continuing from h.
+static uint64_t hashString(const string& s, uint64_t h = 14695981039346656037ULL)
+{
+   for (string::const_iterator it = s.begin(); it != s.end(); ++it) {
+      h ^= (unsigned char)*it;
+      h *= 1099511628211ULL;
+   }
+   return h;
+}
+
+/// Copy file src to dest, byte for byte.
+/// @return true iff successful
+static bool copyFile(const string& src, const string& dest)
+{
+   ifstream in(src.c_str(), ios::binary);
+   ofstream out(dest.c_str(), ios::binary | ios::trunc);
+   if (!in || !out) return false;
+   if (in.peek() != EOF)
+      out << in.rdbuf();
+   out.close();
+   return !out.fail();
+}
+
+/**
+ * Cache of filter_models outputs.  Each entry is a directory named after the
+ * key, holding a copy of each output file and a MANIFEST listing their names.
+ * Outputs are copied rather than hard linked, so that overwriting an output
+ * file later does not change the cache.
+ */
+class FilterCache : private NonCopyable {
+   string entry;   ///< cache entry directory; empty if no cache
+public:
+   /**
+    * Constructor.
+    * @param dir  cache directory; empty for no cache
+    * @param key  description of everything the outputs depend on
+    */
+   FilterCache(const string& dir, const string& key) {
+      if (dir.empty()) return;
+      char hex[17];
+      snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hashString(key));
+      entry = dir + "/" + hex;
+   }
+
+   /**
+    * Copy the outputs of the cache entry into place, if it exists.
+    * @param readonly  leave existing output files alone
+    * @return true iff the cache entry exists and was restored
+    */
+   bool restore(bool readonly) const {
+      if (entry.empty()) return false;
+      ifstream manifest((entry + "/MANIFEST").c_str());
+      if (!manifest) return false;
+      string line;
+      vector<string> tokens;
+      while (getline(manifest, line)) {
+         if (splitZ(line, tokens, "\t", 2) != 2)
+            error(ETFatal, "Invalid line in %s/MANIFEST: %s", entry.c_str(), line.c_str());
+         if (readonly && check_if_exists(tokens[1], false)) {
+            error(ETWarn, "%s exists; not copying it from the cache.", tokens[1].c_str());
+            continue;
+         }
+         if (!copyFile(entry + "/" + tokens[0], tokens[1]))
+            error(ETFatal, "Can't copy %s/%s to %s", entry.c_str(),
+                  tokens[0].c_str(), tokens[1].c_str());
+      }
+      return true;
+   }
+
+   /**
+    * Create the cache entry with copies of files.  The entry is created under
+    * a temporary name first, so it is either complete or absent, even if
+    * several processes create it at the same time.
+    * @param files  output files to save
+    */
+   void save(const vector<string>& files) const {
+      if (entry.empty()) return;
+      char pid[32];
+      snprintf(pid, sizeof(pid), ".tmp.%d", int(getpid()));
+      const string tmp = entry + pid;
+      if (!mkDirectories(tmp.c_str()) && !is_directory(tmp)) {
+         error(ETWarn, "Can't create %s; not caching the filtered models.", tmp.c_str());
+         return;
+      }
+      vector<string> names;
+      {
+         oSafeMagicStream manifest(tmp + "/MANIFEST");
+         for (Uint i = 0; i < files.size(); ++i) {
+            names.push_back(tmp + "/" + toString(i));
+            if (!copyFile(files[i], names.back()))
+               error(ETFatal, "Can't copy %s to %s", files[i].c_str(), names.back().c_str());
+            manifest << i << "\t" << files[i] << endl;
+         }
+      }
+      if (rename(tmp.c_str(), entry.c_str()) != 0) {
+         // Another run created the same entry first: keep that one.
+         for (Uint i = 0; i < names.size(); ++i)
+            unlink(names[i].c_str());
+         unlink((tmp + "/MANIFEST").c_str());
+         rmdir(tmp.c_str());
+      }
+      else
+         cerr << "Saved the filtered models in cache entry " << entry << endl;
+   }
+
+   /// Cache entry directory.
+   const string& name() const { return entry; }
+};
+
+/**
+ * Describe the size and time stamp of a file for the cache key, or those of
+ * each of its member files, recursively, if it is a directory: the members of
+ * a TPPT or TPLM can be replaced without changing the directory's time stamp.
+ */
+static void describeFile(ostream& os, const string& file, const string& name)
+{
+   struct stat st;
+   if (stat(file.c_str(), &st) != 0)
+      return;
+   if (!S_ISDIR(st.st_mode)) {
+      os << (name.empty() ? "" : " " + name + ":") << " size=" << st.st_size
+         << " mtime=" << st.st_mtime;
+      return;
+   }
+   vector<string> members;
+   if (DIR* dir = opendir(file.c_str())) {
+      while (const struct dirent* member = readdir(dir))
+         if (strcmp(member->d_name, ".") && strcmp(member->d_name, ".."))
+            members.push_back(member->d_name);
+      closedir(dir);
+   }
+   sort(members.begin(), members.end());
+   for (Uint i = 0; i < members.size(); ++i)
+      describeFile(os, file + "/" + members[i],
+                   name.empty() ? members[i] : name + "/" + members[i]);
+}
+
+/**
+ * Describe a model file for the cache key: its name, and the sizes and time
+ * stamps of its files.  Model contents are not hashed: that would cost as much as filtering them.
+ */
+static void describeModel(ostream& os, const string& file)
+{
+   char* real = realpath(file.c_str(), NULL);
+   os << "model=" << (real ? real : file.c_str());
+   free(real);
+   describeFile(os, file, "");
+   os << "\n";
+}
+
+
 /**
  *
  * @return Returns true if a filtered CPT was created.
@@ -176,11 +407,18 @@ int MAIN(argc, argv)
    PhraseTable::log_almost_0 = c.phraseTableLogZero;
 
    // Prepares the source sentences
+   // The source text is kept as is for the cache key.
    VectorPSrcSent src_sents;
+   string src_text;
    if (arg.limitPhrases()) {
       LOG_VERBOSE1(filter_models_Logger, "Loading source sentences");
-      string line;
-      iSafeMagicStream is(arg.input);
+      {
+         iSafeMagicStream is(arg.input);
+         ostringstream os;
+         os << is.rdbuf();
+         src_text = os.str();
+      }
+      istringstream is(src_text);
       InputParser reader(is);
       PSrcSent ss;
       while (ss = reader.getMarkedSent())
@@ -229,6 +467,42 @@ int MAIN(argc, argv)
    if ( arg.nopersent ) VocabFilter::maxSourceSentence4filtering = 1;
 
 
+   ////////////////////////////////////////
+   // Reuse the outputs of an identical earlier run, if cached.
+   // Remember the original models: the outputs are the models that replace
+   // them in the config, plus the vocab and the new config.
+   set<string> original_models;
+   original_models.insert(c.multiProbTMFiles.begin(), c.multiProbTMFiles.end());
+   original_models.insert(c.lmFiles.begin(), c.lmFiles.end());
+   original_models.insert(c.LDMFiles.begin(), c.LDMFiles.end());
+   ostringstream cache_key;
+   if (!arg.cache_dir.empty()) {
+      cache_key << "filter_models cache v1\n";
+      arg.describeOptions(cache_key);
+      {
+         iSafeMagicStream config(arg.config);
+         cache_key << "canoe.ini:\n" << config.rdbuf() << "\nsource:\n" << src_text;
+      }
+      for (FL_iterator file(c.multiProbTMFiles.begin()); file!=c.multiProbTMFiles.end(); ++file)
+         describeModel(cache_key, *file);
+      for (FL_iterator file(c.allNonMultiProbPTs.begin()); file!=c.allNonMultiProbPTs.end(); ++file)
+         describeModel(cache_key, *file);
+      for (FL_iterator file(c.lmFiles.begin()); file!=c.lmFiles.end(); ++file)
+         describeModel(cache_key, file->substr(0, file->rfind(PLM::lm_order_separator)));
+      for (FL_iterator file(c.LDMFiles.begin()); file!=c.LDMFiles.end(); ++file) {
+         describeModel(cache_key, *file);
+         describeModel(cache_key, (isZipFile(*file) ? removeExtension(*file) : *file) + ".bkoff");
+      }
+   }
+   const FilterCache cache(arg.cache_dir, cache_key.str());
+   if (cache.restore(arg.readonly)) {
+      cerr << "Copied the filtered models from cache entry " << cache.name() << endl;
+      return 0;
+   }
+
+   FilterJobs jobs(arg.jobs);
+
+
    ////////////////////////////////////////
    // Changing what to do based on what the user asked for and what has already been done.
    if (arg.limit()) {
@@ -373,6 +647,7 @@ int MAIN(argc, argv)
       LOG_VERBOSE1(filter_models_Logger, "Creating the models");
       PhraseTableFilterGrep phraseTable(arg.limitPhrases(), tgt_vocab,
                                         arg.phraseTablePruneType, c.appendJointCounts);
+      FileList filtered_by_jobs;
 
       // Parses the input source sentences
       phraseTable.addSourceSentences(src_sents);
@@ -401,12 +676,28 @@ int MAIN(argc, argv)
                   filteredTranslationModelFilename.c_str());
          }
          else {
-            phraseTable.filter(translationModelFilename, filteredTranslationModelFilename);
+            if (jobs.start()) {
+               phraseTable.filter(translationModelFilename, filteredTranslationModelFilename);
+               jobs.finish();
+            }
+            filtered_by_jobs.push_back(filteredTranslationModelFilename);
             weve_created_a_cpt = true;
          }
 
          *file = filteredTranslationModelFilename;
       }
+      jobs.wait();
+
+      // Jobs run in child processes don't populate tgt_vocab: read it back
+      // from their outputs, which yields the same vocabulary, since
+      // filtering keeps exactly the entries whose target words it adds.
+      if (arg.jobs > 1 && !filtered_by_jobs.empty() && (arg.filterLMs || arg.vocab())) {
+         PhraseTableFilterLM vocabReader(arg.limitPhrases(),
+                                         tgt_vocab, arg.phraseTablePruneType, c.appendJointCounts);
+         vocabReader.addSourceSentences(src_sents);
+         for (FL_iterator file(filtered_by_jobs.begin()); file!=filtered_by_jobs.end(); ++file)
+            vocabReader.readMultiProb(*file);
+      }
    }
    // Reading the vocabulary in the TMs in order to filter LMs.
    // Here, we don't create a new TM.
@@ -461,6 +752,11 @@ int MAIN(argc, argv)
       assert(!tgt_vocab.empty());
 
       LOG_VERBOSE1(filter_models_Logger, "Processing Language Models");
+      // LMs add their special symbols to tgt_vocab, which is done below for
+      // jobs run in child processes.  With -no-src-grep, they also add all
+      // their words, which -vocab must then see: don't use child jobs.
+      FilterJobs lm_jobs(arg.limitPhrases() || !arg.vocab() ? arg.jobs : 1);
+      bool lm_filtered = false;
       for (FL_iterator file(c.lmFiles.begin()); file!=c.lmFiles.end(); ++file) {
          // Extract the physical file name.
          const size_t hash_pos = file->rfind(PLM::lm_order_separator);
@@ -483,21 +779,33 @@ int MAIN(argc, argv)
             error(ETWarn, "Cannot filter %s since %s is read-only.", lm.c_str(), flm.c_str());
          }
          else {
-            if (arg.verbose) {
-               cerr << "loading Language Model from " << lm << " to " << flm << endl;
-            }
-            const time_t start_time = time(NULL);
-            oSafeMagicStream  os_filtered(flm);
-            const PLM *lm_model = PLM::Create(lm, &tgt_vocab, PLM::ClosedVoc,
-                  LOG_ALMOST_0, arg.limitPhrases(), c.lmOrder, &os_filtered);
-            if (arg.verbose) {
-               cerr << " ... done in " << (time(NULL) - start_time) << "s" << endl;
+            if (lm_jobs.start()) {
+               if (arg.verbose) {
+                  cerr << "loading Language Model from " << lm << " to " << flm << endl;
+               }
+               const time_t start_time = time(NULL);
+               {
+                  oSafeMagicStream  os_filtered(flm);
+                  const PLM *lm_model = PLM::Create(lm, &tgt_vocab, PLM::ClosedVoc,
+                        LOG_ALMOST_0, arg.limitPhrases(), c.lmOrder, &os_filtered);
+                  if (lm_model) { delete lm_model; lm_model = NULL; }
+               }
+               if (arg.verbose) {
+                  cerr << " ... done in " << (time(NULL) - start_time) << "s" << endl;
+               }
+               lm_jobs.finish();
             }
-            if (lm_model) { delete lm_model; lm_model = NULL; }
+            lm_filtered = true;
 
             *file = flm + option;
          }
       }
+      lm_jobs.wait();
+      if (arg.jobs > 1 && lm_filtered) {
+         tgt_vocab.addSpecialSymbol(PLM::SentStart);
+         tgt_vocab.addSpecialSymbol(PLM::SentEnd);
+         tgt_vocab.addSpecialSymbol(PLM::UNK_Symbol);
+      }
    }
 
 
@@ -538,7 +846,7 @@ int MAIN(argc, argv)
          else if (arg.isReadOnlyOnDisk(filtered_ldm)) {
             error(ETWarn, "Cannot filter %s since %s is read-only.", file->c_str(), filtered_ldm.c_str());
          }
-         else {
+         else if (jobs.start()) {
             if (c.multiProbTMFiles.size() != 1 || !c.allNonMultiProbPTs.empty()) {
                assert(arg.limitPhrases());
                PhraseTableFilterGrep phraseTable(arg.limitPhrases(),
@@ -566,11 +874,13 @@ int MAIN(argc, argv)
                   error(ETFatal, "Error filtering Lexicalized Distortion Model with filter-distortion-model.pl! (rc=%d)", rc);
                // NOTE: the associated .bkoff for the newly filtered LDM will be created by filter-distortion-model.pl.
             }
+            jobs.finish();
          }
 
          // Replace unfiltered ldm in config file with the filtered one.
          *file = filtered_ldm;
       }
+      jobs.wait();
    }
 
 
@@ -602,4 +912,34 @@ int MAIN(argc, argv)
       c.write(configFile.c_str(), 1, true);
    }
 
+   // Save the outputs for later runs with the same inputs.
+   if (!arg.cache_dir.empty()) {
+      FileList outputs;
+      for (FL_iterator file(c.multiProbTMFiles.begin()); file!=c.multiProbTMFiles.end(); ++file)
+         if (!original_models.count(*file))
+            outputs.push_back(*file);
+      for (FL_iterator file(c.lmFiles.begin()); file!=c.lmFiles.end(); ++file)
+         if (!original_models.count(*file))
+            outputs.push_back(file->substr(0, file->rfind(PLM::lm_order_separator)));
+      for (FL_iterator file(c.LDMFiles.begin()); file!=c.LDMFiles.end(); ++file)
+         if (!original_models.count(*file)) {
+            outputs.push_back(*file);
+            outputs.push_back((isZipFile(*file) ? removeExtension(*file) : *file) + ".bkoff");
+         }
+      if (arg.vocab())
+         outputs.push_back(arg.vocab_file);
+      if (arg.output_config)
+         outputs.push_back(configFile);
+
+      bool complete = true;
+      for (FL_iterator file(outputs.begin()); file!=outputs.end(); ++file)
+         if (*file == "-" || !check_if_exists(*file, false)) {
+            error(ETWarn, "Output %s is not a file; not caching the filtered models.", file->c_str());
+            complete = false;
+            break;
+         }
+      if (complete)
+         cache.save(outputs);
+   }
+
 } END_MAIN
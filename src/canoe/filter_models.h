@@ -96,6 +96,14 @@ Options:\n\
 -lm   Filter language models as described avove [don't]\n\
 -no-per-sent   Global-voc LM filtering strategy (less filtering than default)\n\
 -vocab v       Write the target language vocab for <src> to file <v> [don't]\n\
+-j N  Filter up to N models at a time, each in its own process: the TMs with\n\
+      filter-grep, then the LMs, then the LDMs [1]\n\
+-cache D  Keep a copy of all outputs in directory D, under a key that hashes\n\
+      the options, <config>, the source text, the name of each model and the\n\
+      size and time stamp of each of its files, e.g., those inside a TPPT\n\
+      directory; when a later run has the same key, e.g., when tuning\n\
+      filters the same dev set again, copy them from D instead of filtering\n\
+      [don't]\n\
 \n\
 ";
 
@@ -136,7 +144,8 @@ Examples:\n\
           "tm-online", "c", "tm-hard-limit:",
           "tm-soft-limit:", "f:", "suffix:",
           "full-prune-extra:", "ttable-prune-type:",
-          "ttable-limit:", "vocab:", "input:", "tm-prune:", "ldm", "v"
+          "ttable-limit:", "vocab:", "input:", "tm-prune:", "ldm", "v",
+          "j:", "cache:"
        };
 
        /// Command line arguments processing for filter_models.
@@ -165,6 +174,8 @@ Examples:\n\
              string pruning_strategy_switch;  ///< What kind of pruning was specified by the user.
              bool   filterLDMs;   ///< Should we filter Lexicalized Distortion Models?
              bool   verbose;      ///< Should we display process on screen?
+             Uint   jobs;         ///< Maximum number of models to filter in parallel
+             string cache_dir;    ///< Cache of filtered models, if not empty
 
           public:
              /// Default constructor.
@@ -192,6 +203,8 @@ Examples:\n\
              , pruning_strategy_switch("")
              , filterLDMs(false)
              , verbose(false)
+             , jobs(1)
+             , cache_dir("")
              {
                 argProcessor::processArgs(argc, argv);
              }
@@ -223,6 +236,8 @@ Examples:\n\
                 mp_arg_reader->testAndSet("ldm", filterLDMs);
                 mp_arg_reader->testAndSet("v", verbose);
                 mp_arg_reader->testAndSet("plp", preserve_ldm_paths);
+                mp_arg_reader->testAndSet("j", jobs);
+                mp_arg_reader->testAndSet("cache", cache_dir);
                 // if the option is set we don't want to strip.
                 strip         = !mp_arg_reader->getSwitch("s");
                 output_config = !mp_arg_reader->getSwitch("c");
@@ -240,6 +255,8 @@ Examples:\n\
                 // Check for user misuage of flags
                 if (suffix == "")
                    error(ETFatal, "You must provide a non empty suffix");
+                if (jobs == 0)
+                   error(ETFatal, "-j must be at least 1");
                 if (tm_soft_limit && tm_hard_limit)
                    error(ETFatal, "Cannot do soft_limit and hard_limit at the same time.");
                 if (no_src_grep && !tm_soft_limit && !tm_hard_limit)
@@ -253,6 +270,28 @@ Examples:\n\
                    error(ETFatal, "Invalid ttable-prune-type (%s); must be one of: 'forward-weights', 'backward-weights', 'combined', or 'full'", phraseTablePruneType.c_str());
              }
 
+             /**
+              * Describe all the options that affect the outputs, for the
+              * cache key.  Options added to this class must be added here too,
+              * unless they only affect messages or speed.
+              */
+             void describeOptions(ostream& os) const
+             {
+                os << "config=" << config << "\nsuffix=" << suffix
+                   << "\nvocab=" << vocab_file << "\ncompress=" << compress
+                   << "\nstrip=" << strip << "\nplp=" << preserve_ldm_paths
+                   << "\nreadonly=" << readonly << "\nlm=" << filterLMs
+                   << "\nsoft=" << tm_soft_limit << "\nhard=" << tm_hard_limit
+                   << "\nlimit_file=" << limit_file << "\nnopersent=" << nopersent
+                   << "\nttable_limit=" << ttable_limit
+                   << "\nfull_prune_extra=" << full_prune_extra
+                   << "\nprune_type=" << phraseTablePruneType
+                   << "\nno_src_grep=" << no_src_grep << "\nonline=" << tm_online
+                   << "\noutput_config=" << output_config
+                   << "\ntm_prune=" << pruning_strategy_switch
+                   << "\nldm=" << filterLDMs << "\n";
+             }
+
              /// Checks if the user requested the vocab
              /// @return Returns if the user asked for the vocab
              inline bool vocab() const
@@ -58,6 +58,10 @@ public:
       return phraseLogProb(phrase_info.phrase);
    }
 
+   virtual PrecomputeThreading precomputeThreading() const {
+      return PRECOMPUTE_CONCURRENT;
+   }
+
    virtual double score(const PartialTranslation& pt) {
       return phraseLogProb(pt.lastPhrase->phrase);
    }
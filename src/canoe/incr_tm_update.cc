@@ -0,0 +1,158 @@
+/**
+ * @file incr_tm_update.cc
+ * @brief Add new sentence pairs to an incremental TM (.incrtm).
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "incremental_tm_feature.h"
+#include "config_io.h"
+#include "file_utils.h"
+#include "str_utils.h"
+#include "arg_reader.h"
+#include "printCopyright.h"
+#include "exception_dump.h"  // MAIN
+
+using namespace Portage;
+using namespace std;
+
+static char help_message[] = "\n\
+incr_tm_update [options] MODEL.incrtm SRC TGT\n\
+\n\
+  Word align the sentence pairs in the parallel files SRC and TGT, extract\n\
+  their phrase pairs, and add them to the counts of the incremental TM\n\
+  described by MODEL.incrtm.  Only the new sentence pairs are aligned.  The\n\
+  counts file is then replaced atomically, and decoders using MODEL.incrtm\n\
+  reload it at their next source sentence.\n\
+\n\
+  SRC and TGT must be tokenized and preprocessed the same way as the text the\n\
+  model is used on, e.g., lowercased, with one sentence per line.\n\
+\n\
+Options:\n\
+\n\
+  -v       Write progress information to cerr.\n\
+  -reset   Discard the existing counts first, so the model is rebuilt from\n\
+           SRC and TGT alone.\n\
+  -remove-src OLD_SRC, -remove-tgt OLD_TGT\n\
+           Before adding SRC and TGT, remove the counts of the sentence pairs\n\
+           in OLD_SRC and OLD_TGT, which must have been added earlier with the\n\
+           same word alignment models, e.g., when they drop out of a rolling\n\
+           window.  It is an error if their phrase pairs are not in the\n\
+           counts, which are then left unchanged.\n\
+";
+
+static bool verbose = false;
+static bool reset = false;
+static string model_file;
+static string src_file;
+static string tgt_file;
+static string remove_src_file;
+static string remove_tgt_file;
+static void getArgs(int argc, const char* const argv[]);
+
+/**
+ * Add the sentence pairs in src_file and tgt_file to the counts of tm, or
+ * remove them if remove is true.
+ * @param[out] num_sents  number of sentence pairs read
+ * @param[out] missing    with remove, number of phrase pair occurrences that
+ *                        were not in the counts
+ * @return number of phrase pair occurrences added or removed
+ */
+static Uint updateCounts(IncrementalTMFeature& tm, const string& src_file,
+                         const string& tgt_file, bool remove,
+                         Uint& num_sents, Uint& missing)
+{
+   iSafeMagicStream src(src_file);
+   iSafeMagicStream tgt(tgt_file);
+   string src_line, tgt_line;
+   vector<string> src_toks, tgt_toks;
+   Uint num_pairs = 0;
+   num_sents = missing = 0;
+   while (getline(src, src_line)) {
+      if (!getline(tgt, tgt_line))
+         error(ETFatal, "%s is shorter than %s", tgt_file.c_str(), src_file.c_str());
+      src_toks.clear();
+      tgt_toks.clear();
+      split(src_line, src_toks);
+      split(tgt_line, tgt_toks);
+      ++num_sents;
+      if (src_toks.empty() || tgt_toks.empty()) continue;
+      if (remove) {
+         Uint sent_missing = 0;
+         num_pairs += tm.removeSentencePair(src_toks, tgt_toks, sent_missing);
+         missing += sent_missing;
+      } else {
+         num_pairs += tm.addSentencePair(src_toks, tgt_toks);
+      }
+   }
+   if (getline(tgt, tgt_line))
+      error(ETFatal, "%s is shorter than %s", src_file.c_str(), tgt_file.c_str());
+   return num_pairs;
+}
+
+int MAIN(argc, argv)
+{
+   printCopyright(2026, "incr_tm_update");
+   getArgs(argc, argv);
+
+   IncrementalTMFeature::Creator creator(model_file);
+   CanoeConfig c;
+   Voc vocab;
+   IncrementalTMFeature* tm = creator.create(c, vocab);
+   if (!tm)
+      error(ETFatal, "Cannot load incremental TM %s", model_file.c_str());
+   if (reset)
+      tm->clearCounts();
+
+   Uint num_removed = 0, num_old_sents = 0, missing = 0;
+   if (!remove_src_file.empty()) {
+      num_removed = updateCounts(*tm, remove_src_file, remove_tgt_file, true,
+                                 num_old_sents, missing);
+      if (missing > 0)
+         error(ETFatal, "%u phrase pair occurrences from %s and %s are not in the "
+               "counts of %s, which were therefore not produced from those sentence "
+               "pairs; rebuild the counts with -reset instead.",
+               missing, remove_src_file.c_str(), remove_tgt_file.c_str(),
+               model_file.c_str());
+   }
+   Uint num_sents = 0;
+   const Uint num_pairs = updateCounts(*tm, src_file, tgt_file, false, num_sents, missing);
+
+   tm->save();
+   if (verbose && !remove_src_file.empty())
+      cerr << "Removed " << num_removed << " phrase pair occurrences from "
+           << num_old_sents << " old sentence pairs." << endl;
+   if (verbose)
+      cerr << "Added " << num_pairs << " phrase pair occurrences from "
+           << num_sents << " sentence pairs; the model now has "
+           << tm->getCounts().size() << " distinct phrase pairs." << endl;
+
+   delete tm;
+}
+END_MAIN
+
+void getArgs(int argc, const char* const argv[])
+{
+   const char* switches[] = {"v", "reset", "remove-src:", "remove-tgt:"};
+   ArgReader arg_reader(ARRAY_SIZE(switches), switches, 3, 3, help_message);
+   arg_reader.read(argc-1, argv+1);
+
+   arg_reader.testAndSet("v", verbose);
+   arg_reader.testAndSet("reset", reset);
+   arg_reader.testAndSet("remove-src", remove_src_file);
+   arg_reader.testAndSet("remove-tgt", remove_tgt_file);
+   arg_reader.testAndSet(0, "model", model_file);
+   arg_reader.testAndSet(1, "src", src_file);
+   arg_reader.testAndSet(2, "tgt", tgt_file);
+
+   if (!IncrementalTMFeature::isA(model_file))
+      error(ETFatal, "%s is not an incremental TM: expected a .incrtm file", model_file.c_str());
+   if (remove_src_file.empty() != remove_tgt_file.empty())
+      error(ETFatal, "-remove-src and -remove-tgt must be used together");
+   if (reset && !remove_src_file.empty())
+      error(ETFatal, "-remove-src and -remove-tgt cannot be used with -reset");
+}
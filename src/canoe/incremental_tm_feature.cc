@@ -0,0 +1,261 @@
+/**
+ * @file incremental_tm_feature.cc
+ * @brief Phrase table that can be updated in place with new sentence pairs
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "incremental_tm_feature.h"
+#include "count_annotation.h"
+#include "phrase_table.h"
+#include "phrase_smoother.h"
+#include "phrase_smoother_cc.h"
+#include "file_utils.h"
+#include "str_utils.h"
+#include <cstdio> // for rename()
+#include <sys/stat.h>
+
+// =============================================== IncrementalTMFeature::Creator
+
+IncrementalTMFeature::Creator::Creator(const string& modelName)
+   : PhraseTableFeature::Creator(modelName)
+   , valid(false)
+{
+   iMagicStream in(modelName);
+   if (!in) return;
+
+   string line;
+   if (!getline(in, line) || line != magicNumber) {
+      error(ETWarn, "Invalid incremental TM file %s: should start with magic number \"%s\"",
+            modelName.c_str(), magicNumber.c_str());
+      return;
+   }
+
+   const string dirName = DirName(modelName);
+   while (getline(in, line)) {
+      trim(line);
+      if (line.empty() || line[0] == '#') continue;
+
+      vector<string> tokens;
+      if (split(line, tokens, "\t") != 2) {
+         error(ETWarn, "Invalid incremental TM file %s: invalid line \"%s\". Each line should have "
+               "a keyword, a tab, and a value", modelName.c_str(), line.c_str());
+         return;
+      }
+      trim(tokens[0]);
+      if (tokens[0] == "counts") {
+         countsFile = adjustRelativePath(dirName, trim(tokens[1]));
+      } else if (tokens[0] == "extractor") {
+         // The last two arguments are the word alignment models
+         vector<string> args;
+         split(tokens[1], args, " ");
+         if (args.size() < 2) {
+            error(ETWarn, "Invalid incremental TM file %s: extractor needs two word alignment models",
+                  modelName.c_str());
+            return;
+         }
+         for (Uint i = args.size() - 2; i < args.size(); ++i) {
+            args[i] = adjustRelativePath(dirName, args[i]);
+            modelFiles.push_back(args[i]);
+         }
+         extractorArgs = join(args);
+      } else {
+         error(ETWarn, "Invalid incremental TM file %s: unknown keyword \"%s\"",
+               modelName.c_str(), tokens[0].c_str());
+         return;
+      }
+   }
+
+   if (countsFile.empty() || extractorArgs.empty()) {
+      error(ETWarn, "Invalid incremental TM file %s: both counts and extractor are required.",
+            modelName.c_str());
+      return;
+   }
+
+   valid = true;
+}
+
+void IncrementalTMFeature::Creator::getNumScores(Uint& numModels, Uint& numAdir, Uint& numCounts, bool& hasAlignments)
+{
+   if (!valid) {
+      numModels = numAdir = numCounts = 0;
+      hasAlignments = false;
+   } else {
+      numModels = 2;
+      numAdir = 0;
+      numCounts = 1;
+      hasAlignments = true;
+   }
+}
+
+IncrementalTMFeature* IncrementalTMFeature::Creator::create(const CanoeConfig &c, Voc &vocab)
+{
+   if (valid && checkFileExists(NULL))
+      return new IncrementalTMFeature(*this, vocab);
+   else
+      return NULL;
+}
+
+bool IncrementalTMFeature::Creator::checkFileExists(vector<string>* list)
+{
+   if (list) list->push_back(modelName);
+   if (!valid)
+      return false;
+
+   // The counts file is optional: a new incremental model starts empty.
+   bool ok = true;
+   if (list && check_if_exists(countsFile)) list->push_back(countsFile);
+   for (Uint i = 0; i < modelFiles.size(); ++i) {
+      if (list) list->push_back(modelFiles[i]);
+      if (!check_if_exists(modelFiles[i])) {
+         error(ETWarn, "Incremental TM %s: cannot find word alignment model %s",
+               modelName.c_str(), modelFiles[i].c_str());
+         ok = false;
+      }
+   }
+   return ok;
+}
+
+
+// =============================================== IncrementalTMFeature
+
+string IncrementalTMFeature::magicNumber = "Portage incremental TM v1.0";
+
+bool IncrementalTMFeature::isA(const string& modelName)
+{
+   return isSuffix(".incrtm", modelName);
+}
+
+IncrementalTMFeature::IncrementalTMFeature(Creator &creator, Voc &vocab)
+   : PhraseTableFeature(vocab)
+   , creator(creator)
+   , zn(NULL)
+   , counts_mtime(0)
+   , counts_size(0)
+   , counts_inode(0)
+{
+   if (!ppe.getArgs(creator.extractorArgs, " ", false))
+      error(ETFatal, "Error loading incremental TM %s: invalid extractor arguments \"%s\".",
+            creator.modelName.c_str(), creator.extractorArgs.c_str());
+   // Same settings as incr-update.sh's gen_phrase_tables -write-al top -whole
+   ppe.display_alignments = 1;
+   ppe.whole_sent_if_no_phrase_pairs = true;
+   ppe.loadModels();
+   zn = new ZNSmoother<Uint>(ppe.ibm_1, ppe.ibm_2);
+
+   if (check_if_exists(creator.countsFile)) {
+      cerr << "Loading incremental TM counts " << creator.countsFile << endl;
+      counts.read(creator.countsFile);
+      statCounts();
+   }
+}
+
+IncrementalTMFeature::~IncrementalTMFeature()
+{
+   delete zn;
+}
+
+Uint IncrementalTMFeature::addSentencePair(const vector<string>& src, const vector<string>& tgt)
+{
+   PhraseTableUint pt;
+   vector< vector<Uint> > sets1;
+   ppe.extractPhrasePairs(src, tgt, sets1, NULL, pt, NULL);
+   return counts.merge(pt);
+}
+
+Uint IncrementalTMFeature::removeSentencePair(const vector<string>& src, const vector<string>& tgt,
+                                              Uint& missing)
+{
+   PhraseTableUint pt;
+   vector< vector<Uint> > sets1;
+   ppe.extractPhrasePairs(src, tgt, sets1, NULL, pt, NULL);
+   return counts.subtract(pt, missing);
+}
+
+void IncrementalTMFeature::statCounts()
+{
+   struct stat st;
+   if (stat(creator.countsFile.c_str(), &st) == 0) {
+      counts_mtime = st.st_mtime;
+      counts_size = st.st_size;
+      counts_inode = st.st_ino;
+   }
+}
+
+bool IncrementalTMFeature::reloadIfChanged()
+{
+   struct stat st;
+   if (stat(creator.countsFile.c_str(), &st) != 0 ||
+       (st.st_mtime == counts_mtime && st.st_size == counts_size &&
+        st.st_ino == counts_inode))
+      return false;
+
+   counts.clear();
+   counts.read(creator.countsFile);
+   statCounts();
+   return true;
+}
+
+void IncrementalTMFeature::newSrcSent(const vector<string>& sentence)
+{
+   reloadIfChanged();
+   PhraseTableFeature::newSrcSent(sentence);
+}
+
+void IncrementalTMFeature::save()
+{
+   const string& countsFile = creator.countsFile;
+   const string tmpFile = DirName(countsFile) + "/.tmp." + BaseName(countsFile);
+   {
+      oSafeMagicStream out(tmpFile);
+      counts.write(out);
+   }
+   if (rename(tmpFile.c_str(), countsFile.c_str()) != 0)
+      error(ETFatal, "Cannot rename %s to %s", tmpFile.c_str(), countsFile.c_str());
+   statCounts();
+}
+
+shared_ptr<TargetPhraseTable> IncrementalTMFeature::find(Range r)
+{
+   shared_ptr<TargetPhraseTable> tgtTable(new TargetPhraseTable);
+   assert(tgtTable);
+
+   const vector<string> srcToks(sourceSent.begin() + r.start, sourceSent.begin() + r.end);
+   const Uint srcCount = counts.lookup(join(srcToks), trans);
+   if (srcCount == 0) return tgtTable;
+
+   vector<string> tgtToks;
+   VectorPhrase tgtPhrase;
+   vector<Uint> jointCount(1);
+   for (Uint i = 0; i < trans.size(); ++i) {
+      const IncrPhraseCounts::Translation& t = trans[i];
+      tgtToks.clear();
+      split(*t.phrase2, tgtToks, " ");
+      tgtPhrase.resize(tgtToks.size());
+      for (Uint j = 0; j < tgtToks.size(); ++j)
+         tgtPhrase[j] = vocab.add(tgtToks[j].c_str());
+
+      // Same column order as the cpt written by gen_phrase_tables with
+      // -s RFSmoother -s ZNSmoother: all p(s|t) first, then all p(t|s).
+      TScore* tScores(&(*tgtTable)[tgtPhrase]);
+      tScores->backward.resize(2);
+      tScores->forward.resize(2);
+      tScores->backward[0] = double(t.joint) / t.marginal2;
+      tScores->backward[1] = zn->probLang1GivenLang2(srcToks, tgtToks);
+      tScores->forward[0] = double(t.joint) / srcCount;
+      tScores->forward[1] = zn->probLang2GivenLang1(srcToks, tgtToks);
+
+      jointCount[0] = t.joint;
+      CountAnnotation::getOrCreate(tScores->annotations)->updateValue(jointCount);
+
+      const string& al = t.info->topAlignment();
+      if (!al.empty())
+         tScores->annotations.initAnnotation("a", al.c_str());
+   }
+
+   return tgtTable;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file incremental_tm_feature.h
+ * @brief Phrase table that can be updated in place with new sentence pairs
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef __INCREMENTAL_TM_FEATURE_H__
+#define __INCREMENTAL_TM_FEATURE_H__
+
+#include "phrasetable_feature.h"
+#include "phrase_pair_extractor.h"
+#include "incr_phrase_counts.h"
+
+namespace Portage {
+
+template<class T> class ZNSmoother;
+
+/**
+ * Incremental TM: a phrase table whose joint counts are kept in memory and
+ * updated one sentence pair at a time, with conditional probabilities
+ * calculated on the fly when the table is queried.
+ *
+ * The model is described by a small text file with suffix .incrtm:
+ *   Portage incremental TM v1.0
+ *   counts<tab>JPT
+ *   extractor<tab>PHRASE PAIR EXTRACTOR OPTIONS AND MODELS
+ * JPT is a joint phrase table (e.g., produced by gen_phrase_tables -j or by
+ * save()); it may be missing or empty when starting a new incremental model.
+ * The extractor options are the ones accepted by
+ * PhrasePairExtractor::getArgs(), typically
+ *   -hmm -a GDFA -m 8 MODEL_L2_GIVEN_L1 MODEL_L1_GIVEN_L2
+ * Relative paths are interpreted relative to the .incrtm file's directory.
+ *
+ * The counts file is reread at the start of a source sentence whenever it has
+ * changed on disk, so running decoders see the sentence pairs added to it by
+ * incr_tm_update (e.g., via incr-update.sh) without being restarted.
+ *
+ * The scores provided are the same as those of the incremental TM built by
+ * incr-update.sh (gen_phrase_tables -s RFSmoother -s ZNSmoother -write-count
+ * -write-al top), so an IncrementalTMFeature can replace the incremental
+ * TPPT as a MixTM component: two models, relative frequencies and Zens-Ney
+ * lexical smoothing, plus joint counts and alignments.
+ */
+class IncrementalTMFeature: public PhraseTableFeature {
+public:
+   static string magicNumber;
+
+   class Creator : public PhraseTableFeature::Creator
+   {
+      friend class IncrementalTMFeature;
+      string countsFile;       ///< the jpt holding the counts, path adjusted
+      string extractorArgs;    ///< PhrasePairExtractor args, model paths adjusted
+      vector<string> modelFiles; ///< the word alignment models in extractorArgs
+
+      /// Set by constructor iff modelName was read successfully and parsed correctly.
+      bool valid;
+
+   public:
+      Creator(const string& modelName);
+      virtual void getNumScores(Uint& numModels, Uint& numAdir, Uint& numCounts, bool& hasAlignments);
+      virtual IncrementalTMFeature* create(const CanoeConfig &c, Voc& vocab);
+      virtual bool checkFileExists(vector<string>* list);
+      virtual Uint64 totalMemmapSize() { return 0; }
+      virtual bool prime(bool full = false) { return true; }
+   }; // IncrementalTMFeature::Creator
+
+   static bool isA(const string& modelName);
+
+   virtual ~IncrementalTMFeature();
+
+   virtual Uint getNumModels()  const { return 2; }
+   virtual Uint getNumAdir()    const { return 0; }
+   virtual Uint getNumCounts()  const { return 1; }
+   virtual bool hasAlignments() const { return true; }
+   virtual shared_ptr<TargetPhraseTable> find(Range r);
+   virtual void newSrcSent(const vector<string>& sentence);
+
+   /**
+    * Extract the phrase pairs from a new sentence pair and add their counts
+    * to the table.  Only the new sentence pair is word aligned; existing
+    * counts are not recalculated.  The change is visible to the next call
+    * to find().
+    * @param src  tokenized source sentence
+    * @param tgt  tokenized target sentence
+    * @return number of phrase pair occurrences added
+    */
+   Uint addSentencePair(const vector<string>& src, const vector<string>& tgt);
+
+   /**
+    * Undo addSentencePair(src, tgt), e.g., when a sentence pair drops out of
+    * a rolling window.  The sentence pair is word aligned again, which gives
+    * the same phrase pairs as long as the word alignment models and the
+    * extractor options have not changed.
+    * @param src  tokenized source sentence
+    * @param tgt  tokenized target sentence
+    * @param[out] missing  number of phrase pair occurrences that could not be
+    *             removed because they were not in the counts
+    * @return number of phrase pair occurrences removed
+    */
+   Uint removeSentencePair(const vector<string>& src, const vector<string>& tgt,
+                           Uint& missing);
+
+   /**
+    * Write the counts back to the counts file named in the .incrtm file.
+    * The file is written under a temporary name and renamed, so that
+    * concurrent readers never see a partial table.
+    */
+   void save();
+
+   /**
+    * Reread the counts file if it has changed since it was last read or
+    * saved, forgetting any sentence pairs added since then.
+    * @return true iff the counts were reloaded
+    */
+   bool reloadIfChanged();
+
+   /// Forget all counts, e.g., to rebuild them from a new corpus.
+   void clearCounts() { counts.clear(); }
+
+   /// Read-only access to the counts
+   const IncrPhraseCounts& getCounts() const { return counts; }
+
+private:
+   Creator creator;
+   PhrasePairExtractor ppe;
+   ZNSmoother<Uint>* zn;
+   IncrPhraseCounts counts;
+   vector<IncrPhraseCounts::Translation> trans; ///< scratch space for find()
+   time_t counts_mtime;   ///< modification time of countsFile when last read or saved
+   off_t counts_size;     ///< its size then
+   ino_t counts_inode;    ///< its inode then
+
+   /// Remember what countsFile looks like now, for reloadIfChanged().
+   void statCounts();
+
+   IncrementalTMFeature(Creator &creator, Voc &vocab);
+}; // IncrementalTMFeature
+
+} // namespace Portage
+#endif // __INCREMENTAL_TM_FEATURE_H__
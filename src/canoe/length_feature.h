@@ -40,10 +40,20 @@ namespace Portage{
          return -double(phrase_info.phrase.size());
       }
 
+      virtual PrecomputeThreading precomputeThreading() const {
+         return PRECOMPUTE_CONCURRENT;
+      }
+
       virtual double futureScore(const PartialTranslation &trans) {
          return 0;
       }
 
+      virtual void evaluate(const PartialTranslation &pt, Evaluation& eval) {
+         eval.score = -double(pt.lastPhrase->phrase.size());
+         eval.futureScore = 0;
+         eval.recombHash = 0;
+      }
+
    };
 
 }
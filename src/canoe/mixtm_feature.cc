@@ -223,6 +223,21 @@ void MixTMFeature::clearCache()
       components[i]->clearCache();
 }
 
+bool MixTMFeature::getCacheCounts(Ulong& hits, Ulong& lookups) const
+{
+   bool found = false;
+   hits = lookups = 0;
+   for (Uint i = 0; i < components.size(); ++i) {
+      Ulong h, l;
+      if (components[i]->getCacheCounts(h, l)) {
+         hits += h;
+         lookups += l;
+         found = true;
+      }
+   }
+   return found;
+}
+
 shared_ptr<TargetPhraseTable> MixTMFeature::find(Range r)
 {
    shared_ptr<TargetPhraseTable> tgtTable(new TargetPhraseTable);
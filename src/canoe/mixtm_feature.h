@@ -50,6 +50,7 @@ public:
    virtual bool hasAlignments() const;
    virtual void newSrcSent(const vector<string>& sentence);
    virtual void clearCache();
+   virtual bool getCacheCounts(Ulong& hits, Ulong& lookups) const;
    virtual shared_ptr<TargetPhraseTable> find(Range r);
 
 private:
@@ -222,6 +222,9 @@ NNJM::NNJM(BasicModelGenerator* bmg, const string& arg, bool arg_is_filename) :
    have_tgt_tags(false),
    cache_hits(0),
    cache_misses(0),
+   doc_mode(bmg->c->docMode),
+   unal_phrasepairs(0),
+   total_phrasepairs(0),
    srctags(NULL),
    tgttags(NULL),
    nnjm_wrap(NULL)
@@ -352,7 +355,8 @@ void NNJM::finalizeInitialization()
 void NNJM::newSrcSent(const newSrcSentInfo& info)
 {
    NNJM_MEMORY_FOOTPRINT_PRINT(cerr << score_cache.getStats() << endl;)
-   score_cache.clear();
+   if (!doc_mode)
+      score_cache.clear();
    vector<string> src_sent_tags;
    if (have_src_tags && !info.src_sent.empty()) {
       if (srctags != NULL && !srctags->empty()) {
@@ -399,7 +403,6 @@ void NNJM::newSrcSent(const newSrcSentInfo& info)
 
 vector<Uchar>* NNJM::getSposMap(const PhraseInfo& pi)
 {
-   static Uint unal_phrasepairs = 0, total_phrasepairs = 0; // for alignment check
    const Uint src_len = pi.src_words.size();
    const Uint tgt_len = pi.phrase.size();
    if (total_phrasepairs <= 100) ++total_phrasepairs;
@@ -415,7 +418,7 @@ vector<Uchar>* NNJM::getSposMap(const PhraseInfo& pi)
       const Uint al_id = al->getAlignmentID();
       Cache::iterator res = align_cache.find(CacheKey(src_len, tgt_len, al_id));
       if (res == align_cache.end()) {
-         const vector< vector<Uint> >& sets = *al->getAlignmentSets(al_id, src_len); // src pos -> links
+         const vector< vector<Uint> >& sets = *al->getAlignmentSets(al_id, src_len, sets_cache); // src pos -> links
 
          // This phrase pair doesn't have an alignment annotaion.
          if (sets.empty()) return NULL;
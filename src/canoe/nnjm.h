@@ -16,6 +16,7 @@
 #include "decoder_feature.h"
 #include "basicmodel.h"
 #include "unal_feature.h"
+#include "alignment_annotation.h"
 #include "nnjm_abstract.h"
 #include "wordClassMapper.h"
 #include <tr1/unordered_map>
@@ -55,7 +56,7 @@ public:
 
 protected:
    // For cxxtest
-   NNJM() {}
+   NNJM() : doc_mode(false) {}
 
 
 
@@ -73,6 +74,9 @@ private:
    bool have_tgt_tags;          ///< true if tgt or out voc contains <TAG>* entries
    Uint cache_hits;             ///< cumulative across all sentences
    Uint cache_misses;           ///< cumulative across all sentences
+   bool doc_mode;               ///< keep score_cache across sentences (canoe -doc-mode)
+   Uint unal_phrasepairs;       ///< phrase pairs without alignments, among...
+   Uint total_phrasepairs;      ///< ...the first 100 seen, for the alignment check
 
    Voc srcvoc;   // for words in source sentence
    Voc tgtvoc;   // for words in target history
@@ -91,6 +95,7 @@ private:
    typedef UnalFeature::CacheKeyHash CacheHash;
    typedef boost::unordered_map<CacheKey,vector<Uchar>, CacheHash> Cache;
    Cache align_cache;   // slen+tlen+alignid -> (tgtpos->srcpos)
+   AlignmentAnnotation::SetsCache sets_cache; // for getSposMap()
 
    typedef vector<Uint>::const_iterator VUI;
 
@@ -101,7 +106,9 @@ private:
    VectorPhrase tgt_pad;        // indexed target-hyp prefix, ""
    VectorPhrase tgt_pad_fut;    // future-score target-hyp prefix, ""
 
-   PTrie<double, Empty, false> score_cache; // ngram,w,spos -> score
+   // ngram,w,spos -> score; in doc_mode, the source window itself replaces
+   // spos, so that scores remain valid across sentences.
+   PTrie<double, Empty, false> score_cache;
 
    // Read a voc in 'num word' format. Return num words beginning w/ tag_prefix.
    Uint readVoc(const string& filename, Voc& voc);
@@ -161,13 +168,17 @@ private:
       if (nnjm) {
          if (config.caching) {
             const Uint len = hist_end-hist_beg;
-            Uint ctxt[len+2];
+            const Uint key_len = len + 1 + (doc_mode ? src_end-src_beg : 1);
+            Uint ctxt[key_len];
             for (Uint i = 0; i < len; ++i) ctxt[i] = *(hist_beg+i);
             ctxt[len] = w;
-            ctxt[len+1] = src_pos;
-            if (!score_cache.find(ctxt, len+2, p)) {
+            if (doc_mode)
+               copy(src_beg, src_end, ctxt+len+1);
+            else
+               ctxt[len+1] = src_pos;
+            if (!score_cache.find(ctxt, key_len, p)) {
                p = nnjm->logprob(src_beg, src_end, hist_beg, hist_end, w, src_pos);
-               score_cache.insert(ctxt, len+2, p);
+               score_cache.insert(ctxt, key_len, p);
                ++cache_misses;
             } else
                ++cache_hits;
@@ -228,9 +239,14 @@ public:
 
    virtual void finalizeInitialization();
    virtual void newSrcSent(const newSrcSentInfo& info);
+   virtual void newDocument() { score_cache.clear(); }
    virtual double score(const PartialTranslation& pt);
 
    virtual double precomputeFutureScore(const PhraseInfo& phrase_info);
+   // Uses tgt_pad_fut, align_cache and score_cache, all private.
+   virtual PrecomputeThreading precomputeThreading() const {
+      return PRECOMPUTE_OWN_THREAD;
+   }
    virtual double futureScore(const PartialTranslation &trans) {return 0.0;}
    virtual double partialScore(const PartialTranslation &trans) {return 0.0;}
 
@@ -239,6 +255,11 @@ public:
    virtual bool isRecombinable(const PartialTranslation &pt1,
                                const PartialTranslation &pt2) {return true;}
    virtual Uint lmLikeContextNeeded() { return config.ngorder-1; }
+   virtual bool getCacheCounts(Ulong& hits, Ulong& lookups) const {
+      hits = cache_hits;
+      lookups = Ulong(cache_hits) + cache_misses;
+      return config.caching;
+   }
 };
 }
 
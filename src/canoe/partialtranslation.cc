@@ -53,6 +53,8 @@ PartialTranslation::PartialTranslation(PhraseInfo* phrase)
    , contextSizes(-1) // == all uninit
    , levInfo(NULL)
    , shiftReduce(NULL)
+   , featureRecombHash(0)
+   , featureRecombHashSet(false)
 {}
 
 PartialTranslation::PartialTranslation(Uint sourceLen,
@@ -64,6 +66,8 @@ PartialTranslation::PartialTranslation(Uint sourceLen,
    , contextSizes(1) // the initial empty state always provides <s> (or its bitoken) as context
    , levInfo(usingLev ? new PartialTranslation::levenshteinInfo() : NULL)
    , shiftReduce(usingSR ? new ShiftReducer(sourceLen) : NULL)
+   , featureRecombHash(0)
+   , featureRecombHashSet(false)
 {
    // Set the range of words not covered to be the full range of words
    if ( sourceLen > 0 ) {
@@ -94,6 +98,8 @@ PartialTranslation::PartialTranslation(const PartialTranslation* trans0,
    , shiftReduce(trans0->shiftReduce
                  ? new ShiftReducer(phrase->src_words,trans0->shiftReduce)
                  : NULL)
+   , featureRecombHash(0)
+   , featureRecombHashSet(false)
 {
    assert(trans0 != NULL);
    assert(phrase != NULL);
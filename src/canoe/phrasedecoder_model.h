@@ -253,6 +253,15 @@ namespace Portage
        */
       ShiftReducer* shiftReduce;
 
+      /**
+       * The decoder features' contribution to BasicModel::computeRecombHash(),
+       * cached when BasicModel::scoreAndFutureScore() evaluates this partial
+       * translation.  Only meaningful if featureRecombHashSet is true.
+       */
+      mutable Uint featureRecombHash;
+      /// Whether featureRecombHash has been calculated
+      mutable bool featureRecombHashSet;
+
       /**
        * Constructor, creates a new partial translation object, intended for
        * creating the initial empty PartialTranslation.
@@ -419,6 +428,22 @@ namespace Portage
        */
       virtual double computeFutureScore(const PartialTranslation &trans) = 0;
 
+      /**
+       * Score trans and estimate its future score in one call.
+       * Equivalent to calling scoreTranslation() and computeFutureScore(),
+       * which is what this default implementation does; models can
+       * override it to share work between the two.
+       * @param[in]  trans        The translation to score
+       * @param[out] score        scoreTranslation(trans, verbosity)
+       * @param[out] futureScore  computeFutureScore(trans)
+       * @param[in]  verbosity    Verbose level
+       */
+      virtual void scoreAndFutureScore(const PartialTranslation &trans,
+            double &score, double &futureScore, Uint verbosity = 1) {
+         score = scoreTranslation(trans, verbosity);
+         futureScore = computeFutureScore(trans);
+      }
+
       /** -- Functions to manage recombining hypotheses. -- */
 
       /**
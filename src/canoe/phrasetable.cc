@@ -107,6 +107,33 @@ void PhraseTable::clearCache()
    }
 }
 
+bool PhraseTable::getTMCacheCounts(Ulong& hits, Ulong& lookups) const
+{
+   bool found = false;
+   hits = lookups = 0;
+   for ( Uint i = 0; i < phraseTableFeatures.size(); ++i ) {
+      Ulong h, l;
+      if (phraseTableFeatures[i]->getCacheCounts(h, l)) {
+         hits += h;
+         lookups += l;
+         found = true;
+      }
+   }
+   return found;
+}
+
+bool PhraseTable::getLDMCacheCounts(Ulong& hits, Ulong& lookups) const
+{
+   hits = lookups = 0;
+   for ( Uint i = 0; i < tpldmTables.size(); ++i ) {
+      uint64_t h, l;
+      tpldmTables[i]->getCacheCounts(h, l);
+      hits += h;
+      lookups += l;
+   }
+   return !tpldmTables.empty();
+}
+
 void PhraseTable::openTTable(const string &modelName, const CanoeConfig &c)
 {
    cerr << "Opening phrase table " << modelName << endl;
@@ -207,6 +234,13 @@ Uint PhraseTable::readFile(const char *file, dir d, bool limitPhrases)
       getline(in, line);
       if (line == "") continue;
 
+      // When filtering, most lines of a large table belong to source phrases
+      // that are not wanted: skip those without parsing them.
+      if (limitPhrases && entry.tgtTable == NULL && entry.sameSrc(line)) {
+         entry.skipline();
+         continue;
+      }
+
       entry.newline(line);
       entry.line = &line;
 
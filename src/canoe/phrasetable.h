@@ -194,6 +194,24 @@ public:
     */
    void clearCache();
 
+   /**
+    * Sum the counts of the lookup caches of the translation models that keep
+    * one (TPPTs).
+    * @param hits     cumulative lookups found in the caches
+    * @param lookups  cumulative lookups
+    * @return false if no translation model keeps a cache
+    */
+   bool getTMCacheCounts(Ulong& hits, Ulong& lookups) const;
+
+   /**
+    * Sum the counts of the lookup caches of the lexicalized distortion models
+    * (TPLDMs).
+    * @param hits     cumulative lookups found in the caches
+    * @param lookups  cumulative lookups
+    * @return false if there are no TPLDMs
+    */
+   bool getLDMCacheCounts(Ulong& hits, Ulong& lookups) const;
+
    /**
     * Set the log value to use for missing or 0-prob entries (default is LOG_ALMOST_0)
     */
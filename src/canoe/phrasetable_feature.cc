@@ -15,6 +15,8 @@
 #include "config_io.h"
 #include "tppt_feature.h"
 #include "mixtm_feature.h"
+#include "incremental_tm_feature.h"
+#include "suffix_array_tm_feature.h"
 #include "multiprob_pt_feature.h"
 
 /********************* TScore **********************/
@@ -59,6 +61,10 @@ PhraseTableFeature::PCreator PhraseTableFeature::getCreator(const string& modelN
       return PCreator(new TPPTFeature::Creator(modelName));
    } else if (MixTMFeature::isA(modelName)) {
       return PCreator(new MixTMFeature::Creator(modelName));
+   } else if (IncrementalTMFeature::isA(modelName)) {
+      return PCreator(new IncrementalTMFeature::Creator(modelName));
+   } else if (SuffixArrayTMFeature::isA(modelName)) {
+      return PCreator(new SuffixArrayTMFeature::Creator(modelName));
    } else {
       // We're not allowed to call MultiProbPTFeature::isA() here, since it
       // calls this function.
@@ -222,6 +222,15 @@ public:
    /// Clear all caches kept by this or submodels.
    virtual void clearCache() {};
 
+   /**
+    * Report the counts of the lookup cache kept by this model, if any, for
+    * canoe's -metricsFilename output.
+    * @param hits     cumulative number of lookups found in the cache
+    * @param lookups  cumulative number of lookups
+    * @return false if this model keeps no cache (the default)
+    */
+   virtual bool getCacheCounts(Ulong& hits, Ulong& lookups) const { return false; }
+
    /**
     * Lookup a source phrase and return all target phrases and scores for it.
     * @param r  query range within the sentence last provided vias newSrcSent()
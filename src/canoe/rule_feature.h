@@ -125,6 +125,9 @@ class RuleFeature : public DecoderFeature
 
       virtual void newSrcSent(const newSrcSentInfo& new_src_sent_info);
       virtual double precomputeFutureScore(const PhraseInfo& phrase_info);
+      virtual PrecomputeThreading precomputeThreading() const {
+         return PRECOMPUTE_CONCURRENT;
+      }
       virtual double futureScore(const PartialTranslation &trans);
       virtual double score(const PartialTranslation& pt);
       virtual Uint computeRecombHash(const PartialTranslation &pt);
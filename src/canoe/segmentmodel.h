@@ -71,6 +71,9 @@ namespace Portage {
     virtual bool isRecombinable(const PartialTranslation &pt1,
                                 const PartialTranslation &pt2) {return true;}
     virtual double futureScore(const PartialTranslation &trans) {return 0;}
+    virtual PrecomputeThreading precomputeThreading() const {
+      return PRECOMPUTE_CONCURRENT;
+    }
   };
 
 
@@ -0,0 +1,599 @@
+/**
+ * @file sentence_dispatcher.cc
+ * @brief Dispatcher/worker protocol to translate one input with many
+ *        long-lived canoe workers.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "sentence_dispatcher.h"
+#include "errors.h"
+#include "str_utils.h"
+#include <algorithm>
+#include <sys/socket.h>  // socket(), send(), recv()
+#include <netinet/in.h>  // sockaddr_in
+#include <netdb.h>       // getaddrinfo()
+#include <poll.h>        // poll()
+#include <fcntl.h>       // fcntl()
+#include <signal.h>      // kill()
+#include <sys/wait.h>    // waitpid()
+#include <unistd.h>      // close(), fork(), gethostname()
+#include <errno.h>       // errno
+#include <cstring>       // strerror()
+
+using namespace Portage;
+using namespace std;
+using namespace Portage::SentenceDispatch;
+
+const char* const SentenceDispatch::streamNames[NUM_STREAMS] = {
+   "out", "nbest", "ffvals", "sfvals", "pal", "lattice", "lattice_state"
+};
+
+/// Convenient errno->string conversion
+static string strerr() {
+   string result;
+   if (errno != 0) {
+      result = ": ";
+      result += strerror(errno);
+   }
+   return result;
+}
+
+/// Don't pass a socket on to the programs we start.
+static void setCloseOnExec(int fd) {
+   fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+}
+
+bool SentenceDispatch::sendMessage(int fd, const string& type, const string& payload)
+{
+   const string message = type + " " + toString(payload.size()) + "\n" + payload;
+   const char* p = message.data();
+   size_t left = message.size();
+   while (left > 0) {
+      // MSG_NOSIGNAL: a peer that has gone away must not kill us with SIGPIPE
+      const ssize_t n = send(fd, p, left, MSG_NOSIGNAL);
+      if (n < 0) {
+         if (errno == EINTR) continue;
+         return false;
+      }
+      p += n;
+      left -= n;
+   }
+   return true;
+}
+
+bool SentenceDispatch::parseMessage(string& buf, string& type, string& payload, bool& bad)
+{
+   static const Uint maxHeaderSize = 64;
+   bad = false;
+   const string::size_type eol = buf.find('\n');
+   if (eol == string::npos) {
+      bad = buf.size() > maxHeaderSize;
+      return false;
+   }
+   vector<string> tokens;
+   Uint length;
+   if (eol > maxHeaderSize || splitZ(buf.substr(0, eol), tokens) != 2 ||
+       !conv(tokens[1], length)) {
+      bad = true;
+      return false;
+   }
+   if (buf.size() - (eol + 1) < length)
+      return false;
+   type = tokens[0];
+   payload = buf.substr(eol + 1, length);
+   buf.erase(0, eol + 1 + length);
+   return true;
+}
+
+string SentenceDispatch::encodeStreams(const vector<string>& streams)
+{
+   assert(streams.size() == NUM_STREAMS);
+   string payload;
+   for (Uint k = 0; k < NUM_STREAMS; ++k) {
+      payload += toString(streams[k].size());
+      payload += '\n';
+      payload += streams[k];
+   }
+   return payload;
+}
+
+bool SentenceDispatch::decodeStreams(const string& payload, vector<string>& streams)
+{
+   streams.assign(NUM_STREAMS, "");
+   string::size_type pos = 0;
+   for (Uint k = 0; k < NUM_STREAMS; ++k) {
+      const string::size_type eol = payload.find('\n', pos);
+      Uint length;
+      if (eol == string::npos || !conv(payload.substr(pos, eol - pos), length) ||
+          payload.size() - (eol + 1) < length)
+         return false;
+      streams[k] = payload.substr(eol + 1, length);
+      pos = eol + 1 + length;
+   }
+   return pos == payload.size();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// DispatchWorker
+
+DispatchWorker::DispatchWorker(const string& spec, const vector<string>& files)
+   : fd(-1), remote(spec)
+{
+   vector<string> tokens;
+   if (splitZ(spec, tokens, ":") != 2)
+      error(ETFatal, "Invalid dispatcher specification: %s; must be HOST:PORT", spec.c_str());
+
+   struct addrinfo hints;
+   struct addrinfo* addresses;
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   if (0 != getaddrinfo(tokens[0].c_str(), tokens[1].c_str(), &hints, &addresses))
+      error(ETFatal, "Can't resolve %s", spec.c_str());
+
+   // Try each address, e.g., both IPv6 and IPv4 for localhost.
+   errno = 0;
+   for (struct addrinfo* a = addresses; a != NULL && fd < 0; a = a->ai_next) {
+      fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) < 0) {
+         close(fd);
+         fd = -1;
+      }
+   }
+   freeaddrinfo(addresses);
+   if (fd < 0)
+      error(ETFatal, "Error connecting to dispatcher %s%s", spec.c_str(), strerr().c_str());
+   setCloseOnExec(fd);
+
+   assert(files.size() == NUM_STREAMS);
+   ostringstream hello;
+   for (Uint k = OUT + 1; k < NUM_STREAMS; ++k)
+      if (!files[k].empty())
+         hello << streamNames[k] << '\t' << files[k] << '\n';
+   char hostname[256] = "";
+   gethostname(hostname, sizeof(hostname) - 1);
+   hello << "worker\t" << hostname << ":" << getpid() << '\n';
+   if (!sendMessage(fd, "HELLO", hello.str()))
+      error(ETFatal, "Error writing to dispatcher %s%s", spec.c_str(), strerr().c_str());
+}
+
+DispatchWorker::~DispatchWorker()
+{
+   if (fd >= 0) close(fd);
+}
+
+bool DispatchWorker::getBatch(string& batch)
+{
+   string type;
+   bool bad;
+   while (!parseMessage(inbuf, type, batch, bad)) {
+      if (bad)
+         error(ETFatal, "Invalid message from dispatcher %s", remote.c_str());
+      char buffer[65536];
+      const ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      inbuf.append(buffer, n);
+   }
+   if (type == "DONE")
+      return false;
+   if (type != "BATCH")
+      error(ETFatal, "Unexpected message %s from dispatcher %s", type.c_str(), remote.c_str());
+   return true;
+}
+
+void DispatchWorker::sendResult(const vector<string>& streams)
+{
+   // If this fails, the dispatcher is gone, and getBatch() will say so.
+   sendMessage(fd, "RESULT", encodeStreams(streams));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// SentenceDispatcher
+
+SentenceDispatcher::SentenceDispatcher(const vector<string>& sents, const Options& opts)
+   : sents(sents)
+   , opts(opts)
+   , tokensLeft(0)
+   , nextSent(0)
+   , nextWrite(0)
+   , listenFd(-1)
+   , port(0)
+   , outputs(NUM_STREAMS, (oSafeMagicStream*)NULL)
+   , reissued(0)
+{
+   // A sentence costs one token more than its length, so that empty lines
+   // count too.
+   tokens.resize(sents.size());
+   vector<string> toks;
+   for (Uint s = 0; s < sents.size(); ++s) {
+      tokens[s] = splitZ(sents[s], toks) + 1;
+      tokensLeft += tokens[s];
+   }
+}
+
+SentenceDispatcher::~SentenceDispatcher()
+{
+   for (Uint i = 0; i < workers.size(); ++i)
+      close(workers[i].fd);
+   if (listenFd >= 0) close(listenFd);
+   for (Uint k = 0; k < outputs.size(); ++k)
+      delete outputs[k];
+}
+
+Uint SentenceDispatcher::listen(Uint requested_port)
+{
+   errno = 0;
+   listenFd = socket(AF_INET, SOCK_STREAM, 0);
+   if (listenFd < 0)
+      error(ETFatal, "Can't create socket%s", strerr().c_str());
+   setCloseOnExec(listenFd);
+   int one = 1;
+   setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+   struct sockaddr_in address;
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_ANY);
+   address.sin_port = htons(requested_port);
+   if (bind(listenFd, (struct sockaddr*)&address, sizeof(address)) < 0)
+      error(ETFatal, "Can't bind to port %u%s", requested_port, strerr().c_str());
+   if (::listen(listenFd, 128) < 0)
+      error(ETFatal, "Can't listen on port %u%s", requested_port, strerr().c_str());
+
+   socklen_t length = sizeof(address);
+   if (getsockname(listenFd, (struct sockaddr*)&address, &length) < 0)
+      error(ETFatal, "Can't get the listening port%s", strerr().c_str());
+   port = ntohs(address.sin_port);
+   return port;
+}
+
+void SentenceDispatcher::startLocalWorkers(Uint n, const string& cmd)
+{
+   assert(listenFd >= 0);
+   const string command = cmd + " -dispatcher localhost:" + toString(port);
+   if (opts.verbose)
+      cerr << "Starting " << n << " local workers: " << command << endl;
+   cout.flush();
+   cerr.flush();
+   for (Uint i = 0; i < n; ++i) {
+      const pid_t pid = fork();
+      if (pid < 0)
+         error(ETFatal, "Can't start local worker%s", strerr().c_str());
+      if (pid == 0) {
+         // Workers return their outputs through the dispatcher; keep their
+         // standard output, if they write anything there, out of ours.
+         dup2(2, 1);
+         execl("/bin/sh", "sh", "-c", command.c_str(), (char*)NULL);
+         _exit(127);
+      }
+      localWorkers.push_back(pid);
+   }
+}
+
+void SentenceDispatcher::run(ostream& out)
+{
+   const bool hadLocalWorkers = !localWorkers.empty();
+   const time_t start = time(NULL);
+
+   while (!finished()) {
+      reapLocalWorkers();
+      if (hadLocalWorkers && localWorkers.empty() && workers.empty())
+         error(ETFatal, "All the local workers have exited before the end of the job; "
+               "see their messages above.");
+
+      vector<struct pollfd> fds(workers.size() + 1);
+      fds[0].fd = listenFd;
+      fds[0].events = POLLIN;
+      for (Uint i = 0; i < workers.size(); ++i) {
+         fds[i+1].fd = workers[i].fd;
+         fds[i+1].events = POLLIN;
+      }
+      // Wake up every second to check on local workers and reissue batches.
+      if (poll(&fds[0], fds.size(), 1000) < 0) {
+         if (errno == EINTR) continue;
+         error(ETFatal, "Error waiting for workers%s", strerr().c_str());
+      }
+
+      for (Uint i = workers.size(); i-- > 0; ) {
+         if (fds[i+1].revents == 0) continue;
+         if (!receive(workers[i], out)) {
+            disconnect(workers[i]);
+            workers.erase(workers.begin() + i);
+         }
+      }
+      if (fds[0].revents & POLLIN)
+         accept();
+
+      // Workers waiting for work may get some now: a batch lost by another
+      // worker, an old enough batch to reissue, or DONE.
+      for (Uint i = workers.size(); i-- > 0; ) {
+         if (!workers[i].waiting) continue;
+         if (!dispatch(workers[i])) {
+            disconnect(workers[i]);
+            workers.erase(workers.begin() + i);
+         }
+      }
+   }
+
+   // Idle workers are told they are done.  Workers still translating a copy
+   // of a batch that came back from another worker are just disconnected;
+   // the local ones are also stopped, since their work is no longer needed.
+   for (Uint i = 0; i < workers.size(); ++i) {
+      Worker& w(workers[i]);
+      if (w.batch < 0)
+         sendMessage(w.fd, "DONE", "");
+      else {
+         vector<string> tokens;
+         if (splitZ(w.desc, tokens, ":") == 2) {
+            pid_t pid = conv<pid_t>(tokens[1]);
+            if (find(localWorkers.begin(), localWorkers.end(), pid) != localWorkers.end())
+               kill(pid, SIGTERM);
+         }
+      }
+      close(w.fd);
+   }
+   workers.clear();
+   for (Uint i = 0; i < localWorkers.size(); ++i)
+      waitpid(localWorkers[i], NULL, 0);
+   localWorkers.clear();
+
+   if (opts.verbose)
+      cerr << "Dispatched " << sents.size() << " sentences in " << batches.size()
+           << " batches (" << reissued << " reissued) in "
+           << (time(NULL) - start) << " seconds." << endl;
+}
+
+void SentenceDispatcher::accept()
+{
+   const int fd = ::accept(listenFd, NULL, NULL);
+   if (fd < 0) {
+      if (errno != EINTR && errno != EAGAIN && errno != ECONNABORTED)
+         error(ETWarn, "Error accepting a worker connection%s", strerr().c_str());
+      return;
+   }
+   setCloseOnExec(fd);
+   workers.push_back(Worker(fd));
+   workers.back().desc = "connection " + toString(fd);
+}
+
+bool SentenceDispatcher::receive(Worker& w, ostream& out)
+{
+   char buffer[65536];
+   const ssize_t n = recv(w.fd, buffer, sizeof(buffer), 0);
+   if (n < 0 && errno == EINTR) return true;
+   if (n <= 0) return false;
+   w.inbuf.append(buffer, n);
+
+   string type, payload;
+   bool bad;
+   while (parseMessage(w.inbuf, type, payload, bad))
+      if (!handleMessage(w, type, payload, out))
+         return false;
+   if (bad)
+      error(ETWarn, "Invalid message from worker %s; disconnecting it.", w.desc.c_str());
+   return !bad;
+}
+
+bool SentenceDispatcher::handleMessage(Worker& w, const string& type,
+                                       const string& payload, ostream& out)
+{
+   if (type == "HELLO" && !w.ready) {
+      if (!handleHello(w, payload)) return false;
+   } else if (type == "RESULT" && w.ready) {
+      if (!handleResult(w, payload)) return false;
+      writeOutputs(out);
+   } else {
+      error(ETWarn, "Unexpected message %s from worker %s; disconnecting it.",
+            type.c_str(), w.desc.c_str());
+      return false;
+   }
+   return dispatch(w);
+}
+
+bool SentenceDispatcher::handleHello(Worker& w, const string& payload)
+{
+   vector<string> workerFiles(NUM_STREAMS);
+   vector<string> lines, tokens;
+   splitZ(payload, lines, "\n");
+   for (Uint i = 0; i < lines.size(); ++i) {
+      if (splitZ(lines[i], tokens, "\t", 2) != 2) {
+         error(ETWarn, "Invalid HELLO line from worker %s: %s", w.desc.c_str(), lines[i].c_str());
+         return false;
+      }
+      if (tokens[0] == "worker") {
+         w.desc = tokens[1];
+         continue;
+      }
+      const Uint k = find(streamNames + OUT + 1, streamNames + NUM_STREAMS, tokens[0]) - streamNames;
+      if (k == NUM_STREAMS) {
+         error(ETWarn, "Unknown output %s from worker %s", tokens[0].c_str(), w.desc.c_str());
+         return false;
+      }
+      workerFiles[k] = tokens[1];
+   }
+
+   if (files.empty()) {
+      // The first worker determines which outputs the job produces.
+      files = workerFiles;
+      for (Uint k = OUT + 1; k < NUM_STREAMS; ++k)
+         if (!files[k].empty()) {
+            if (opts.verbose)
+               cerr << "Writing " << streamNames[k] << " output to " << files[k] << endl;
+            outputs[k] = new oSafeMagicStream(files[k]);
+         }
+   } else if (workerFiles != files) {
+      error(ETWarn, "Worker %s does not produce the same outputs as the first worker; "
+            "disconnecting it.", w.desc.c_str());
+      return false;
+   }
+
+   w.ready = true;
+   if (opts.verbose)
+      cerr << "Worker " << w.desc << " connected." << endl;
+   return true;
+}
+
+bool SentenceDispatcher::handleResult(Worker& w, const string& payload)
+{
+   if (w.batch < 0) {
+      error(ETWarn, "Unexpected RESULT from worker %s; disconnecting it.", w.desc.c_str());
+      return false;
+   }
+   Batch& batch(batches[w.batch]);
+   if (!batch.done) {
+      vector<string> streams;
+      if (!decodeStreams(payload, streams)) {
+         error(ETWarn, "Invalid RESULT from worker %s; disconnecting it.", w.desc.c_str());
+         return false;
+      }
+      const Uint lines = count(streams[OUT].begin(), streams[OUT].end(), '\n');
+      if (lines != batch.end - batch.begin) {
+         error(ETWarn, "Worker %s returned %u translations for %u sentences; disconnecting it.",
+               w.desc.c_str(), lines, batch.end - batch.begin);
+         return false;
+      }
+      batch.streams.swap(streams);
+      batch.done = true;
+   }
+   // else another copy of this batch came back first.
+   --batch.copies;
+   w.batch = -1;
+   return true;
+}
+
+bool SentenceDispatcher::dispatch(Worker& w)
+{
+   w.waiting = false;
+   if (finished())
+      return sendMessage(w.fd, "DONE", "");
+   const int b = nextBatch();
+   if (b < 0) {
+      w.waiting = true;
+      return true;
+   }
+   return sendBatch(w, b);
+}
+
+int SentenceDispatcher::nextBatch()
+{
+   // Batches lost by a worker come first.
+   while (!lostBatches.empty()) {
+      const Uint b = lostBatches.front();
+      lostBatches.pop_front();
+      if (!batches[b].done && batches[b].copies == 0)
+         return b;
+   }
+
+   if (nextSent < sents.size()) {
+      // Local workers count even before they connect.
+      Uint numWorkers = 0;
+      for (Uint i = 0; i < workers.size(); ++i)
+         if (workers[i].ready) ++numWorkers;
+      numWorkers = max(1u, max(numWorkers, Uint(localWorkers.size())));
+      const Uint target = max(opts.minBatchTokens,
+                              min(opts.maxBatchTokens, tokensLeft / (2 * numWorkers)));
+      Uint end = nextSent, batchTokens = 0;
+      do
+         batchTokens += tokens[end++];
+      while (end < sents.size() && batchTokens + tokens[end] <= target);
+      batches.push_back(Batch(nextSent, end));
+      tokensLeft -= batchTokens;
+      nextSent = end;
+      return batches.size() - 1;
+   }
+
+   if (opts.reissue) {
+      // The oldest unfinished batch is the one holding back the outputs.
+      const time_t now = time(NULL);
+      for (Uint b = nextWrite; b < batches.size(); ++b)
+         if (!batches[b].done && batches[b].copies == 1 &&
+             Uint(now - batches[b].issued) >= opts.reissueAfter)
+            return b;
+   }
+   return -1;
+}
+
+bool SentenceDispatcher::sendBatch(Worker& w, Uint b)
+{
+   Batch& batch(batches[b]);
+   if (batch.copies++ == 0)
+      batch.issued = time(NULL);
+   else {
+      ++reissued;
+      if (opts.verbose)
+         cerr << "Reissuing sentences " << batch.begin << " to " << batch.end - 1
+              << " to worker " << w.desc << endl;
+   }
+   // Assigned before sending, so that disconnect() recovers it on failure.
+   w.batch = b;
+
+   string payload;
+   for (Uint s = batch.begin; s < batch.end; ++s) {
+      payload += toString(s);
+      payload += '\t';
+      payload += sents[s];
+      payload += '\n';
+   }
+   return sendMessage(w.fd, "BATCH", payload);
+}
+
+void SentenceDispatcher::disconnect(Worker& w)
+{
+   if (w.batch >= 0) {
+      Batch& batch(batches[w.batch]);
+      --batch.copies;
+      if (!batch.done && batch.copies == 0) {
+         error(ETWarn, "Worker %s disconnected while translating sentences %u to %u.",
+               w.desc.c_str(), batch.begin, batch.end - 1);
+         if (++batch.lost >= opts.maxLost)
+            error(ETFatal, "Sentences %u to %u were lost by %u workers; giving up.",
+                  batch.begin, batch.end - 1, batch.lost);
+         lostBatches.push_front(w.batch);
+      }
+      w.batch = -1;
+   } else if (opts.verbose) {
+      cerr << "Worker " << w.desc << " disconnected." << endl;
+   }
+   close(w.fd);
+}
+
+void SentenceDispatcher::writeOutputs(ostream& out)
+{
+   const Uint before = nextWrite;
+   while (nextWrite < batches.size() && batches[nextWrite].done) {
+      Batch& batch(batches[nextWrite]);
+      out << batch.streams[OUT];
+      for (Uint k = OUT + 1; k < NUM_STREAMS; ++k)
+         if (outputs[k])
+            *outputs[k] << batch.streams[k];
+      vector<string>().swap(batch.streams);
+      ++nextWrite;
+   }
+   if (nextWrite > before) {
+      out.flush();
+      if (opts.verbose)
+         cerr << "Wrote outputs for " << batches[nextWrite-1].end << "/"
+              << sents.size() << " sentences." << endl;
+   }
+}
+
+void SentenceDispatcher::reapLocalWorkers()
+{
+   for (Uint i = localWorkers.size(); i-- > 0; ) {
+      int status;
+      if (waitpid(localWorkers[i], &status, WNOHANG) == localWorkers[i]) {
+         if (!(WIFEXITED(status) && WEXITSTATUS(status) == 0))
+            error(ETWarn, "Local worker %d exited abnormally (status %d).",
+                  localWorkers[i], status);
+         localWorkers.erase(localWorkers.begin() + i);
+      }
+   }
+}
@@ -0,0 +1,243 @@
+/**
+ * @file sentence_dispatcher.h
+ * @brief Dispatcher/worker protocol to translate one input with many
+ *        long-lived canoe workers.
+ *
+ * The dispatcher (canoe-dispatcher) holds the source text and listens on a
+ * TCP port.  Workers (canoe -dispatcher HOST:PORT) connect to it, locally or
+ * from other nodes, and repeatedly receive a batch of consecutive source
+ * sentences, translate it, and send back all its outputs: the 1-best
+ * translations and, if the worker's configuration asks for them, the n-best
+ * lists, ffvals, sfvals, pal and lattice outputs, as canoe would write them
+ * in -append mode.  The dispatcher writes each output in input order as soon
+ * as all the batches before it are complete, so no worker needs the input
+ * file and no output needs to be reassembled afterwards.
+ *
+ * Batches are sized by source tokens, following guided self-scheduling: each
+ * new batch gets about 1/(2W) of the tokens not yet dispatched, where W is
+ * the number of workers, within [minBatchTokens, maxBatchTokens].  Batches
+ * are thus large at first and get smaller towards the end, so the workers
+ * finish at about the same time.  Once every sentence has been dispatched,
+ * an idle worker gets a second copy of the oldest unfinished batch, and the
+ * first copy to come back is used: a straggler, e.g., a worker on an
+ * overloaded node, then delays the end of the job by at most one batch.  The
+ * batch of a worker that disconnects before returning it is dispatched
+ * again.
+ *
+ * Protocol: every message is a header line "TYPE LENGTH\n" followed by
+ * LENGTH bytes of payload.
+ *  - worker -> dispatcher
+ *    - HELLO: one "NAME\tFILE\n" line for each output file the worker's
+ *      configuration produces (NAME is one of streamNames, except "out"),
+ *      plus a "worker\tDESCRIPTION\n" line.
+ *    - RESULT: the outputs of the last batch received, for each stream in
+ *      Stream order: "LENGTH\n" followed by LENGTH bytes.
+ *  - dispatcher -> worker, in reply to HELLO or RESULT
+ *    - BATCH: one "ID\tSOURCE SENTENCE\n" line per sentence, with ID the
+ *      0-based line number in the input, as for canoe -lb.
+ *    - DONE: empty; all the work is done and the worker should exit.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef SENTENCE_DISPATCHER_H
+#define SENTENCE_DISPATCHER_H
+
+#include "portage_defs.h"
+#include "file_utils.h"
+#include <deque>
+#include <sys/types.h>
+
+namespace Portage {
+
+namespace SentenceDispatch {
+
+   /// The outputs returned by a worker for each batch.
+   enum Stream {
+      OUT,             ///< 1-best translations, canoe's standard output
+      NBEST,           ///< n-best lists
+      FFVALS,          ///< n-best feature values
+      SFVALS,          ///< n-best sparse feature values
+      PAL,             ///< n-best phrase alignments
+      LATTICE,         ///< lattices
+      LATTICE_STATE,   ///< lattice states
+      NUM_STREAMS
+   };
+
+   /// Names of the streams in HELLO messages.
+   extern const char* const streamNames[NUM_STREAMS];
+
+   /**
+    * Send one message on socket fd.
+    * @return true iff the whole message was sent
+    */
+   bool sendMessage(int fd, const string& type, const string& payload);
+
+   /**
+    * Extract the first message from buf, if it is complete.
+    * @param buf      data received so far; the message is removed from it
+    * @param type     set to the message type
+    * @param payload  set to the message payload
+    * @param bad      set to true if buf does not start with a valid header
+    * @return true iff a complete message was extracted
+    */
+   bool parseMessage(string& buf, string& type, string& payload, bool& bad);
+
+   /// Encode the streams of a RESULT message.
+   string encodeStreams(const vector<string>& streams);
+
+   /**
+    * Decode the streams of a RESULT message.
+    * @return true iff payload is a valid encoding of NUM_STREAMS streams
+    */
+   bool decodeStreams(const string& payload, vector<string>& streams);
+
+} // namespace SentenceDispatch
+
+
+/// Worker side of the protocol, used by canoe -dispatcher HOST:PORT.
+class DispatchWorker : private NonCopyable {
+   int fd;               ///< connection to the dispatcher
+   string remote;        ///< HOST:PORT of the dispatcher, for messages
+   string inbuf;         ///< data received and not yet parsed
+public:
+   /**
+    * Connect to the dispatcher and say hello.
+    * @param spec   HOST:PORT of the dispatcher
+    * @param files  name of the file each stream goes into in -append mode,
+    *               indexed by SentenceDispatch::Stream; empty for streams
+    *               this worker does not produce.  files[OUT] is ignored.
+    */
+   DispatchWorker(const string& spec, const vector<string>& files);
+   /// Destructor; closes the connection.
+   ~DispatchWorker();
+
+   /**
+    * Get the next batch to translate.
+    * @param batch  set to the batch, in canoe -lb input format
+    * @return false if the dispatcher says all the work is done, or has
+    *         closed the connection, e.g., because another worker already
+    *         returned the last batch.
+    */
+   bool getBatch(string& batch);
+
+   /**
+    * Send back the outputs of the batch last received.
+    * @param streams  outputs, indexed by SentenceDispatch::Stream
+    */
+   void sendResult(const vector<string>& streams);
+};
+
+
+/// Dispatcher side of the protocol, used by canoe-dispatcher.
+class SentenceDispatcher : private NonCopyable {
+public:
+   /// Tuning parameters
+   struct Options {
+      Uint minBatchTokens;  ///< minimum batch size, in source tokens
+      Uint maxBatchTokens;  ///< maximum batch size, in source tokens
+      bool reissue;         ///< give idle workers copies of unfinished batches
+      Uint reissueAfter;    ///< minimum age of a batch before reissuing it, in seconds
+      Uint maxLost;         ///< give up on a batch lost by this many workers
+      Uint verbose;         ///< verbosity level
+      Options()
+         : minBatchTokens(1), maxBatchTokens(500), reissue(true)
+         , reissueAfter(0), maxLost(3), verbose(0) {}
+   };
+
+   /**
+    * Constructor.
+    * @param sents  source sentences, one per line, without newlines
+    * @param opts   tuning parameters
+    */
+   SentenceDispatcher(const vector<string>& sents, const Options& opts);
+   /// Destructor; closes all connections and output files.
+   ~SentenceDispatcher();
+
+   /**
+    * Start listening for workers.
+    * @param port  TCP port; 0 for any free port
+    * @return the port used
+    */
+   Uint listen(Uint port);
+
+   /**
+    * Start local workers; must be called after listen().
+    * @param n    number of workers to start
+    * @param cmd  canoe command to run; " -dispatcher localhost:PORT" is
+    *             appended to it
+    */
+   void startLocalWorkers(Uint n, const string& cmd);
+
+   /**
+    * Dispatch all the input to the workers, and write the outputs.  Returns
+    * when all the outputs have been written.  Exits with a fatal error if
+    * all the local workers, and no remote ones, have exited before that.
+    * @param out  where to write the 1-best translations
+    */
+   void run(ostream& out);
+
+private:
+   /// A batch of consecutive source sentences.
+   struct Batch {
+      Uint begin, end;          ///< sentences [begin, end)
+      Uint copies;              ///< number of workers translating it now
+      Uint lost;                ///< number of workers that lost it
+      time_t issued;            ///< when it was last issued
+      bool done;                ///< whether its outputs have been received
+      vector<string> streams;   ///< its outputs, until written
+      Batch(Uint begin, Uint end)
+         : begin(begin), end(end), copies(0), lost(0), issued(0), done(false) {}
+   };
+
+   /// A connected worker.
+   struct Worker {
+      int fd;           ///< connection
+      string inbuf;     ///< data received and not yet parsed
+      bool ready;       ///< received HELLO
+      int batch;        ///< index of the batch it is translating; -1 if none
+      bool waiting;     ///< waiting for work, which will come later
+      string desc;      ///< description, for messages
+      Worker(int fd) : fd(fd), ready(false), batch(-1), waiting(false) {}
+   };
+
+   const vector<string>& sents;
+   const Options opts;
+   vector<Uint> tokens;         ///< number of tokens in each sentence
+   Uint tokensLeft;             ///< number of tokens not yet in a batch
+   Uint nextSent;               ///< first sentence not yet in a batch
+   vector<Batch> batches;       ///< batches created so far, in input order
+   Uint nextWrite;              ///< first batch whose outputs are not written
+   deque<Uint> lostBatches;     ///< batches to dispatch again
+   vector<Worker> workers;      ///< connected workers
+   int listenFd;                ///< listening socket
+   Uint port;                   ///< listening port
+   vector<pid_t> localWorkers;  ///< local worker processes still running
+   vector<string> files;        ///< output file names, from the first HELLO
+   vector<oSafeMagicStream*> outputs;   ///< output streams except OUT
+   Uint reissued;               ///< number of batches reissued
+
+   bool finished() const {
+      return nextSent == sents.size() && nextWrite == batches.size();
+   }
+   void accept();
+   bool receive(Worker& w, ostream& out);
+   bool handleMessage(Worker& w, const string& type, const string& payload,
+                      ostream& out);
+   bool handleHello(Worker& w, const string& payload);
+   bool handleResult(Worker& w, const string& payload);
+   bool dispatch(Worker& w);
+   int nextBatch();
+   bool sendBatch(Worker& w, Uint b);
+   void disconnect(Worker& w);
+   void writeOutputs(ostream& out);
+   void reapLocalWorkers();
+}; // SentenceDispatcher
+
+} // Portage
+
+#endif // SENTENCE_DISPATCHER_H
@@ -0,0 +1,474 @@
+/**
+ * @file suffix_array_tm_feature.cc
+ * @brief Phrase table extracted on the fly from a suffix-array-indexed bitext
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "suffix_array_tm_feature.h"
+#include "count_annotation.h"
+#include "alignment_file.h"
+#include "ibm.h"
+#include "phrase_smoother.h"
+#include "phrase_smoother_cc.h"
+#include "tpt_utils.h"
+#include "file_utils.h"
+#include "str_utils.h"
+#include <unistd.h> // for access()
+
+using ugdiss::id_type;
+using ugdiss::getFileSize;
+
+// =============================================== SuffixArrayTMFeature::Creator
+
+SuffixArrayTMFeature::Creator::Creator(const string& modelName)
+   : PhraseTableFeature::Creator(modelName)
+   , maxSamples(300)
+   , maxPhraseLen(7)
+   , valid(false)
+{
+   iMagicStream in(modelName);
+   if (!in) return;
+
+   string line;
+   if (!getline(in, line) || line != magicNumber) {
+      error(ETWarn, "Invalid suffix-array TM file %s: should start with magic number \"%s\"",
+            modelName.c_str(), magicNumber.c_str());
+      return;
+   }
+
+   const string dirName = DirName(modelName);
+   while (getline(in, line)) {
+      trim(line);
+      if (line.empty() || line[0] == '#') continue;
+
+      vector<string> tokens;
+      if (split(line, tokens, "\t") != 2) {
+         error(ETWarn, "Invalid suffix-array TM file %s: invalid line \"%s\". Each line should have "
+               "a keyword, a tab, and a value", modelName.c_str(), line.c_str());
+         return;
+      }
+      trim(tokens[0]);
+      trim(tokens[1]);
+      if (tokens[0] == "L1") {
+         base1 = adjustRelativePath(dirName, tokens[1]);
+      } else if (tokens[0] == "L2") {
+         base2 = adjustRelativePath(dirName, tokens[1]);
+      } else if (tokens[0] == "alignment") {
+         alignmentFile = adjustRelativePath(dirName, tokens[1]);
+      } else if (tokens[0] == "lex") {
+         if (split(tokens[1], lexFiles, " ") != 2) {
+            error(ETWarn, "Invalid suffix-array TM file %s: lex needs two IBM1 models",
+                  modelName.c_str());
+            return;
+         }
+         for (Uint i = 0; i < lexFiles.size(); ++i)
+            lexFiles[i] = adjustRelativePath(dirName, lexFiles[i]);
+      } else if (tokens[0] == "samples" || tokens[0] == "max_phrase_len") {
+         Uint& value = tokens[0] == "samples" ? maxSamples : maxPhraseLen;
+         if (!conv(tokens[1], value) || value == 0) {
+            error(ETWarn, "Invalid suffix-array TM file %s: %s must be a positive integer",
+                  modelName.c_str(), tokens[0].c_str());
+            return;
+         }
+      } else {
+         error(ETWarn, "Invalid suffix-array TM file %s: unknown keyword \"%s\"",
+               modelName.c_str(), tokens[0].c_str());
+         return;
+      }
+   }
+
+   if (base1.empty() || base2.empty() || alignmentFile.empty()) {
+      error(ETWarn, "Invalid suffix-array TM file %s: L1, L2 and alignment are required.",
+            modelName.c_str());
+      return;
+   }
+
+   valid = true;
+}
+
+string SuffixArrayTMFeature::Creator::getSufaPrefix(const string& base)
+{
+   // Same search order as ugdiss::open_mm_tsa()
+   if (0 == access((base + ".tpsa/mct").c_str(), F_OK))
+      return base + ".tpsa/";
+   else if (0 == access((base + "/mct").c_str(), F_OK))
+      return base + "/";
+   else if (0 == access((base + ".mct").c_str(), F_OK))
+      return base + ".";
+   else
+      return "";
+}
+
+void SuffixArrayTMFeature::Creator::getNumScores(Uint& numModels, Uint& numAdir, Uint& numCounts, bool& hasAlignments)
+{
+   if (!valid) {
+      numModels = numAdir = numCounts = 0;
+      hasAlignments = false;
+   } else {
+      numModels = lexFiles.empty() ? 1 : 2;
+      numAdir = 0;
+      numCounts = 1;
+      hasAlignments = true;
+   }
+}
+
+SuffixArrayTMFeature* SuffixArrayTMFeature::Creator::create(const CanoeConfig &c, Voc &vocab)
+{
+   if (valid && checkFileExists(NULL))
+      return new SuffixArrayTMFeature(*this, vocab);
+   else
+      return NULL;
+}
+
+bool SuffixArrayTMFeature::Creator::checkFileExists(vector<string>* list)
+{
+   if (list) list->push_back(modelName);
+   if (!valid)
+      return false;
+
+   bool ok = true;
+   const string bases[2] = { base1, base2 };
+   for (Uint i = 0; i < 2; ++i) {
+      const string prefix = getSufaPrefix(bases[i]);
+      if (prefix.empty()) {
+         error(ETWarn, "Suffix-array TM %s: cannot find suffix array %s",
+               modelName.c_str(), bases[i].c_str());
+         ok = false;
+      } else if (list) {
+         list->push_back(prefix + "tdx");
+         list->push_back(prefix + "mct");
+         list->push_back(prefix + "msa");
+      }
+   }
+   vector<string> files(lexFiles);
+   files.push_back(alignmentFile);
+   for (Uint i = 0; i < files.size(); ++i) {
+      if (list) list->push_back(files[i]);
+      if (!check_if_exists(files[i])) {
+         error(ETWarn, "Suffix-array TM %s: cannot find %s",
+               modelName.c_str(), files[i].c_str());
+         ok = false;
+      }
+   }
+   return ok;
+}
+
+Uint64 SuffixArrayTMFeature::Creator::totalMemmapSize()
+{
+   if (!valid) return 0;
+   Uint64 total = 0;
+   const string bases[2] = { base1, base2 };
+   for (Uint i = 0; i < 2; ++i) {
+      const string prefix = getSufaPrefix(bases[i]);
+      if (prefix.empty()) return 0;
+      total += getFileSize(prefix + "tdx") + getFileSize(prefix + "mct") +
+               getFileSize(prefix + "msa");
+   }
+   return total;
+}
+
+bool SuffixArrayTMFeature::Creator::prime(bool full)
+{
+   if (!valid) return false;
+   cerr << "\tPriming: " << modelName << endl;
+   const string bases[2] = { base1, base2 };
+   for (Uint i = 0; i < 2; ++i) {
+      const string prefix = getSufaPrefix(bases[i]);
+      if (prefix.empty()) return false;
+      gulpFile(prefix + "tdx");
+      gulpFile(prefix + "msa");
+      if (full) gulpFile(prefix + "mct");
+   }
+   return true;
+}
+
+
+// =============================================== SuffixArrayTMFeature
+
+string SuffixArrayTMFeature::magicNumber = "Portage suffix-array TM v1.0";
+
+bool SuffixArrayTMFeature::isA(const string& modelName)
+{
+   return isSuffix(".satm", modelName);
+}
+
+SuffixArrayTMFeature::SuffixArrayTMFeature(Creator &creator, Voc &vocab)
+   : PhraseTableFeature(vocab)
+   , creator(creator)
+   , alignment(NULL)
+   , ibm_1(NULL)
+   , ibm_2(NULL)
+   , zn(NULL)
+{
+   cerr << "Loading suffix-array TM " << creator.modelName << endl;
+   ugdiss::open_mm_tsa(creator.base1, voc1, track1, sufa1);
+   ugdiss::open_mm_tsa(creator.base2, voc2, track2, sufa2);
+   if (track1.size() != track2.size())
+      error(ETFatal, "Suffix-array TM %s: L1 and L2 corpora have different sizes: %u vs %u",
+            creator.modelName.c_str(), Uint(track1.size()), Uint(track2.size()));
+
+   alignment = AlignmentFile::create(creator.alignmentFile);
+   if (alignment->size() != track1.size())
+      error(ETFatal, "Suffix-array TM %s: alignment file %s has %u lines, expected %u",
+            creator.modelName.c_str(), creator.alignmentFile.c_str(),
+            alignment->size(), Uint(track1.size()));
+
+   if (!creator.lexFiles.empty()) {
+      ibm_1 = new IBM1(creator.lexFiles[0]);
+      ibm_2 = new IBM1(creator.lexFiles[1]);
+      zn = new ZNSmoother<Uint>(ibm_1, ibm_2);
+   }
+}
+
+SuffixArrayTMFeature::~SuffixArrayTMFeature()
+{
+   delete zn;
+   delete ibm_2;
+   delete ibm_1;
+   delete alignment;
+}
+
+void SuffixArrayTMFeature::newSrcSent(const vector<string>& sentence)
+{
+   PhraseTableFeature::newSrcSent(sentence);
+   clearCache();
+   sourceSentTokens.resize(sentence.size());
+   for (Uint i = 0; i < sentence.size(); ++i)
+      sourceSentTokens[i] = Token(voc1[sentence[i]]);
+   noMatchFrom.assign(sentence.size(), sentence.size() + 1);
+   // An unknown word can't be part of any match
+   for (Uint i = 0; i < sentence.size(); ++i)
+      if (sourceSentTokens[i].id() == voc1.getUnkId())
+         for (Uint j = 0; j <= i; ++j)
+            noMatchFrom[j] = min(noMatchFrom[j], i + 1);
+}
+
+void SuffixArrayTMFeature::clearCache()
+{
+   cache.clear();
+   marginals2.clear();
+}
+
+shared_ptr<TargetPhraseTable> SuffixArrayTMFeature::find(Range r)
+{
+   assert(r.end <= sourceSentTokens.size() && r.start < r.end);
+   if (r.end >= noMatchFrom[r.start])
+      return shared_ptr<TargetPhraseTable>(new TargetPhraseTable);
+
+   vector<id_type> key(r.end - r.start);
+   for (Uint i = r.start; i < r.end; ++i)
+      key[i - r.start] = sourceSentTokens[i].id();
+   ResultCache::iterator it = cache.find(key);
+   if (it == cache.end())
+      it = cache.insert(make_pair(key, extract(r))).first;
+
+   // Callers may modify the table they get, so give them a copy.
+   return shared_ptr<TargetPhraseTable>(new TargetPhraseTable(*it->second));
+}
+
+/**
+ * Count the occurrences in suffix array range [lo,hi).  Counting exactly means
+ * decoding every entry; for frequent phrases, estimating from the size of the
+ * range is plenty accurate.
+ */
+template<class SUFA>
+static Uint countOccurrences(const SUFA& sufa, char const* lo, char const* hi)
+{
+   return (hi - lo < 65536) ? sufa.rawCnt(lo, hi) : sufa.approxCnt(lo, hi);
+}
+
+Uint SuffixArrayTMFeature::getMarginal2(const vector<Token>& phrase2)
+{
+   vector<id_type> key(phrase2.size());
+   for (Uint i = 0; i < phrase2.size(); ++i)
+      key[i] = phrase2[i].id();
+   MarginalCache::iterator it = marginals2.find(key);
+   if (it != marginals2.end()) return it->second;
+
+   Uint count = 0;
+   char const* lo = sufa2.lower_bound(phrase2.begin(), phrase2.end());
+   if (lo) {
+      char const* hi = sufa2.upper_bound(phrase2.begin(), phrase2.end());
+      count = countOccurrences(sufa2, lo, hi);
+   }
+   marginals2[key] = count;
+   return count;
+}
+
+/**
+ * Find the beginning of the suffix array entry containing position m in
+ * [lo,hi).  Same logic as the private mmTSA::index_jump(): sentence ids are
+ * written with flag 0 (non-negative bytes) and offsets with flag 1.
+ */
+static char const* entryStart(char const* lo, char const* m)
+{
+   if (m > lo) {
+      while (m > lo && *m <  0) --m;
+      while (m > lo && *m >= 0) --m;
+      if (*m < 0) ++m;
+   }
+   return m;
+}
+
+namespace {
+   /// Statistics accumulated for one target phrase while sampling
+   struct SampledPair {
+      Uint count;                     ///< number of samples yielding this pair
+      map<string,Uint> alignments;    ///< alignment -> count
+      SampledPair() : count(0) {}
+   };
+}
+
+shared_ptr<TargetPhraseTable> SuffixArrayTMFeature::extract(Range r)
+{
+   shared_ptr<TargetPhraseTable> tgtTable(new TargetPhraseTable);
+   assert(tgtTable);
+
+   const Uint len = r.end - r.start;
+   const Token* key = &sourceSentTokens[r.start];
+   char const* lo = sufa1.lower_bound(key, len);
+   char const* const hi = lo ? sufa1.upper_bound(key, len) : NULL;
+   if (!lo || lo >= hi) {
+      noMatchFrom[r.start] = min(noMatchFrom[r.start], r.end);
+      return tgtTable;
+   }
+
+   // Choose the occurrences to sample: all of them for rare phrases,
+   // otherwise maxSamples entries evenly spaced over the range.
+   const Uint maxSamples = creator.maxSamples;
+   vector<char const*> samples;
+   Uint srcCount = 0;
+   if (sufa1.approxCnt(lo, hi) <= maxSamples * 2) {
+      id_type sid;
+      uint16_t off;
+      for (char const* p = lo; p < hi; ++srcCount) {
+         samples.push_back(p);
+         p = sufa1.readSid(p, hi, sid);
+         p = sufa1.readOffset(p, hi, off);
+      }
+      if (samples.size() > maxSamples) {
+         vector<char const*> all;
+         all.swap(samples);
+         for (Uint i = 0; i < maxSamples; ++i)
+            samples.push_back(all[Uint64(i) * all.size() / maxSamples]);
+      }
+   } else {
+      srcCount = countOccurrences(sufa1, lo, hi);
+      const Uint64 range = hi - lo;
+      for (Uint i = 0; i < maxSamples; ++i) {
+         char const* p = entryStart(lo, lo + range * i / maxSamples);
+         if (samples.empty() || p != samples.back())
+            samples.push_back(p);
+      }
+   }
+
+   // Extract the minimal consistent phrase pair from each sample
+   typedef map<vector<id_type>, SampledPair> PairMap;
+   PairMap pairs;
+   Uint numExtracted = 0;
+   vector< vector<Uint> > sets;
+   vector<id_type> tgtKey;
+   for (Uint s = 0; s < samples.size(); ++s) {
+      id_type sid;
+      uint16_t off;
+      char const* p = sufa1.readSid(samples[s], hi, sid);
+      sufa1.readOffset(p, hi, off);
+      if (!alignment->get(sid, sets)) continue;
+
+      const Uint srcLen = track1.sntLen(sid);
+      const Uint tgtLen = track2.sntLen(sid);
+      const Uint start = off, end = off + len;
+      assert(end <= srcLen);
+      Uint tmin = tgtLen, tmax = 0;
+      for (Uint i = start; i < end && i < sets.size(); ++i)
+         for (Uint j = 0; j < sets[i].size(); ++j)
+            if (sets[i][j] < tgtLen) {
+               tmin = min(tmin, sets[i][j]);
+               tmax = max(tmax, sets[i][j]);
+            }
+      if (tmin > tmax || tmax - tmin + 1 > creator.maxPhraseLen) continue;
+
+      bool consistent = true;
+      for (Uint i = 0; i < srcLen && i < sets.size() && consistent; ++i)
+         if (i < start || i >= end)
+            for (Uint j = 0; j < sets[i].size(); ++j)
+               if (sets[i][j] >= tmin && sets[i][j] <= tmax) {
+                  consistent = false;
+                  break;
+               }
+      if (!consistent) continue;
+
+      const Token* tgt = track2.sntStart(sid);
+      tgtKey.resize(tmax - tmin + 1);
+      for (Uint j = tmin; j <= tmax; ++j)
+         tgtKey[j - tmin] = tgt[j].id();
+
+      // Alignment of the pair, in the "_"-separated format used by canoe
+      string al;
+      for (Uint i = start; i < end; ++i) {
+         if (i > start) al += '_';
+         bool empty = true;
+         if (i < sets.size())
+            for (Uint j = 0; j < sets[i].size(); ++j)
+               if (sets[i][j] >= tmin && sets[i][j] <= tmax) {
+                  if (!empty) al += ',';
+                  al += toString(sets[i][j] - tmin);
+                  empty = false;
+               }
+         if (empty) al += '-';
+      }
+
+      SampledPair& pair = pairs[tgtKey];
+      ++pair.count;
+      ++pair.alignments[al];
+      ++numExtracted;
+   }
+   if (numExtracted == 0) return tgtTable;
+
+   vector<string> srcToks(sourceSent.begin() + r.start, sourceSent.begin() + r.end);
+   vector<string> tgtToks;
+   vector<Token> tgtPhrase2;
+   VectorPhrase tgtPhrase;
+   vector<Uint> jointCount(1);
+   const double scale = double(srcCount) / samples.size();
+   for (PairMap::const_iterator it(pairs.begin()); it != pairs.end(); ++it) {
+      const vector<id_type>& ids = it->first;
+      tgtToks.resize(ids.size());
+      tgtPhrase.resize(ids.size());
+      tgtPhrase2.resize(ids.size());
+      for (Uint j = 0; j < ids.size(); ++j) {
+         tgtToks[j] = voc2[ids[j]];
+         tgtPhrase[j] = vocab.add(tgtToks[j].c_str());
+         tgtPhrase2[j] = Token(ids[j]);
+      }
+
+      // The joint count is estimated by scaling the sample count back to the
+      // full number of occurrences of the source phrase.
+      const double joint = max(1.0, it->second.count * scale);
+      const Uint marginal2 = max(getMarginal2(tgtPhrase2), Uint(1));
+
+      TScore* tScores(&(*tgtTable)[tgtPhrase]);
+      tScores->backward.push_back(min(1.0, joint / marginal2));
+      tScores->forward.push_back(double(it->second.count) / numExtracted);
+      if (zn) {
+         tScores->backward.push_back(zn->probLang1GivenLang2(srcToks, tgtToks));
+         tScores->forward.push_back(zn->probLang2GivenLang1(srcToks, tgtToks));
+      }
+
+      jointCount[0] = Uint(joint + 0.5);
+      CountAnnotation::getOrCreate(tScores->annotations)->updateValue(jointCount);
+
+      const map<string,Uint>& als = it->second.alignments;
+      map<string,Uint>::const_iterator best = als.begin();
+      for (map<string,Uint>::const_iterator al(als.begin()); al != als.end(); ++al)
+         if (al->second > best->second) best = al;
+      tScores->annotations.initAnnotation("a", best->first.c_str());
+   }
+
+   return tgtTable;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file suffix_array_tm_feature.h
+ * @brief Phrase table extracted on the fly from a suffix-array-indexed bitext
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef __SUFFIX_ARRAY_TM_FEATURE_H__
+#define __SUFFIX_ARRAY_TM_FEATURE_H__
+
+#include "phrasetable_feature.h"
+#include "ug_mm_tsa.h"
+#include <map>
+
+namespace Portage {
+
+class AlignmentFile;
+class IBM1;
+template<class T> class ZNSmoother;
+
+/**
+ * Suffix-array TM: instead of a precomputed phrase table, phrase pairs are
+ * extracted and scored at decoding time from a word-aligned bitext indexed
+ * with memory-mapped suffix arrays, in the style of Callison-Burch et al.
+ * (2005) and Lopez (2008).
+ *
+ * For each source phrase queried, at most a fixed number of its occurrences
+ * in the bitext are sampled (evenly spaced in the suffix array range, so
+ * results are deterministic), the minimal phrase pair consistent with the
+ * word alignment is extracted from each sample, and relative frequencies are
+ * estimated from the extracted pairs.
+ *
+ * The model is described by a small text file with suffix .satm:
+ *   Portage suffix-array TM v1.0
+ *   L1<tab>BASE.L1
+ *   L2<tab>BASE.L2
+ *   alignment<tab>ALIGNMENT_FILE
+ *   lex<tab>IBM1_L2_GIVEN_L1 IBM1_L1_GIVEN_L2    (optional)
+ *   samples<tab>N                               (optional, default 300)
+ *   max_phrase_len<tab>N                        (optional, default 7)
+ * BASE.L1 and BASE.L2 are the base names of the suffix arrays built by
+ * mmsufa.build for each side of the bitext, as for phrasepair-contingency.
+ * ALIGNMENT_FILE is the word alignment of L1 to L2, one line per sentence
+ * pair, in green format or as built by tp_alignment_build.
+ * If lex is given, Zens-Ney lexical smoothing with the two IBM1 models is
+ * added as a second model, as gen_phrase_tables -s ZNSmoother would.
+ * Relative paths are interpreted relative to the .satm file's directory.
+ *
+ * Scores provided: relative frequencies (and lexical smoothing if lex is
+ * given), the estimated joint count, and the alignment of each pair.
+ */
+class SuffixArrayTMFeature: public PhraseTableFeature {
+public:
+   static string magicNumber;
+
+   class Creator : public PhraseTableFeature::Creator
+   {
+      friend class SuffixArrayTMFeature;
+      string base1;            ///< suffix array base name for L1, path adjusted
+      string base2;            ///< suffix array base name for L2, path adjusted
+      string alignmentFile;    ///< L1-L2 word alignment file, path adjusted
+      vector<string> lexFiles; ///< IBM1 ttables for lexical smoothing, if any
+      Uint maxSamples;         ///< max number of occurrences sampled per source phrase
+      Uint maxPhraseLen;       ///< max length of extracted target phrases
+
+      /// Set by constructor iff modelName was read successfully and parsed correctly.
+      bool valid;
+
+      /// Find the directory prefix open_mm_tsa() will use for base, or "" if none exists
+      static string getSufaPrefix(const string& base);
+
+   public:
+      Creator(const string& modelName);
+      virtual void getNumScores(Uint& numModels, Uint& numAdir, Uint& numCounts, bool& hasAlignments);
+      virtual SuffixArrayTMFeature* create(const CanoeConfig &c, Voc& vocab);
+      virtual bool checkFileExists(vector<string>* list);
+      virtual Uint64 totalMemmapSize();
+      virtual bool prime(bool full = false);
+   }; // SuffixArrayTMFeature::Creator
+
+   static bool isA(const string& modelName);
+
+   virtual ~SuffixArrayTMFeature();
+
+   virtual Uint getNumModels()  const { return ibm_1 ? 2 : 1; }
+   virtual Uint getNumAdir()    const { return 0; }
+   virtual Uint getNumCounts()  const { return 1; }
+   virtual bool hasAlignments() const { return true; }
+   virtual void newSrcSent(const vector<string>& sentence);
+   virtual void clearCache();
+   virtual shared_ptr<TargetPhraseTable> find(Range r);
+
+private:
+   typedef ugdiss::L2R_Token<ugdiss::SimpleWordId> Token;
+   typedef ugdiss::mmTtrack<Token> Track;
+   typedef ugdiss::mmTSA<Token> Sufa;
+
+   Creator creator;
+
+   ugdiss::TokenIndex voc1, voc2;
+   Track track1, track2;
+   Sufa sufa1, sufa2;
+   AlignmentFile* alignment;
+
+   IBM1* ibm_1;        ///< IBM1 p(L2|L1), if lex was given
+   IBM1* ibm_2;        ///< IBM1 p(L1|L2), if lex was given
+   ZNSmoother<Uint>* zn;
+
+   /// The current source sentence, mapped to the L1 suffix array vocabulary
+   vector<Token> sourceSentTokens;
+   /// noMatchFrom[i] = e means source range [i,e) was found not to occur in
+   /// the bitext, so neither does any longer range starting at i.
+   vector<Uint> noMatchFrom;
+
+   /// Per-sentence cache of results, by source phrase
+   typedef map<vector<ugdiss::id_type>, shared_ptr<TargetPhraseTable> > ResultCache;
+   ResultCache cache;
+   /// Per-sentence cache of target phrase marginal counts
+   typedef map<vector<ugdiss::id_type>, Uint> MarginalCache;
+   MarginalCache marginals2;
+
+   SuffixArrayTMFeature(Creator &creator, Voc &vocab);
+
+   /// Count the occurrences of a target phrase in the bitext, with caching
+   Uint getMarginal2(const vector<Token>& phrase2);
+
+   /// Sample, extract and score the translations of source range r
+   shared_ptr<TargetPhraseTable> extract(Range r);
+}; // SuffixArrayTMFeature
+
+} // namespace Portage
+#endif // __SUFFIX_ARRAY_TM_FEATURE_H__
@@ -0,0 +1,4 @@
+0 2 1
+0 1
+0 2 1
+0 2 1
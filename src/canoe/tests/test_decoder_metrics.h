@@ -0,0 +1,64 @@
+/**
+ * @file test_decoder_metrics.h  Test suite for DecoderMetrics
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include <sstream>
+#include "decoder_metrics.h"
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestDecoderMetrics : public CxxTest::TestSuite
+{
+public:
+   void testPerSentenceCounts() {
+      vector<string> names;
+      names.push_back("LengthFeature");
+      DecoderMetrics m(names);
+
+      vector<Ulong> lm_hits(3, 10);
+      vector<DecoderMetrics::CacheCounts> caches;
+      caches.push_back(DecoderMetrics::CacheCounts("lm", 5, 20));
+      m.startSentence(7, 3, lm_hits, caches);
+      m.features[0].add(0.5);
+      m.features[0].add(0.25);
+      ++m.stack(0).pushed;
+      m.stack(3).pruned = 2;
+      TS_ASSERT_EQUALS(m.stacks.size(), 4u);
+
+      lm_hits[1] = 14;
+      caches[0].hits = 8;
+      caches[0].lookups = 24;
+      m.endSentence(lm_hits, caches);
+      TS_ASSERT_EQUALS(m.features[0].calls, 2u);
+      TS_ASSERT_EQUALS(m.features[0].seconds, 0.75);
+      TS_ASSERT_EQUALS(m.lm_ngram_hits[0], 0u);
+      TS_ASSERT_EQUALS(m.lm_ngram_hits[1], 4u);
+      TS_ASSERT_EQUALS(m.caches[0].hits, 3u);
+      TS_ASSERT_EQUALS(m.caches[0].lookups, 4u);
+
+      ostringstream oss;
+      m.toJSON(oss);
+      const string json = oss.str();
+      TS_ASSERT_EQUALS(json.substr(0, 25), "{\"sent_id\":7,\"src_len\":3,");
+      TS_ASSERT(json.find("{\"name\":\"LengthFeature\",\"calls\":2,\"seconds\":0.75}") != string::npos);
+      TS_ASSERT(json.find("\"stacks\":[{\"pushed\":1,\"pruned\":0,\"recombined\":0},") != string::npos);
+      TS_ASSERT(json.find("{\"name\":\"lm\",\"hits\":3,\"lookups\":4,\"hit_rate\":0.75}") != string::npos);
+      TS_ASSERT_EQUALS(json[json.size()-1], '}');
+
+      // A new sentence starts from zero.
+      m.startSentence(8, 1, lm_hits, caches);
+      TS_ASSERT_EQUALS(m.features[0].calls, 0u);
+      TS_ASSERT(m.stacks.empty());
+   }
+}; // TestDecoderMetrics
+
+} // Portage
@@ -0,0 +1,219 @@
+/**
+ * @file test_incremental_tm_feature.h
+ *
+ * Unit test for incremental_tm_feature.h
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "incremental_tm_feature.h"
+#include "count_annotation.h"
+#include "alignment_annotation.h"
+#include "phrase_smoother.h"
+#include "phrase_smoother_cc.h"
+#include "ibm.h"
+#include "config_io.h"
+#include "file_utils.h"
+#include <cstdlib>
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestIncrementalTMFeature : public CxxTest::TestSuite {
+   string tmpdir;
+   string incrtm;      // the .incrtm file
+   string countsFile;  // its counts
+   string model1;      // IBM1 en|fr
+   string model2;      // IBM1 fr|en
+
+   static void writeFile(const string& filename, const char* contents) {
+      oSafeMagicStream out(filename);
+      out << contents;
+   }
+
+   /// The entry of tpt for target phrase tgt, or NULL if there is none.
+   static const TScore* findTrans(const TargetPhraseTable& tpt, Voc& vocab,
+                                  const string& tgt) {
+      for (TargetPhraseTable::const_iterator it(tpt.begin()); it != tpt.end(); ++it) {
+         vector<string> toks;
+         for (Uint i = 0; i < it->first.size(); ++i)
+            toks.push_back(vocab.word(it->first[i]));
+         if (join(toks) == tgt)
+            return &it->second;
+      }
+      return NULL;
+   }
+
+public:
+   void setUp() {
+      char tmpdirname[] = "/tmp/testIncrementalTM.XXXXXX";
+      tmpdir = mkdtemp(tmpdirname);
+      incrtm = tmpdir + "/cpt.fr2en.incrtm";
+      countsFile = tmpdir + "/cpt.fr2en.jpt";
+      model1 = tmpdir + "/ibm1.en_given_fr";
+      model2 = tmpdir + "/ibm1.fr_given_en";
+
+      writeFile(model1,
+         "la the 0.9\n"
+         "la house 0.1\n"
+         "maison house 0.8\n"
+         "maison the 0.2\n"
+         "le the 1\n"
+         "chat cat 1\n");
+      writeFile(model2,
+         "the la 0.6\n"
+         "the le 0.4\n"
+         "house maison 1\n"
+         "cat chat 1\n");
+      writeFile(countsFile,
+         "la maison ||| the house ||| 2 a=0_1:2\n"
+         "la maison ||| house ||| 1 a=1:1\n"
+         "maison ||| house ||| 3 a=0:3\n");
+      oSafeMagicStream out(incrtm);
+      out << IncrementalTMFeature::magicNumber << endl
+          << "counts\tcpt.fr2en.jpt" << endl
+          << "extractor\t-ibm 1 -m 8 ibm1.en_given_fr ibm1.fr_given_en" << endl;
+   }
+
+   void tearDown() {
+      if (system(("rm -rf " + tmpdir).c_str()) != 0)
+         TS_FAIL("cannot remove " + tmpdir);
+   }
+
+   void testIsA() {
+      TS_ASSERT(IncrementalTMFeature::isA("test.incrtm"));
+      TS_ASSERT(!IncrementalTMFeature::isA("test.satm"));
+   }
+
+   void testGetNumScores() {
+      Uint numModels, numAdir, numCounts;
+      bool hasAlignments;
+      PhraseTableFeature::getNumScores(incrtm, numModels, numAdir, numCounts, hasAlignments);
+      TS_ASSERT_EQUALS(numModels, 2u);
+      TS_ASSERT_EQUALS(numAdir, 0u);
+      TS_ASSERT_EQUALS(numCounts, 1u);
+      TS_ASSERT(hasAlignments);
+   }
+
+   void testFind() {
+      CanoeConfig c;
+      Voc vocab;
+      PhraseTableFeature* pt = PhraseTableFeature::create(incrtm, c, vocab);
+      TS_ASSERT(pt);
+      if (!pt) return;
+
+      vector<string> sent;
+      split("la maison xyz", sent);
+      pt->newSrcSent(sent);
+
+      IBM1 ibm1(model1), ibm2(model2);
+      ZNSmoother<Uint> zn(&ibm1, &ibm2);
+      vector<string> src, tgt;
+      split("la maison", src);
+
+      // c(la maison, the house) = 2, c(la maison) = 3, c(the house) = 2
+      shared_ptr<TargetPhraseTable> tpt = pt->find(Range(0,2));
+      TS_ASSERT_EQUALS(tpt->size(), 2u);
+      const TScore* ts = findTrans(*tpt, vocab, "the house");
+      TS_ASSERT(ts);
+      if (ts) {
+         split("the house", tgt);
+         TS_ASSERT_EQUALS(ts->backward.size(), 2u);
+         TS_ASSERT_EQUALS(ts->forward.size(), 2u);
+         TS_ASSERT_DELTA(ts->backward[0], 1.0, 1e-6);
+         TS_ASSERT_DELTA(ts->backward[1], zn.probLang1GivenLang2(src, tgt), 1e-6);
+         TS_ASSERT_DELTA(ts->forward[0], 2.0/3, 1e-6);
+         TS_ASSERT_DELTA(ts->forward[1], zn.probLang2GivenLang1(src, tgt), 1e-6);
+         TS_ASSERT(ts->backward[1] != ts->forward[1]);
+         const CountAnnotation* count = CountAnnotation::get(ts->annotations);
+         TS_ASSERT(count);
+         if (count) TS_ASSERT_EQUALS(count->joint_counts[0], 2.0);
+         const AlignmentAnnotation* al = AlignmentAnnotation::get(ts->annotations);
+         TS_ASSERT(al);
+         if (al) TS_ASSERT_EQUALS(string(al->getAlignment()), "0_1");
+      }
+
+      // c(la maison, house) = 1, c(house) = 4
+      ts = findTrans(*tpt, vocab, "house");
+      TS_ASSERT(ts);
+      if (ts) {
+         TS_ASSERT_DELTA(ts->backward[0], 0.25, 1e-6);
+         TS_ASSERT_DELTA(ts->forward[0], 1.0/3, 1e-6);
+      }
+
+      // Unknown phrases have no translations
+      TS_ASSERT(pt->find(Range(2,3))->empty());
+      TS_ASSERT(pt->find(Range(0,3))->empty());
+
+      delete pt;
+   }
+
+   void testAddAndRemoveSentencePair() {
+      IncrementalTMFeature::Creator creator(incrtm);
+      CanoeConfig c;
+      Voc vocab;
+      IncrementalTMFeature* tm = creator.create(c, vocab);
+      TS_ASSERT(tm);
+      if (!tm) return;
+      ostringstream before;
+      tm->getCounts().write(before);
+
+      vector<string> src, tgt;
+      split("le chat", src);
+      split("the cat", tgt);
+      TS_ASSERT(tm->addSentencePair(src, tgt) > 0);
+      tm->newSrcSent(src);
+      shared_ptr<TargetPhraseTable> tpt = tm->find(Range(0,2));
+      const TScore* ts = findTrans(*tpt, vocab, "the cat");
+      TS_ASSERT(ts);
+      if (ts) TS_ASSERT_DELTA(ts->forward[0], 1.0, 1e-6);
+      TS_ASSERT(!tm->find(Range(0,1))->empty());
+
+      Uint missing = 1;
+      TS_ASSERT(tm->removeSentencePair(src, tgt, missing) > 0);
+      TS_ASSERT_EQUALS(missing, 0u);
+      ostringstream after;
+      tm->getCounts().write(after);
+      TS_ASSERT_EQUALS(after.str(), before.str());
+      tm->newSrcSent(src);
+      TS_ASSERT(tm->find(Range(0,2))->empty());
+
+      // Removing it again finds nothing to remove.
+      TS_ASSERT_EQUALS(tm->removeSentencePair(src, tgt, missing), 0u);
+      TS_ASSERT(missing > 0);
+
+      delete tm;
+   }
+
+   void testSaveAndReload() {
+      IncrementalTMFeature::Creator creator(incrtm);
+      CanoeConfig c;
+      Voc vocab;
+      IncrementalTMFeature* tm = creator.create(c, vocab);
+      TS_ASSERT(tm);
+      if (!tm) return;
+
+      vector<string> src, tgt;
+      split("le chat", src);
+      split("the cat", tgt);
+      tm->addSentencePair(src, tgt);
+      const Uint size = tm->getCounts().size();
+      tm->save();
+      TS_ASSERT(!tm->reloadIfChanged());
+
+      // Another process replacing the counts, e.g., incr_tm_update
+      writeFile(countsFile, "le chat ||| the cat ||| 1 a=0_1:1\n");
+      TS_ASSERT(tm->reloadIfChanged());
+      TS_ASSERT_EQUALS(tm->getCounts().size(), 1u);
+      TS_ASSERT(size > 1);
+      delete tm;
+   }
+}; // TestIncrementalTMFeature
+
+} // Portage
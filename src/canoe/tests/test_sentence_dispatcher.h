@@ -0,0 +1,95 @@
+/**
+ * @file test_sentence_dispatcher.h
+ * @brief Test suite for the canoe-dispatcher message protocol
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "sentence_dispatcher.h"
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace Portage;
+using namespace Portage::SentenceDispatch;
+
+namespace Portage {
+
+class TestSentenceDispatcher : public CxxTest::TestSuite
+{
+public:
+   void testParseMessage() {
+      string buf = "BATCH 12\n0\tla maison\nDONE 0\nRESU";
+      string type, payload;
+      bool bad;
+      TS_ASSERT(parseMessage(buf, type, payload, bad));
+      TS_ASSERT_EQUALS(type, "BATCH");
+      TS_ASSERT_EQUALS(payload, "0\tla maison\n");
+      TS_ASSERT(parseMessage(buf, type, payload, bad));
+      TS_ASSERT_EQUALS(type, "DONE");
+      TS_ASSERT_EQUALS(payload, "");
+      // Incomplete messages stay in the buffer.
+      TS_ASSERT(!parseMessage(buf, type, payload, bad));
+      TS_ASSERT(!bad);
+      buf += "LT 3\nab";
+      TS_ASSERT(!parseMessage(buf, type, payload, bad));
+      TS_ASSERT(!bad);
+      buf += "c";
+      TS_ASSERT(parseMessage(buf, type, payload, bad));
+      TS_ASSERT_EQUALS(type, "RESULT");
+      TS_ASSERT_EQUALS(payload, "abc");
+      TS_ASSERT(buf.empty());
+   }
+
+   void testBadHeader() {
+      string type, payload;
+      bool bad;
+      string buf = "BATCH x\n";
+      TS_ASSERT(!parseMessage(buf, type, payload, bad));
+      TS_ASSERT(bad);
+      buf = "BATCH\n";
+      TS_ASSERT(!parseMessage(buf, type, payload, bad));
+      TS_ASSERT(bad);
+      buf = string(100, 'x');
+      TS_ASSERT(!parseMessage(buf, type, payload, bad));
+      TS_ASSERT(bad);
+   }
+
+   void testStreams() {
+      vector<string> streams(NUM_STREAMS);
+      streams[OUT] = "the house\na cat\n";
+      streams[NBEST] = "the house\nthe home\n\na cat\n";
+      streams[LATTICE] = "FINAL\n(0 (1 \"x\" 0.5))\n";
+      const string payload = encodeStreams(streams);
+      vector<string> decoded;
+      TS_ASSERT(decodeStreams(payload, decoded));
+      TS_ASSERT(decoded == streams);
+      TS_ASSERT(!decodeStreams(payload + "x", decoded));
+      TS_ASSERT(!decodeStreams(payload.substr(0, payload.size() - 1), decoded));
+   }
+
+   void testSendMessage() {
+      int fds[2];
+      TS_ASSERT_EQUALS(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+      const string payload(10000, 'a');
+      TS_ASSERT(sendMessage(fds[0], "BATCH", payload));
+      close(fds[0]);
+      string buf;
+      char chunk[4096];
+      ssize_t n;
+      while ((n = read(fds[1], chunk, sizeof(chunk))) > 0)
+         buf.append(chunk, n);
+      close(fds[1]);
+      string type, received;
+      bool bad;
+      TS_ASSERT(parseMessage(buf, type, received, bad));
+      TS_ASSERT_EQUALS(type, "BATCH");
+      TS_ASSERT(received == payload);
+   }
+}; // TestSentenceDispatcher
+
+} // Portage
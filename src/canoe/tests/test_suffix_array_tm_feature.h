@@ -0,0 +1,105 @@
+/**
+ * @file test_suffix_array_tm_feature.h
+ *
+ * Unit test for suffix_array_tm_feature.h
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "suffix_array_tm_feature.h"
+#include "config_io.h"
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestSuffixArrayTMFeature : public CxxTest::TestSuite {
+   // tests/data/satm/bitext.* is this four sentence pair bitext:
+   //   la maison bleue / the blue house     0 2 1
+   //   la maison / the house                0 1
+   //   une maison rouge / a red house       0 2 1
+   //   la voiture bleue / the blue car      0 2 1
+   string satm;
+public:
+   void setUp() {
+      satm = "tests/data/satm/bitext.satm";
+      Error_ns::Current::errorCallback = Error_ns::nullErrorCallBack; // silence errors
+   }
+
+   void testIsA() {
+      TS_ASSERT(SuffixArrayTMFeature::isA("test.satm"));
+      TS_ASSERT(!SuffixArrayTMFeature::isA("test.mixtm"));
+   }
+
+   void testCheckFileExists() {
+      TS_ASSERT(PhraseTableFeature::checkFileExists(satm));
+      TS_ASSERT(!PhraseTableFeature::checkFileExists("tests/data/satm/bitext-bad.satm"));
+      vector<string> list;
+      PhraseTableFeature::checkFileExists(satm, &list);
+      TS_ASSERT_EQUALS(list.size(), 8u);
+   }
+
+   void testGetNumScores() {
+      Uint numModels, numAdir, numCounts;
+      bool hasAlignments;
+      PhraseTableFeature::getNumScores(satm, numModels, numAdir, numCounts, hasAlignments);
+      TS_ASSERT_EQUALS(numModels, 1u);
+      TS_ASSERT_EQUALS(numAdir, 0u);
+      TS_ASSERT_EQUALS(numCounts, 1u);
+      TS_ASSERT(hasAlignments);
+   }
+
+   void testFind() {
+      CanoeConfig c;
+      Voc vocab;
+      PhraseTableFeature* pt = PhraseTableFeature::create(satm, c, vocab);
+      TS_ASSERT(pt);
+      if (!pt) return;
+
+      vector<string> sent;
+      split("la maison bleue xyz", sent);
+      pt->newSrcSent(sent);
+
+      // "la maison bleue" -> "the house" is not consistent with the
+      // alignment, so "la maison" only yields "the house" from sentence 2.
+      shared_ptr<TargetPhraseTable> tpt = pt->find(Range(0,2));
+      TS_ASSERT_EQUALS(tpt->size(), 1u);
+      if (tpt->size() == 1) {
+         TS_ASSERT_EQUALS(vocab.word(tpt->begin()->first[0]), string("the"));
+         TS_ASSERT_EQUALS(vocab.word(tpt->begin()->first[1]), string("house"));
+         TS_ASSERT_EQUALS(tpt->begin()->second.forward[0], 1.0);
+      }
+
+      // Swapped alignment inside the phrase pair
+      tpt = pt->find(Range(1,3));
+      TS_ASSERT_EQUALS(tpt->size(), 1u);
+      if (tpt->size() == 1) {
+         TS_ASSERT_EQUALS(vocab.word(tpt->begin()->first[0]), string("blue"));
+         TS_ASSERT_EQUALS(vocab.word(tpt->begin()->first[1]), string("house"));
+      }
+
+      // "maison" -> "house" three times, "bleue" -> "blue" twice; "blue"
+      // occurs twice in the target corpus, so p(bleue|blue) is 1.
+      tpt = pt->find(Range(2,3));
+      TS_ASSERT_EQUALS(tpt->size(), 1u);
+      if (tpt->size() == 1)
+         TS_ASSERT_EQUALS(tpt->begin()->second.backward[0], 1.0);
+
+      // Unknown words have no translations
+      TS_ASSERT(pt->find(Range(3,4))->empty());
+      TS_ASSERT(pt->find(Range(2,4))->empty());
+
+      // Cached results are copies the caller may modify freely
+      pt->find(Range(0,2))->clear();
+      TS_ASSERT_EQUALS(pt->find(Range(0,2))->size(), 1u);
+
+      delete pt;
+   }
+}; // TestSuffixArrayTMFeature
+
+} // Portage
@@ -0,0 +1,106 @@
+/**
+ * @file test_translation_cache.h
+ * @brief Test suite for TranslationCache
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "translation_cache.h"
+#include "str_utils.h"
+#include <unistd.h>
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestTranslationCache : public CxxTest::TestSuite
+{
+   string filename;
+public:
+   void setUp() {
+      char tmp[] = "/tmp/test_translation_cache.XXXXXX";
+      close(mkstemp(tmp));
+      filename = tmp;
+   }
+   void tearDown() {
+      unlink(filename.c_str());
+   }
+
+   void testNormalize() {
+      TS_ASSERT_EQUALS(TranslationCache::normalize("  la  maison\t bleue \r"), "la maison bleue");
+      TS_ASSERT_EQUALS(TranslationCache::normalize("   "), "");
+      TS_ASSERT_EQUALS(TranslationCache::normalize("x"), "x");
+   }
+
+   void testFindInsert() {
+      string value;
+      {
+         TranslationCache cache(filename, "config1", 1);
+         cache.lock();
+         TS_ASSERT(!cache.find("la maison", value));
+         TS_ASSERT(cache.insert("la maison", "the house"));
+         TS_ASSERT(cache.insert("", ""));
+         TS_ASSERT(cache.find("la  maison ", value));
+         TS_ASSERT_EQUALS(value, "the house");
+         TS_ASSERT(cache.insert("la maison", "the home"));
+         TS_ASSERT(cache.find("la maison", value));
+         TS_ASSERT_EQUALS(value, "the home");
+         TS_ASSERT_EQUALS(cache.size(), 2u);
+         cache.unlock();
+      }
+      // Entries persist, but only for the same fingerprint.
+      {
+         TranslationCache cache(filename, "config1");
+         cache.lock();
+         TS_ASSERT(cache.find("la maison", value));
+         TS_ASSERT_EQUALS(value, "the home");
+         TS_ASSERT(cache.find(" ", value));
+         TS_ASSERT_EQUALS(value, "");
+         cache.unlock();
+      }
+      {
+         TranslationCache cache(filename, "config2");
+         cache.lock();
+         TS_ASSERT(!cache.find("la maison", value));
+         cache.clear();
+         cache.unlock();
+      }
+      {
+         TranslationCache cache(filename, "config1");
+         cache.lock();
+         TS_ASSERT(!cache.find("la maison", value));
+         TS_ASSERT_EQUALS(cache.size(), 0u);
+         cache.unlock();
+      }
+   }
+
+   void testEviction() {
+      TranslationCache cache(filename, "config", 1);
+      cache.lock();
+      string value;
+      TS_ASSERT(cache.insert("kept", "recently used"));
+      const string big(1000, 'x');
+      // About 1MB / 1000 bytes entries fit, so this evicts several times.
+      for (Uint i = 0; i < 5000; ++i) {
+         TS_ASSERT(cache.insert("sentence " + toString(i), big));
+         if (i % 100 == 0)
+            TS_ASSERT(cache.find("kept", value));
+      }
+      TS_ASSERT(cache.size() < 1000);
+      TS_ASSERT(cache.find("kept", value));
+      TS_ASSERT_EQUALS(value, "recently used");
+      TS_ASSERT(cache.find("sentence 4999", value));
+      TS_ASSERT_EQUALS(value, big);
+      TS_ASSERT(!cache.find("sentence 0", value));
+      // Too large for the cache.
+      TS_ASSERT(!cache.insert("huge", string(1 << 20, 'x')));
+      cache.unlock();
+   }
+}; // TestTranslationCache
+
+} // Portage
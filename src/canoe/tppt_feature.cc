@@ -62,6 +62,15 @@ void TPPTFeature::newSrcSent(const vector<string>& sentence)
    PhraseTableFeature::newSrcSent(sentence);
 }
 
+bool TPPTFeature::getCacheCounts(Ulong& hits, Ulong& lookups) const
+{
+   uint64_t h, l;
+   tppt.getCacheCounts(h, l);
+   hits = h;
+   lookups = l;
+   return true;
+}
+
 shared_ptr<TargetPhraseTable> TPPTFeature::find(Range r)
 {
    shared_ptr<TargetPhraseTable> tgtTable(new TargetPhraseTable);
@@ -52,6 +52,7 @@ public:
    virtual bool hasAlignments() const { return tppt.hasAlignments(); }
    virtual void newSrcSent(const vector<string>& sentence);
    virtual void clearCache() { tppt.clearCache(); }
+   virtual bool getCacheCounts(Ulong& hits, Ulong& lookups) const;
    virtual shared_ptr<TargetPhraseTable> find(Range r);
 }; // TPPTFeature
 
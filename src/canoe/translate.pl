@@ -195,6 +195,15 @@ Specify additional C<canoe-parallel.sh> options (valid when n > 1).
 
 Specify additional C<rat.sh> options (valid for -with-rescoring only).
 
+=item -cache=CACHE
+
+Decode through the persistent translation cache file CACHE, which is created
+if needed: decoder-ready source sentences already translated with the same
+F<canoe.ini> file and decoder options are taken from CACHE instead of being
+decoded again.  CACHE can be shared by concurrent translate.pl runs; delete it
+when the models change without changing F<canoe.ini>.
+(See C<translation-cache -h>; invalid with -with-rescoring.)
+
 =back
 
 =head2 XML Specific Options
@@ -413,6 +422,7 @@ Getopt::Long::GetOptions(
    "xtra-decode-opts=s"  => \my $xtra_decode_opts,
    "xtra-cp-opts=s"      => \my $xtra_cp_opts,
    "xtra-rat-opts=s"     => \my $xtra_rat_opts,
+   "cache=s"             => \my $cache,
 
    #XML specific options
    "xml"            => \my $xml,
@@ -655,6 +665,8 @@ $with_rescoring or !defined $xtra_rat_opts
 $xtra_cp_opts = "" unless defined $xtra_cp_opts;
 $xtra_decode_opts = "" unless defined $xtra_decode_opts;
 $xtra_rat_opts = "" unless defined $xtra_rat_opts;
+!defined $cache or !$with_rescoring
+   or die "Error: -cache is not valid with -with-rescoring.\nStopped";
 
 # XML specific options
 $xml = 0 unless defined $xml;
@@ -897,7 +909,18 @@ TRANS:{
       $decoder_opts .= " -ffvals" if $with_ce;
       $decoder_opts .= " $xtra_decode_opts";
       my $decoder_log = ($verbose > 1) ? "2> '${dir}/log.decode'" : "";
-      call("$decoder $decoder_opts -f ${canoe_ini} < '${q_dec}' > '${p_raw}' ${decoder_log}");
+      if (defined $cache) {
+         # The fingerprint leaves out what does not change canoe's output.
+         (my $key = $decoder_opts) =~ s/^-v \d+//;
+         $key =~ s/'/'\\''/g;
+         (my $cmd = "$decoder $decoder_opts -f ${canoe_ini}") =~ s/'/'\\''/g;
+         my $v = $verbose ? "-v" : "";
+         call("translation-cache $v -cmd '$cmd' -key '$key' -key-file '${canoe_ini}'" .
+              " '$cache' '${q_dec}' '${p_raw}' ${decoder_log}");
+      }
+      else {
+         call("$decoder $decoder_opts -f ${canoe_ini} < '${q_dec}' > '${p_raw}' ${decoder_log}");
+      }
 
       my $wal_opt = ($wal eq "h") ? "" : "-wal";
       call("set -o pipefail;" .
@@ -0,0 +1,243 @@
+/**
+ * @file translation-cache.cc
+ * @brief Translate with a decoder command, through a persistent cache of its
+ *        outputs.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "translation_cache.h"
+#include "file_utils.h"
+#include "str_utils.h"
+#include "arg_reader.h"
+#include "printCopyright.h"
+#include "exception_dump.h"  // MAIN
+#include <sys/stat.h>        // stat()
+#include <unistd.h>          // close(), unlink()
+#include <cstring>           // strcpy()
+
+using namespace Portage;
+using namespace std;
+
+static char help_message[] = "\n\
+translation-cache [options] CACHE [INFILE [OUTFILE]]\n\
+\n\
+  Translate INFILE [-] with a decoder command, writing one output line per\n\
+  input line to OUTFILE [-], and keep the decoder's output for each sentence\n\
+  in the persistent cache file CACHE, which is created if needed.  Sentences\n\
+  found in the cache are not decoded again; the other ones are decoded with\n\
+  one run of the command, each distinct sentence once, and are then added to\n\
+  the cache.  Sentences are matched exactly, except for whitespace.\n\
+\n\
+  The cached value is the whole output line of the command, so it includes\n\
+  anything canoe writes on that line, e.g., the trace, word and phrase\n\
+  alignments with -walign -palign, or ffvals with -ffvals.  Other outputs of\n\
+  the command, such as n-best lists, are not cached and cover only the\n\
+  sentences not found in the cache.\n\
+\n\
+  Each entry is stored with a fingerprint of the configuration, computed from\n\
+  the -key and -key-file options if given, otherwise from CMD, and is only\n\
+  found again with the same fingerprint.  Models modified in place are not\n\
+  detected unless their files are given with -key-file: delete the cache or\n\
+  change its name when the models change.\n\
+\n\
+  CACHE has a fixed size; when it is full, the least recently used half of\n\
+  its entries are discarded.  It can be shared by concurrent processes.\n\
+\n\
+Options:\n\
+\n\
+  -v             Write cache statistics to cerr.\n\
+  -cmd CMD       Decoder command, reading sentences on its standard input and\n\
+                 writing one line per sentence on its standard output\n\
+                 [canoe -f canoe.ini].\n\
+  -key K         Use K to compute the fingerprint; repeatable.\n\
+  -key-file F    Use the name, size, modification time and contents of file\n\
+                 F to compute the fingerprint; repeatable.\n\
+  -size MB       Size of CACHE if it is created, in MB [256].\n\
+  -readonly      Don't add new translations to CACHE.\n\
+  -clear         Remove all the entries from CACHE first.\n\
+";
+
+static bool verbose = false;
+static string cmd = "canoe -f canoe.ini";
+static vector<string> keys;
+static vector<string> key_files;
+static Uint size_mb = TranslationCache::defaultSizeMB;
+static bool readonly = false;
+static bool clear_cache = false;
+static string cache_file;
+static string infile("-");
+static string outfile("-");
+static void getArgs(int argc, const char* const argv[]);
+
+/// FNV-1a hash of s, continuing from h.
+static Uint64 hashString(const string& s, Uint64 h = 14695981039346656037ULL)
+{
+   for (string::const_iterator it = s.begin(); it != s.end(); ++it) {
+      h ^= (unsigned char)*it;
+      h *= 1099511628211ULL;
+   }
+   return h;
+}
+
+/// Describe file for the fingerprint: its real name, size, mtime and contents.
+static void describeFile(ostream& os, const string& file)
+{
+   char* real = realpath(file.c_str(), NULL);
+   os << "file=" << (real ? real : file.c_str());
+   free(real);
+   struct stat st;
+   if (stat(file.c_str(), &st) != 0)
+      error(ETFatal, "Can't access key file %s", file.c_str());
+   os << " size=" << st.st_size << " mtime=" << st.st_mtime << "\n";
+   if (S_ISREG(st.st_mode)) {
+      iSafeMagicStream in(file);
+      os << in.rdbuf() << "\n";
+   }
+}
+
+/// Create an empty temporary file.
+static string getTempName()
+{
+   static const char* tmpdir = getenv("TMPDIR");
+   static const string path = tmpdir ? tmpdir : "/tmp";
+   static const string name = "translation-cache.XXXXXX";
+   char tmp[path.size()+name.size()+2];
+   strcpy(tmp,(path+"/"+name).c_str());
+   if ( close(mkstemp(tmp)) )
+      error(ETFatal, "Unable to get a temp file name using mkstemp(%s)", tmp);
+   return tmp;
+}
+
+int MAIN(argc, argv)
+{
+   printCopyright(2026, "translation-cache");
+   getArgs(argc, argv);
+
+   ostringstream fp;
+   if (keys.empty() && key_files.empty())
+      fp << "cmd=" << cmd << "\n";
+   for (Uint i = 0; i < keys.size(); ++i)
+      fp << "key=" << keys[i] << "\n";
+   for (Uint i = 0; i < key_files.size(); ++i)
+      describeFile(fp, key_files[i]);
+   char fingerprint[17];
+   snprintf(fingerprint, sizeof(fingerprint), "%016llx",
+            (unsigned long long)hashString(fp.str()));
+
+   vector<string> sents;
+   {
+      iSafeMagicStream in(infile);
+      string line;
+      while (getline(in, line))
+         sents.push_back(line);
+   }
+
+   TranslationCache cache(cache_file, fingerprint, size_mb);
+
+   // Look up every sentence, and collect the distinct ones not found.
+   vector<string> results(sents.size());
+   vector<Uint> miss(sents.size(), Uint(-1));   // index in misses, if not found
+   vector<string> misses;
+   {
+      map<string, Uint> missIndex;
+      cache.lock();
+      if (clear_cache) cache.clear();
+      for (Uint i = 0; i < sents.size(); ++i) {
+         if (cache.find(sents[i], results[i])) continue;
+         const string norm = TranslationCache::normalize(sents[i]);
+         map<string, Uint>::iterator it = missIndex.find(norm);
+         if (it == missIndex.end()) {
+            it = missIndex.insert(make_pair(norm, misses.size())).first;
+            misses.push_back(sents[i]);
+         }
+         miss[i] = it->second;
+      }
+      cache.unlock();
+   }
+   if (verbose)
+      cerr << "translation-cache: " << sents.size() << " sentences, "
+           << sents.size() - count(miss.begin(), miss.end(), Uint(-1)) << " not in cache, "
+           << misses.size() << " distinct ones to decode; "
+           << cache.size() << " entries in " << cache_file << endl;
+
+   // Decode the misses, without holding the lock.
+   if (!misses.empty()) {
+      const string tmpIn = getTempName();
+      const string tmpOut = getTempName();
+      {
+         oSafeMagicStream out(tmpIn);
+         for (Uint i = 0; i < misses.size(); ++i)
+            out << misses[i] << '\n';
+      }
+      const string command = cmd + " < '" + tmpIn + "' > '" + tmpOut + "'";
+      cout.flush();
+      cerr.flush();
+      const int rc = system(command.c_str());
+      if (rc != 0) {
+         unlink(tmpIn.c_str());
+         unlink(tmpOut.c_str());
+         error(ETFatal, "Decoder command failed (status %d): %s", rc, command.c_str());
+      }
+
+      vector<string> outputs;
+      outputs.reserve(misses.size());
+      {
+         iSafeMagicStream in(tmpOut);
+         string line;
+         while (getline(in, line))
+            outputs.push_back(line);
+      }
+      unlink(tmpIn.c_str());
+      unlink(tmpOut.c_str());
+      if (outputs.size() != misses.size())
+         error(ETFatal, "Decoder command wrote %d lines for %d sentences: %s",
+               Uint(outputs.size()), Uint(misses.size()), cmd.c_str());
+
+      for (Uint i = 0; i < sents.size(); ++i)
+         if (miss[i] != Uint(-1))
+            results[i] = outputs[miss[i]];
+
+      if (!readonly) {
+         cache.lock();
+         for (Uint i = 0; i < misses.size(); ++i)
+            if (!cache.insert(misses[i], outputs[i]))
+               error(ETWarn, "Translation of sentence too large for cache: %s", misses[i].c_str());
+         cache.unlock();
+      }
+   }
+
+   oSafeMagicStream out(outfile);
+   for (Uint i = 0; i < results.size(); ++i)
+      out << results[i] << '\n';
+   return 0;
+}
+END_MAIN
+
+// arg processing
+
+void getArgs(int argc, const char* const argv[])
+{
+   const char* switches[] = {"v", "cmd:", "key:", "key-file:", "size:",
+                             "readonly", "clear"};
+   ArgReader arg_reader(ARRAY_SIZE(switches), switches, 1, 3, help_message);
+   arg_reader.read(argc-1, argv+1);
+
+   arg_reader.testAndSet("v", verbose);
+   arg_reader.testAndSet("cmd", cmd);
+   arg_reader.testAndSet("key", keys);
+   arg_reader.testAndSet("key-file", key_files);
+   arg_reader.testAndSet("size", size_mb);
+   arg_reader.testAndSet("readonly", readonly);
+   arg_reader.testAndSet("clear", clear_cache);
+   arg_reader.testAndSet(0, "cache", cache_file);
+   arg_reader.testAndSet(1, "infile", infile);
+   arg_reader.testAndSet(2, "outfile", outfile);
+
+   if (size_mb == 0)
+      error(ETFatal, "-size must be at least 1");
+}
@@ -0,0 +1,256 @@
+/**
+ * @file translation_cache.cc
+ * @brief Implementation of TranslationCache.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "translation_cache.h"
+#include "errors.h"
+#include <algorithm>
+#include <vector>
+#include <cstring>       // memcmp(), memcpy(), memset(), strerror()
+#include <errno.h>       // errno
+#include <fcntl.h>       // open()
+#include <sys/file.h>    // flock()
+#include <sys/mman.h>    // mmap()
+#include <sys/stat.h>    // fstat()
+#include <unistd.h>      // close(), ftruncate()
+
+using namespace Portage;
+
+/// Identifies cache files, and their format version.
+static const char magic[16] = "PortageTCache1";
+
+struct TranslationCache::Header {
+   char magic[16];        ///< the string magic
+   Uint64 numSlots;       ///< size of the hash table, a power of 2
+   Uint64 dataSize;       ///< size of the data area, in bytes
+   Uint64 dataUsed;       ///< bytes used in the data area
+   Uint64 count;          ///< number of entries
+   Uint64 clock;          ///< incremented at each use of an entry
+};
+
+struct TranslationCache::Slot {
+   Uint64 hash;           ///< hash of the key, 0 for an empty slot
+   Uint64 offset;         ///< position of the key in the data area
+   Uint64 lastUse;        ///< value of clock when last found or inserted
+   Uint keyLen;           ///< length of the key
+   Uint valueLen;         ///< length of the value, which follows the key
+};
+
+/// FNV-1a hash of s; never 0, which marks empty slots.
+static Uint64 hashKey(const string& s)
+{
+   Uint64 h = 14695981039346656037ULL;
+   for (string::const_iterator it = s.begin(); it != s.end(); ++it) {
+      h ^= (unsigned char)*it;
+      h *= 1099511628211ULL;
+   }
+   return h ? h : 1;
+}
+
+TranslationCache::TranslationCache(const string& filename,
+      const string& fingerprint, Uint sizeMB)
+   : filename(filename)
+   , fingerprint(fingerprint)
+   , fd(-1)
+   , map(NULL)
+   , mapSize(0)
+   , header(NULL)
+   , slots(NULL)
+   , data(NULL)
+{
+   fd = open(filename.c_str(), O_RDWR | O_CREAT, 0666);
+   if (fd < 0)
+      error(ETFatal, "Can't open translation cache %s: %s", filename.c_str(), strerror(errno));
+
+   // Initialize the file under lock, in case another process creates it too.
+   lock();
+   struct stat st;
+   if (fstat(fd, &st) != 0)
+      error(ETFatal, "Can't stat translation cache %s: %s", filename.c_str(), strerror(errno));
+   const bool create = st.st_size == 0;
+   if (create) {
+      if (sizeMB == 0)
+         error(ETFatal, "The size of translation cache %s must be at least 1 MB", filename.c_str());
+      mapSize = Uint64(sizeMB) << 20;
+      if (ftruncate(fd, mapSize) != 0)
+         error(ETFatal, "Can't create translation cache %s: %s", filename.c_str(), strerror(errno));
+   } else {
+      mapSize = st.st_size;
+   }
+
+   void* addr = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (addr == MAP_FAILED)
+      error(ETFatal, "Can't memory map translation cache %s: %s", filename.c_str(), strerror(errno));
+   map = static_cast<char*>(addr);
+   header = reinterpret_cast<Header*>(map);
+
+   if (create) {
+      // Make the table as large as possible, with at least 256 bytes of data
+      // per slot.
+      Uint64 numSlots = 1024;
+      while (numSlots * 2 * 256 <= mapSize) numSlots *= 2;
+      memcpy(header->magic, magic, sizeof(magic));
+      header->numSlots = numSlots;
+      header->dataSize = mapSize - sizeof(Header) - numSlots * sizeof(Slot);
+      header->dataUsed = 0;
+      header->count = 0;
+      header->clock = 0;
+   } else if (mapSize < sizeof(Header) || memcmp(header->magic, magic, sizeof(magic)) != 0 ||
+              mapSize != sizeof(Header) + header->numSlots * sizeof(Slot) + header->dataSize) {
+      error(ETFatal, "%s is not a translation cache file, or it is corrupt", filename.c_str());
+   }
+   slots = reinterpret_cast<Slot*>(map + sizeof(Header));
+   data = map + sizeof(Header) + header->numSlots * sizeof(Slot);
+   unlock();
+}
+
+TranslationCache::~TranslationCache()
+{
+   if (map) munmap(map, mapSize);
+   if (fd >= 0) close(fd);
+}
+
+void TranslationCache::lock()
+{
+   while (flock(fd, LOCK_EX) != 0)
+      if (errno != EINTR)
+         error(ETFatal, "Can't lock translation cache %s: %s", filename.c_str(), strerror(errno));
+}
+
+void TranslationCache::unlock()
+{
+   flock(fd, LOCK_UN);
+}
+
+string TranslationCache::normalize(const string& src)
+{
+   string norm;
+   norm.reserve(src.size());
+   for (string::const_iterator it = src.begin(); it != src.end(); ++it) {
+      if (*it == ' ' || *it == '\t' || *it == '\r' || *it == '\n') {
+         if (!norm.empty() && norm[norm.size()-1] != ' ')
+            norm += ' ';
+      } else {
+         norm += *it;
+      }
+   }
+   if (!norm.empty() && norm[norm.size()-1] == ' ')
+      norm.erase(norm.size()-1);
+   return norm;
+}
+
+string TranslationCache::makeKey(const string& src) const
+{
+   return fingerprint + '\n' + normalize(src);
+}
+
+TranslationCache::Slot* TranslationCache::findSlot(const string& key, Uint64 hash) const
+{
+   const Uint64 mask = header->numSlots - 1;
+   for (Uint64 i = hash & mask; ; i = (i + 1) & mask) {
+      Slot* slot = &slots[i];
+      if (slot->hash == 0 ||
+          (slot->hash == hash && slot->keyLen == key.size() &&
+           memcmp(data + slot->offset, key.data(), key.size()) == 0))
+         return slot;
+   }
+}
+
+bool TranslationCache::find(const string& src, string& value)
+{
+   const string key = makeKey(src);
+   Slot* slot = findSlot(key, hashKey(key));
+   if (slot->hash == 0) return false;
+   value.assign(data + slot->offset + slot->keyLen, slot->valueLen);
+   slot->lastUse = ++header->clock;
+   return true;
+}
+
+bool TranslationCache::insert(const string& src, const string& value)
+{
+   const string key = makeKey(src);
+   const Uint64 len = key.size() + value.size();
+   if (len > header->dataSize / 2 || value.size() > Uint(-1)) return false;
+
+   const Uint64 hash = hashKey(key);
+   Slot* slot = findSlot(key, hash);
+   const bool isNew = slot->hash == 0;
+   // The table is kept at most 3/4 full, so probing stays short.
+   if ((isNew && (header->count + 1) * 4 > header->numSlots * 3) ||
+       header->dataUsed + len > header->dataSize) {
+      evict();
+      slot = findSlot(key, hash);
+   }
+
+   // A replaced value leaves its old copy in the data area until evict().
+   if (slot->hash == 0) ++header->count;
+   slot->hash = hash;
+   slot->offset = header->dataUsed;
+   slot->lastUse = ++header->clock;
+   slot->keyLen = key.size();
+   slot->valueLen = value.size();
+   memcpy(data + header->dataUsed, key.data(), key.size());
+   memcpy(data + header->dataUsed + key.size(), value.data(), value.size());
+   header->dataUsed += len;
+   return true;
+}
+
+/// Sorts slots from the most to the least recently used.
+static bool moreRecent(const pair<Uint64, Uint64>& a, const pair<Uint64, Uint64>& b)
+{
+   return a.first > b.first;
+}
+
+void TranslationCache::evict()
+{
+   // (lastUse, slot index) of all the entries
+   vector<pair<Uint64, Uint64> > used;
+   used.reserve(header->count);
+   for (Uint64 i = 0; i < header->numSlots; ++i)
+      if (slots[i].hash != 0)
+         used.push_back(make_pair(slots[i].lastUse, i));
+   sort(used.begin(), used.end(), moreRecent);
+
+   // Save the most recent entries that fit in half the table and data area.
+   vector<Slot> kept;
+   string keptData;
+   for (Uint64 i = 0; i < used.size() && kept.size() * 8 < header->numSlots * 3; ++i) {
+      Slot slot = slots[used[i].second];
+      const Uint64 len = Uint64(slot.keyLen) + slot.valueLen;
+      if (keptData.size() + len > header->dataSize / 2) break;
+      keptData.append(data + slot.offset, len);
+      slot.offset = keptData.size() - len;
+      kept.push_back(slot);
+   }
+
+   // Rebuild the table with only those.
+   memset(slots, 0, header->numSlots * sizeof(Slot));
+   memcpy(data, keptData.data(), keptData.size());
+   header->dataUsed = keptData.size();
+   header->count = kept.size();
+   const Uint64 mask = header->numSlots - 1;
+   for (vector<Slot>::const_iterator it = kept.begin(); it != kept.end(); ++it) {
+      Uint64 i = it->hash & mask;
+      while (slots[i].hash != 0) i = (i + 1) & mask;
+      slots[i] = *it;
+   }
+}
+
+void TranslationCache::clear()
+{
+   memset(slots, 0, header->numSlots * sizeof(Slot));
+   header->dataUsed = 0;
+   header->count = 0;
+}
+
+Uint64 TranslationCache::size() const
+{
+   return header->count;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file translation_cache.h
+ * @brief Persistent exact-match cache of decoder outputs, in a memory mapped
+ *        hash file.
+ *
+ * The cache maps a source sentence, normalized by collapsing its whitespace,
+ * and a fingerprint of the decoder configuration to the decoder's output for
+ * that sentence, e.g., canoe's 1-best line with its trace and alignments.
+ * Lookups and insertions work directly on the memory mapped file, so the
+ * cache persists across processes, and the file can be shared by concurrent
+ * processes, which serialize their accesses with lock() and unlock().
+ *
+ * The file has a fixed size, chosen when it is created: a header, an open
+ * addressing hash table of fixed size slots, and a data area where the keys
+ * and values are appended.  When either the table or the data area is full,
+ * the cache keeps the most recently used half of its entries and discards
+ * the rest.  Numbers are stored in the native byte order, so the file is
+ * only portable between machines of the same architecture.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef TRANSLATION_CACHE_H
+#define TRANSLATION_CACHE_H
+
+#include "portage_defs.h"
+#include <string>
+
+namespace Portage {
+
+class TranslationCache : private NonCopyable
+{
+public:
+   /// Default size of a new cache file, in MB.
+   static const Uint defaultSizeMB = 256;
+
+   /**
+    * Open cache file filename, creating it if it doesn't exist.
+    * @param filename     cache file
+    * @param fingerprint  describes the decoder configuration; entries stored
+    *                     with a different fingerprint are never returned
+    * @param sizeMB       size of the file if it is created; an existing file
+    *                     keeps its size
+    */
+   TranslationCache(const string& filename, const string& fingerprint,
+                    Uint sizeMB = defaultSizeMB);
+   /// Destructor.
+   ~TranslationCache();
+
+   /// Get exclusive access to the cache file; blocks until available.
+   void lock();
+   /// Release the access obtained with lock().
+   void unlock();
+
+   /**
+    * Look up the decoder output for source sentence src.  Must be called
+    * between lock() and unlock().
+    * @param src    source sentence
+    * @param value  set to the decoder output if found
+    * @return true iff src was found
+    */
+   bool find(const string& src, string& value);
+
+   /**
+    * Store the decoder output value for source sentence src, replacing any
+    * previous one.  Must be called between lock() and unlock().
+    * @return false if the entry is too large for the cache and was ignored
+    */
+   bool insert(const string& src, const string& value);
+
+   /// Number of entries in the cache.
+   Uint64 size() const;
+
+   /// Remove all the entries.  Must be called between lock() and unlock().
+   void clear();
+
+   /// Collapse runs of whitespace into single spaces and trim the ends.
+   static string normalize(const string& src);
+
+private:
+   struct Header;
+   struct Slot;
+
+   /// The key under which src is stored.
+   string makeKey(const string& src) const;
+   /// Slot where key is stored, or the empty slot where it belongs.
+   Slot* findSlot(const string& key, Uint64 hash) const;
+   /// Keep the most recently used half of the entries, drop the others.
+   void evict();
+
+   const string filename; ///< cache file name
+   const string fingerprint; ///< prefix of all our keys
+   int fd;                ///< descriptor of the open cache file
+   char* map;             ///< the whole memory mapped file
+   Uint64 mapSize;        ///< size of the file, in bytes
+   Header* header;        ///< header at the start of map
+   Slot* slots;           ///< hash table, after the header
+   char* data;            ///< data area, after the hash table
+}; // TranslationCache
+
+} // Portage
+
+#endif // TRANSLATION_CACHE_H
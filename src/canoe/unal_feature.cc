@@ -23,7 +23,7 @@ Uint UnalFeature::count_unal_words(const PhraseInfo& phrase_info)
    const Uint tgt_len = phrase_info.phrase.size();
 
    const vector<vector<Uint > >* sets = AlignmentAnnotation::getAlignmentSets
-      (a_ann->getAlignmentID(),src_len);
+      (a_ann->getAlignmentID(),src_len,sets_cache);
    if (sets->empty()) return 0;
 
    Uint result(0);
@@ -14,6 +14,7 @@
 #define _UNAL_FEATURE_H_
 
 #include "decoder_feature.h"
+#include "alignment_annotation.h"
 #include <boost/unordered_map.hpp>
 
 namespace Portage {
@@ -50,6 +51,9 @@ namespace Portage {
       Cache cache;
       //vector<Uint> cache;
 
+      /// our own, since precomputeFutureScore() runs in its own thread
+      AlignmentAnnotation::SetsCache sets_cache;
+
       /// value signifying uninitialized cache entry
       //static const Uint cache_not_set = Uint(-1);
 
@@ -91,6 +95,10 @@ namespace Portage {
       // depend solely on the last phrase pair added.
       // this method gets the resutls from the subclass and caches them.
       virtual double precomputeFutureScore(const PhraseInfo& phrase_info);
+      // precomputeFutureScore() fills the cache
+      virtual PrecomputeThreading precomputeThreading() const {
+         return PRECOMPUTE_OWN_THREAD;
+      }
 
       // the whole future score is computed phrase by phrase, so only
       // precomputeFutureScore() has to do any calculations.
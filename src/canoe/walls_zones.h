@@ -148,8 +148,10 @@ public:
          const Uint wall_pos = walls[i].pos;
          if (phrase_info.src_words.start < wall_pos && phrase_info.src_words.end > wall_pos) {
             const Uint src_len = phrase_info.src_words.size();
+            // not a shared cache: this may run in several threads at once
+            AlignmentAnnotation::SetsCache sets_cache;
             const vector<vector<Uint> >* sets =
-               AlignmentAnnotation::getSets(phrase_info.annotations, src_len);
+               AlignmentAnnotation::getSets(phrase_info.annotations, src_len, sets_cache);
 
             // If there is no alignment annotation, we assume the phrase pair
             // is not compositional and count this as a violation.
@@ -314,8 +316,10 @@ public:
          // compatible alignment
          if (isStraddlingZoneBoundary(zone, src)) {
             const Uint src_len = src.size();
+            // not a shared cache: this may run in several threads at once
+            AlignmentAnnotation::SetsCache sets_cache;
             const vector<vector<Uint> >* sets =
-               AlignmentAnnotation::getSets(phrase_info.annotations, src_len);
+               AlignmentAnnotation::getSets(phrase_info.annotations, src_len, sets_cache);
 
             // If there is no alignment annotation, we assume the phrase pair
             // is not compositional and count this straddling as a violation.
@@ -507,8 +511,10 @@ public:
          const Range zone = local_walls[i].zone;
          if (phrase_info.src_words.start < wall_pos && phrase_info.src_words.end > wall_pos) {
             const Uint src_len = phrase_info.src_words.size();
+            // not a shared cache: this may run in several threads at once
+            AlignmentAnnotation::SetsCache sets_cache;
             const vector<vector<Uint> >* sets =
-               AlignmentAnnotation::getSets(phrase_info.annotations, src_len);
+               AlignmentAnnotation::getSets(phrase_info.annotations, src_len, sets_cache);
 
             // If there is no alignment annotation, we assume the phrase pair
             // is not compositional and count this as a violation.
@@ -15,6 +15,7 @@
 #include <iostream>
 #include <vector>
 #include <str_utils.h>
+#include <binio.h>
 #include <cstdlib>
 #include <string>
 
@@ -104,6 +105,14 @@ struct DistortionCount {
          val(i) = conv<Uint>(*b++);
    }
  
+   // binary I/O, for PhraseTableGen's sorted runs spilled to disk
+   void writebin(ostream& os) const {
+      for (Uint i = 0; i < size(); ++i) BinIO::writebin(os, val(i));
+   }
+   void readbin(istream& is) {
+      for (Uint i = 0; i < size(); ++i) BinIO::readbin(is, val(i));
+   }
+
    // Dump counts for a single phrase-pair occurrence
    void dumpSingleton(ostream& os) {
       os << "prev=" << (prevmono ? "mono" : prevswap ? "swap" : prevdisc ? "disc" : "ERROR") 
@@ -16,6 +16,7 @@
  */
 
 #include "wer.h"
+#include "levenshtein.h"
 #include <portage_defs.h>
 #include <vector>
 #include <string>
@@ -44,6 +45,12 @@ namespace Portage
 
    Uint find_mWER(const vector<string>& tst, const vector<string>& ref, Uint* len_of_best)
    {
+      // The distance alone doesn't need the full matrix.
+      if (!len_of_best) {
+         BitParallelLevenshtein<string> lev;
+         return lev.distance(tst, ref);
+      }
+
       Uint n = tst.size();
       Uint m = ref.size();
 
@@ -15,6 +15,7 @@
 #include "lmtext.h"
 #include "lmmix.h"
 #include "lmdynmap.h"
+#include "lmdynamic.h"
 #include "tplm.h"
 #include "lmrestcost.h"
 #include "str_utils.h"
@@ -37,6 +38,8 @@ namespace Portage {
 // Constructors
 PLM::PLM(VocabFilter* vocab, OOVHandling oov_handling, float oov_unigram_prob)
    : cache(NULL)
+   , cache_lookups(0)
+   , cache_hits(0)
    , vocab(vocab)
    , complex_open_voc_lm(oov_handling == FullOpenVoc)
    , gram_order(0)
@@ -47,6 +50,8 @@ PLM::PLM(VocabFilter* vocab, OOVHandling oov_handling, float oov_unigram_prob)
 
 PLM::PLM()
    : cache(NULL)
+   , cache_lookups(0)
+   , cache_hits(0)
    , vocab(NULL)
    , complex_open_voc_lm(false)
    , gram_order(0)
@@ -121,6 +126,8 @@ shared_ptr<PLM::Creator> PLM::getCreator(const string& lm_filename)
       cr = new TPLM::Creator(lm_physical_filename, naming_limit_order);
    } else if (LMRestCost::isA(lm_physical_filename)) {
       cr = new LMRestCost::Creator(lm_physical_filename, naming_limit_order);
+   } else if (LMDynamic::isA(lm_physical_filename)) {
+      cr = new LMDynamic::Creator(lm_physical_filename, naming_limit_order);
    } else {
       // EJJ Important note: we must not call LMText::isA() here, because it
       // calls this function! We could call LMBin::isA(), but that would be
@@ -345,8 +352,11 @@ float PLM::cachedWordProb(Uint word, const Uint context[],
 
       // Search in cache for matching Uint query
       float query_result(0);
-      if ( cache->find(query, context_length+1, query_result) )
+      ++cache_lookups;
+      if ( cache->find(query, context_length+1, query_result) ) {
+         ++cache_hits;
          return query_result;
+      }
 
       const float result = wordProb(word, context, context_length);
       cache->insert(query, context_length+1, result);
@@ -368,7 +378,7 @@ void PLM::Hits::init(Uint gram_order) {
 
 PLM::Hits& PLM::Hits::operator+=(const Hits& other) {
    if (values.size() < other.values.size()) values.resize(other.values.size(), 0);
-   for (Uint i(0); i<values.size(); ++i)
+   for (Uint i(0); i<other.values.size(); ++i)
       values[i] += other.values[i];
    if ( other.latest_hit > latest_hit ) latest_hit = other.latest_hit;
    return *this;
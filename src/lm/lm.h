@@ -76,11 +76,15 @@ public:
       Uint getLatestHit() const {
          return latest_hit;
       }
+      /// Get the hits for each N, indexed by N.
+      const vector<Uint>& getValues() const { return values; }
    };
 
 private:
    /// Cache results of queries to cachedWordProb().
    LMCache* cache;
+   /// Lookups in cache, and how many of those were found, since creation.
+   Ulong cache_lookups, cache_hits;
 
 protected:
    /// Keeps track of how many times each N is hit over all queries
@@ -484,6 +488,15 @@ public:
     */
    virtual void clearHits() { hits.clear(); }
 
+   /**
+    * Get the number of hits and lookups in the cachedWordProb() cache since
+    * this model was created.
+    */
+   virtual void getCacheCounts(Ulong& num_hits, Ulong& num_lookups) const {
+      num_hits = cache_hits;
+      num_lookups = cache_lookups;
+   }
+
    /**
     * Get the depth where the latest n-gram query was found, i.e., how much of the
     * word plus its context was found.
@@ -0,0 +1,300 @@
+/**
+ * @file lmdynamic.cc  Dynamic LM: n-gram counts kept in memory and updatable.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "lmdynamic.h"
+#include "str_utils.h"
+#include "file_utils.h"
+#include <sys/stat.h>
+#include <cmath>
+
+using namespace Portage;
+
+const char* const LMDynamic::magic = "Dynamic LM v1.0 (NRC)";
+const Uint LMDynamic::NONE;
+
+static const string help_the_poor_user_s = string("\
+Syntax for dynamic LM config file:\n\
+   ") + LMDynamic::magic + "\n\
+   order=N\n\
+   corpus=CORPUS\n\
+<N> is the n-gram order of the model [3]\n\
+<CORPUS> contains one tokenized sentence per line; corpus= may be repeated.\n\
+Relative paths are interpreted relative to the directory of the config file.\n\
+";
+static const char* help_the_poor_user = help_the_poor_user_s.c_str();
+
+LMDynamic::Creator::Creator(
+      const string& lm_physical_filename, Uint naming_limit_order)
+   : PLM::Creator(lm_physical_filename, naming_limit_order)
+   , order(3)
+{
+}
+
+bool LMDynamic::isA(const string& lm_physical_filename)
+{
+   return !is_directory(lm_physical_filename) &&
+      matchMagicNumber(lm_physical_filename, magic);
+}
+
+bool LMDynamic::Creator::checkFileExists(vector<string>* list)
+{
+   if (list) list->push_back(lm_physical_filename);
+   if (!check_if_exists(lm_physical_filename))
+      return false;
+
+   const string dir = DirName(lm_physical_filename);
+   corpora.clear();
+   order = 3;
+
+   string line;
+   iSafeMagicStream config(lm_physical_filename);
+   if (!getline(config, line) || line != magic) {
+      error(ETWarn, "Dynamic LM config file %s does not start with magic string '%s'\n%s",
+            lm_physical_filename.c_str(), magic, help_the_poor_user);
+      return false;
+   }
+
+   bool ok = true;
+   while (getline(config, line)) {
+      trim(line);
+      if (line.empty() || line[0] == '#') continue;
+      const string::size_type p = line.find('=');
+      string key = line.substr(0, p);
+      trim(key);
+      string value = p == string::npos ? "" : line.substr(p+1);
+      trim(value);
+      if (key == "order" && conv(value, order) && order > 0) {
+         continue;
+      } else if (key == "corpus" && !value.empty()) {
+         corpora.push_back(adjustRelativePath(dir, value));
+         if (list) list->push_back(corpora.back());
+         if (!check_if_exists(corpora.back())) {
+            error(ETWarn, "Can't access corpus %s in dynamic LM config file %s",
+                  corpora.back().c_str(), lm_physical_filename.c_str());
+            ok = false;
+         }
+      } else {
+         error(ETWarn, "Invalid line in dynamic LM config file %s: %s\n%s",
+               lm_physical_filename.c_str(), line.c_str(), help_the_poor_user);
+         ok = false;
+      }
+   }
+
+   return ok;
+}
+
+PLM* LMDynamic::Creator::Create(VocabFilter* vocab,
+                                OOVHandling oov_handling,
+                                float oov_unigram_prob,
+                                bool limit_vocab,
+                                Uint limit_order,
+                                ostream *const os_filtered,
+                                bool quiet)
+{
+   if (!checkFileExists(NULL))
+      error(ETFatal, "Problem with dynamic LM %s, aborting.", lm_physical_filename.c_str());
+   if (!vocab)
+      error(ETFatal, "Dynamic LM %s requires a vocabulary.", lm_physical_filename.c_str());
+   if (os_filtered)
+      error(ETWarn, "Dynamic LM %s cannot be written as a filtered LM.",
+            lm_physical_filename.c_str());
+   const Uint n = (limit_order && limit_order < order) ? limit_order : order;
+   LMDynamic* lm = new LMDynamic(vocab, oov_handling, oov_unigram_prob, n, corpora);
+   if (!quiet)
+      cerr << "Counted " << lm->numSentences() << " sentences for dynamic LM "
+           << lm_physical_filename << endl;
+   return lm;
+}
+
+LMDynamic::LMDynamic(VocabFilter* vocab, OOVHandling oov_handling,
+                     float oov_unigram_prob, Uint order,
+                     const vector<string>& corpus_files)
+   : PLM(vocab, oov_handling, oov_unigram_prob)
+   , order(order)
+   , histories(1)
+   , num_sentences(0)
+   , sent_start(addWord(SentStart))
+   , sent_end(addWord(SentEnd))
+{
+   assert(vocab);
+   assert(order > 0);
+   gram_order = order;
+   hits.init(order);
+   for (Uint i = 0; i < corpus_files.size(); ++i)
+      corpora.push_back(Corpus(corpus_files[i]));
+   loadCorpora();
+}
+
+LMDynamic::~LMDynamic()
+{
+}
+
+Uint LMDynamic::addWord(const char* word)
+{
+   const Uint old_size = local_voc.size();
+   const Uint id = local_voc.add(word);
+   if (id == old_size) {
+      // A word already in the global vocab may now be mapped.
+      const Uint global_index = vocab->index(word);
+      if (global_index < global2local.size())
+         global2local[global_index] = id;
+   }
+   return id;
+}
+
+void LMDynamic::resyncGlobal2Local()
+{
+   for (Uint i = global2local.size(); i < vocab->size(); ++i) {
+      const Uint id = local_voc.index(vocab->word(i));
+      global2local.push_back(id < local_voc.size() ? id : NONE);
+   }
+}
+
+void LMDynamic::addSentence(const vector<string>& tokens)
+{
+   sent_buffer.clear();
+   sent_buffer.push_back(sent_start);
+   for (Uint i = 0; i < tokens.size(); ++i)
+      sent_buffer.push_back(addWord(tokens[i].c_str()));
+   sent_buffer.push_back(sent_end);
+   countSentence();
+}
+
+void LMDynamic::addSentence(const string& line)
+{
+   vector<string> tokens;
+   split(line, tokens);
+   addSentence(tokens);
+}
+
+void LMDynamic::countSentence()
+{
+   // Count each word, </s> included, after each of its contexts of length 0
+   // to order-1, creating the histories as needed.
+   for (Uint i = 1; i < sent_buffer.size(); ++i) {
+      const Uint w = sent_buffer[i];
+      Uint h = 0;
+      for (Uint k = 0; ; ++k) {
+         Uint& c = counts[key(h, w)];
+         if (c++ == 0) ++histories[h].types;
+         ++histories[h].total;
+         if (k + 1 >= order || k + 1 > i) break;
+         pair<unordered_map<Uint64, Uint>::iterator, bool> res =
+            extensions.insert(make_pair(key(h, sent_buffer[i-k-1]), Uint(histories.size())));
+         if (res.second) histories.push_back(History());
+         h = res.first->second;
+      }
+   }
+   ++num_sentences;
+}
+
+void LMDynamic::clearCounts()
+{
+   histories.assign(1, History());
+   extensions.clear();
+   counts.clear();
+   num_sentences = 0;
+}
+
+void LMDynamic::loadCorpora()
+{
+   clearCounts();
+   string line;
+   for (Uint i = 0; i < corpora.size(); ++i) {
+      Corpus& corpus = corpora[i];
+      struct stat st;
+      if (stat(corpus.filename.c_str(), &st) == 0) {
+         corpus.mtime = st.st_mtime;
+         corpus.size = st.st_size;
+         corpus.inode = st.st_ino;
+      }
+      iSafeMagicStream is(corpus.filename);
+      while (getline(is, line))
+         addSentence(line);
+   }
+}
+
+bool LMDynamic::reloadIfChanged()
+{
+   bool changed = false;
+   for (Uint i = 0; i < corpora.size() && !changed; ++i) {
+      const Corpus& corpus = corpora[i];
+      struct stat st;
+      changed = stat(corpus.filename.c_str(), &st) == 0 &&
+         (st.st_mtime != corpus.mtime || st.st_size != corpus.size ||
+          st.st_ino != corpus.inode);
+   }
+   if (changed) {
+      loadCorpora();
+      clearCache();
+   }
+   return changed;
+}
+
+void LMDynamic::newSrcSent(const vector<string>& src_sent,
+                           Uint external_src_sent_id)
+{
+   reloadIfChanged();
+}
+
+float LMDynamic::wordProb(Uint word, const Uint context[], Uint context_length)
+{
+   if (context_length >= order)
+      context_length = order - 1;
+
+   const Uint w = localIndex(word);
+   const Uint unigram_count = w == NONE ? 0 : count(0, w);
+   if (unigram_count == 0) {
+      // Never seen: oov_unigram_prob, times the back-off weight
+      // T(h)/(c(h)+T(h)) of each known context.
+      double bo = 1.0;
+      Uint h = 0;
+      for (Uint k = 0; k < context_length; ++k) {
+         const Uint prev = localIndex(context[k]);
+         if (prev == NONE || (h = extension(h, prev)) == NONE) break;
+         bo *= double(histories[h].types) / (histories[h].total + histories[h].types);
+      }
+      hits.hit(0);
+      return oov_unigram_prob + log10(bo);
+   }
+
+   double p = double(unigram_count) / histories[0].total;
+   Uint depth = 1;
+   Uint h = 0;
+   for (Uint k = 0; k < context_length; ++k) {
+      const Uint prev = localIndex(context[k]);
+      if (prev == NONE || (h = extension(h, prev)) == NONE) break;
+      const History& hist = histories[h];
+      const Uint c = count(h, w);
+      if (c) depth = k + 2;
+      p = (c + hist.types * p) / (hist.total + hist.types);
+   }
+   hits.hit(depth);
+   return log10(p);
+}
+
+float LMDynamic::cachedWordProb(Uint word, const Uint context[],
+                                Uint context_length)
+{
+   // Queries are a few hash lookups: not worth caching.
+   return wordProb(word, context, context_length);
+}
+
+Uint LMDynamic::minContextSize(const Uint context[], Uint context_length)
+{
+   // Longer contexts than the longest known history are never used.
+   Uint h = 0;
+   Uint k = 0;
+   for (; k < context_length && k + 1 < order; ++k) {
+      const Uint prev = localIndex(context[k]);
+      if (prev == NONE || (h = extension(h, prev)) == NONE) break;
+   }
+   return k;
+}
@@ -0,0 +1,193 @@
+/**
+ * @file lmdynamic.h  Dynamic LM: n-gram counts kept in memory and updatable.
+ *
+ * A dynamic LM keeps the n-gram counts of a small corpus, typically the
+ * target side of a document or of an incremental corpus, in memory, and
+ * calculates interpolated Witten-Bell probabilities from them on the fly:
+ *    p(w|h) = (c(h w) + T(h) p(w|h')) / (c(h) + T(h))
+ * where h' is h without its oldest word, c(h) is the number of times h was
+ * seen as a context, and T(h) the number of distinct words seen after it.
+ * Unigram probabilities are maximum likelihood estimates, and words never
+ * seen get oov_unigram_prob, so the model is best used as a component of a
+ * MixLM.
+ *
+ * New sentences can be added at any time with addSentence(), without any
+ * retraining.  A dynamic LM is also reloaded at the start of a source sentence
+ * whenever one of its corpus files has changed, so a long-running decoder
+ * sees additions to the corpus within milliseconds.
+ *
+ * A dynamic LM is invoked by naming its config file, which looks like this:
+ *    Dynamic LM v1.0 (NRC)
+ *    order=3
+ *    corpus=CORPUS
+ * where CORPUS contains one tokenized sentence per line, and may be repeated
+ * to count several corpora.  Relative paths are relative to the config file.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef LM_DYNAMIC_H
+#define LM_DYNAMIC_H
+
+#include "lm.h"
+#include "voc.h"
+#include <sys/types.h>
+
+namespace Portage
+{
+
+class LMDynamic : public PLM
+{
+public:
+   /// Magic first line of dynamic LM config files.
+   static const char* const magic;
+
+   /// Return true if lm_physical_filename is a dynamic LM config file
+   static bool isA(const string& lm_physical_filename);
+
+   struct Creator : public PLM::Creator {
+      Creator(const string& lm_physical_filename, Uint naming_limit_order);
+      virtual bool checkFileExists(vector<string>* list);
+      virtual PLM* Create(VocabFilter* vocab,
+                          OOVHandling oov_handling,
+                          float oov_unigram_prob,
+                          bool limit_vocab,
+                          Uint limit_order,
+                          ostream *const os_filtered,
+                          bool quiet);
+   private:
+      Uint order;              ///< order from the config file
+      vector<string> corpora;  ///< corpus files from the config file
+   };
+
+   /**
+    * Constructor.
+    * @param vocab             shared vocab object for all models
+    * @param oov_handling      type of vocabulary
+    * @param oov_unigram_prob  the unigram prob of words never seen
+    * @param order             n-gram order of the model
+    * @param corpora           corpus files to count, one tokenized sentence
+    *                          per line; they are watched for changes
+    */
+   LMDynamic(VocabFilter* vocab, OOVHandling oov_handling,
+             float oov_unigram_prob, Uint order,
+             const vector<string>& corpora = vector<string>());
+
+   /// Destructor.
+   ~LMDynamic();
+
+   /**
+    * Add the n-gram counts of a sentence to the model.  Callers using
+    * cachedWordProb() should call clearCache() afterwards.
+    * @param tokens  the sentence, without \<s\> and \</s\>
+    */
+   void addSentence(const vector<string>& tokens);
+
+   /**
+    * Add the n-gram counts of a whitespace-tokenized sentence to the model.
+    * @param line  the sentence
+    */
+   void addSentence(const string& line);
+
+   /// Forget all counts.
+   void clearCounts();
+
+   /**
+    * Recount the corpus files if any of them has changed since it was last
+    * counted.  Sentences added with addSentence() are forgotten in that case.
+    * @return true iff the model was reloaded
+    */
+   bool reloadIfChanged();
+
+   /// Number of sentences counted so far.
+   Uint numSentences() const { return num_sentences; }
+
+   virtual float wordProb(Uint word, const Uint context[], Uint context_length);
+   virtual float cachedWordProb(Uint word, const Uint context[],
+                                Uint context_length);
+   virtual Uint minContextSize(const Uint context[], Uint context_length);
+   virtual void newSrcSent(const vector<string>& src_sent,
+                           Uint external_src_sent_id);
+   virtual Uint getLatestNgramDepth() const { return hits.getLatestHit(); }
+
+protected:
+   virtual Uint getGramOrder() { return order; }
+
+private:
+   static const Uint NONE = Uint(-1);  ///< no such word or history
+
+   /// Counts for a history, i.e., a context of up to order-1 words.
+   struct History {
+      Uint total;    ///< c(h): number of words seen after this history
+      Uint types;    ///< T(h): number of distinct words seen after it
+      History() : total(0), types(0) {}
+   };
+
+   /// A corpus file, and what it looked like when it was last counted.
+   struct Corpus {
+      string filename;
+      time_t mtime;
+      off_t size;
+      ino_t inode;
+      explicit Corpus(const string& filename)
+         : filename(filename), mtime(0), size(0), inode(0) {}
+   };
+
+   Uint order;                   ///< n-gram order
+   Voc local_voc;                ///< words seen in the counted sentences
+   vector<Uint> global2local;    ///< global word index -> local index, or NONE
+   vector<History> histories;    ///< history counts; 0 is the empty history
+   /// (history, previous word) -> history extended with that word
+   unordered_map<Uint64, Uint> extensions;
+   /// (history, word) -> c(h w)
+   unordered_map<Uint64, Uint> counts;
+   vector<Corpus> corpora;       ///< watched corpus files
+   Uint num_sentences;           ///< number of sentences counted
+   Uint sent_start;              ///< local index of <s>
+   Uint sent_end;                ///< local index of </s>
+   vector<Uint> sent_buffer;     ///< workspace for addSentence()
+
+   static Uint64 key(Uint history, Uint word) {
+      return (Uint64(history) << 32) | word;
+   }
+
+   /// Local index of a word, adding it to local_voc if needed.
+   Uint addWord(const char* word);
+
+   /// Local index of a global word index, or NONE.
+   Uint localIndex(Uint global_index) {
+      if (global_index >= global2local.size())
+         resyncGlobal2Local();
+      return global_index < global2local.size() ?
+         global2local[global_index] : NONE;
+   }
+
+   /// Map global words added since the last call to local ones.
+   void resyncGlobal2Local();
+
+   /// Extension of history by word, or NONE.
+   Uint extension(Uint history, Uint word) const {
+      unordered_map<Uint64, Uint>::const_iterator it = extensions.find(key(history, word));
+      return it == extensions.end() ? NONE : it->second;
+   }
+
+   /// c(history word)
+   Uint count(Uint history, Uint word) const {
+      unordered_map<Uint64, Uint>::const_iterator it = counts.find(key(history, word));
+      return it == counts.end() ? 0 : it->second;
+   }
+
+   /// Count the sentence in sent_buffer, which includes <s> and </s>.
+   void countSentence();
+
+   /// Count the corpus files and remember their state.
+   void loadCorpora();
+}; // class LMDynamic
+
+} // Portage
+
+#endif // LM_DYNAMIC_H
@@ -283,6 +283,10 @@ public:
    static string fix_relative_path(const string& path, string file);
 
    virtual Hits getHits() { assert(m!=NULL); return m->getHits(); }
+   virtual void getCacheCounts(Ulong& num_hits, Ulong& num_lookups) const {
+      assert(m!=NULL);
+      m->getCacheCounts(num_hits, num_lookups);
+   }
 };
 
 } // Portage
@@ -0,0 +1,132 @@
+/**
+ * @file test_lmdynamic.h  Test suite for LMDynamic.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "portage_defs.h"
+#include "lmdynamic.h"
+#include "vocab_filter.h"
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestLMDynamic : public CxxTest::TestSuite
+{
+   string config, corpus;
+   VocabFilter* vocab;
+
+   void writeCorpus(const string& text) {
+      oMagicStream os(corpus);
+      os << text;
+   }
+
+   float prob(PLM* lm, const char* w, const char* c1 = NULL, const char* c2 = NULL) {
+      Uint context[2];
+      Uint len = 0;
+      if (c1) context[len++] = vocab->add(c1);
+      if (c2) context[len++] = vocab->add(c2);
+      return lm->wordProb(vocab->add(w), context, len);
+   }
+
+public:
+   void setUp() {
+      config = "tests/test_lmdynamic.tmp.dynlm";
+      corpus = "tests/test_lmdynamic.tmp.corpus";
+      writeCorpus("a b c\na b d\nb c a\n");
+      oMagicStream os(config);
+      os << LMDynamic::magic << endl
+         << "# comment" << endl
+         << "order = 3" << endl
+         << "corpus=test_lmdynamic.tmp.corpus" << endl;
+      vocab = new VocabFilter(0);
+   }
+
+   void tearDown() {
+      delete vocab;
+      remove(config.c_str());
+      remove(corpus.c_str());
+   }
+
+   void testCreate() {
+      TS_ASSERT(LMDynamic::isA(config));
+      TS_ASSERT(!LMDynamic::isA(corpus));
+      TS_ASSERT(PLM::checkFileExists(config));
+      PLM* lm = PLM::Create(config, vocab, PLM::ClosedVoc, -18, false, 0, NULL, true);
+      TS_ASSERT(lm != NULL);
+      TS_ASSERT_EQUALS(lm->getOrder(), 3u);
+      TS_ASSERT_EQUALS(dynamic_cast<LMDynamic*>(lm)->numSentences(), 3u);
+      delete lm;
+      lm = PLM::Create(config, vocab, PLM::ClosedVoc, -18, false, 2, NULL, true);
+      TS_ASSERT_EQUALS(lm->getOrder(), 2u);
+      delete lm;
+   }
+
+   void testSumsToOne() {
+      LMDynamic lm(vocab, PLM::ClosedVoc, -18, 3, vector<string>(1, corpus));
+      const char* words[] = { "a", "b", "c", "d", PLM::SentEnd };
+      const char* contexts[][2] = {
+         { NULL, NULL }, { "a", NULL }, { "b", "a" }, { "a", "c" }, { "c", "b" },
+         { "d", "b" }, { PLM::SentStart, NULL }, { "x", NULL }, { "b", "x" },
+      };
+      for (Uint i = 0; i < ARRAY_SIZE(contexts); ++i) {
+         double sum = 0;
+         for (Uint w = 0; w < ARRAY_SIZE(words); ++w)
+            sum += pow(10.0, prob(&lm, words[w], contexts[i][0], contexts[i][1]));
+         TS_ASSERT_DELTA(sum, 1.0, 1e-5);
+      }
+
+      // p(b|a) = (2 + 2 * 3/12) / (3 + 2)
+      TS_ASSERT_DELTA(prob(&lm, "b", "a"), log10(0.5), 1e-5);
+      TS_ASSERT_EQUALS(lm.getLatestNgramDepth(), 2u);
+      TS_ASSERT_DELTA(prob(&lm, "x", "a"), -18 + log10(2.0 / 5), 1e-5);
+      TS_ASSERT_EQUALS(lm.getLatestNgramDepth(), 0u);
+   }
+
+   void testAddSentence() {
+      LMDynamic lm(vocab, PLM::ClosedVoc, -18, 3);
+      TS_ASSERT_DELTA(prob(&lm, "e"), -18, 1e-5);
+      lm.addSentence("e f");
+      const float p = prob(&lm, "f", "e");
+      TS_ASSERT(p > -1);
+      lm.addSentence("e g");
+      TS_ASSERT(prob(&lm, "f", "e") < p);
+      TS_ASSERT_EQUALS(lm.numSentences(), 2u);
+      lm.clearCounts();
+      TS_ASSERT_EQUALS(lm.numSentences(), 0u);
+      TS_ASSERT_DELTA(prob(&lm, "f", "e"), -18, 1e-5);
+   }
+
+   void testMinContextSize() {
+      LMDynamic lm(vocab, PLM::ClosedVoc, -18, 3, vector<string>(1, corpus));
+      Uint context[3] = { vocab->add("b"), vocab->add("a"), vocab->add("c") };
+      TS_ASSERT_EQUALS(lm.minContextSize(context, 3), 2u);
+      TS_ASSERT_EQUALS(lm.minContextSize(context, 1), 1u);
+      context[1] = vocab->add("d");
+      TS_ASSERT_EQUALS(lm.minContextSize(context, 3), 1u);
+      context[0] = vocab->add("x");
+      TS_ASSERT_EQUALS(lm.minContextSize(context, 3), 0u);
+   }
+
+   void testReload() {
+      LMDynamic lm(vocab, PLM::ClosedVoc, -18, 3, vector<string>(1, corpus));
+      TS_ASSERT(!lm.reloadIfChanged());
+      TS_ASSERT_DELTA(prob(&lm, "e"), -18, 1e-5);
+      writeCorpus("a b c\na b d\nb c a\ne\n");
+      TS_ASSERT(lm.reloadIfChanged());
+      TS_ASSERT_EQUALS(lm.numSentences(), 4u);
+      TS_ASSERT_DELTA(prob(&lm, "e"), log10(1.0 / 14), 1e-5);
+      TS_ASSERT(!lm.reloadIfChanged());
+   }
+}; // TestLMDynamic
+
+} // Portage
@@ -45,6 +45,9 @@ Options:\n\
   -prec p     Precision: stop when max change in any weight is < p [0.001]\n\
   -prior wts  Use MAP prior weights from file wts [uniform]\n\
   -w          Multiply prior weights by w to get MAP prior counts [0]\n\
+\n\
+  Model probabilities are computed only once, in parallel over models when\n\
+  OMP_NUM_THREADS allows, and kept in memory: 8 bytes per token per model.\n\
 ";
 
 // globals
@@ -144,52 +147,67 @@ int main(int argc, char* argv[])
       cerr << " x " << w << endl;
    }
 
-   // em
+   // compute the probability of each token according to each model, once
 
    start = time(NULL);
-   EM em(models.size());
-   if (init_weights.size()) em.getWeights() = init_weights;
-   vector<double> probs(models.size());
-   string sent_end(PLM::SentEnd);
-
-   for (Uint iter = 0; iter < num_iters; ++iter) {
-
-      Uint lineno = 0;
+   vector<Uint> word_ids;       // text tokens, including eos, as vocab indexes
+   vector<Uint> sent_ends;      // line -> index in word_ids past its last token
+   {
       iSafeMagicStream textfile(textfilename);
-      Uint context[order - 1];
-      double logprob = 0.0;
-      Uint ntoks = 0, noovs = 0;
-
       while (getline(textfile, line)) {
-
-         for (Uint m = 0; m < models.size(); ++m)
-            models[m]->newSrcSent(toks, lineno);
+         splitZ(line, toks);
+         for (Uint i = 0; i < toks.size(); ++i)
+            word_ids.push_back(vocab.index(toks[i].c_str()));
+         word_ids.push_back(vocab.index(PLM::SentEnd)); // predict eos as well
+         sent_ends.push_back(word_ids.size());
+      }
+   }
+   EMMatrix probs(models.size());
+   probs.add(word_ids.size());
+   const Uint sent_start = vocab.index(PLM::SentStart);
+
+   // Models are not thread safe, so each one is queried by a single thread.
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+   for (int m = 0; m < int(models.size()); ++m) {
+      Uint context[order - 1];
+      vector<string> sent;
+      Uint t = 0;
+      for (Uint lineno = 0; lineno < sent_ends.size(); ++lineno) {
+         sent.clear();
+         for (Uint i = t; i+1 < sent_ends[lineno]; ++i)
+            sent.push_back(vocab.word(word_ids[i]));
+         models[m]->newSrcSent(sent, lineno);
 
          for (Uint j = 0; j < order - 1; ++j) 
-            context[j] = vocab.index(PLM::SentStart);
-
-         splitZ(line, toks);
-         toks.push_back(sent_end); // predict eos as well
-         for (Uint i = 0; i < toks.size(); ++i) {
-            Uint w = vocab.index(toks[i].c_str());
-            for (Uint m = 0; m < models.size(); ++m)
-               probs[m] = pow(10.0, static_cast<double>(models[m]->wordProb(w, context, order-1)));
-            double p = em.count(probs);
-            if (p) {
-               logprob += log10(p);
-               ++ntoks;
-            } else
-               ++noovs;
+            context[j] = sent_start;
+         for (; t < sent_ends[lineno]; ++t) {
+            const Uint w = word_ids[t];
+            probs.row(t)[m] = pow(10.0, static_cast<double>(models[m]->wordProb(w, context, order-1)));
             for (Uint j = order-1; j > 0; --j) 
                context[j] = context[j-1];
             context[0] = w;
          }
-         ++lineno;
       }
+   }
+   if (verbose)
+      cerr << sent_ends.size() << " lines read, probabilities computed in "
+           << (time(NULL)-start) << " secs" << endl;
+
+   // em
+
+   start = time(NULL);
+   EM em(models.size());
+   if (init_weights.size()) em.getWeights() = init_weights;
+
+   for (Uint iter = 0; iter < num_iters; ++iter) {
+      Uint noovs = 0;
+      const double logprob = em.countAll(probs, &noovs) / log(10.0);
+      const Uint ntoks = probs.numInstances() - noovs;
       if (verbose) {
          if (iter == 0)
-            cerr << lineno << " lines read, " 
-                 << ntoks << " tokens counted (includes eos), " 
+            cerr << ntoks << " tokens counted (includes eos), " 
                  << noovs << " tokens ignored" << endl;
          cerr << "iter " << iter+1 << " done: ppx = " << pow(10.0, -logprob / ntoks) << endl;
       }
@@ -41,23 +41,9 @@ namespace Portage
    }
 
    template <class ScoreStats>
-   void LineMax<ScoreStats>::findSentenceIntervals(Uint &numchanges,
-         double *& gamma,
-         ScoreStats *& dBLEU,
-         ScoreStats & curScore,
-         linemaxpt *& myHeappoint,
-         int s,
+   void LineMax<ScoreStats>::findSentenceIntervals(Uint s,
          const uVector& p,
-         const uVector& dir,
-         const uMatrix& H,
-         const vector<ScoreStats>& scoreStats)
-   // If a heap-point is not added, myHeappoint will be NULL.
-   // All arrays indexed by s are replaced here by their s-th entry, ie..
-   // numChanges = numChanges[s],
-   // gamma = gamma[s],
-   // dBLEU = dBLEU[s],
-   // H = H[s],
-   // scoreStats = scoreStats[s]
+         const uVector& dir)
    {
       using namespace boost::numeric;
       /* For the given source sentence (f_s):
@@ -102,13 +88,16 @@ namespace Portage
          We store each newgamma (in ascending order) in gamma (an array), and the
          number of newgamma's in numchanges.  Since there are K different lines, we
          know a priori that there are at most (K-1) newgamma's to store.
-         In practice here, we can forget the specific values of \hat{e} but remember
-         their contribution to the BLEU score.  Thus, we tally up the total
-         statistics for the BLEU score at \gamma_0 in curScore, and for the change in
-         \hat{e} at gamma[i], we store the change in BLEU statistics in dBLEU[i].
+         We store the value of \hat{e} on (-\infty, gamma[0]) in firstK[s], and
+         its value after the change at gamma[i] in newk[i]; the caller gets the
+         change in BLEU statistics at gamma[i] from these two hypotheses.
          */
 
-      assert(H.size1() == scoreStats.size());
+      const uMatrix& H(vH[s]);
+      assert(H.size1() == allScoreStats[s].size());
+      double* const gamma(&gammaWorkSpace[0] + offset[s]);
+      Uint* const newks(&kWorkSpace[0] + offset[s]);
+      Uint& numchanges(numChanges[s]);
 
       const Uint K(H.size1());
       const Uint M(H.size2());
@@ -202,10 +191,7 @@ namespace Portage
 
       // Initially, oldk = index of maximum element in C
       Uint oldk(my_vector_max_index(C));
-#pragma omp critical (findSentenceIntervals_curBLEU)
-{
-      curScore += scoreStats[oldk];
-} // ends omp critical section
+      firstK[s] = oldk;
 
       numchanges = 0;
       while (true) {
@@ -297,23 +283,13 @@ namespace Portage
          // Remember stuff for this intersection
          assert(numchanges < K);
          gamma[numchanges] = newgamma;
-         dBLEU[numchanges] = scoreStats[newk] - scoreStats[oldk];
+         newks[numchanges] = newk;
          numchanges++;
 
          oldk = newk;
          oldgamma = newgamma;
          found[newk] = true;
       } // while
-
-      if (numchanges > 0) {
-         myHeappoint = new linemaxpt();
-         myHeappoint->gamma = gamma[0];
-         myHeappoint->s = s;
-         myHeappoint->i = 0;
-      }
-      else {
-         myHeappoint = NULL;
-      } // if
    } // ends LineMax<ScoreStats>::findSentenceIntervals
 
 
@@ -326,35 +302,25 @@ namespace Portage
       // t - SMALL or t + SMALL respectively as the final gamma.
       const double SMALL(1.0f);
 
-      Uint numchanges[S];
-
-      this->record_history = record_history;
       if (record_history) history.clear();
 
-      ScoreStats curScoreStats;     // Accumulate the current BLEU statistics.
-
-      // Store the linemaxpt values for the least gamma in each partition;
-      // will subsequently become a heap.
-      linemaxpt* heappoints[S];
-
       int s;
 #pragma omp parallel for private(s)
-      for (s=0; s<int(S); ++s) {
-         findSentenceIntervals(numchanges[s],
-                               gammaWorkSpace[s],
-                               scoreWorkSpace[s],
-                               curScoreStats,  // Needs a one time lock
-                               heappoints[s],  // clean up null pointers
-                               s,        // const
-                               p,        // const
-                               dir,      // const
-                               vH[s],    // const
-                               allScoreStats[s]); // const
-      } // for
+      for (s=0; s<int(S); ++s)
+         findSentenceIntervals(s, p, dir);
 
-      // Remove the empty heap points and recalculate the heap size
-      linemaxpt** last_heappoint = remove_if(heappoints, heappoints+S, linemaxpt::isNull);
-      int heapsize(last_heappoint - heappoints);       // Number of members in heappoints
+      // Accumulate the BLEU statistics on (-\infty, first change point), in
+      // sentence order so the result does not depend on the thread schedule.
+      ScoreStats curScoreStats;
+      for (Uint s(0); s<S; ++s)
+         curScoreStats += allScoreStats[s][firstK[s]];
+
+      // Store the linemaxpt values for the least gamma in each partition;
+      // will subsequently become a heap.
+      heap.clear();
+      for (Uint s(0); s<S; ++s)
+         if (numChanges[s] > 0)
+            heap.push_back(linemaxpt(gammaWorkSpace[offset[s]], s, 0));
 
       /*
          Using the previous computations, we now determine the intervals on which
@@ -366,8 +332,9 @@ namespace Portage
          for all n.
 
          The BLEU stats for (-\infty, gamma[s_1][i_1]) are already stored in
-         curScore.  For each (s,i), we have recorded (in scoreWorkSpace) the change in the
-         BLEU stats from the interval just before gamma[s][i] to the interval just
+         curScore.  For each (s,i), we have recorded (in kWorkSpace) the hypothesis
+         that becomes best at gamma[s][i], which gives the change in the BLEU
+         stats from the interval just before gamma[s][i] to the interval just
          after gamma[s][i].  By iterating through the (s, i)'s in order by
          gamma[s][i] (ie.  iterating through the (s_n, i_n)'s in order by n), the
          BLEU stats for each interval are computed by updating the stats for the
@@ -389,12 +356,12 @@ namespace Portage
          (the next lowest gamma) and if i+1 < numchanges[s], add
          (gamma[s][i+1], s, i+1) to the heap.
          iii)  Repeat (ii) until the heap is empty.
-         Our heap is contained in the array heappoints.
+         Our heap is contained in the preallocated array heap, by value.
       */
       double maxscore(0.0f);  // Will hold the best BLEU score
       double maxgamma(0.0f);  // Will hold the gamma which produces the best BLEU score
 
-      if (heapsize == 0) {
+      if (heap.empty()) {
          // Special situation: no matter what gamma is, the BLEU score is
          // the same.
          maxscore = curScoreStats.score();
@@ -403,51 +370,54 @@ namespace Portage
       }
       else {
          // Create the heap
-         make_heap(heappoints, heappoints + heapsize, linemaxpt::greater);
+         make_heap(heap.begin(), heap.end(), linemaxpt::greater);
 
          maxscore = curScoreStats.score();
-         maxgamma = heappoints[0]->gamma - SMALL;
+         maxgamma = heap.front().gamma - SMALL;
 
          double oldgamma(0.0f);  // Holds the left endpoint of the interval whose stats are in curScoreStats
          while (true) {
             // Put max element at end of heap
-            pop_heap(heappoints, heappoints + heapsize, linemaxpt::greater);
-            // Update BLEU statistics
-            curScoreStats += scoreWorkSpace[heappoints[heapsize - 1]->s][heappoints[heapsize - 1]->i];
+            pop_heap(heap.begin(), heap.end(), linemaxpt::greater);
+            linemaxpt& pt(heap.back());
+            const Uint o(offset[pt.s]);
+            // Update BLEU statistics: hypothesis kWorkSpace[o+i] replaces the
+            // previous best one for sentence pt.s.
+            const vector<ScoreStats>& scoreStats(allScoreStats[pt.s]);
+            curScoreStats += scoreStats[kWorkSpace[o + pt.i]];
+            curScoreStats -= scoreStats[pt.i == 0 ? firstK[pt.s] : kWorkSpace[o + pt.i - 1]];
             // Save left endpoint of the new interval
-            oldgamma = heappoints[heapsize - 1]->gamma;
+            oldgamma = pt.gamma;
 
-            heappoints[heapsize - 1]->i++;
+            pt.i++;
             // Determine whether there is a new point to add to the heap
             // (same s, but i increases)
-            if (heappoints[heapsize - 1]->i < numchanges[heappoints[heapsize - 1]->s]) {
+            if (pt.i < numChanges[pt.s]) {
                // Add point (gamma[s][i], s, i) to the heap
-               heappoints[heapsize - 1]->gamma =
-                  gammaWorkSpace[heappoints[heapsize - 1]->s][heappoints[heapsize - 1]->i];
-               push_heap(heappoints, heappoints + heapsize, linemaxpt::greater);
+               pt.gamma = gammaWorkSpace[o + pt.i];
+               push_heap(heap.begin(), heap.end(), linemaxpt::greater);
             }
             else {
                // Decrease heap size
-               delete heappoints[heapsize - 1];
-               --heapsize;
+               heap.pop_back();
             } // if
 
             // Exit loop if there are no new points (heap is empty)
-            if (heapsize == 0) {
+            if (heap.empty()) {
                break;
             } // for
 
-            // Determine the BLEU score for the interval (oldgamma, heappoints[0]->gamma).
+            // Determine the BLEU score for the interval (oldgamma, heap.front().gamma).
             const double curscore = curScoreStats.score();
             // Determine if this is the new best score AND if the interval is non-empty
-            if (curscore > maxscore && heappoints[0]->gamma != oldgamma) {
+            if (curscore > maxscore && heap.front().gamma != oldgamma) {
                // New best score
                maxscore = curscore;
                // Use the midpoint of this range.
-               maxgamma = (heappoints[0]->gamma + oldgamma) / 2;
+               maxgamma = (heap.front().gamma + oldgamma) / 2;
             }
             if (record_history)
-               history.push_back(make_pair((heappoints[0]->gamma + oldgamma) / 2, curscore));
+               history.push_back(make_pair((heap.front().gamma + oldgamma) / 2, curscore));
          }
 
 
@@ -20,7 +20,6 @@
 #include "portage_defs.h"
 #include "boostDef.h"
 #include <vector>
-#include <boost/checked_delete.hpp>
 #include <algorithm>
 
 namespace Portage
@@ -40,23 +39,17 @@ public:
       Uint s;         ///< index of source sentence.
       Uint i;         ///< index.
 
+      /// Constructor.
+      linemaxpt(double gamma, Uint s, Uint i) : gamma(gamma), s(s), i(i) {}
+
       /**
        * Sorts in decreasing order p1 and p2
        * @param p1  left-hand side operand
        * @param p2  right-hand side operand
        * @return Returns p1 > p2
        */
-      static bool greater(const linemaxpt * const p1, const linemaxpt * const p2) {
-         return p1->gamma > p2->gamma;
-      }
-
-      /**
-       * Checks if the linemaxpt pointer is NULL
-       * @param  p  a pointer to a linemaxpt
-       * @return Returns true if the point is NULL
-       */
-      static bool isNull(const linemaxpt* const p) {
-         return p == NULL;
+      static bool greater(const linemaxpt& p1, const linemaxpt& p2) {
+         return p1.gamma > p2.gamma;
       }
    };
 
@@ -64,9 +57,16 @@ private:
    const Uint S;                                ///< number of source sentences
    const vector<uMatrix>& vH;                   ///< Feature function values
    const vector< vector<ScoreStats> >& allScoreStats;  ///< translations' score
-   ScoreStats** scoreWorkSpace;                 ///< efficient ScoreStats workspace
-   double** gammaWorkSpace;                     ///< efficient gamma workspae
-   bool record_history;
+
+   // Workspace, allocated once by the constructor.  The change points of
+   // sentence s are stored in gammaWorkSpace and kWorkSpace, starting at
+   // offset[s]; there are at most K_s - 1 of them.
+   vector<Uint> offset;         ///< start of each sentence's change points
+   vector<double> gammaWorkSpace;  ///< gamma of each change point, ascending
+   vector<Uint> kWorkSpace;     ///< best hypothesis after each change point
+   vector<Uint> firstK;         ///< best hypothesis before the first change
+   vector<Uint> numChanges;     ///< number of change points per sentence
+   vector<linemaxpt> heap;      ///< heap used to merge the change points
 
 public:
    /**
@@ -88,27 +88,14 @@ public:
       , allScoreStats(allScoreStats)
    {
       assert(vH.size() == allScoreStats.size());
-      scoreWorkSpace = new ScoreStats*[S];
-      assert(scoreWorkSpace);
-      gammaWorkSpace = new double*[S];
-      assert(gammaWorkSpace);
-      for (Uint s(0); s<S; ++s) {
-         scoreWorkSpace[s] = new ScoreStats[allScoreStats[s].size()];
-         gammaWorkSpace[s] = new double[allScoreStats[s].size()];
-      }
-   }
-   /// Destructor.
-   ~LineMax() {
-      using namespace boost;
-      using namespace std;
-
-      assert(scoreWorkSpace);
-      for_each(scoreWorkSpace, scoreWorkSpace+S, checked_array_delete<ScoreStats>);
-      checked_array_delete(scoreWorkSpace);
-
-      assert(gammaWorkSpace);
-      for_each(gammaWorkSpace, gammaWorkSpace+S, checked_array_delete<double>);
-      checked_array_delete(gammaWorkSpace);
+      offset.resize(S+1, 0);
+      for (Uint s(0); s<S; ++s)
+         offset[s+1] = offset[s] + allScoreStats[s].size();
+      gammaWorkSpace.resize(offset[S]);
+      kWorkSpace.resize(offset[S]);
+      firstK.resize(S);
+      numChanges.resize(S);
+      heap.reserve(S);
    }
 
    /// Set of (gamma,score(gamma)) pairs
@@ -148,27 +135,13 @@ public:
 
 private:
    /**
-    * @param numchanges
-    * @param gamma
-    * @param dBLEU
-    * @param curBLEU
-    * @param myHeappoint
-    * @param s
-    * @param p
-    * @param dir
-    * @param H
-    * @param bleu
+    * Finds the upper envelope of the K lines of source sentence s along
+    * p + gamma * dir, storing its change points in the workspace.
+    * @param s    index of the source sentence
+    * @param p    starting point
+    * @param dir  direction
     */
-   void findSentenceIntervals(Uint &numchanges,
-                              double *& gamma,
-                              ScoreStats *&dBLEU,
-                              ScoreStats &curBLEU,
-                              linemaxpt*& myHeappoint,
-                              const int s,
-                              const uVector& p,
-                              const uVector& dir,
-                              const uMatrix& H,
-                              const vector<ScoreStats>& bleu);
+   void findSentenceIntervals(Uint s, const uVector& p, const uVector& dir);
 }; // ends class LineMax
 } // ends namespace Portage
 
@@ -108,6 +108,8 @@ class Powell
          : vH(vH)
          , allScoreStats(allScoreStats)
          , linemax_och(vH, allScoreStats)
+         , powell_count(0)
+         , linemax_count(0)
          , randomize_feature_order(randomize_feature_order)
          , logstream(NULL)
       {
@@ -141,6 +143,14 @@ class Powell
             int &iter,
             double &score);
 
+      /**
+       * Set the number of previous calls to the Powell() operator, which
+       * identifies the calls in the log.  Useful when several Powell objects
+       * share a log, e.g., when running restarts in parallel.
+       * @param count  number of calls so far
+       */
+      void setCallCount(Uint count) { powell_count = count; }
+
 };  // ends class Powell
 
 }
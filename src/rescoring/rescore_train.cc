@@ -380,58 +380,101 @@ double runPowell(const vector<uMatrix>& vH,
 
    const Uint M = best_wts.size();
 
-   Powell<ScoreMetric> powell(vH, scores);
-   powell.logstream = logfile;
-
-   while (num_runs < total_runs) {
-
-      uVector wts(M);
-      if (num_runs < init_wts.size())
-         wts = init_wts[num_runs];
-      else
-         ffset.getRandomWeights(wts);
-
-      if (arg.bVerbose) {
-         cerr << "Calling Powell with initial wts=" << wts << endl;
+   // Powell runs are independent, so they are done in batches of one run per
+   // thread, each thread using its own Powell object.  The results of a batch
+   // are then processed in run order, exactly as if the runs had been done
+   // one after the other: the initial weights, the stopping criteria and the
+   // best weights found do not depend on the number of threads.
+   // A partial batch, at the end, leaves threads idle, and running it in
+   // parallel would keep LineMax's own parallel loop over sentences serial,
+   // since OpenMP doesn't nest parallel regions by default: its runs are done
+   // one at a time, each with all the threads in LineMax.
+#ifdef _OPENMP
+   const Uint num_threads = omp_get_max_threads();
+#else
+   const Uint num_threads = 1;
+#endif
+   vector< Powell<ScoreMetric>* > powells(num_threads, (Powell<ScoreMetric>*)NULL);
+
+   bool done = false;
+   while (!done && num_runs < total_runs) {
+
+      const Uint batch_size = min(num_threads, total_runs - num_runs);
+      vector<uVector> batch_wts(batch_size, uVector(M));
+      vector<double> batch_scores(batch_size, 0.0);
+      vector<Uint> batch_seconds(batch_size, 0);
+      vector<string> batch_logs(batch_size);
+
+      for (Uint j = 0; j < batch_size; ++j) {
+         if (num_runs + j < init_wts.size())
+            batch_wts[j] = init_wts[num_runs + j];
+         else
+            ffset.getRandomWeights(batch_wts[j]);
+
+         if (arg.bVerbose) {
+            cerr << "Calling Powell with initial wts=" << batch_wts[j] << endl;
+         }
       }
 
-      if (logfile) (*logfile) << "--- iter " << num_runs+1 << " ---" << endl;
+#pragma omp parallel for schedule(dynamic, 1) if(batch_size == num_threads)
+      for (int j = 0; j < int(batch_size); ++j) {
+#ifdef _OPENMP
+         Powell<ScoreMetric>*& powell = powells[omp_get_thread_num()];
+#else
+         Powell<ScoreMetric>*& powell = powells[0];
+#endif
+         if (!powell) powell = new Powell<ScoreMetric>(vH, scores);
 
-      int iter = 0;
-      double score = 0.0;
-      const time_t powell_start = time(NULL);             // time
-      powell(wts, POWELL_TOLERANCE, iter, score);
-      ++num_runs;
+         ostringstream log;
+         powell->logstream = logfile ? &log : NULL;
+         powell->setCallCount(num_runs + j);
 
-      if (arg.bVerbose) {
-         cerr << "Powell returned wts=" << wts << endl;
-         fprintf(stderr, "Score: %f in %d seconds\n", ScoreMetric::convertToDisplay(score), (Uint)(time(NULL)- powell_start));
+         int iter = 0;
+         const time_t powell_start = time(NULL);             // time
+         (*powell)(batch_wts[j], POWELL_TOLERANCE, iter, batch_scores[j]);
+         batch_seconds[j] = time(NULL) - powell_start;
+         if (logfile) batch_logs[j] = log.str();
       }
 
-      double pnorm_score = ScoreMetric::convertToPnorm(score);
-      assert(pnorm_score >= 0 && pnorm_score <= 1);
-      history.push_back(history_datum<ScoreMetric>(score, wts));
-      score_history.push_back(pnorm_score);
-
-      if (score > best_score) {
-         best_wts = wts;
-         best_score = score;
-      }
-      if (!arg.approx_expect && arg.num_powell_runs == 0 && ScoreMetric::convertToPnorm(score) > extend_thresh) {
-         // 'normal' stopping criterion
-         total_runs = max(num_runs+rescore_train::NUM_INIT_RUNS+2, 2 * num_runs); // bizarre for bkw compat
-         extend_thresh = ScoreMetric::convertToPnorm(score) + SCORETOL;
-      }
-      else if (arg.approx_expect && num_runs > rescore_train::NUM_INIT_RUNS+2) {
-         // approx-expect stopping
-         const double m = mean(score_history.begin(), score_history.end());
-         const double s = sdev(score_history.begin(), score_history.end(), m);
-         const Uint expected_iters = Uint(1.0 / (1.0 - normalCDF(ScoreMetric::convertToPnorm(best_score), m, s)));
-         if (num_runs + expected_iters > total_runs)
-            break;
+      for (Uint j = 0; !done && j < batch_size; ++j) {
+         const uVector& wts = batch_wts[j];
+         const double score = batch_scores[j];
+
+         if (logfile) (*logfile) << "--- iter " << num_runs+1 << " ---" << endl << batch_logs[j];
+         ++num_runs;
+
+         if (arg.bVerbose) {
+            cerr << "Powell returned wts=" << wts << endl;
+            fprintf(stderr, "Score: %f in %d seconds\n", ScoreMetric::convertToDisplay(score), batch_seconds[j]);
+         }
+
+         double pnorm_score = ScoreMetric::convertToPnorm(score);
+         assert(pnorm_score >= 0 && pnorm_score <= 1);
+         history.push_back(history_datum<ScoreMetric>(score, wts));
+         score_history.push_back(pnorm_score);
+
+         if (score > best_score) {
+            best_wts = wts;
+            best_score = score;
+         }
+         if (!arg.approx_expect && arg.num_powell_runs == 0 && ScoreMetric::convertToPnorm(score) > extend_thresh) {
+            // 'normal' stopping criterion
+            total_runs = max(num_runs+rescore_train::NUM_INIT_RUNS+2, 2 * num_runs); // bizarre for bkw compat
+            extend_thresh = ScoreMetric::convertToPnorm(score) + SCORETOL;
+         }
+         else if (arg.approx_expect && num_runs > rescore_train::NUM_INIT_RUNS+2) {
+            // approx-expect stopping
+            const double m = mean(score_history.begin(), score_history.end());
+            const double s = sdev(score_history.begin(), score_history.end(), m);
+            const Uint expected_iters = Uint(1.0 / (1.0 - normalCDF(ScoreMetric::convertToPnorm(best_score), m, s)));
+            if (num_runs + expected_iters > total_runs)
+               done = true;
+         }
       }
    }
 
+   for (Uint t = 0; t < powells.size(); ++t)
+      delete powells[t];
    if (logfile) delete logfile;
 
    return best_score;
@@ -162,6 +162,16 @@ Output selection options (specify as many as you need):\n\
             in the format c=<count>.  [don't]\n\
 -f1 freqs1  Write language 1 phrases and their frequencies to file freqs1.\n\
 -f2 freqs2  Write language 2 phrases and their frequencies to file freqs2.\n\
+\n\
+Memory options:\n\
+\n\
+-mem-budget MB  Keep at most about MB megabytes of phrase pairs in memory:\n\
+            whenever the table grows larger, write it to a sorted run on disk\n\
+            in $TMPDIR (or /tmp) and start over; the runs are merged at the\n\
+            end.  -multipr output is then pruned and smoothed from the merged\n\
+            joint table, one lang1 phrase at a time, and -j output is grouped\n\
+            by lang1 phrase rather than in the usual order.  Not compatible\n\
+            with -i, -w, -f1 or -f2.  [no limit]\n\
 ";
 
 // globals
@@ -179,7 +189,7 @@ static const char* const switches[] = {
    "lc1:", "lc2:",
    "num-file-args", // hidden option for gen-jpt-parallel.sh
    "file-args", // hidden option for gen-jpt-parallel.sh
-   "multipr:", "tmtext", "giza", "ext"
+   "multipr:", "tmtext", "giza", "ext", "mem-budget:"
 };
 
 static Uint smoothing_verbose = 0; // ugly ugly ugly ugly ugly ugly ugly ugly
@@ -204,6 +214,7 @@ static bool write_count = false;
 static bool compress_output = false;
 static Uint first_file_arg = 2;
 static bool externalAlignerMode = false;
+static Uint mem_budget = 0;
 
 // Most parameters are in now ppe, with their defaults set in
 // PhrasePairExtractor::PhrasePairExtractor() (see phrase_pair_extractor.h).
@@ -295,6 +306,7 @@ public:
       mp_arg_reader->testAndSet("multipr", multipr_output);
       mp_arg_reader->testAndSet("write-al", store_alignment_option);
       mp_arg_reader->testAndSet("write-count", write_count);
+      mp_arg_reader->testAndSet("mem-budget", mem_budget);
 
       if (mp_arg_reader->getSwitch("tmtext"))
          error(ETFatal, "-tmtext is obsolete");
@@ -381,6 +393,10 @@ public:
 
       if (!indiv_tables && !joint && multipr_output.empty())
          error(ETFatal, "No output requested");
+
+      if (mem_budget && (indiv_tables || ppe.add_word_translations ||
+                         freqs1 != "" || freqs2 != ""))
+         error(ETFatal, "-mem-budget is not compatible with -i, -w, -f1 or -f2");
    }
 };
 
@@ -426,6 +442,7 @@ struct ExtractPhrasePairs {
 };
 
 void doEverything(const char* prog_name, ARG& args);
+void writeTables(PhraseTableUint& pt, const string& z_ext);
 
 
 int MAIN(argc, argv)
@@ -476,6 +493,8 @@ void doEverything(const char* prog_name, ARG& args)
    }
 
    PhraseTableUint pt;
+   if (mem_budget)
+      pt.spillToDisk(Uint64(mem_budget) << 20);
    Voc word_voc_1, word_voc_2;
 
    string alfile1, alfile2;
@@ -589,6 +608,30 @@ void doEverything(const char* prog_name, ARG& args)
       if (os2) delete os2;
    }
 
+   if (pt.numSpilledRuns() > 0) {
+      if (ppe.verbose)
+         cerr << "merging " << pt.numSpilledRuns() << " sorted runs" << endl;
+      if (multipr_output == "") {
+         // Only -j: stream the merged runs directly.
+         pt.dump_joint_freqs(cout, 0, false, false, ppe.display_alignments);
+      } else {
+         const string merged_jpt = pt.mergeToJointFile();
+         PhraseTableUint merged_pt;
+         merged_pt.readJointTable(merged_jpt, true);
+         writeTables(merged_pt, z_ext);
+         unlink(merged_jpt.c_str());
+      }
+   } else {
+      writeTables(pt, z_ext);
+   }
+
+   if (ppe.verbose) cerr << "done" << endl;
+
+}
+
+/// Prune, smooth and write the requested global tables.
+void writeTables(PhraseTableUint& pt, const string& z_ext)
+{
    if (prune1 || prune1w) {
       if (ppe.verbose) {
          cerr << "pruning to best ";
@@ -633,7 +676,4 @@ void doEverything(const char* prog_name, ARG& args)
          pt.dump_freqs_lang2(ofs);
       }
    }
-
-   if (ppe.verbose) cerr << "done" << endl;
-
 }
@@ -0,0 +1,284 @@
+/**
+ * @file incr_phrase_counts.cc
+ * @brief Implementation of IncrPhraseCounts.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "incr_phrase_counts.h"
+#include "phrase_table.h"
+#include "str_utils.h"
+#include "file_utils.h"
+#include <algorithm>
+
+using namespace Portage;
+
+/**
+ * Tally the alignments in display format al, as written by dump_joint_freqs()
+ * with display_alignments=1 or 2, into alignments.
+ * @param al  "al1:count1;al2:count2;..." or a single alignment without count
+ * @param pair_count  count to use for a single alignment without a count
+ */
+static void tallyAlignments(map<string,Uint>& alignments, const string& al, Uint pair_count)
+{
+   if (al.empty()) return;
+   vector<string> items;
+   split(al, items, ";");
+   for (Uint i = 0; i < items.size(); ++i) {
+      const string::size_type colon = items[i].rfind(':');
+      if (colon == string::npos) {
+         alignments[items[i]] += (items.size() == 1 ? pair_count : 1);
+      } else {
+         Uint count = 1;
+         if (!conv(items[i].substr(colon+1), count))
+            error(ETFatal, "Invalid alignment count in alignment field %s", al.c_str());
+         alignments[items[i].substr(0, colon)] += count;
+      }
+   }
+}
+
+/**
+ * Undo tallyAlignments(alignments, al, pair_count), forgetting alignments
+ * whose count drops to 0.
+ */
+static void untallyAlignments(map<string,Uint>& alignments, const string& al, Uint pair_count)
+{
+   map<string,Uint> removed;
+   tallyAlignments(removed, al, pair_count);
+   for (map<string,Uint>::const_iterator it(removed.begin()); it != removed.end(); ++it) {
+      map<string,Uint>::iterator found = alignments.find(it->first);
+      if (found == alignments.end()) continue;
+      if (found->second > it->second)
+         found->second -= it->second;
+      else
+         alignments.erase(found);
+   }
+}
+
+const string& IncrPhraseCounts::PairInfo::topAlignment() const
+{
+   static const string empty;
+   map<string,Uint>::const_iterator best = alignments.end();
+   for (map<string,Uint>::const_iterator it(alignments.begin()); it != alignments.end(); ++it)
+      if (best == alignments.end() || it->second > best->second)
+         best = it;
+   return best == alignments.end() ? empty : best->first;
+}
+
+void IncrPhraseCounts::clear()
+{
+   index1.clear();
+   index2.clear();
+   phrases2.clear();
+   marginals1.clear();
+   marginals2.clear();
+   table.clear();
+   num_pairs = 0;
+}
+
+Uint IncrPhraseCounts::getId(PhraseIndex& index, const string& phrase, bool& added)
+{
+   pair<PhraseIndex::iterator, bool> res =
+      index.insert(make_pair(phrase, Uint(index.size())));
+   added = res.second;
+   return res.first->second;
+}
+
+void IncrPhraseCounts::add(const string& phrase1, const string& phrase2, Uint count,
+                           const string& green_alignment)
+{
+   bool added;
+   const Uint id1 = getId(index1, phrase1, added);
+   if (added) {
+      marginals1.push_back(0);
+      table.push_back(TargetCounts());
+   }
+   const Uint id2 = getId(index2, phrase2, added);
+   if (added) {
+      marginals2.push_back(0);
+      phrases2.push_back(&(index2.find(phrase2)->first));
+   }
+   assert(id1 < table.size() && id2 < phrases2.size());
+
+   PairInfo& info = table[id1][id2];
+   if (info.count == 0) ++num_pairs;
+   info.count += count;
+   marginals1[id1] += count;
+   marginals2[id2] += count;
+   tallyAlignments(info.alignments, green_alignment, count);
+}
+
+Uint IncrPhraseCounts::merge(PhraseTableUint& pt)
+{
+   Uint total = 0;
+   string p1, p2, al;
+   for (PhraseTableUint::iterator it(pt.begin()), end(pt.end()); it != end; ++it) {
+      it.getPhrase(1, p1);
+      it.getPhrase(2, p2);
+      it.getAlignmentString(al, false, false);
+      const Uint count = it.getJointFreq();
+      // Alignments are written with explicit counts, except when there is
+      // exactly one seen once, which tallyAlignments() handles.
+      add(p1, p2, count, al);
+      total += count;
+   }
+   return total;
+}
+
+Uint IncrPhraseCounts::remove(const string& phrase1, const string& phrase2, Uint count,
+                              const string& green_alignment)
+{
+   PhraseIndex::const_iterator p1 = index1.find(phrase1);
+   PhraseIndex::const_iterator p2 = index2.find(phrase2);
+   if (p1 == index1.end() || p2 == index2.end()) return 0;
+   const Uint id1 = p1->second;
+   const Uint id2 = p2->second;
+   TargetCounts::iterator it = table[id1].find(id2);
+   if (it == table[id1].end()) return 0;
+
+   PairInfo& info = it->second;
+   const Uint removed = min(count, info.count);
+   marginals1[id1] -= removed;
+   marginals2[id2] -= removed;
+   info.count -= removed;
+   if (info.count == 0) {
+      table[id1].erase(it);
+      --num_pairs;
+   } else {
+      untallyAlignments(info.alignments, green_alignment, count);
+   }
+   return removed;
+}
+
+Uint IncrPhraseCounts::subtract(PhraseTableUint& pt, Uint& missing)
+{
+   Uint total = 0;
+   missing = 0;
+   string p1, p2, al;
+   for (PhraseTableUint::iterator it(pt.begin()), end(pt.end()); it != end; ++it) {
+      it.getPhrase(1, p1);
+      it.getPhrase(2, p2);
+      it.getAlignmentString(al, false, false);
+      const Uint count = it.getJointFreq();
+      const Uint removed = remove(p1, p2, count, al);
+      total += removed;
+      missing += count - removed;
+   }
+   return total;
+}
+
+void IncrPhraseCounts::merge(const IncrPhraseCounts& other)
+{
+   vector<const string*> phrases1(other.index1.size());
+   for (PhraseIndex::const_iterator it(other.index1.begin()); it != other.index1.end(); ++it)
+      phrases1[it->second] = &it->first;
+
+   for (Uint id1 = 0; id1 < other.table.size(); ++id1) {
+      for (TargetCounts::const_iterator it(other.table[id1].begin());
+           it != other.table[id1].end(); ++it) {
+         add(*phrases1[id1], *other.phrases2[it->first], it->second.count);
+         // The alignments were already counted in it->second; copy them directly.
+         PairInfo& info = table[index1[*phrases1[id1]]][index2[*other.phrases2[it->first]]];
+         for (map<string,Uint>::const_iterator al(it->second.alignments.begin());
+              al != it->second.alignments.end(); ++al)
+            info.alignments[al->first] += al->second;
+      }
+   }
+}
+
+void IncrPhraseCounts::read(istream& in, const string& stream_name)
+{
+   const string& psep = PhraseTableBase::psep;
+   string line;
+   vector<string> toks;
+   Uint line_no = 0;
+   while (getline(in, line)) {
+      ++line_no;
+      toks.clear();
+      split(line, toks, " ");
+      if (toks.empty()) continue;
+
+      vector<string>::iterator sep1 = find(toks.begin(), toks.end(), psep);
+      vector<string>::iterator sep2 =
+         sep1 == toks.end() ? toks.end() : find(sep1+1, toks.end(), psep);
+      if (sep2 == toks.end() || sep2+1 == toks.end())
+         error(ETFatal, "Bad format in %s at line %u: expected \"src ||| tgt ||| count\"",
+               stream_name.c_str(), line_no);
+
+      Uint count;
+      if (!conv(*(sep2+1), count))
+         error(ETFatal, "Bad count in %s at line %u: %s",
+               stream_name.c_str(), line_no, (sep2+1)->c_str());
+
+      string al;
+      for (vector<string>::iterator it(sep2+2); it < toks.end(); ++it)
+         if (isPrefix("a=", *it))
+            al = it->substr(2);
+
+      add(join(toks.begin(), sep1), join(sep1+1, sep2), count, al);
+   }
+}
+
+void IncrPhraseCounts::read(const string& filename)
+{
+   iSafeMagicStream in(filename);
+   read(in, filename);
+}
+
+void IncrPhraseCounts::write(ostream& out, bool write_al) const
+{
+   // Sort by source phrase, then by target phrase, to produce a jpt in the
+   // same order as LC_ALL=C sort would.
+   vector<pair<string,Uint> > sources(index1.begin(), index1.end());
+   sort(sources.begin(), sources.end());
+
+   const string& psep = PhraseTableBase::psep;
+   vector<pair<string,const PairInfo*> > targets;
+   for (Uint i = 0; i < sources.size(); ++i) {
+      const TargetCounts& tc = table[sources[i].second];
+      targets.clear();
+      for (TargetCounts::const_iterator it(tc.begin()); it != tc.end(); ++it)
+         targets.push_back(make_pair(*phrases2[it->first], &it->second));
+      sort(targets.begin(), targets.end());
+
+      for (Uint j = 0; j < targets.size(); ++j) {
+         const PairInfo& info = *targets[j].second;
+         out << sources[i].first << ' ' << psep << ' ' << targets[j].first
+             << ' ' << psep << ' ' << info.count;
+         if (write_al && !info.alignments.empty()) {
+            out << " a=";
+            for (map<string,Uint>::const_iterator al(info.alignments.begin());
+                 al != info.alignments.end(); ++al) {
+               if (al != info.alignments.begin()) out << ';';
+               out << al->first << ':' << al->second;
+            }
+         }
+         out << nf_endl;
+      }
+   }
+   out.flush();
+}
+
+Uint IncrPhraseCounts::lookup(const string& phrase1, vector<Translation>& trans) const
+{
+   trans.clear();
+   PhraseIndex::const_iterator p1 = index1.find(phrase1);
+   if (p1 == index1.end()) return 0;
+
+   const Uint id1 = p1->second;
+   const TargetCounts& tc = table[id1];
+   trans.reserve(tc.size());
+   for (TargetCounts::const_iterator it(tc.begin()); it != tc.end(); ++it) {
+      Translation t;
+      t.phrase2 = phrases2[it->first];
+      t.joint = it->second.count;
+      t.marginal2 = marginals2[it->first];
+      t.info = &it->second;
+      trans.push_back(t);
+   }
+   return marginals1[id1];
+}
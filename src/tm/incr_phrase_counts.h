@@ -0,0 +1,157 @@
+/**
+ * @file incr_phrase_counts.h
+ * @brief Mergeable in-memory joint phrase counts, for incremental TMs.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef INCR_PHRASE_COUNTS_H
+#define INCR_PHRASE_COUNTS_H
+
+#include "portage_defs.h"
+#include "string_hash.h"
+#include <map>
+#include <iostream>
+
+namespace Portage {
+
+class PhraseTableUint;
+
+/**
+ * Joint phrase pair counts that can be updated in place, one batch of phrase
+ * pairs at a time, and queried by source phrase while being updated.
+ *
+ * PhraseTableGen is designed to be filled once and then dumped; it cannot be
+ * queried for all translations of a source phrase, and its marginals are only
+ * tallied by the smoothers at dump time.  IncrPhraseCounts keeps the
+ * marginals up to date with every addition, so that relative-frequency
+ * estimates can be calculated on demand, e.g., by a decoder feature.
+ *
+ * Phrases are stored in their text form, with tokens separated by single
+ * spaces.  The on-disk representation is a regular joint phrase table (jpt),
+ * so counts can also be combined with merge_counts.
+ */
+class IncrPhraseCounts : private NonCopyable
+{
+public:
+   /// Information about one phrase pair
+   struct PairInfo {
+      Uint count;                    ///< joint count
+      map<string,Uint> alignments;   ///< green alignment -> count
+      PairInfo() : count(0) {}
+      /// Most frequent alignment, or "" if none were recorded.
+      const string& topAlignment() const;
+   };
+
+   /// One translation of a source phrase, as returned by lookup()
+   struct Translation {
+      const string* phrase2;   ///< target phrase, space separated tokens
+      Uint joint;              ///< joint count c(s,t)
+      Uint marginal2;          ///< target marginal c(t)
+      const PairInfo* info;    ///< full pair information
+   };
+
+private:
+   typedef unordered_map<string, Uint> PhraseIndex;
+   typedef map<Uint, PairInfo> TargetCounts;  ///< id2 -> pair info
+
+   PhraseIndex index1;               ///< source phrase -> id1
+   PhraseIndex index2;               ///< target phrase -> id2
+   vector<const string*> phrases2;   ///< id2 -> target phrase (points into index2)
+   vector<Uint> marginals1;          ///< id1 -> c(s)
+   vector<Uint> marginals2;          ///< id2 -> c(t)
+   vector<TargetCounts> table;       ///< id1 -> (id2 -> pair info)
+   Uint num_pairs;                   ///< number of distinct phrase pairs
+
+   Uint getId(PhraseIndex& index, const string& phrase, bool& added);
+
+public:
+   /// Constructor: creates an empty table
+   IncrPhraseCounts() : num_pairs(0) {}
+
+   /// Remove all counts
+   void clear();
+
+   /// Number of distinct phrase pairs
+   Uint size() const { return num_pairs; }
+   /// True iff no phrase pairs have been added
+   bool empty() const { return num_pairs == 0; }
+
+   /**
+    * Add count occurrences of a phrase pair.
+    * @param phrase1  source phrase, tokens separated by single spaces
+    * @param phrase2  target phrase, tokens separated by single spaces
+    * @param count    number of occurrences to add
+    * @param green_alignment  if non-empty, alignment in green format to
+    *                 tally with the same count
+    */
+   void add(const string& phrase1, const string& phrase2, Uint count,
+            const string& green_alignment = "");
+
+   /**
+    * Merge all phrase pairs from a PhraseTableUint, e.g., as produced by
+    * PhrasePairExtractor::extractPhrasePairs() for a few new sentence pairs.
+    * All the alignments of each pair are tallied, as in add().
+    * @return number of phrase pair occurrences added
+    */
+   Uint merge(PhraseTableUint& pt);
+
+   /// Merge all counts from another IncrPhraseCounts object.
+   void merge(const IncrPhraseCounts& other);
+
+   /**
+    * Remove count occurrences of a phrase pair, undoing add().  A pair whose
+    * count drops to 0 is forgotten, as are alignments whose count does.
+    * @param phrase1  source phrase, tokens separated by single spaces
+    * @param phrase2  target phrase, tokens separated by single spaces
+    * @param count    number of occurrences to remove
+    * @param green_alignment  alignment given to add() with the same count
+    * @return number of occurrences removed, less than count if the pair did
+    *         not have that many
+    */
+   Uint remove(const string& phrase1, const string& phrase2, Uint count,
+               const string& green_alignment = "");
+
+   /**
+    * Subtract all phrase pairs from a PhraseTableUint, undoing merge(pt),
+    * e.g., when sentence pairs drop out of a rolling window.
+    * @param[out] missing  number of phrase pair occurrences in pt that
+    *                      could not be removed because they were not counted
+    * @return number of phrase pair occurrences removed
+    */
+   Uint subtract(PhraseTableUint& pt, Uint& missing);
+
+   /**
+    * Read a joint phrase table, adding its counts to the current ones.
+    * Lines must be "src ||| tgt ||| count [a=alignments]", as written by
+    * gen_phrase_tables -j or by write().
+    */
+   void read(istream& in, const string& stream_name = "jpt stream");
+   /// Same as read(istream&), but opens the file itself.
+   void read(const string& filename);
+
+   /**
+    * Write the table as a jpt, sorted in LC_ALL=C order so it is directly
+    * usable by merge_counts and joint2cond_phrase_tables.
+    * @param write_al  if true, also write all the alignments of each pair
+    *                  with their counts, as "a=al1:count1;al2:count2;..."
+    */
+   void write(ostream& out, bool write_al = true) const;
+
+   /**
+    * Look up all translations of phrase1.
+    * @param phrase1  source phrase, tokens separated by single spaces
+    * @param[out] trans  translations found, cleared first
+    * @return the source marginal c(s), 0 if phrase1 is unknown
+    */
+   Uint lookup(const string& phrase1, vector<Translation>& trans) const;
+
+}; // class IncrPhraseCounts
+
+} // namespace Portage
+
+#endif // INCR_PHRASE_COUNTS_H
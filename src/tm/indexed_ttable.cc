@@ -0,0 +1,88 @@
+/**
+ * @file indexed_ttable.cc
+ * @brief Integer-encoded access to an IBM1 ttable, for lexical smoothing
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "indexed_ttable.h"
+#include "ibm.h"
+#include "voc.h"
+#include <cmath>
+
+using namespace Portage;
+
+IndexedTTable::Cache::Cache(Uint bits)
+   : mask((1u << bits) - 1)
+{
+   Entry empty;
+   empty.src = empty.tgt = Uint(-1);  // never a valid pair of tt indexes
+   empty.p = 0.0;
+   entries.assign(mask + 1, empty);
+}
+
+IndexedTTable::IndexedTTable(IBM1& ibm)
+   : tt(ibm.getTTable())
+   , use_nulls(ibm.useImplicitNulls)
+   , null_index(ibm.getTTable().sourceIndex(IBM1::nullWord()))
+{}
+
+void IndexedTTable::update(const Voc& src_voc, const Voc& tgt_voc)
+{
+   for (Uint i = src_index.size(); i < src_voc.size(); ++i)
+      src_index.push_back(tt.sourceIndex(src_voc.word(i)));
+   for (Uint i = tgt_index.size(); i < tgt_voc.size(); ++i)
+      tgt_index.push_back(tt.targetIndex(tgt_voc.word(i)));
+}
+
+double IndexedTTable::pr(const vector<Uint>& src_toks, Uint tgt_tok,
+                         Cache& cache, vector<double>* probs) const
+{
+   // Mirrors IBM1::pr() exactly, including the order of the summation.
+   const Uint base = use_nulls ? 1 : 0;
+   if (probs) (*probs).assign(src_toks.size() + base, 0.0);
+
+   assert(tgt_tok < tgt_index.size());
+   const Uint tindex = tgt_index[tgt_tok];
+   if (tindex == tt.numTargetWords())
+      return 0.0;
+
+   double p = 0.0;
+   for (Uint i = 0; i < src_toks.size(); ++i) {
+      assert(src_toks[i] < src_index.size());
+      const double wp = prob(src_index[src_toks[i]], tindex, cache);
+      if (wp != 0.0) {
+         p += wp;
+         if (probs) (*probs)[base+i] = wp;
+      }
+   }
+
+   Uint num_src = src_toks.size();
+
+   if (use_nulls) {
+      const double wp = prob(null_index, tindex, cache);
+      if (wp != 0.0) {
+         p += wp;
+         if (probs) (*probs)[0] = wp;
+      }
+      ++num_src;
+   }
+
+   return num_src == 0 ? 0.0 : p / num_src;
+}
+
+double IndexedTTable::logpr(const vector<Uint>& src_toks,
+                            const vector<Uint>& tgt_toks,
+                            double smooth, Cache& cache) const
+{
+   double lp = 0, logsmooth = log(smooth);
+   for (Uint i = 0; i < tgt_toks.size(); ++i) {
+      double tp = pr(src_toks, tgt_toks[i], cache);
+      lp += tp == 0 ? logsmooth : log(tp);
+   }
+   return lp;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file indexed_ttable.h
+ * @brief Integer-encoded access to an IBM1 ttable, for lexical smoothing
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef __INDEXED_TTABLE_H__
+#define __INDEXED_TTABLE_H__
+
+#include "portage_defs.h"
+#include "ttable.h"
+#include <vector>
+
+namespace Portage {
+
+class IBM1;
+class Voc;
+
+/**
+ * Read-only view of the ttable of an IBM1 model where words are identified
+ * by their index in a pair of external vocabularies, such as the word
+ * vocabularies of a PhraseTableGen, rather than by their strings.
+ *
+ * Vocabulary indexes are mapped to ttable indexes once, by update(), so the
+ * scoring functions never hash a word.  Word-pair probabilities are further
+ * memoized in a Cache, which the caller provides so that several threads can
+ * score with the same IndexedTTable, each with its own Cache.
+ *
+ * pr() and logpr() return exactly what IBM1::pr() and IBM1::logpr() return
+ * on the corresponding strings.
+ */
+class IndexedTTable
+{
+   const TTable& tt;
+   const bool use_nulls;               ///< copy of ibm.useImplicitNulls
+   const Uint null_index;              ///< tt source index of IBM1::nullWord()
+   vector<Uint> src_index;             ///< src_voc index -> tt source index
+   vector<Uint> tgt_index;             ///< tgt_voc index -> tt target index
+
+   /// Uncached p(tgt|src), with tt indexes; 0 if not in the ttable.
+   double lookup(Uint src, Uint tgt) const {
+      const TTable::SrcDistn& distn = tt.getSourceDistn(src);
+      const int offset = tt.targetOffset(tgt, distn);
+      return offset == -1 ? 0.0 : distn[offset].second;
+   }
+
+public:
+   /**
+    * Bounded, direct-mapped cache of word-pair probabilities.  A Cache must
+    * only be used with the IndexedTTable it was first used with, and by only
+    * one thread at a time.
+    */
+   class Cache {
+      friend class IndexedTTable;
+      struct Entry {
+         Uint src;
+         Uint tgt;
+         double p;
+      };
+      vector<Entry> entries;
+      Uint mask;
+   public:
+      /// @param bits  log2 of the number of entries
+      explicit Cache(Uint bits = 16);
+   };
+
+   /**
+    * Constructor.  Call update() before scoring.
+    * @param ibm  model whose ttable and null word setting are used; must
+    *             outlive this object, and its case mapping, if any, must be
+    *             set before calling update().
+    */
+   explicit IndexedTTable(IBM1& ibm);
+
+   /**
+    * Extend the index maps to cover all words currently in src_voc and
+    * tgt_voc.  Not thread safe: call before scoring in parallel.
+    * @param src_voc  vocabulary of the conditioning (ttable source) language
+    * @param tgt_voc  vocabulary of the predicted (ttable target) language
+    */
+   void update(const Voc& src_voc, const Voc& tgt_voc);
+
+   /// Number of src_voc and tgt_voc words covered by the last update().
+   Uint srcVocSize() const { return src_index.size(); }
+   Uint tgtVocSize() const { return tgt_index.size(); }
+
+   /**
+    * Same as IBM1::pr(src_toks, tgt_tok, probs), with words given as
+    * vocabulary indexes already covered by update().
+    */
+   double pr(const vector<Uint>& src_toks, Uint tgt_tok, Cache& cache,
+             vector<double>* probs = NULL) const;
+
+   /**
+    * Same as IBM1::logpr(src_toks, tgt_toks, smooth), with words given as
+    * vocabulary indexes already covered by update().
+    */
+   double logpr(const vector<Uint>& src_toks, const vector<Uint>& tgt_toks,
+                double smooth, Cache& cache) const;
+
+private:
+   /// Cached p(tgt|src), with tt indexes.
+   double prob(Uint src, Uint tgt, Cache& cache) const {
+      Cache::Entry& e = cache.entries[(src * 2654435761u ^ tgt) & cache.mask];
+      if (e.src != src || e.tgt != tgt) {
+         e.src = src;
+         e.tgt = tgt;
+         e.p = lookup(src, tgt);
+      }
+      return e.p;
+   }
+}; // class IndexedTTable
+
+} // namespace Portage
+
+#endif // __INDEXED_TTABLE_H__
@@ -35,13 +35,15 @@ static char help_message[] = "\n\
 joint2cond_phrase_tables [-Hvijz][-[no-]sort][-1 l1][-2 l2][-o name][-s 'meth args']\n\
                          [-ibm n][-hmm][-ibm_l2_given_l1 m][-ibm_l1_given_l2 m]\n\
                          [-prune1 n][-prune1w nw][-multipr d]\n\
-                         [-lc1 loc][-lc2 loc] [-[no-]reduce-mem][jtable]\n\
+                         [-lc1 loc][-lc2 loc] [-[no-]reduce-mem]\n\
+                         [-mem-budget MB][jtable]\n\
 \n\
 Convert joint-frequency phrase table <jtable> (stdin if no <jtable> parameter\n\
 given) into two standard conditional-probability phrase tables\n\
 <name>.<l1>_given_<l2> and <name>.<l2>_given_<l1>. <jtable> can be one or more\n\
-individual joint tables cat'd together. Note that the ibm-model parameters are\n\
-required only for certain smoothing schemes.\n\
+individual joint tables cat'd together, or a binary joint table created by\n\
+jpt2bjpt or merge_counts -b, which is read without any text parsing. Note that\n\
+the ibm-model parameters are required only for certain smoothing schemes.\n\
 \n\
 Options:\n\
 \n\
@@ -108,6 +110,12 @@ Options:\n\
                   using this option, or else the output will be incorrect.\n\
                   When combined with -prune1[w], all phrase pairs for a given\n\
                   lang1 phrase must also occur consecutively.\n\
+-mem-budget MB  Read <jtable> keeping at most about MB megabytes of phrase\n\
+                  pairs in memory, spilling sorted runs to $TMPDIR (or /tmp)\n\
+                  as needed, then merge the runs into a temporary jtable and\n\
+                  process it as with -reduce-mem.  Unlike -reduce-mem, this\n\
+                  works with concatenated jpts and with stdin.  Has no effect\n\
+                  if the whole table fits in MB.  [no limit]\n\
 ";
 
 // globals
@@ -135,6 +143,7 @@ static bool compress_output = false;
 static const string extension(".gz");
 static bool sorted(true);
 static bool reduce_memory(false);
+static Uint mem_budget = 0;
 static string store_alignment_option = "";
 static Uint display_alignments = 0; // 0=none, 1=top, 2=all/keep
 static bool write_count(false);
@@ -145,6 +154,9 @@ static void getArgs(int argc, const char* const argv[]);
 template<class T>
 static void doEverything(const char* prog_name);
 
+template<class T>
+static void writeTables(PhraseTableGen<T>& pt, time_t start_time);
+
 // main
 
 int MAIN(argc,argv)
@@ -188,8 +200,27 @@ static void doEverything(const char* prog_name)
 {
    time_t start_time(time(NULL));
    PhraseTableGen<T> pt;
+   if (mem_budget)
+      pt.spillToDisk(Uint64(mem_budget) << 20);
    pt.readJointTable(in_file, reduce_memory, swap_on_read, max_len_on_read);
 
+   if (pt.numSpilledRuns() > 0) {
+      if (verbose)
+         cerr << "merging " << pt.numSpilledRuns() << " sorted runs" << endl;
+      const string merged_jpt = pt.mergeToJointFile();
+      reduce_memory = true;
+      PhraseTableGen<T> merged_pt;
+      merged_pt.readJointTable(merged_jpt, reduce_memory);
+      writeTables(merged_pt, start_time);
+      unlink(merged_jpt.c_str());
+   } else {
+      writeTables(pt, start_time);
+   }
+}
+
+template<class T>
+static void writeTables(PhraseTableGen<T>& pt, time_t start_time)
+{
    if (verbose && !reduce_memory) {
       cerr << "read joint table: "
            << pt.numLang1Phrases() << " " << lang1 << " phrases, "
@@ -303,7 +334,7 @@ static void getArgs(int argc, const char* const argv[])
       "lc1:", "lc2:",
       "write-al:", "write-count", "write-smoother-state",
       "tmtext", "multipr:", "sort", "no-sort",
-      "reduce-mem", "no-reduce-mem"
+      "reduce-mem", "no-reduce-mem", "mem-budget:"
    };
 
    ArgReader arg_reader(ARRAY_SIZE(switches), switches, 0, 1, help_message,
@@ -335,6 +366,7 @@ static void getArgs(int argc, const char* const argv[])
    arg_reader.testAndSetOrReset("sort", "no-sort", sorted);
    if (sorted && multipr_output != "") cerr << "Producing sorted cpt." << endl;
    arg_reader.testAndSetOrReset("reduce-mem", "no-reduce-mem", reduce_memory);
+   arg_reader.testAndSet("mem-budget", mem_budget);
    arg_reader.testAndSet("write-al", store_alignment_option);
    arg_reader.testAndSet("write-count", write_count);
    arg_reader.testAndSet("write-smoother-state", write_smoother_state);
@@ -375,6 +407,11 @@ static void getArgs(int argc, const char* const argv[])
       smoothing_methods.resize(1);
    }
 
+   if (reduce_memory && mem_budget) {
+      error(ETWarn, "-mem-budget reads the jtable in memory first; ignoring -reduce-mem.");
+      reduce_memory = false;
+   }
+
    if (reduce_memory && (in_file == "-")) {
       error(ETWarn, "Cannot reduce memory when reading jtable from stdin. "
             "Phrase tables will be kept entirely in memory.  "
@@ -203,6 +203,16 @@ template<class T> struct ValAndIndex {
    operator T&() {
       return val;
    }
+
+   // binary I/O, for PhraseTableGen's sorted runs spilled to disk
+   void writebin(ostream& os) const {
+      BinIO::writebin(os, val);
+      BinIO::writebin(os, index);
+   }
+   void readbin(istream& is) {
+      BinIO::readbin(is, val);
+      BinIO::readbin(is, index);
+   }
 };
 
 template <class StringType, class T> bool conv(StringType s, ValAndIndex<T>& vi)
@@ -666,8 +676,30 @@ void doEverything(const char* prog_name)
    vector<double> adir_vals;
    string p1, p2;
    Uint total = 0;
-   for (typename PhraseTableGen< ValAndIndex<T> >::iterator it = pt.begin(); 
-	it != pt.end(); ++it) {
+
+   // The count-independent smoothers score a block of phrase pairs at a
+   // time, which lets the lexical ones use several threads; pairs are still
+   // written in table order.
+   typedef typename PhraseTableGen< ValAndIndex<T> >::iterator PTIter;
+   const Uint block_size = 100000;
+   vector<PTIter> block;
+   vector< vector<double> > noncount_rev(noncount_smoothers.size());
+   vector< vector<double> > noncount_fwd(noncount_smoothers.size());
+   vector< vector<double> > adir_noncount_rev(adir_noncount_smoothers.size());
+   vector< vector<double> > adir_noncount_fwd(adir_noncount_smoothers.size());
+   Uint b = 0; // position of it in block
+   for (PTIter it = pt.begin(); it != pt.end(); ++it, ++b) {
+      if (b == block.size()) {
+         block.clear();
+         b = 0;
+         for (PTIter bit = it; bit != pt.end() && block.size() < block_size; ++bit)
+            block.push_back(bit);
+         for (Uint i = 0; i < noncount_smoothers.size(); ++i)
+            noncount_smoothers[i]->probsForBlock(block, noncount_rev[i], noncount_fwd[i]);
+         for (Uint i = 0; i < adir_noncount_smoothers.size(); ++i)
+            adir_noncount_smoothers[i]->probsForBlock(block, adir_noncount_rev[i],
+                                                      adir_noncount_fwd[i]);
+      }
       vals_fwd.clear();
       vals_rev.clear();
       adir_vals.clear();
@@ -716,15 +748,15 @@ void doEverything(const char* prog_name)
       }
       for (Uint i = 0; i < noncount_smoothers.size(); ++i) {
          if (!write_best_lex || write_best.size() == 0 || i+1 == wbjf) {
-            vals_rev.push_back(noncount_smoothers[i]->probLang1GivenLang2(it));
-            vals_fwd.push_back(noncount_smoothers[i]->probLang2GivenLang1(it));
+            vals_rev.push_back(noncount_rev[i][b]);
+            vals_fwd.push_back(noncount_fwd[i][b]);
          }
       }
       for (Uint i = 0; i < adir_noncount_smoothers.size(); ++i) {
          if (!(write_best_lex && write_best_adir) || write_best.size() == 0 || i+1 == wbjf) {
-            adir_vals.push_back(adir_noncount_smoothers[i]->probLang1GivenLang2(it));
+            adir_vals.push_back(adir_noncount_rev[i][b]);
             if (!adir_noncount_smoothers[i]->isSymmetrical()) 
-               adir_vals.push_back(adir_noncount_smoothers[i]->probLang2GivenLang1(it));
+               adir_vals.push_back(adir_noncount_fwd[i][b]);
          }
       }
 
@@ -27,6 +27,7 @@
 #include "ngram_counts.h"
 #include "phrase_table.h"
 #include "word_classes.h"
+#include "indexed_ttable.h"
 
 namespace Portage {
 
@@ -85,6 +86,19 @@ public:
    virtual double probLang2GivenLang1(
       const typename PhraseTableGen<T>::iterator& it) = 0;
 
+   /**
+    * Compute probLang1GivenLang2() and probLang2GivenLang1() for a block of
+    * phrase pairs.  The default calls them on each pair in turn; smoothers
+    * that can score pairs independently of each other override this to use
+    * several threads.
+    * @param its          phrase pairs to score
+    * @param l1_given_l2  probLang1GivenLang2(its[i]) in l1_given_l2[i]
+    * @param l2_given_l1  probLang2GivenLang1(its[i]) in l2_given_l1[i]
+    */
+   virtual void probsForBlock(
+      const vector<typename PhraseTableGen<T>::iterator>& its,
+      vector<double>& l1_given_l2, vector<double>& l2_given_l1);
+
    /**
     * Return true if this smoother looks at joint counts from the phrasetable
     * (as opposed to just the phrases, like the IBM smoothers).
@@ -774,6 +788,42 @@ class LexicalSmoother : public PhraseSmoother<T>
    vector<string> l1_phrase;
    vector<string> l2_phrase;
 
+public:
+   /// Per-thread state for the integer-encoded probability functions
+   struct Workspace {
+      IndexedTTable::Cache cache_lang2_given_lang1;
+      IndexedTTable::Cache cache_lang1_given_lang2;
+      vector<double> probs;        ///< scratch space for subclasses
+   };
+
+private:
+   /// Integer-encoded state, created on first use if hasIndexedProbs()
+   struct Indexed {
+      IndexedTTable tt_lang2_given_lang1;
+      IndexedTTable tt_lang1_given_lang2;
+      Workspace ws;                ///< for the iterator-based functions
+      vector<Workspace> thread_ws; ///< for probsForBlock(), one per thread
+      vector<Uint> l1_ids;         ///< l1 phrase as pt word indexes
+      vector<Uint> l2_ids;         ///< l2 phrase as pt word indexes
+      Indexed(IBM1& ibm_lang2_given_lang1, IBM1& ibm_lang1_given_lang2) :
+         tt_lang2_given_lang1(ibm_lang2_given_lang1),
+         tt_lang1_given_lang2(ibm_lang1_given_lang2) {}
+   };
+   Indexed* indexed;
+
+   /// Table being smoothed; NULL in the stand-alone case
+   PhraseTableGen<T>* pt;
+
+   /// Create indexed if needed and possible; return true iff indexed exists.
+   bool useIndexed();
+
+   /**
+    * Get the current phrase pair of it as pt word indexes, extending the
+    * IndexedTTables as needed.  Requires useIndexed().  Not thread safe.
+    */
+   void getPhraseIds(const typename PhraseTableGen<T>::iterator& it,
+                     vector<Uint>& l1_ids, vector<Uint>& l2_ids);
+
 protected:
    IBM1* ibm_lang2_given_lang1;
    IBM1* ibm_lang1_given_lang2;
@@ -790,7 +840,30 @@ protected:
    /// Constructor for subclasses to use in the stand-alone case
    LexicalSmoother(IBM1* ibm_lang2_given_lang1, IBM1* ibm_lang1_given_lang2);
 
+   /**
+    * Return true if this class defines the integer-encoded prob*() virtuals
+    * below, which the iterator-based functions then use instead of the
+    * string-based ones.
+    */
+   virtual bool hasIndexedProbs() {return false;}
+
+   /**
+    * Optional integer-encoded versions of the string-based probability
+    * functions, for smoothers that only look up IBM1 ttable probabilities.
+    * Phrases are given as indexes in the phrase table's word vocabularies.
+    * These must be thread safe as long as each thread has its own ws.
+    */
+   virtual double probLang1GivenLang2(const vector<Uint>& l1_ids, const vector<Uint>& l2_ids,
+                                      const IndexedTTable& tt_lang1_given_lang2,
+                                      Workspace& ws) {return 0.0;}
+   virtual double probLang2GivenLang1(const vector<Uint>& l1_ids, const vector<Uint>& l2_ids,
+                                      const IndexedTTable& tt_lang2_given_lang1,
+                                      Workspace& ws) {return 0.0;}
+
 public:
+   /// Destructor.
+   virtual ~LexicalSmoother() { delete indexed; }
+
    /// get p(l1|l2) outside the factory/iterator framework
    virtual double probLang1GivenLang2(const vector<string>& l1_phrase, const vector<string>& l2_phrase) = 0;
    /// get p(l2|l1) outside the factory/iterator framework
@@ -799,6 +872,9 @@ public:
    // standard factory/iterator framework API
    virtual double probLang1GivenLang2(const typename PhraseTableGen<T>::iterator& it);
    virtual double probLang2GivenLang1(const typename PhraseTableGen<T>::iterator& it);
+   virtual void probsForBlock(
+      const vector<typename PhraseTableGen<T>::iterator>& its,
+      vector<double>& l1_given_l2, vector<double>& l2_given_l1);
    virtual bool usesCounts() {return false;}
    virtual bool isSymmetrical() {return false;}
 };
@@ -829,6 +905,15 @@ public:
 
    virtual double probLang1GivenLang2(const vector<string>& l1_phrase, const vector<string>& l2_phrase);
    virtual double probLang2GivenLang1(const vector<string>& l1_phrase, const vector<string>& l2_phrase);
+
+protected:
+   virtual bool hasIndexedProbs() {return true;}
+   virtual double probLang1GivenLang2(const vector<Uint>& l1_ids, const vector<Uint>& l2_ids,
+                                      const IndexedTTable& tt_lang1_given_lang2,
+                                      typename LexicalSmoother<T>::Workspace& ws);
+   virtual double probLang2GivenLang1(const vector<Uint>& l1_ids, const vector<Uint>& l2_ids,
+                                      const IndexedTTable& tt_lang2_given_lang1,
+                                      typename LexicalSmoother<T>::Workspace& ws);
 };
 
 
@@ -855,6 +940,15 @@ public:
 
    virtual double probLang1GivenLang2(const vector<string>& l1_phrase, const vector<string>& l2_phrase);
    virtual double probLang2GivenLang1(const vector<string>& l1_phrase, const vector<string>& l2_phrase);
+
+protected:
+   virtual bool hasIndexedProbs() {return true;}
+   virtual double probLang1GivenLang2(const vector<Uint>& l1_ids, const vector<Uint>& l2_ids,
+                                      const IndexedTTable& tt_lang1_given_lang2,
+                                      typename LexicalSmoother<T>::Workspace& ws);
+   virtual double probLang2GivenLang1(const vector<Uint>& l1_ids, const vector<Uint>& l2_ids,
+                                      const IndexedTTable& tt_lang2_given_lang1,
+                                      typename LexicalSmoother<T>::Workspace& ws);
 };
 
 //-----------------------------------------------------------------------------
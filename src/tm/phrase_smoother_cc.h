@@ -21,9 +21,28 @@
 #include <stdio.h>
 #include <sstream>
 #include "phrase_smoother.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace Portage {
 
+/**
+ * PhraseSmoother
+ */
+template<class T>
+void PhraseSmoother<T>::probsForBlock(
+   const vector<typename PhraseTableGen<T>::iterator>& its,
+   vector<double>& l1_given_l2, vector<double>& l2_given_l1)
+{
+   l1_given_l2.resize(its.size());
+   l2_given_l1.resize(its.size());
+   for (Uint i = 0; i < its.size(); ++i) {
+      l1_given_l2[i] = probLang1GivenLang2(its[i]);
+      l2_given_l1[i] = probLang2GivenLang1(its[i]);
+   }
+}
+
 /**
  * PhraseSmootherFactory
  */
@@ -1064,7 +1083,7 @@ double EventCounts<T>::probLang2GivenLang1(const typename PhraseTableGen<T>::ite
  */
 template<class T>
 LexicalSmoother<T>::LexicalSmoother(PhraseSmootherFactory<T>& factory, const string& args) :
-   PhraseSmoother<T>(0)
+   PhraseSmoother<T>(0), indexed(NULL), pt(factory.getPhraseTable())
 {
    Uint model_index = 0;
    if (args != "") {
@@ -1080,9 +1099,52 @@ LexicalSmoother<T>::LexicalSmoother(PhraseSmootherFactory<T>& factory, const str
      error(ETFatal, "Can't create Lexical (Zens-Ney, IBM1 or IBM) smoother without IBM models");
 }
 
+template<class T>
+LexicalSmoother<T>::LexicalSmoother(IBM1* ibm_lang2_given_lang1, IBM1* ibm_lang1_given_lang2) :
+   PhraseSmoother<T>(0), indexed(NULL), pt(NULL),
+   ibm_lang2_given_lang1(ibm_lang2_given_lang1),
+   ibm_lang1_given_lang2(ibm_lang1_given_lang2)
+{
+   if (!(ibm_lang2_given_lang1 && ibm_lang1_given_lang2))
+     error(ETFatal, "Can't create Lexical (Zens-Ney, IBM1 or IBM) smoother without IBM models");
+}
+
+template<class T>
+bool LexicalSmoother<T>::useIndexed()
+{
+   if (!indexed && pt && hasIndexedProbs())
+      indexed = new Indexed(*ibm_lang2_given_lang1, *ibm_lang1_given_lang2);
+   return indexed != NULL;
+}
+
+template<class T>
+void LexicalSmoother<T>::getPhraseIds(const typename PhraseTableGen<T>::iterator& it,
+                                      vector<Uint>& l1_ids, vector<Uint>& l2_ids)
+{
+   assert(indexed);
+   it.getPhrase(1, l1_ids);
+   it.getPhrase(2, l2_ids);
+
+   // The word vocabularies can grow while iterating over a table that is not
+   // kept in memory, so the ttable index maps are extended on demand.
+   const Voc& wvoc1 = pt->getWordVoc(1);
+   const Voc& wvoc2 = pt->getWordVoc(2);
+   if (indexed->tt_lang2_given_lang1.srcVocSize() < wvoc1.size() ||
+       indexed->tt_lang2_given_lang1.tgtVocSize() < wvoc2.size()) {
+      indexed->tt_lang2_given_lang1.update(wvoc1, wvoc2);
+      indexed->tt_lang1_given_lang2.update(wvoc2, wvoc1);
+   }
+}
+
 template<class T>
 double LexicalSmoother<T>::probLang1GivenLang2(const typename PhraseTableGen<T>::iterator& it)
 {
+   if (useIndexed()) {
+      getPhraseIds(it, indexed->l1_ids, indexed->l2_ids);
+      return probLang1GivenLang2(indexed->l1_ids, indexed->l2_ids,
+                                 indexed->tt_lang1_given_lang2, indexed->ws);
+   }
+
    it.getPhrase(1, l1_phrase);
    it.getPhrase(2, l2_phrase);
 
@@ -1092,12 +1154,60 @@ double LexicalSmoother<T>::probLang1GivenLang2(const typename PhraseTableGen<T>:
 template<class T>
 double LexicalSmoother<T>::probLang2GivenLang1(const typename PhraseTableGen<T>::iterator& it)
 {
+   if (useIndexed()) {
+      getPhraseIds(it, indexed->l1_ids, indexed->l2_ids);
+      return probLang2GivenLang1(indexed->l1_ids, indexed->l2_ids,
+                                 indexed->tt_lang2_given_lang1, indexed->ws);
+   }
+
    it.getPhrase(1, l1_phrase);
    it.getPhrase(2, l2_phrase);
 
    return probLang2GivenLang1(l1_phrase, l2_phrase);
 }
 
+template<class T>
+void LexicalSmoother<T>::probsForBlock(
+   const vector<typename PhraseTableGen<T>::iterator>& its,
+   vector<double>& l1_given_l2, vector<double>& l2_given_l1)
+{
+   if (!useIndexed()) {
+      PhraseSmoother<T>::probsForBlock(its, l1_given_l2, l2_given_l1);
+      return;
+   }
+
+   // Decoding the phrases touches the iterators and may extend the index
+   // maps, so it is done sequentially; the scoring proper is thread safe.
+   const Uint n = its.size();
+   vector< vector<Uint> > l1_ids(n), l2_ids(n);
+   for (Uint i = 0; i < n; ++i)
+      getPhraseIds(its[i], l1_ids[i], l2_ids[i]);
+
+   l1_given_l2.resize(n);
+   l2_given_l1.resize(n);
+   const IndexedTTable& tt_lang1_given_lang2 = indexed->tt_lang1_given_lang2;
+   const IndexedTTable& tt_lang2_given_lang1 = indexed->tt_lang2_given_lang1;
+   vector<Workspace>& thread_ws = indexed->thread_ws;
+#ifdef _OPENMP
+   // Workspaces persist across blocks so the caches stay warm.
+   if (thread_ws.size() < Uint(omp_get_max_threads()))
+      thread_ws.resize(omp_get_max_threads());
+#pragma omp parallel for schedule(static)
+#else
+   if (thread_ws.empty())
+      thread_ws.resize(1);
+#endif
+   for (int i = 0; i < int(n); ++i) {
+#ifdef _OPENMP
+      Workspace& ws = thread_ws[omp_get_thread_num()];
+#else
+      Workspace& ws = thread_ws[0];
+#endif
+      l1_given_l2[i] = probLang1GivenLang2(l1_ids[i], l2_ids[i], tt_lang1_given_lang2, ws);
+      l2_given_l1[i] = probLang2GivenLang1(l1_ids[i], l2_ids[i], tt_lang2_given_lang1, ws);
+   }
+}
+
 /*-----------------------------------------------------------------------------
  * Zens-Ney using IBM1 parameters.
  */
@@ -1149,6 +1259,48 @@ double ZNSmoother<T>::probLang2GivenLang1(const vector<string>& l1_phrase, const
    return pr_global == 0.0 ? PhraseSmoother<T>::VERY_SMALL_PROB : pr_global;
 }
 
+template<class T>
+double ZNSmoother<T>::probLang1GivenLang2(const vector<Uint>& l1_ids, const vector<Uint>& l2_ids,
+                                          const IndexedTTable& tt_lang1_given_lang2,
+                                          typename LexicalSmoother<T>::Workspace& ws)
+{
+   double pr_global = 1.0;
+   for (Uint j = 0; j < l1_ids.size(); ++j) {
+
+      // get p(l1_ids[j]|x) for all x in l2_ids
+      tt_lang1_given_lang2.pr(l2_ids, l1_ids[j], ws.cache_lang1_given_lang2, &ws.probs);
+
+      double pr_local = 1.0;
+      for (Uint i = 0; i < ws.probs.size(); ++i)
+         pr_local *= (1.0 - ws.probs[i]);
+
+      pr_global *= (1.0 - pr_local);
+   }
+
+   return pr_global == 0.0 ? PhraseSmoother<T>::VERY_SMALL_PROB : pr_global;
+}
+
+template<class T>
+double ZNSmoother<T>::probLang2GivenLang1(const vector<Uint>& l1_ids, const vector<Uint>& l2_ids,
+                                          const IndexedTTable& tt_lang2_given_lang1,
+                                          typename LexicalSmoother<T>::Workspace& ws)
+{
+   double pr_global = 1.0;
+   for (Uint j = 0; j < l2_ids.size(); ++j) {
+
+      // get p(l2_ids[j]|x) for all x in l1_ids
+      tt_lang2_given_lang1.pr(l1_ids, l2_ids[j], ws.cache_lang2_given_lang1, &ws.probs);
+
+      double pr_local = 1.0;
+      for (Uint i = 0; i < ws.probs.size(); ++i)
+         pr_local *= (1.0 - ws.probs[i]);
+
+      pr_global *= (1.0 - pr_local);
+   }
+
+   return pr_global == 0.0 ? PhraseSmoother<T>::VERY_SMALL_PROB : pr_global;
+}
+
 /*-----------------------------------------------------------------------------
  * IBM1Smoother.
  */
@@ -1174,6 +1326,22 @@ double IBM1Smoother<T>::probLang2GivenLang1(const vector<string>& l1_phrase, con
    return exp(this->ibm_lang2_given_lang1->IBM1::logpr(l1_phrase, l2_phrase, 1e-07));
 }
 
+template<class T>
+double IBM1Smoother<T>::probLang1GivenLang2(const vector<Uint>& l1_ids, const vector<Uint>& l2_ids,
+                                            const IndexedTTable& tt_lang1_given_lang2,
+                                            typename LexicalSmoother<T>::Workspace& ws)
+{
+   return exp(tt_lang1_given_lang2.logpr(l2_ids, l1_ids, 1e-07, ws.cache_lang1_given_lang2));
+}
+
+template<class T>
+double IBM1Smoother<T>::probLang2GivenLang1(const vector<Uint>& l1_ids, const vector<Uint>& l2_ids,
+                                            const IndexedTTable& tt_lang2_given_lang1,
+                                            typename LexicalSmoother<T>::Workspace& ws)
+{
+   return exp(tt_lang2_given_lang1.logpr(l1_ids, l2_ids, 1e-07, ws.cache_lang2_given_lang1));
+}
+
 /*-----------------------------------------------------------------------------
  * IBMSmoother.
  */
@@ -18,6 +18,12 @@
 #define PHRASE_TABLE_CC_H
 
 #include "word_align_io.h"
+#include "binio.h"
+#include <queue>
+#include <fstream>
+#include <limits>
+#include <cstdlib>
+#include <unistd.h>
 
 namespace Portage {
 
@@ -33,6 +39,224 @@ void PhraseTableGen<T>::clear()
       delete phrase_table[i];
    phrase_table.clear();
    lang2_voc.clear();
+   for ( Uint i = 0; i < phrase_alignment_table.size(); ++i )
+      delete phrase_alignment_table[i];
+   phrase_alignment_table.clear();
+   num_lang1_phrases = 0;
+   mem_estimate = 0;
+}
+
+/*---------------------------------------------------------------------------------------------
+  External-memory construction
+  -------------------------------------------------------------------------------------------*/
+
+/// Orders indexes in a Voc of compressed phrases by their compressed strings.
+struct CompressedPhraseLess {
+   const Voc& voc;
+   explicit CompressedPhraseLess(const Voc& voc) : voc(voc) {}
+   bool operator()(Uint a, Uint b) const { return strcmp(voc.word(a), voc.word(b)) < 0; }
+};
+
+template<class T>
+void PhraseTableGen<T>::spillToDisk(Uint64 max_mem, const string& tmp_dir)
+{
+   if (max_mem && (!keep_phrase_table_in_memory || locked))
+      error(ETFatal, "Cannot spill a phrase table to disk when it is not kept in memory or is locked.");
+   spill_budget = max_mem;
+   spill_dir = tmp_dir;
+   if (spill_dir.empty()) {
+      const char* const tmpdir = getenv("TMPDIR");
+      spill_dir = tmpdir ? tmpdir : "/tmp";
+   }
+}
+
+template<class T>
+string PhraseTableGen<T>::makeSpillFile(const char* prefix) const
+{
+   const string name = spill_dir + "/" + prefix + ".XXXXXX";
+   char tmp[name.size()+1];
+   strcpy(tmp, name.c_str());
+   const int fd = mkstemp(tmp);
+   if (fd < 0 || close(fd))
+      error(ETFatal, "Unable to create a temp file using mkstemp(%s)", tmp);
+   return tmp;
+}
+
+template<class T>
+void PhraseTableGen<T>::tallyMemory(bool new_phrase1, Uint len1, bool new_phrase2, Uint len2,
+                                    bool new_pair, Uint new_alignments, bool new_alignment_freqs)
+{
+   // Rough accounting, with allowance for container overhead and growth slack.
+   if (new_phrase1) mem_estimate += len1 + 96;
+   if (new_phrase2) mem_estimate += len2 + 64;
+   if (new_pair) mem_estimate += 2 * (sizeof(Uint) + sizeof(T));
+   mem_estimate += new_alignments * 2 * (sizeof(Uint) + sizeof(T));
+   if (new_alignment_freqs) mem_estimate += sizeof(AlignmentFreqs<T>) + 16;
+}
+
+template<class T>
+void PhraseTableGen<T>::spill()
+{
+   const string filename = makeSpillFile("jpt-run");
+   spill_runs.push_back(filename);
+
+   ofstream os(filename.c_str(), ios::binary);
+   vector<Uint> ids1(lang1_voc.size());
+   for (Uint i = 0; i < ids1.size(); ++i) ids1[i] = i;
+   sort(ids1.begin(), ids1.end(), CompressedPhraseLess(lang1_voc));
+
+   vector<Uint> ids2;
+   static const AlignmentFreqs<T> no_alignments;
+   for (Uint i = 0; i < ids1.size(); ++i) {
+      const Uint id1 = ids1[i];
+      const PhraseFreqs& pf = *phrase_table[id1];
+      ids2.clear();
+      for (typename PhraseFreqs::const_iterator it(pf.begin()); it != pf.end(); ++it)
+         ids2.push_back(it->first);
+      sort(ids2.begin(), ids2.end(), CompressedPhraseLess(lang2_voc));
+
+      BinIO::writebin(os, string(lang1_voc.word(id1)));
+      BinIO::writebin(os, Uint(ids2.size()));
+      PhraseAlignments* const pa =
+         id1 < phrase_alignment_table.size() ? phrase_alignment_table[id1] : NULL;
+      for (Uint j = 0; j < ids2.size(); ++j) {
+         BinIO::writebin(os, string(lang2_voc.word(ids2[j])));
+         BinIO::writebin(os, pf.find(ids2[j])->second);
+         const AlignmentFreqs<T>* af = &no_alignments;
+         if (pa) {
+            typename PhraseAlignments::iterator p = pa->find(ids2[j]);
+            if (p != pa->end()) af = &p->second;
+         }
+         BinIO::writebin(os, static_cast<const vector< pair<Uint,T> >&>(*af));
+      }
+   }
+   os.flush();
+   if (!os)
+      error(ETFatal, "Error writing sorted run %s", filename.c_str());
+   os.close();
+
+   clear();
+}
+
+/// Sequential reader for the sorted runs written by PhraseTableGen<T>::spill().
+template<class T>
+struct SpilledRunReader {
+   ifstream in;
+   Uint run;                              // chronological index of this run
+   Uint left;                             // lang2 phrases left for phrase1
+   string phrase1;                        // current pair, compressed
+   string phrase2;
+   T val;
+   vector< pair<Uint,T> > alignments;
+
+   SpilledRunReader(const string& filename, Uint run)
+      : in(filename.c_str(), ios::binary), run(run), left(0)
+   {
+      if (!in)
+         error(ETFatal, "Unable to open sorted run %s", filename.c_str());
+   }
+
+   /// Read the next phrase pair; return false at the end of the run.
+   bool next() {
+      if (left == 0) {
+         if (in.peek() == EOF) return false;
+         BinIO::readbin(in, phrase1);
+         BinIO::readbin(in, left);
+      }
+      BinIO::readbin(in, phrase2);
+      BinIO::readbin(in, val);
+      BinIO::readbin(in, alignments);
+      if (!in)
+         error(ETFatal, "Corrupt sorted run");
+      --left;
+      return true;
+   }
+
+   /// Order for a min-heap on (phrase1, phrase2, run)
+   struct Greater {
+      bool operator()(const SpilledRunReader* a, const SpilledRunReader* b) const {
+         int c = strcmp(a->phrase1.c_str(), b->phrase1.c_str());
+         if (c == 0) c = strcmp(a->phrase2.c_str(), b->phrase2.c_str());
+         return c == 0 ? a->run > b->run : c > 0;
+      }
+   };
+};
+
+template<class T>
+void PhraseTableGen<T>::mergeSpilledRuns(ostream& ostr, T thresh, bool filt,
+                                         Uint display_alignments, bool no_zeros)
+{
+   typedef SpilledRunReader<T> Reader;
+   vector<Reader*> readers;
+   priority_queue<Reader*, vector<Reader*>, typename Reader::Greater> heap;
+   for (Uint i = 0; i < spill_runs.size(); ++i) {
+      readers.push_back(new Reader(spill_runs[i], i));
+      if (readers.back()->next())
+         heap.push(readers.back());
+   }
+
+   // Equal pairs come out of the heap in chronological order, so merged
+   // alignments keep the order in which they were first seen, as in memory.
+   string coded1, coded2, p1, p2, alignments_s;
+   AlignmentFreqs<T> alignments;
+   while (!heap.empty()) {
+      Reader* r = heap.top();
+      coded1 = r->phrase1;
+      coded2 = r->phrase2;
+      T val = T();
+      alignments.clear();
+      while (!heap.empty() && (r = heap.top(), r->phrase2 == coded2 && r->phrase1 == coded1)) {
+         heap.pop();
+         val += r->val;
+         for (Uint i = 0; i < r->alignments.size(); ++i)
+            alignments[r->alignments[i].first] += r->alignments[i].second;
+         if (r->next())
+            heap.push(r);
+      }
+
+      if ((!filt || val >= thresh) && (!no_zeros || val != T(0))) {
+         p1 = recodePhrase(coded1.c_str(), wvoc1);
+         p2 = recodePhrase(coded2.c_str(), wvoc2);
+         const char* alignments_cstr(NULL);
+         if (display_alignments) {
+            displayAlignments(alignments_s, alignments, alignment_voc,
+                              phraseLength(coded1.c_str()), phraseLength(coded2.c_str()),
+                              false, display_alignments == 1);
+            alignments_cstr = alignments_s.c_str();
+         }
+         writePhrasePair(ostr, p1.c_str(), p2.c_str(), alignments_cstr, val);
+      }
+   }
+
+   for (Uint i = 0; i < readers.size(); ++i)
+      delete readers[i];
+   removeSpilledRuns();
+}
+
+template<class T>
+string PhraseTableGen<T>::mergeToJointFile()
+{
+   if (spill_dir.empty())
+      spillToDisk(0);
+   const string filename = makeSpillFile("jpt-merged");
+   {
+      ofstream os(filename.c_str());
+      os.precision(numeric_limits<T>::digits10 + 3); // exact round trip
+      if (spill_runs.empty())
+         spill();
+      dump_joint_freqs(os, 0, false, false, 2, false);
+      if (!os)
+         error(ETFatal, "Error writing merged jpt %s", filename.c_str());
+   }
+   return filename;
+}
+
+template<class T>
+void PhraseTableGen<T>::removeSpilledRuns()
+{
+   for (Uint i = 0; i < spill_runs.size(); ++i)
+      unlink(spill_runs[i].c_str());
+   spill_runs.clear();
 }
 
 template<class T>
@@ -166,6 +390,12 @@ pair<Uint,Uint> PhraseTableGen<T>::addPhrasePair(ToksIterT beg1, ToksIterT end1,
       }
       return make_pair(id1,id2);
    } else {
+      // Spill before adding, so the indexes returned stay valid until the
+      // next call.
+      if (spill_budget && mem_estimate > spill_budget)
+         spill();
+      const Uint num1 = lang1_voc.size();
+      const Uint num2 = lang2_voc.size();
       const Uint id1 = lang1_voc.add(phrase1.c_str());
       num_lang1_phrases = lang1_voc.size();
       const Uint id2 = lang2_voc.add(phrase2.c_str(), val);
@@ -176,11 +406,20 @@ pair<Uint,Uint> PhraseTableGen<T>::addPhrasePair(ToksIterT beg1, ToksIterT end1,
                while ( phrase_alignment_table.size() <= id1 )
                   phrase_alignment_table.push_back(new PhraseAlignments());
          }
+         const Uint num_pairs = phrase_table[id1]->size();
          (*phrase_table[id1])[id2] += val;
+         Uint num_alignments = 0, new_alignments = 0;
          if (green_alignment) {
             const Uint alignment_id = alignment_voc.add(green_alignment);
-            (*phrase_alignment_table[id1])[id2][alignment_id] += val;
+            AlignmentFreqs<T>& alignments = (*phrase_alignment_table[id1])[id2];
+            num_alignments = alignments.size();
+            alignments[alignment_id] += val;
+            new_alignments = alignments.size() - num_alignments;
          }
+         if (spill_budget)
+            tallyMemory(id1 == num1, phrase1.size(), id2 == num2, phrase2.size(),
+                        phrase_table[id1]->size() != num_pairs,
+                        new_alignments, new_alignments && num_alignments == 0);
       }
       return make_pair(id1,id2);
    }
@@ -239,31 +478,50 @@ void PhraseTableGen<T>::lookupPhrasePair(const string &line, Uint& id1, Uint& id
    } else
       alignments.clear();
 
+   tallyPhrasePair(phrase1, phrase2, val, alignments, id1, id2);
+}
+
+template<class T>
+void PhraseTableGen<T>::tallyPhrasePair(const string& phrase1, const string& phrase2,
+                                        T val, const string& alignments,
+                                        Uint& id1, Uint& id2)
+{
    if (phrase_table_read) {
       id1 = lang1_voc.index(phrase1.c_str());
       id2 = lang2_voc.index(phrase2.c_str());
    } else {
       // add to the phrase table if not already fully read in.
+      const Uint num1 = lang1_voc.size();
+      const Uint num2 = lang2_voc.size();
       id1 = lang1_voc.add(phrase1.c_str());
       num_lang1_phrases = lang1_voc.size();
       id2 = lang2_voc.add(phrase2.c_str(), val);
       if (keep_phrase_table_in_memory) {
          if (id1 == phrase_table.size())
             phrase_table.push_back(new PhraseFreqs());
+         const Uint num_pairs = phrase_table[id1]->size();
          (*phrase_table[id1])[id2] += val;
 
          // parse and add the alignments too, if present.
+         Uint num_alignments = 0, new_alignments = 0;
          if ( !alignments.empty() ) {
             while ( phrase_alignment_table.size() <= id1 )
                phrase_alignment_table.push_back(new PhraseAlignments());
-            if (!zero_counts_on_read)
-               parseAndTallyAlignments((*phrase_alignment_table[id1])[id2],
-                                       alignment_voc, alignments);
+            if (!zero_counts_on_read) {
+               AlignmentFreqs<T>& alignment_freqs = (*phrase_alignment_table[id1])[id2];
+               num_alignments = alignment_freqs.size();
+               parseAndTallyAlignments(alignment_freqs, alignment_voc, alignments);
+               new_alignments = alignment_freqs.size() - num_alignments;
+            }
             /*
             parseAndTallyAlignments(phrase_alignment_table.find(id1).find(id2),
                                     alignment_voc, alignments);
             */
          }
+         if (spill_budget)
+            tallyMemory(id1 == num1, phrase1.size(), id2 == num2, phrase2.size(),
+                        phrase_table[id1]->size() != num_pairs,
+                        new_alignments, new_alignments && num_alignments == 0);
       }
    }
 }
@@ -545,6 +803,15 @@ void PhraseTableGen<T>::dump_joint_freqs(ostream& ostr,
 {
    remap_psep();
 
+   if (!spill_runs.empty()) {
+      if (reverse)
+         error(ETFatal, "Cannot dump a phrase table spilled to disk in reverse order.");
+      if (lang1_voc.size() > 0)
+         spill();
+      mergeSpilledRuns(ostr, thresh, filt, display_alignments, no_zeros);
+      return;
+   }
+
    string p1, p2, alignments_s;
    const char* alignments_cstr(NULL);
    for (iterator it = begin(); it != end(); ++it) {
@@ -565,12 +832,9 @@ void PhraseTableGen<T>::dump_joint_freqs(ostream& ostr,
 }
 
 template<class T>
-void PhraseTableGen<T>::readJointTable(istream& in, bool reduce_memory, bool swap_on_read,
-                                       Uint limit_len_on_read, bool zero_counts_on_read)
+bool PhraseTableGen<T>::startReading(bool reduce_memory, bool swap_on_read,
+                                     Uint limit_len_on_read, bool zero_counts_on_read)
 {
-   string line, alignments;
-   Uint id1, id2;
-   T val;
    this->swap_on_read = swap_on_read;
    this->limit_len_on_read = limit_len_on_read;
    this->zero_counts_on_read = zero_counts_on_read;
@@ -578,19 +842,33 @@ void PhraseTableGen<T>::readJointTable(istream& in, bool reduce_memory, bool swa
    if (phrase_table_read && !keep_phrase_table_in_memory)
       error(ETFatal, "Cannot read multiple phrase table files "
             "if not keeping phrase tables in memory.");
-   else if (!phrase_table_read) {
+   else if (!phrase_table_read)
       keep_phrase_table_in_memory = ! reduce_memory;
-      jpt_stream = &in; // used for unit testing only
-   }
 
    // In "reduce memory" mode (for joint2cond_phrase_tables), we don't
    // actually read the phrase table at this point, we just store the file name
    // (in the other readJointTable() method) and the stream.
-   if (!keep_phrase_table_in_memory) return;
+   return keep_phrase_table_in_memory;
+}
+
+template<class T>
+void PhraseTableGen<T>::readJointTable(istream& in, bool reduce_memory, bool swap_on_read,
+                                       Uint limit_len_on_read, bool zero_counts_on_read)
+{
+   string line, alignments;
+   Uint id1, id2;
+   T val;
+
+   if (!phrase_table_read)
+      jpt_stream = &in; // used for unit testing only
+   if (!startReading(reduce_memory, swap_on_read, limit_len_on_read, zero_counts_on_read))
+      return;
 
    phrase_table_read = false;   // reading more.
    Uint counter(0);
    while (getline(in, line)) {
+      if (spill_budget && mem_estimate > spill_budget)
+         spill();
       lookupPhrasePair(line, id1, id2, val, alignments);
       if ( ++counter % 1000000 == 0 ) cerr << ".";
    }
@@ -598,11 +876,76 @@ void PhraseTableGen<T>::readJointTable(istream& in, bool reduce_memory, bool swa
    phrase_table_read = true;
 }
 
+/// Map reader vocabulary indexes to wvoc indexes, then compress the phrase.
+static inline void compressBinaryJPTPhrase(const vector<Uint>& toks, const Voc& reader_voc,
+                                           vector<Uint>& wvoc_index, Voc& wvoc,
+                                           vector<Uint>& buf, string& coded)
+{
+   buf.resize(toks.size());
+   for (Uint i = 0; i < toks.size(); ++i) {
+      if (toks[i] >= wvoc_index.size())
+         wvoc_index.resize(reader_voc.size(), Uint(-1));
+      Uint& w = wvoc_index[toks[i]];
+      if (w == Uint(-1)) w = wvoc.add(reader_voc.word(toks[i]));
+      buf[i] = w;
+   }
+   PhraseTableBase::compressPhrase(buf.begin(), buf.end(), coded, wvoc);
+}
+
+template<class T>
+void PhraseTableGen<T>::readJointTable(BinaryJPTReader& reader, bool reduce_memory, bool swap_on_read,
+                                       Uint limit_len_on_read, bool zero_counts_on_read)
+{
+   if (!startReading(reduce_memory, swap_on_read, limit_len_on_read, zero_counts_on_read))
+      return;
+
+   phrase_table_read = false;   // reading more.
+   const Voc& reader_voc = reader.getVoc();
+   vector<Uint> wvoc1_index, wvoc2_index, buf;
+   string phrase1, phrase2, alignments;
+   Uint id1, id2;
+   while (reader.next()) {
+      if (spill_budget && mem_estimate > spill_budget)
+         spill();
+      const BinaryJPTEntry& e = reader.entry();
+      // Same length test as lookupPhrasePair() makes on text lines.
+      if (limit_len_on_read && (e.phrase1.size() > limit_len_on_read ||
+                                e.phrase1.size() + 1 + e.phrase2.size() > limit_len_on_read))
+         continue;
+      if (e.values.empty())
+         error(ETFatal, "Missing count in binary JPT %s, entry %llu", jpt_file.c_str(),
+               (unsigned long long)reader.numEntries());
+      const vector<Uint>& toks1 = swap_on_read ? e.phrase2 : e.phrase1;
+      const vector<Uint>& toks2 = swap_on_read ? e.phrase1 : e.phrase2;
+      compressBinaryJPTPhrase(toks1, reader_voc, wvoc1_index, wvoc1, buf, phrase1);
+      compressBinaryJPTPhrase(toks2, reader_voc, wvoc2_index, wvoc2, buf, phrase2);
+      const T val = zero_counts_on_read ? T(0) : T(e.values[0]);
+      alignments.clear();
+      for (Uint i = 0; i < e.extras.size(); ++i) {
+         const char* extra = reader_voc.word(e.extras[i]);
+         if (extra[0] == 'a' && extra[1] == '=') {
+            if (swap_on_read)
+               error(ETFatal, "swap-on-read not compatible with alignment info in jpt");
+            alignments = extra+2;
+         }
+      }
+      tallyPhrasePair(phrase1, phrase2, val, alignments, id1, id2);
+      if ( reader.numEntries() % 1000000 == 0 ) cerr << ".";
+   }
+   cerr << endl;
+   phrase_table_read = true;
+}
+
 template<class T>
 void PhraseTableGen<T>::readJointTable(const string& infile, bool reduce_memory, bool swap_on_read,
                                        Uint limit_len_on_read, bool zero_counts_on_read)
 {
    jpt_file = infile;
+   if (isBinaryJPT(infile)) {
+      BinaryJPTReader reader(infile);
+      readJointTable(reader, reduce_memory, swap_on_read, limit_len_on_read, zero_counts_on_read);
+      return;
+   }
    iSafeMagicStream in(infile);
    readJointTable(in, reduce_memory, swap_on_read, limit_len_on_read, zero_counts_on_read);
 
@@ -1057,7 +1400,7 @@ PhraseTableGen<T>::iterator::MemoryIteratorStrategy::getAlignmentString(string&
 {
    const AlignmentFreqs<T>& alignments(getAlignments());
    displayAlignments(al, alignments, pt->alignment_voc,
-                     getPhraseLength(1), getPhraseLength(2), reverse, top_only);
+                     this->getPhraseLength(1), this->getPhraseLength(2), reverse, top_only);
 }
 
 template<class T>
@@ -1083,7 +1426,7 @@ PhraseTableGen<T>::iterator::FileIteratorStrategy::FileIteratorStrategy(PhraseTa
    if (end) return;
    jpt_stream.reset();
    if (pt->jpt_file.length() > 0) {
-      auto_ptr<iSafeMagicStream> new_stream(new iSafeMagicStream(pt->jpt_file));
+      auto_ptr<istream> new_stream(openJPTAsText(pt->jpt_file));
       jpt_stream = new_stream;
    } else if (pt->jpt_stream) {
       // This path is used only for unit testing
@@ -1135,7 +1478,7 @@ PhraseTableGen<T>::iterator::FileIteratorStrategy::getAlignmentString(string& al
       AlignmentFreqs<T> alignment_freqs;
       parseAndTallyAlignments(alignment_freqs, pt->alignment_voc, alignments);
       displayAlignments(al, alignment_freqs, pt->alignment_voc,
-                        getPhraseLength(1), getPhraseLength(2), reverse, top_only);
+                        this->getPhraseLength(1), this->getPhraseLength(2), reverse, top_only);
    } else {
       // In the default case, we don't actually have to parse the alignment
       // string, we just copy it through.
@@ -1209,7 +1552,7 @@ void PhraseTableGen<T>::iterator::File2IteratorStrategy::getPhrase(Uint lang, ve
    if (lang == 1)
       pt->getPhrase(lang, phrase1.c_str(), toks);
    else
-      pt->getPhrase(lang, getPhraseIndex(lang), toks);
+      pt->getPhrase(lang, this->getPhraseIndex(lang), toks);
 }
 
 template<class T>
@@ -1218,7 +1561,7 @@ void PhraseTableGen<T>::iterator::File2IteratorStrategy::getPhrase(Uint lang, ve
    if (lang == 1)
       pt->getPhrase(lang, phrase1.c_str(), toks);
    else
-      pt->getPhrase(lang, getPhraseIndex(lang), toks);
+      pt->getPhrase(lang, this->getPhraseIndex(lang), toks);
 }
 
 template<class T>
@@ -1227,7 +1570,7 @@ string& PhraseTableGen<T>::iterator::File2IteratorStrategy::getPhrase(Uint lang,
    if (lang == 1)
       pt->getPhrase(lang, phrase1.c_str(), phrase);
    else
-      pt->getPhrase(lang, getPhraseIndex(lang), phrase);
+      pt->getPhrase(lang, this->getPhraseIndex(lang), phrase);
    return phrase;
 }
 
@@ -1237,7 +1580,7 @@ Uint PhraseTableGen<T>::iterator::File2IteratorStrategy::getPhraseLength(Uint la
    if (lang == 1)
       return pt->getPhraseLength(lang, phrase1.c_str());
    else
-      return pt->getPhraseLength(lang, getPhraseIndex(lang));
+      return pt->getPhraseLength(lang, this->getPhraseIndex(lang));
 }
 
 /*---------------------------------------------------------------------------------------------
@@ -1383,7 +1726,7 @@ PhraseTableGen<T>::iterator::Pruning2IteratorStrategy::operator++()
             break;
          }
       }
-      pt->prunePhraseFreqs(phrase_freqs, getPhraseLength(1));
+      pt->prunePhraseFreqs(phrase_freqs, this->getPhraseLength(1));
       pf_index = 0;
    }
 
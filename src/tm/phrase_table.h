@@ -31,6 +31,7 @@
 #include <cmath>
 #include "voc.h"
 #include "file_utils.h"
+#include "binary_jpt.h"
 #include "vector_map.h"
 #include "ordered_vector_map.h"
 #include "portage_defs.h"
@@ -186,6 +187,12 @@ template<class T> class PhraseTableGen : public PhraseTableBase, private NonCopy
    Uint prune1_fixed;           // fixed part of pruning factor;
    Uint prune1_per_word;        // variable part of pruning factor; 
 
+   // External-memory construction, see spillToDisk()
+   Uint64 spill_budget;         // approx. max bytes of phrase pairs in memory; 0 = no spilling
+   string spill_dir;            // directory for the sorted runs
+   vector<string> spill_runs;   // sorted runs written so far, in chronological order
+   Uint64 mem_estimate;         // approx. bytes used by the phrase pairs in memory
+
    string jpt_file;             // file name of jpt file
    istream* jpt_stream;         // stream used for reading a jpt file - for unit testing only
    bool phrase_table_read;      // set upon completion of first jpt file reading
@@ -432,9 +439,11 @@ public:
    PhraseTableGen() : num_lang1_phrases(0), keep_phrase_table_in_memory(true),
                       zero_counts_on_read(false), locked(false),
                       prune1_fixed(0), prune1_per_word(0),
+                      spill_budget(0), mem_estimate(0),
                       jpt_stream(NULL), phrase_table_read(false) {}
 
    ~PhraseTableGen() {
+      removeSpilledRuns();
       for ( typename PhraseAlignmentTable::iterator
                   it(phrase_alignment_table.begin()),
                   end(phrase_alignment_table.end());
@@ -453,6 +462,15 @@ public:
    void readJointTable(const string& infile, bool reduce_memory=false,
                        bool swap_on_read=false, Uint limit_len_on_read=0,
                        bool zero_counts_on_read=false);
+   /**
+    * Same as readJointTable(istream&...), but reading a binary jpt directly,
+    * without tokenizing.  readJointTable(const string&...) calls this when
+    * given a binary jpt (see binary_jpt.h); in reduced memory mode, the
+    * iterators then read the file as text via openJPTAsText().
+    */
+   void readJointTable(BinaryJPTReader& reader, bool reduce_memory=false,
+                       bool swap_on_read=false, Uint limit_len_on_read=0,
+                       bool zero_counts_on_read=false);
 
    /**
     * Remap psep so it doesn't get output as a token in the resulting phrase table.
@@ -471,6 +489,9 @@ public:
     *                           the most frequent alignment (ties are broken
     *                           arbitrarily); if 2, display all alignments with counts.
     * @param no_zeros if true, don't write phrase pairs for which T(freq) == 0.
+    *
+    * If the table was spilled to disk (see spillToDisk()), this merges the
+    * sorted runs and empties the table; reverse is then not supported.
     */
    void dump_joint_freqs(ostream& ostr, T thresh = 0, bool reverse = false,
                          bool filt = true, Uint display_alignments = 0, 
@@ -513,6 +534,64 @@ public:
     */
    void clear();
 
+   /**
+    * Build the table in external memory: whenever the phrase pairs added with
+    * addPhrasePair() or readJointTable() use more than about max_mem bytes,
+    * write them to a
+    * sorted run on disk and clear the in-memory table.  dump_joint_freqs()
+    * then merges all runs, summing the counts and alignments of pairs seen in
+    * several runs, so its output is the same as without spilling, except
+    * that lines are grouped by lang1 phrase in an arbitrary but fixed order.
+    *
+    * Only construction and dump_joint_freqs() are supported once a run has
+    * been written: iterating, pruning, querying, locking and the other dump
+    * functions need the whole table in memory.  Call before adding pairs.
+    *
+    * Runs hold phrases in compressed form and alignments as indexes, so
+    * they are much smaller than the equivalent jpt.  Each run is a sequence
+    * of lang1 phrases in increasing compressed order, each written as
+    * (phrase1, n, n x (phrase2, freq, alignments)), with phrase2 also in
+    * increasing compressed order and alignments as (alignment_voc index,
+    * freq) pairs, all in BinIO format.
+    *
+    * @param max_mem  approximate memory budget, in bytes; 0 disables spilling
+    * @param tmp_dir  directory for the runs; "" means $TMPDIR, or else /tmp
+    */
+   void spillToDisk(Uint64 max_mem, const string& tmp_dir = "");
+
+   /// Number of sorted runs written to disk so far.
+   Uint numSpilledRuns() const { return spill_runs.size(); }
+
+   /**
+    * Merge the sorted runs and the rest of the table into a new jpt file in
+    * the spill directory, with all alignments and their counts, and empty
+    * the table.  All pairs for a given lang1 phrase are consecutive in the
+    * file, so it can be read back with readJointTable(file, true) into a new
+    * table for pruning and smoothing in reduced memory mode.
+    * @return the name of the jpt file, which the caller must delete
+    */
+   string mergeToJointFile();
+
+private:
+   /// Write the in-memory contents to a new sorted run, then clear them.
+   void spill();
+
+   /// Create a new empty file in spill_dir and return its name.
+   string makeSpillFile(const char* prefix) const;
+
+   /// Update mem_estimate after adding a phrase pair to the in-memory table.
+   void tallyMemory(bool new_phrase1, Uint len1, bool new_phrase2, Uint len2,
+                    bool new_pair, Uint new_alignments, bool new_alignment_freqs);
+
+   /// Merge all sorted runs into ostr in jpt format, then delete them.
+   void mergeSpilledRuns(ostream& ostr, T thresh, bool filt,
+                         Uint display_alignments, bool no_zeros);
+
+   /// Delete the sorted run files, if any.
+   void removeSpilledRuns();
+
+public:
+
    /**
     * Lock
     */
@@ -595,6 +674,22 @@ private:
     */
    void lookupPhrasePair(const string &line, string& phrase1, Uint& id2, T& val, string& alignments);
 
+   /**
+    * Tally a phrase pair read from a jpt, in compressed form, or look it up
+    * if the table has been fully read: the second half of the first
+    * lookupPhrasePair() method.
+    */
+   void tallyPhrasePair(const string& phrase1, const string& phrase2, T val,
+                        const string& alignments, Uint& id1, Uint& id2);
+
+   /**
+    * Record the reading options and check that reading is possible.
+    * @return true iff the entries must be read now, i.e., the table is kept
+    *         in memory
+    */
+   bool startReading(bool reduce_memory, bool swap_on_read,
+                     Uint limit_len_on_read, bool zero_counts_on_read);
+
 public:
    /**
     * If given phrase pair exists in the table, return true and set val to
@@ -674,6 +769,12 @@ public:
    void  getPhrase(Uint lang, Uint id, vector<string>& toks);
    void  getPhrase(Uint lang, Uint id, vector<Uint>& toks); // toks are wvoc indexes
 
+   /**
+    * Word vocabulary for a given language: maps the indexes returned by
+    * getPhrase(lang, id, vector<Uint>&) to words.
+    */
+   const Voc& getWordVoc(Uint lang) const { return lang == 1 ? wvoc1 : wvoc2; }
+
 private:
 
    string& getPhrase(Uint lang, const char* coded, string &phrase);
@@ -0,0 +1,156 @@
+/**
+ * @file test_incr_phrase_counts.h  Tests for IncrPhraseCounts.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include <sstream>
+#include "incr_phrase_counts.h"
+#include "phrase_table.h"
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestIncrPhraseCounts : public CxxTest::TestSuite
+{
+public:
+   void testAddAndLookup() {
+      IncrPhraseCounts counts;
+      TS_ASSERT(counts.empty());
+      counts.add("la maison", "the house", 2, "0_1");
+      counts.add("la maison", "house", 1, "1");
+      counts.add("maison", "house", 3);
+
+      TS_ASSERT_EQUALS(counts.size(), 3u);
+      vector<IncrPhraseCounts::Translation> trans;
+      TS_ASSERT_EQUALS(counts.lookup("la maison", trans), 3u);
+      TS_ASSERT_EQUALS(trans.size(), 2u);
+      for (Uint i = 0; i < trans.size(); ++i) {
+         if (*trans[i].phrase2 == "the house") {
+            TS_ASSERT_EQUALS(trans[i].joint, 2u);
+            TS_ASSERT_EQUALS(trans[i].marginal2, 2u);
+            TS_ASSERT_EQUALS(trans[i].info->topAlignment(), "0_1");
+         } else {
+            TS_ASSERT_EQUALS(*trans[i].phrase2, "house");
+            TS_ASSERT_EQUALS(trans[i].joint, 1u);
+            TS_ASSERT_EQUALS(trans[i].marginal2, 4u);
+         }
+      }
+      TS_ASSERT_EQUALS(counts.lookup("chat", trans), 0u);
+      TS_ASSERT(trans.empty());
+   }
+
+   void testIncrementalUpdate() {
+      IncrPhraseCounts counts;
+      counts.add("a", "x", 1, "0");
+      counts.add("a", "x", 2, "0");
+      counts.add("a", "y", 1);
+      vector<IncrPhraseCounts::Translation> trans;
+      TS_ASSERT_EQUALS(counts.lookup("a", trans), 4u);
+      TS_ASSERT_EQUALS(counts.size(), 2u);
+   }
+
+   void testReadWriteRoundTrip() {
+      istringstream in(
+         "b ||| y ||| 2 a=0:2\n"
+         "a ||| x ||| 3 a=0:2;0_0:1\n"
+         "a ||| x y ||| 1\n");
+      IncrPhraseCounts counts;
+      counts.read(in);
+      ostringstream out;
+      counts.write(out);
+      TS_ASSERT_EQUALS(out.str(),
+         "a ||| x ||| 3 a=0:2;0_0:1\n"
+         "a ||| x y ||| 1\n"
+         "b ||| y ||| 2 a=0:2\n");
+   }
+
+   void testMerge() {
+      IncrPhraseCounts c1, c2;
+      c1.add("a", "x", 1, "0");
+      c2.add("a", "x", 2, "0");
+      c2.add("b", "x", 1);
+      c1.merge(c2);
+      vector<IncrPhraseCounts::Translation> trans;
+      TS_ASSERT_EQUALS(c1.lookup("a", trans), 3u);
+      TS_ASSERT_EQUALS(trans.size(), 1u);
+      TS_ASSERT_EQUALS(trans[0].marginal2, 4u);
+      TS_ASSERT_EQUALS(trans[0].info->alignments.find("0")->second, 3u);
+   }
+
+   void testMergePhraseTableUint() {
+      PhraseTableUint pt;
+      istringstream jpt("a ||| x ||| 2 a=0\nb c ||| y ||| 1\n");
+      pt.readJointTable(jpt);
+      IncrPhraseCounts counts;
+      TS_ASSERT_EQUALS(counts.merge(pt), 3u);
+      vector<IncrPhraseCounts::Translation> trans;
+      TS_ASSERT_EQUALS(counts.lookup("b c", trans), 1u);
+      TS_ASSERT_EQUALS(*trans[0].phrase2, "y");
+      TS_ASSERT_EQUALS(counts.lookup("a", trans), 2u);
+      TS_ASSERT_EQUALS(trans[0].info->topAlignment(), "0");
+   }
+
+   void testRemove() {
+      IncrPhraseCounts counts;
+      counts.add("a", "x", 2, "0");
+      counts.add("a", "x", 1, "0_0");
+      counts.add("a", "y", 1);
+      TS_ASSERT_EQUALS(counts.remove("a", "x", 1, "0_0"), 1u);
+      vector<IncrPhraseCounts::Translation> trans;
+      TS_ASSERT_EQUALS(counts.lookup("a", trans), 3u);
+      for (Uint i = 0; i < trans.size(); ++i)
+         if (*trans[i].phrase2 == "x") {
+            TS_ASSERT_EQUALS(trans[i].joint, 2u);
+            TS_ASSERT_EQUALS(trans[i].info->alignments.size(), 1u);
+            TS_ASSERT_EQUALS(trans[i].info->topAlignment(), "0");
+         }
+
+      // Removing more than was added removes what there is.
+      TS_ASSERT_EQUALS(counts.remove("a", "y", 2), 1u);
+      TS_ASSERT_EQUALS(counts.remove("b", "y", 1), 0u);
+      TS_ASSERT_EQUALS(counts.size(), 1u);
+      TS_ASSERT_EQUALS(counts.lookup("a", trans), 2u);
+      TS_ASSERT_EQUALS(trans.size(), 1u);
+      TS_ASSERT_EQUALS(trans[0].marginal2, 2u);
+
+      TS_ASSERT_EQUALS(counts.remove("a", "x", 2, "0"), 2u);
+      TS_ASSERT(counts.empty());
+      TS_ASSERT_EQUALS(counts.lookup("a", trans), 0u);
+      TS_ASSERT(trans.empty());
+      ostringstream out;
+      counts.write(out);
+      TS_ASSERT_EQUALS(out.str(), "");
+   }
+
+   void testSubtractUndoesMerge() {
+      istringstream in("a ||| x ||| 3 a=0:2;0_0:1\nb ||| y ||| 2 a=0:2\n");
+      IncrPhraseCounts counts;
+      counts.read(in);
+      ostringstream before;
+      counts.write(before);
+
+      PhraseTableUint pt;
+      istringstream jpt("a ||| x ||| 2 a=0\nb c ||| y ||| 1\n");
+      pt.readJointTable(jpt);
+      TS_ASSERT_EQUALS(counts.merge(pt), 3u);
+      Uint missing = 1;
+      TS_ASSERT_EQUALS(counts.subtract(pt, missing), 3u);
+      TS_ASSERT_EQUALS(missing, 0u);
+      ostringstream after;
+      counts.write(after);
+      TS_ASSERT_EQUALS(after.str(), before.str());
+
+      // Subtracting again removes the part of pt that is still there.
+      TS_ASSERT_EQUALS(counts.subtract(pt, missing), 2u);
+      TS_ASSERT_EQUALS(missing, 1u);
+   }
+}; // TestIncrPhraseCounts
+
+} // Portage
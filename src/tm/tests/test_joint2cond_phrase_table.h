@@ -358,6 +358,51 @@ public:
       testDumpMultiProb(true, 0, prune);
    }
 
+   /// Sorted lines of a jpt, to compare tables in different orders.
+   vector<string> sortedLines(const string& jpt)
+   {
+      vector<string> lines;
+      istringstream in(jpt);
+      string line;
+      while (getline(in, line))
+         lines.push_back(line);
+      sort(lines.begin(), lines.end());
+      return lines;
+   }
+
+   void testSpillToDisk()
+   {
+      // Read the table twice, so pairs occur in several runs.
+      const string jpt = makeDataStream(data, data_length);
+      PhraseTableGen<Uint> in_memory, spilled;
+      spilled.spillToDisk(1);  // 1 byte: spill before nearly every pair
+      for (Uint i = 0; i < 2; ++i) {
+         istringstream in1(jpt), in2(jpt);
+         in_memory.readJointTable(in1);
+         spilled.readJointTable(in2);
+      }
+      TS_ASSERT(spilled.numSpilledRuns() > 1);
+
+      ostringstream expected_out, out;
+      in_memory.dump_joint_freqs(expected_out);
+      spilled.dump_joint_freqs(out);
+      TS_ASSERT(sortedLines(out.str()) == sortedLines(expected_out.str()));
+      TS_ASSERT_EQUALS(spilled.numSpilledRuns(), 0u);
+
+      // Pairs must come out grouped by lang1 phrase
+      vector<string> seen;
+      istringstream in(out.str());
+      string line;
+      while (getline(in, line)) {
+         const string s = line.substr(0, line.find(psep));
+         if (seen.empty() || seen.back() != s) {
+            TS_ASSERT(find(seen.begin(), seen.end(), s) == seen.end());
+            seen.push_back(s);
+         }
+      }
+      TS_ASSERT_EQUALS(seen.size(), 4u);
+   }
+
 };
 
 const string TestJoint2CondPhraseTable::sep(" ");
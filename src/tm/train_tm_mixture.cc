@@ -282,15 +282,15 @@ struct Probs {
    }
    // boxing's input end
 
-   // Pseudo-normalize a vector of probabilities, one per cpt, for a given
+   // Pseudo-normalize an array of probabilities, one per cpt, for a given
    // phrase pair and column. Zero probabilities for cpts that don't contain
    // the conditioning phrase are replaced by the avg over all cpts that do.
-   void norm(vector<double>& probs, Uint phrase, Uint col, Uint ncols) {
+   void norm(double* probs, Uint phrase, Uint col, Uint ncols) {
       Uint pind = col >= ncols/2 ? src_indexes[phrase] : tgt_indexes[phrase];
       PhrasePresence& ppr(col >= ncols/2 ? src_phrases : tgt_phrases);
       double s = 0;
       Uint n = 0;
-      for (Uint i = 0; i < probs.size(); ++i)
+      for (Uint i = 0; i < numCpts(); ++i)
          if (ppr.occurs(pind, i)) {
             s += probs[i];
             ++n;
@@ -298,7 +298,7 @@ struct Probs {
       s /= n;
       assert(s);
       s *= smooth_coeff;
-      for (Uint i = 0; i < probs.size(); ++i)
+      for (Uint i = 0; i < numCpts(); ++i)
          if (!ppr.occurs(pind, i)) {
             assert(probs[i] == 0.0);
             probs[i] = s;
@@ -770,7 +770,6 @@ int MAIN(argc, argv)
             fixed_weights.size(), num_cols);
    vector< vector<double> > wts(num_cols);   // col, cpt -> wt
    for (Uint i = 0; i < num_cols; ++i) {
-      vector<double> pr(probs.numCpts());  // prob vector for current column
       if (verbose) {
          if (njcols == 1)
             cerr << "EM for column " << i+1 << ": " << endl;
@@ -781,49 +780,63 @@ int MAIN(argc, argv)
          if (verbose) cerr << "(skipping - using fixed weights)" << endl;
          wts[i] = fixed_weights[i];
       } else {
-         Stats stats;
-         EM em(probs.numCpts());
-         for (Uint iter = 0; iter < maxiter; ++iter) {
-            double lp = 0.0, tot_smoothedcount = 0.0;
-            for (Uint j = 0; j < jpt_freqs.size(); ++j) {
-               if (!probs.phrasePairInSomeCpt(j)) continue;
-               if (njcols == 1) {  // cpt mixture
-                  for (Uint k = 0; k < pr.size(); ++k)
-                     pr[k] = probs.getProb(k, j, i);
-                  if (smooth_cpts) probs.norm(pr, j, i, num_cols);
-                  double smoothedcount = jpt_freqs[j][0];
-                  if (tomodel) smoothedcount *= im_probs[j][i];
-                  if (df) smoothedcount *= probs.computeDf(j);
-                  if (idf) smoothedcount *= probs.computeIdf(j);
-                  lp += smoothedcount * log(em.count(pr, smoothedcount));
-                  tot_smoothedcount += smoothedcount;
-                  if (verbose && iter == 0) stats.add(pr);
-               } else {            // dm mixture
-                  for (Uint r = 3*i; r < 3*(i+1); ++r) {  // column index in 0..5
-                     for (Uint k = 0; k < pr.size(); ++k)
-                        pr[k] = probs.getProb(k, j, r);
-                     double smoothedcount = jpt_freqs[j][r];
-                     if (tomodel) {
-                        Uint tot_freq = 0;
-                        for (Uint m = 3*i; m < 3*(i+1); ++m)
-                           tot_freq += jpt_freqs[j][m];
-                        smoothedcount = tot_freq * im_probs[j][r];
-                     }
-                     if (df) smoothedcount *= probs.computeDf(j);
-                     if (idf) smoothedcount *= probs.computeIdf(j);
-                     lp += smoothedcount * log(em.count(pr, smoothedcount));
-                     tot_smoothedcount += smoothedcount;
-                  }
+         // The probabilities and smoothed counts of the phrase pairs don't
+         // change from one iteration to the next, so compute them only once,
+         // as EM instances: one per phrase pair, or three for dms.
+         vector<Uint> inst_phrases, inst_cols;  // instance -> phrase pair, column
+         for (Uint j = 0; j < jpt_freqs.size(); ++j) {
+            if (!probs.phrasePairInSomeCpt(j)) continue;
+            if (njcols == 1) {  // cpt mixture
+               inst_phrases.push_back(j);
+               inst_cols.push_back(i);
+            } else              // dm mixture
+               for (Uint r = 3*i; r < 3*(i+1); ++r) {  // column index in 0..5
+                  inst_phrases.push_back(j);
+                  inst_cols.push_back(r);
                }
+         }
+         EMMatrix instances(probs.numCpts(), true);
+         instances.add(inst_phrases.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+         for (int n = 0; n < int(inst_phrases.size()); ++n) {
+            const Uint j = inst_phrases[n], r = inst_cols[n];
+            double* pr = instances.row(n);
+            for (Uint k = 0; k < probs.numCpts(); ++k)
+               pr[k] = probs.getProb(k, j, r);
+            double smoothedcount = jpt_freqs[j][njcols == 1 ? 0 : r];
+            if (njcols == 1) {
+               if (smooth_cpts) probs.norm(pr, j, i, num_cols);
+               if (tomodel) smoothedcount *= im_probs[j][i];
+            } else if (tomodel) {
+               Uint tot_freq = 0;
+               for (Uint m = 3*i; m < 3*(i+1); ++m)
+                  tot_freq += jpt_freqs[j][m];
+               smoothedcount = tot_freq * im_probs[j][r];
             }
-            if (verbose) {
-               if (iter == 0 && njcols == 1) {
-                  stats.report(i);
-                  stats.clear();
-               }
+            if (df) smoothedcount *= probs.computeDf(j);
+            if (idf) smoothedcount *= probs.computeIdf(j);
+            instances.setFreq(n, smoothedcount);
+         }
+         double tot_smoothedcount = 0.0;
+         for (Uint n = 0; n < instances.numInstances(); ++n)
+            tot_smoothedcount += instances.freq(n);
+         if (verbose && njcols == 1) {
+            Stats stats;
+            for (Uint n = 0; n < instances.numInstances(); ++n)
+               stats.add(vector<double>(instances.row(n), instances.row(n) + probs.numCpts()));
+            stats.report(i);
+         }
+
+         EM em(probs.numCpts());
+         for (Uint iter = 0; iter < maxiter; ++iter) {
+            Uint num_zeros = 0;
+            double lp = em.countAll(instances, &num_zeros);
+            if (num_zeros) lp = -INFINITY;  // log of a zero probability
+            if (verbose)
                cerr << "iter " << iter+1 << " done: ppx = "
                     << exp(-lp / tot_smoothedcount) << endl;
-            }
             if (em.estimate() < prec)
                break;
          }
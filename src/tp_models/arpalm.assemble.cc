@@ -35,12 +35,14 @@
 
 #include "tpt_typedefs.h"
 #include "tpt_tightindex.h"
+#include "tpt_blockindex.h"
 #include "tpt_tokenindex.h"
 #include "tpt_pickler.h"
 #include "tpt_utils.h"
+#include "tplm_format.h"
 
 static char help_message[] = "\n\
-arpalm.assemble [-h] LM_ORDER OUTPUT_BASE_NAME\n\
+arpalm.assemble [-h] [-index-v2] LM_ORDER OUTPUT_BASE_NAME\n\
 \n\
   Assemble the encoded LM (TPLM) from the sorted ngram files.\n\
 \n\
@@ -51,6 +53,12 @@ arpalm.assemble [-h] LM_ORDER OUTPUT_BASE_NAME\n\
 \n\
   This is the final step in arpalm2tplm conversion.\n\
   This program is normally via arpalm2tplm.sh.\n\
+\n\
+Options:\n\
+\n\
+  -index-v2  Write the trie node indices in the version 2 (block) format,\n\
+             faster to search, especially on pages not yet in memory, and\n\
+             mark it in the TPLM header.\n\
 ";
 
 using namespace std;
@@ -58,6 +66,7 @@ using namespace ugdiss;
 TokenIndex* tidx=NULL;
 
 id_type numTokens;
+bool block_index = false; // write node indices in BLOCK_INDEX format
 
 class ngram
 {
@@ -258,14 +267,25 @@ writeNode(ostream& out, vector<ngramStreamer*>& B, size_t i, filepos_type& outPo
   TPT_DBG(assert(outPos == (filepos_type)out.tellp()));
   filepos_type idxStart = outPos;
   typedef vector<idx_entry_t>::iterator idx_iter_t;
-  for (idx_iter_t it = tmpidx.begin(); it != tmpidx.end(); it++)
+  if (block_index)
     {
-      outPos += tightwrite(out, it->first, false);
-      if (it->first&FLAGMASK)
-        outPos += tightwrite(out, idxStart - it->second, true);
-      else
-        outPos += tightwrite(out, it->second, true);
+      vector<pair<uint64_t,uint64_t> > entries;
+      entries.reserve(tmpidx.size());
+      for (idx_iter_t it = tmpidx.begin(); it != tmpidx.end(); it++)
+        entries.push_back(pair<uint64_t,uint64_t>
+                          (it->first, (it->first&FLAGMASK)
+                           ? idxStart - it->second : it->second));
+      outPos += blockwrite(out, entries);
     }
+  else
+    for (idx_iter_t it = tmpidx.begin(); it != tmpidx.end(); it++)
+      {
+        outPos += tightwrite(out, it->first, false);
+        if (it->first&FLAGMASK)
+          outPos += tightwrite(out, idxStart - it->second, true);
+        else
+          outPos += tightwrite(out, it->second, true);
+      }
   TPT_DBG(assert(outPos >= 0); assert(outPos == (filepos_type)out.tellp()));
   filepos_type myPosition = outPos;
   uchar flags = tmpidx.empty() ? 0: HAS_CHILD_MASK;
@@ -278,6 +298,20 @@ writeNode(ostream& out, vector<ngramStreamer*>& B, size_t i, filepos_type& outPo
   p = binread(p,bowId);
   p = binread(p,pvalEncSize);
 
+  // arpalm.sng-av always writes the probability index in TIGHT_INDEX
+  // format; convert it if needed.
+  string pvalIdx;
+  if (block_index && pvalEncSize)
+    {
+      vector<pair<uint64_t,uint64_t> > entries;
+      readindex(TIGHT_INDEX, p, p + pvalEncSize, entries);
+      ostringstream buf;
+      blockwrite(buf, entries);
+      pvalIdx = buf.str();
+      p = pvalIdx.data();
+      pvalEncSize = pvalIdx.size();
+    }
+
   if (flags || pvalEncSize)
     {
       outPos += binwrite(out, bowId);
@@ -317,6 +351,12 @@ int MAIN(argc, argv)
       cerr << help_message << endl;
       exit(0);
     }
+  if (argc > 1 && !strcmp(argv[1], "-index-v2"))
+    {
+      block_index = true;
+      --argc;
+      ++argv;
+    }
   if (argc < 3)
     cerr << efatal << "LM_ORDER and OUTPUT_BASE_NAME required." << endl
          << help_message << exit_1;
@@ -369,7 +409,7 @@ int MAIN(argc, argv)
       out.put(flags[i]);
     }
   out.seekp(0);
-  numwrite(out,sIdx);
+  numwrite(out,TPLMFormat::encode(sIdx, block_index ? BLOCK_INDEX : TIGHT_INDEX));
   cerr << "done arpalm.assemble" << endl;
 }
 END_MAIN
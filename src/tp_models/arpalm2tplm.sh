@@ -27,7 +27,7 @@ usage() {
    done
    cat <<==EOF== >&2
 
-Usage: arpalm2tplm.sh [-n NUM_PAR] <ARPALM_filename> [TPLM_prefix]
+Usage: arpalm2tplm.sh [-n NUM_PAR] [-index-v2] <ARPALM_filename> [TPLM_prefix]
 
    Convert an ARPA format LM into a Tightly Packed LM (TPLM):
    an LM encoded using Uli Germann's Tightly Packed tries.
@@ -38,6 +38,10 @@ Usage: arpalm2tplm.sh [-n NUM_PAR] <ARPALM_filename> [TPLM_prefix]
 Options:
 
    -n NUM_PAR   Specifies how many parallel workers to use [4]
+   -index-v2    Write the trie node indices in the version 2 (block) format,
+                faster to search, especially on pages not yet in memory.
+                The resulting TPLM is not readable by older versions of
+                Portage.
    -h(elp)      Print this help message
    -v(erbose)   Increment the verbosity level by 1 (may be repeated)
    -d(ebug)     Debug mode - don't delete tmp directory.
@@ -83,6 +87,7 @@ while [ $# -gt 0 ]; do
    -n)           arg_check 1 $# $!; arg_check_pos_int $2 $1; NUM_PAR=$2; shift;;
    -v|-verbose)  VERBOSE=$(( $VERBOSE + 1 ));;
    -d|-debug)    DEBUG=1;;
+   -index-v2)    ASSEMBLE_OPTS="-index-v2";;
    -q|-quiet)    VERBOSE=0;;
    --)           shift; break;;
    -*)           error_exit "Unknown option $1.";;
@@ -166,8 +171,8 @@ verbose 1 "run-parallel.sh ${RP_OPTS} sng-av.jobs.logging $NUM_PAR >& $(redirect
 run-parallel.sh ${RP_OPTS} sng-av.jobs.logging $NUM_PAR >& $(redirect arpalm.sng-av)
 
 verbose 1 "Assembling sub-jobs."
-verbose 1 "arpalm.assemble $LMORDER ../$OUTPUTLM.tplm/ >& $(redirect arpalm.assemble)"
-${TIME_MEM} arpalm.assemble $LMORDER ../$OUTPUTLM.tplm/ >& $(redirect arpalm.assemble)
+verbose 1 "arpalm.assemble $ASSEMBLE_OPTS $LMORDER ../$OUTPUTLM.tplm/ >& $(redirect arpalm.assemble)"
+${TIME_MEM} arpalm.assemble $ASSEMBLE_OPTS $LMORDER ../$OUTPUTLM.tplm/ >& $(redirect arpalm.assemble)
 cd ..
 
 for x in cbk tdx tplm; do
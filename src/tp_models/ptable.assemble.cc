@@ -34,13 +34,14 @@
 #include "tpt_typedefs.h"
 #include "tpt_tokenindex.h"
 #include "tpt_tightindex.h"
+#include "tpt_blockindex.h"
 #include "tpt_pickler.h"
 #include "tpt_bitcoder.h"
 #include "tpt_utils.h"
 #include "tppt_config.h"
 
 static char help_message[] = "\n\
-ptable.assemble [-h] OUTPUT_BASE_NAME\n\
+ptable.assemble [-h] [-index-v2] OUTPUT_BASE_NAME\n\
 \n\
   Sort the entries and assemble the encoded phrase table (TPPT) from the\n\
   various intermediate files.\n\
@@ -49,8 +50,16 @@ ptable.assemble [-h] OUTPUT_BASE_NAME\n\
 \n\
   This is the final step in the conversion of text phrase tables to tightly\n\
   packed phrase tables (TPPT).\n\
+  The phrase table entries are encoded in parallel: set OMP_NUM_THREADS to\n\
+  control the number of threads used.\n\
   This program is normally called via textpt2tppt.sh.\n\
 \n\
+Options:\n\
+\n\
+  -index-v2  Write the trie node indices in the version 2 (block) format,\n\
+             faster to search, especially on pages not yet in memory.\n\
+             Readers older than this format refuse the resulting TPPT.\n\
+\n\
 ";
 
 #define VERIFY_VALUE_ENCODING 0
@@ -80,6 +89,7 @@ uint32_t num_uint_scores = 0;
 uint32_t num_alignment_offset_slots = 0;
 uint32_t num_scores = 0;
 bool has_alignments = false;
+bool block_index = false;     // write node indices in BLOCK_INDEX format
 
 // return a list of codebooks, where each entry has a bool indicating whether
 // the code book encodes floats (true) or uint32_t (false), and a list of the
@@ -279,6 +289,51 @@ encodeAllEntries(string& dest, size_t o)
    return i-o;
 }
 
+// The values of all source phrases are encoded in parallel, one batch at a
+// time, ahead of the (sequential) traversal of the source trie that consumes
+// them in order.  The encoding of each source phrase is independent of the
+// others, so the output is the same as when encoding on the fly, while memory
+// use is bounded by the batch size.
+const size_t encodingBatchSize = 100000; // number of source phrases per batch
+vector<size_t> batchStart;  // index into srcPO of each source phrase in the batch, plus end
+vector<string> batchValue;  // encoded values of each source phrase in the batch
+size_t batchNext = 0;       // next source phrase in the batch to be consumed
+
+/** Same as encodeAllEntries(dest,o), but using the parallel batch encoding.
+ *  Calls must be made in increasing order of o, one per source phrase.
+ */
+size_t
+getEncodedEntries(string& dest, size_t o)
+{
+   assert(dest.size()==0);
+   assert(o < numEntries);
+   if (batchNext+1 >= batchStart.size() || batchStart[batchNext] != o)
+   {
+      // Finding the boundaries between source phrases is cheap, do it sequentially.
+      batchStart.clear();
+      size_t i = o;
+      while (i < numEntries && batchStart.size() < encodingBatchSize)
+      {
+         batchStart.push_back(i);
+         const uint32_t curSrcPid = srcBase[srcPO[i]];
+         while (++i < numEntries && srcBase[srcPO[i]] == curSrcPid) {}
+      }
+      batchStart.push_back(i);
+      batchValue.resize(batchStart.size()-1);
+#pragma omp parallel for schedule(dynamic,256)
+      for (long k = 0; k < long(batchValue.size()); ++k)
+      {
+         batchValue[k].clear();
+         encodeAllEntries(batchValue[k], batchStart[k]);
+      }
+      batchNext = 0;
+   }
+   dest.swap(batchValue[batchNext]);
+   const size_t numCP = batchStart[batchNext+1] - batchStart[batchNext];
+   ++batchNext;
+   return numCP;
+}
+
 char const* refIdx_start;
 char const* refIdx_end;
 
@@ -315,7 +370,7 @@ processNode(ostream& out, filepos_type& curOutPos, char const* const p, uchar fl
       TPT_DBG(cerr << "top of stack: " << srcBase[srcPO[o]] << endl);
       assert (srcBase[srcPO[o]] >= srcPid);
       if (srcBase[srcPO[o]] == srcPid)
-         o += (numPhrases = encodeAllEntries(myValue,o));
+         o += (numPhrases = getEncodedEntries(myValue,o));
    }
    vector<pair<id_type,filepos_type> > I;
    for (q = idxStart; q < idxStop;)
@@ -339,7 +394,7 @@ processNode(ostream& out, filepos_type& curOutPos, char const* const p, uchar fl
          if (offset == srcBase[srcPO[o]])
          {
             string chldval; // child value
-            uint32_t numCP = encodeAllEntries(chldval,o); // num child phrase entries
+            uint32_t numCP = getEncodedEntries(chldval,o); // num child phrase entries
             o += numCP;
             id_type key = (id&flagfilter)+HAS_VALUE_MASK;
             TPT_DBG(assert((filepos_type)out.tellp() == curOutPos));
@@ -353,13 +408,24 @@ processNode(ostream& out, filepos_type& curOutPos, char const* const p, uchar fl
 
    TPT_DBG(assert((filepos_type)out.tellp() == curOutPos));
    filepos_type myIStart = curOutPos;
-   for (size_t i = 0; i < I.size(); i++)
+   if (block_index)
    {
-      curOutPos += tightwrite(out, I[i].first, false);
-      if (I[i].first&flagmask)
-         curOutPos += tightwrite(out, myIStart-I[i].second, true);
-      else
-         curOutPos += tightwrite(out, I[i].second, true);
+      vector<pair<uint64_t,uint64_t> > entries(I.size());
+      for (size_t i = 0; i < I.size(); i++)
+         entries[i] = make_pair(uint64_t(I[i].first), uint64_t(I[i].first&flagmask
+                                ? myIStart-I[i].second : I[i].second));
+      curOutPos += blockwrite(out, entries);
+   }
+   else
+   {
+      for (size_t i = 0; i < I.size(); i++)
+      {
+         curOutPos += tightwrite(out, I[i].first, false);
+         if (I[i].first&flagmask)
+            curOutPos += tightwrite(out, myIStart-I[i].second, true);
+         else
+            curOutPos += tightwrite(out, I[i].second, true);
+      }
    }
    TPT_DBG(assert((filepos_type)out.tellp() == curOutPos));
    filepos_type myPos = curOutPos;
@@ -409,6 +475,12 @@ int MAIN(argc, argv)
       cerr << help_message << endl;
       exit(0);
    }
+   if (argc > 1 && !strcmp(argv[1], "-index-v2"))
+   {
+      block_index = true;
+      --argc;
+      ++argv;
+   }
    if (argc < 2)
       cerr << efatal << "OUTPUT_BASE_NAME required." << endl
            << help_message << exit_1;
@@ -432,6 +504,14 @@ int MAIN(argc, argv)
       TPPTConfig::read(configName, third_col_count, fourth_col_count, num_counts,
                        has_alignments);
 
+   if (block_index) {
+      // The index format is recorded in the config file.
+      if (tppt_version < 2)
+         cerr << efatal << "-index-v2 requires config file " << configName << exit_1;
+      TPPTConfig::write(configName, third_col_count, fourth_col_count, num_counts,
+                        has_alignments, BLOCK_INDEX);
+   }
+
    if (has_alignments) {
       assert(tppt_version >= 2);
       string alnName = bname + ".aln";
@@ -539,7 +619,7 @@ int MAIN(argc, argv)
       else if (o < numEntries && offset == srcBase[srcPO[o]])
       {
          string chldval; // child value
-         uint32_t numCP = encodeAllEntries(chldval,o); // num child phrase entries
+         uint32_t numCP = getEncodedEntries(chldval,o); // num child phrase entries
          TPT_DBG(assert((filepos_type)idx.tellp() == curIdxPos));
          I[i] = pair<filepos_type,uchar>(curIdxPos, HAS_VALUE_MASK);
          curIdxPos += binwrite(idx, numCP);
@@ -42,6 +42,8 @@ Options:
   -h(elp)     print this help message
   -v(erbose)  increment the verbosity level by 1 (may be repeated)
   -d(ebug)    print debugging information
+  -index-v2   write the trie node indices in the version 2 (block) format,
+              faster to search; see textpt2tppt.sh -h
 
 ==EOF==
 
@@ -57,6 +59,7 @@ while [ $# -gt 0 ]; do
                         BASE_OPTIONS="$BASE_OPTIONS $1";;
    -d|-debug)           DEBUG=1
                         BASE_OPTIONS="$BASE_OPTIONS $1";;
+   -index-v2)           BASE_OPTIONS="$BASE_OPTIONS $1";;
    -h|-help)            usage;;
    --)                  shift; break;;
    -*)                  error_exit "Unknown option $1.";;
@@ -38,6 +38,15 @@ Options:
 
    -h(elp)      print this help message
    -d(ebug)     keep the temporary directory when done
+   -n NCPUS     number of threads for the final assembly step [all available]
+   -index-v2    write the trie node indices in the version 2 (block) format,
+                faster to search, especially on pages not yet in memory.
+                The resulting TPPT is not readable by older versions of
+                Portage.
+   -serial      run the encoding passes one after the other, reading the text
+                phrase table three times; uses less memory, but takes longer.
+                By default, the text phrase table is read once and the source
+                phrases, target phrases and scores are encoded concurrently.
 
 ==EOF==
 
@@ -53,6 +62,9 @@ while [ $# -gt 0 ]; do
 
    -v|-verbose)         VERBOSE=$(( $VERBOSE + 1 ));;
    -d|-debug)           DEBUG=1;;
+   -n)                  arg_check 1 $# $1; arg_check_pos_int $2 $1; NCPUS=$2; shift;;
+   -serial)             SERIAL=1;;
+   -index-v2)           ASSEMBLE_OPTS="-index-v2";;
    -h|-help)            usage;;
    --)                  shift; break;;
    -*)                  error_exit "Unknown option $1.";;
@@ -102,10 +114,34 @@ if [[ ! -r $TEXTPT ]]; then
    error_exit "Can't read $TEXTPT."
 fi
 
-run_cmd "time-mem ptable.encode-phrases $TEXTPT 1 $OUTPUTPT >&2"
-run_cmd "time-mem ptable.encode-phrases $TEXTPT 2 $OUTPUTPT >&2"
-run_cmd "time-mem ptable.encode-scores $TEXTPT $OUTPUTPT >&2"
-run_cmd "time-mem ptable.assemble $OUTPUTPT >&2"
+if [[ $SERIAL ]]; then
+   run_cmd "time-mem ptable.encode-phrases $TEXTPT 1 $OUTPUTPT >&2"
+   run_cmd "time-mem ptable.encode-phrases $TEXTPT 2 $OUTPUTPT >&2"
+   run_cmd "time-mem ptable.encode-scores $TEXTPT $OUTPUTPT >&2"
+else
+   # The three encoding passes are independent of each other: decompress the
+   # text phrase table once and feed it to all three at the same time.
+   mkfifo src.fifo trg.fifo scr.fifo || error_exit "Can't create fifos in $TMPDIR."
+   time-mem ptable.encode-phrases src.fifo 1 $OUTPUTPT >&2 & SRC_PID=$!
+   time-mem ptable.encode-phrases trg.fifo 2 $OUTPUTPT >&2 & TRG_PID=$!
+   time-mem ptable.encode-scores scr.fifo $OUTPUTPT >&2 & SCR_PID=$!
+   case $TEXTPT in
+      *.bz2)       CAT="bzcat";;
+      *.xz|*.lzma) CAT="xzcat";;
+      *)           CAT="zcat -f";;
+   esac
+   verbose 1 "$CAT $TEXTPT | tee src.fifo trg.fifo > scr.fifo"
+   ( set -o pipefail; $CAT $TEXTPT | tee src.fifo trg.fifo > scr.fifo ) ||
+      error_exit "Error reading $TEXTPT."
+   for PID in $SRC_PID $TRG_PID $SCR_PID; do
+      wait $PID || error_exit "Error encoding $TEXTPT; see messages above."
+   done
+   rm -f src.fifo trg.fifo scr.fifo
+fi
+if [[ $NCPUS ]]; then
+   export OMP_NUM_THREADS=$NCPUS
+fi
+run_cmd "time-mem ptable.assemble $ASSEMBLE_OPTS $OUTPUTPT >&2"
 for x in tppt cbk trg.repos.dat src.tdx trg.tdx; do
    mv $OUTPUTPT.$x ../$OUTPUTPT$TPT_EXTENSION/$x ||
       error_exit "Can't mv $OUTPUTPT.$x into $OUTPUTPT$TPT_EXTENSION/$x, model probably exists but can't be moved or renamed properly."
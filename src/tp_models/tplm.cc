@@ -169,10 +169,10 @@ namespace Portage
       }
 #endif 
 
-    char const* p = tightfind_noflags(startPIdx,stopPIdx,key);
-    if (!p)
+    filepos_type v;
+    if (!indexfind_noflags(index_format,startPIdx,stopPIdx,key,v))
       return false;
-    tightread(p,stopPIdx,val);
+    val = v;
     return true;
 //     if (!tightfind_noflags(*file,startPIdx,stopPIdx,key))
 //       return false;
@@ -226,6 +226,7 @@ namespace Portage
     p = binread(p,foo);
     v.startPIdx = p;
     v.stopPIdx  = v.startPIdx+foo;
+    v.index_format = index_format;
     return v.stopPIdx;
   }
 }
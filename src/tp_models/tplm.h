@@ -38,7 +38,9 @@
 #include "tpt_typedefs.h"
 #include "tpt_pickler.h"
 #include "tpt_tightindex.h"
+#include "tpt_blockindex.h"
 #include "tpt_utils.h"
+#include "tplm_format.h"
 #include <vector>
 #include <string>
 #include <boost/iostreams/device/mapped_file.hpp>
@@ -82,6 +84,9 @@ private:
   char const* idxStart;
   size_t topLevelRecSize;
 
+  /** Encoding of the trie node indices: TIGHT_INDEX or BLOCK_INDEX */
+  uint32_t index_format;
+
   /** Code book mapping from score IDs to actual scores */
   bio::mapped_file_source codebook;
 
@@ -364,11 +369,13 @@ LMtpt(string basename
     cerr << efatal << "Empty tplm file '" << basename << "tplm'." << exit_1;
   filepos_type iStart;
   numread(file.data(),iStart);
+  this->index_format = TPLMFormat::decode(iStart);
   if (fSize < iStart)
     cerr << efatal << "Bad index start (" << iStart << ") in tplm file '"
          << basename << "tplm'." << exit_1;
   this->idxStart = file.data()+iStart;
   this->topLevelRecSize = sizeof(filepos_type)+1;
+  reader.index_format = this->index_format;
   // trie.open(basename+"dat");
   tindex.open(basename+"tdx");
   tindex.iniReverseIndex();
@@ -691,11 +698,8 @@ private_wordProb(Uint word, const Uint context[], Uint context_length)
           cx++;
           // cerr << "[1] " << cwid << endl;
           char const* iStart = iStop - diff;
-          p = tightfind(iStart,iStop,cwid,flags);
-          // cerr << "[2] " << int(p) << endl;
-          if (!p)
+          if (!indexfind(index_format,iStart,iStop,cwid,flags,diff))
             break;
-          tightread(p,iStop,diff);
           if (flags)
             iStop = iStart - diff;
           else
@@ -834,9 +838,8 @@ minContextSize(const Uint context[], Uint context_length)
                << endl;
 #endif
           bool has_child = flags & HAS_CHILD_MASK;
-          char const* p = (has_child
-                           ? binread(iStop,diff)
-                           : iStop);
+          if (has_child)
+            binread(iStop,diff);
 #if LMTPTQ_DEBUG_LOOKUP
           cerr << "   has_child: " << has_child;
 #endif
@@ -850,12 +853,9 @@ minContextSize(const Uint context[], Uint context_length)
             break;
           // cerr << "[1] " << cwid << endl;
           char const* iStart = iStop - diff;
-          p = tightfind(iStart,iStop,cwid,flags);
-          // cerr << "[2] " << int(p) << endl;
-          if (!p)
+          if (!indexfind(index_format,iStart,iStop,cwid,flags,diff))
             break;
           ++cx;
-          tightread(p,iStop,diff);
           if (flags)
             iStop = iStart - diff;
           else
@@ -907,6 +907,8 @@ Entry
   char const* stopPIdx;
   /** Id of backoff weight */
   valIdType bo_idx;
+  /** Encoding of the probability value index: TIGHT_INDEX or BLOCK_INDEX */
+  uint32_t index_format;
 
 public:
   /** retrieves probability value Id for a word, given the context represented by
@@ -931,11 +933,13 @@ public:
   // quantization and 'regular' LMs
 
   /** constructor */
-  Entry() : file(NULL), startPIdx(0), stopPIdx(0), bo_idx(0) {};
+  Entry() : file(NULL), startPIdx(0), stopPIdx(0), bo_idx(0),
+            index_format(TIGHT_INDEX) {};
 
   /** constructor with initialization from an integer */
   Entry(filepos_type dummy)
-    : file(NULL), startPIdx(0), stopPIdx(0), bo_idx(dummy) {};
+    : file(NULL), startPIdx(0), stopPIdx(0), bo_idx(dummy),
+      index_format(TIGHT_INDEX) {};
 };
 
 template<typename valIdType>
@@ -944,6 +948,9 @@ LMtpt<valIdType>::
 Reader
 {
 public:
+  /** Encoding of the probability value indices: TIGHT_INDEX or BLOCK_INDEX */
+  uint32_t index_format;
+  Reader() : index_format(TIGHT_INDEX) {}
   void operator()(istream& in, LMtpt<valIdType>::Entry& v) const;
   char const* operator()(char const* p, LMtpt<valIdType>::Entry& v) const;
 };
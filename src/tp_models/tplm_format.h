@@ -0,0 +1,53 @@
+/**
+ * @file tplm_format.h
+ * @brief Encoding of the trie node index format in the TPLM header.
+ *
+ * A TPLM file starts with the position of its top-level index.  TPLMs with
+ * block node indices set the top bit of that position, so that readers that
+ * only know the original tight node indices reject them with a "Bad index
+ * start" error instead of misparsing them.  TPLMs built before the block
+ * index format never have that bit set.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef TPLM_FORMAT_H
+#define TPLM_FORMAT_H
+
+#include "tpt_typedefs.h"
+#include "tpt_blockindex.h"
+
+namespace ugdiss {
+
+namespace TPLMFormat {
+
+   /// Top bit of the index start position: set for BLOCK_INDEX TPLMs
+   static const filepos_type BlockIndexFlag = filepos_type(1) << 63;
+
+   /// @return the index start position to write in the TPLM header
+   inline filepos_type encode(filepos_type iStart, uint32_t index_format)
+   {
+      return index_format == BLOCK_INDEX ? (iStart | BlockIndexFlag) : iStart;
+   }
+
+   /**
+    * Decode the TPLM header.
+    * @param[in,out] iStart  the position read; set to the index start position
+    * @return the encoding of the trie node indices
+    */
+   inline uint32_t decode(filepos_type& iStart)
+   {
+      if (!(iStart & BlockIndexFlag))
+         return TIGHT_INDEX;
+      iStart &= ~BlockIndexFlag;
+      return BLOCK_INDEX;
+   }
+
+} // namespace TPLMFormat
+} // namespace ugdiss
+
+#endif // TPLM_FORMAT_H
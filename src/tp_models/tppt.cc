@@ -22,6 +22,7 @@
 #include "tpt_typedefs.h"
 #include "tpt_pickler.h"
 #include "tpt_tightindex.h"
+#include "tpt_blockindex.h"
 #include "repos_getSequence.h"
 #include "tpt_utils.h"
 #include <iostream>
@@ -41,21 +42,27 @@ namespace ugdiss
    TpPhraseTable::
    TpPhraseTable() 
       : idxBase(0) 
+      , cacheLookups(0)
+      , cacheHits(0)
       , tppt_version(0)
       , third_col_count(0)
       , fourth_col_count(0)
       , num_counts(0)
       , has_alignment(false)
+      , index_format(TIGHT_INDEX)
    {}
   
    TpPhraseTable::
    TpPhraseTable(const string& fname)
       : idxBase(0) 
+      , cacheLookups(0)
+      , cacheHits(0)
       , tppt_version(0)
       , third_col_count(0)
       , fourth_col_count(0)
       , num_counts(0)
       , has_alignment(false)
+      , index_format(TIGHT_INDEX)
    {
       this->open(fname);
    }
@@ -196,7 +203,7 @@ namespace ugdiss
       string bname = getBasename(fname);
 
       tppt_version = TPPTConfig::read(bname+"config",third_col_count, fourth_col_count,
-                                      num_counts, has_alignment);
+                                      num_counts, has_alignment, &index_format);
 
       // Note that the files other than the index file (tppt) are assumed to
       // be < 4Gb in size, i.e. 32-bit offsets are sometimes assumed.
@@ -305,11 +312,9 @@ namespace ugdiss
       if (wid > root->numTokens)
          cerr << efatal << "Encountered bad wid: " << wid << exit_1;
       uchar flags;
-      char const* p = tightfind(idxStart,idxStop,wid,flags);
-      if (!p)
-         return TpPhraseTable::node_ptr_t();
       filepos_type offset;
-      tightread(p,idxStop,offset);
+      if (!indexfind(root->index_format,idxStart,idxStop,wid,flags,offset))
+         return TpPhraseTable::node_ptr_t();
       return TpPhraseTable::node_ptr_t(new Node(root,idxStart-offset,flags));
    }
 
@@ -349,8 +354,12 @@ namespace ugdiss
          const uint32_t num_floats = root->third_col_count + root->fourth_col_count;
          typedef map<char const*,TpPhraseTable::val_ptr_t>::iterator myIter;
          myIter m = root->cache.find(valStart);
+         ++root->cacheLookups;
          if (m != root->cache.end())
+         {
+            ++root->cacheHits;
             valPtr = m->second;
+         }
          else
          {
             uint32_t numPhrases;
@@ -557,14 +566,24 @@ namespace ugdiss
       if (value(false) != NULL)
          list.push_back(make_pair(prefix + " ||| ", *this));
 
-      id_type id; id_type flagmask = FLAGMASK; filepos_type offset;
-      for (char const* p = idxStart; p < idxStop;)
+      vector<pair<id_type, Node> > kids;
+      children(kids);
+      for (size_t i = 0; i < kids.size(); ++i)
+         kids[i].second.enumerate(list, prefix+" "+root->srcVcb[kids[i].first]);
+   }
+
+   void
+   TpPhraseTable::Node::
+   children(vector<pair<id_type, Node> >& list)
+   {
+      vector<pair<uint64_t,uint64_t> > entries;
+      readindex(root->index_format, idxStart, idxStop, entries);
+      list.reserve(list.size() + entries.size());
+      for (size_t i = 0; i < entries.size(); ++i)
       {
-         p = tightread(p,idxStop,id);
-         p = tightread(p,idxStop,offset);
-         uchar flags = id&flagmask;
-         id >>= FLAGBITS;
-         Node(root,idxStart-offset,flags).enumerate(list, prefix+" "+root->srcVcb[id]);
+         const uchar flags = entries[i].first&FLAGMASK;
+         const id_type id = entries[i].first>>FLAGBITS;
+         list.push_back(make_pair(id, Node(root,idxStart-entries[i].second,flags)));
       }
    }
 
@@ -595,31 +614,19 @@ namespace ugdiss
             out << endl;
          }
       }
-      id_type id; id_type flagmask = FLAGMASK; filepos_type offset;
-      for (char const* p = idxStart; p < idxStop;) {
-         p = tightread(p,idxStop,id);
-         p = tightread(p,idxStop,offset);
-         uchar flags = id&flagmask;
-         id >>= FLAGBITS;
-         Node(root,idxStart-offset,flags).dump(out,prefix+" "+root->srcVcb[id]);
-      }
+      vector<pair<id_type, Node> > kids;
+      children(kids);
+      for (size_t i = 0; i < kids.size(); ++i)
+         kids[i].second.dump(out,prefix+" "+root->srcVcb[kids[i].first]);
    }
 
    void
    TpPhraseTable::Node::
    dump_sorted(ostream& out, string prefix)
    {
-      id_type id; id_type flagmask = FLAGMASK; filepos_type offset;
       vector<pair<id_type, Node> > sorted_children;
-      sorted_children.reserve((idxStop-idxStart)/(sizeof(id)+sizeof(offset))+1);
       sorted_children.push_back(make_pair(root->srcVcb.getNumTokens()+1, *this));
-      for (char const* p = idxStart; p < idxStop;) {
-         p = tightread(p,idxStop,id);
-         p = tightread(p,idxStop,offset);
-         uchar flags = id&flagmask;
-         id >>= FLAGBITS;
-         sorted_children.push_back(make_pair(id, Node(root,idxStart-offset,flags)));
-      }
+      children(sorted_children);
       std::sort(sorted_children.begin(), sorted_children.end(), VcbLessThan(root->srcVcb));
       for (uint32_t i = 0; i < sorted_children.size(); ++i) {
          Node& child = sorted_children[i].second;
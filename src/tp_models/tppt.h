@@ -57,6 +57,8 @@ namespace ugdiss
          char const* idxStop;
          char const* valStart;
          val_ptr_t valPtr;
+         /// Read the children of this node as (id, node) pairs, in id order.
+         void children(vector<pair<id_type, Node> >& list);
       public:
          boost::shared_ptr<Node> find(string const& wrd);
          Node(TpPhraseTable* _root, char const* p, uchar flags);
@@ -110,6 +112,8 @@ namespace ugdiss
       char const* idxBase;
       id_type     numTokens;
       map<char const*,val_ptr_t> cache;
+      uint64_t cacheLookups;      ///< number of lookups in cache
+      uint64_t cacheHits;         ///< number of those found there
 
       /// Get the model base name from its name
       static string getBasename(const string& fname);
@@ -123,6 +127,7 @@ namespace ugdiss
       uint32_t num_counts;        ///< Number of values in the count field (c=)
       bool has_alignment;         ///< Whether alignments are present
       uint32_t alignment_encoding_bits; ///< Number of bits used to encoding alignment links
+      uint32_t index_format;      ///< Encoding of node indices: TIGHT_INDEX or BLOCK_INDEX
 
    public:
       TokenIndex srcVcb;
@@ -134,6 +139,11 @@ namespace ugdiss
       // vector<TCand> readValue(char const* p);
       void clearCache();
 
+      /** cumulative counts of the lookups in the cache and of those that
+       *  found their value there, for canoe's -metricsFilename output */
+      void getCacheCounts(uint64_t& hits, uint64_t& lookups) const
+      { hits = cacheHits; lookups = cacheLookups; }
+
       /** look up translation candidates for a single phrase */
       val_ptr_t lookup(vector<string> const& snt, uint32_t start, uint32_t stop);
 
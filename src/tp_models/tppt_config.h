@@ -13,6 +13,7 @@
 #define TPPT_CONFIG_H
 
 #include "tpt_typedefs.h"
+#include "tpt_blockindex.h"
 #include "str_utils.h"
 
 namespace ugdiss {
@@ -25,7 +26,8 @@ namespace TPPTConfig {
 
    void write(const string& filename,
       uint32_t third_col_count, uint32_t fourth_col_count,
-      uint32_t num_counts, bool has_alignments)
+      uint32_t num_counts, bool has_alignments,
+      uint32_t index_format = TIGHT_INDEX)
    {
       ofstream configFile(filename.c_str());
       if (configFile.fail())
@@ -38,20 +40,28 @@ namespace TPPTConfig {
          << "NumCounts=" << num_counts << endl
          << "HasAlignment=" << has_alignments << endl
          ;
+      // Only mention the index format if it isn't the original one, so
+      // older readers still accept the files they can read.
+      if (index_format != TIGHT_INDEX)
+         configFile << "IndexFormat=" << index_format << endl;
       configFile.close();
    }
 
    /**
     * Read a TPPT config file.
+    * @param index_format  if not NULL, set to the encoding of the trie node
+    *                      indices: TIGHT_INDEX or BLOCK_INDEX
     * @return the TPPT version number: 1 is original (no config file found),
     *         2 is v2, with support for 4th column, counts and alignments.
     */
    uint32_t read(const string& filename,
       uint32_t &third_col_count, uint32_t &fourth_col_count,
-      uint32_t &num_counts, bool &has_alignments)
+      uint32_t &num_counts, bool &has_alignments,
+      uint32_t* index_format = NULL)
    {
       third_col_count = fourth_col_count = num_counts = 0;
       has_alignments = false;
+      if (index_format) *index_format = TIGHT_INDEX;
 
       ifstream configFile(filename.c_str());
       if (configFile.fail()) {
@@ -75,6 +85,13 @@ namespace TPPTConfig {
                num_counts = conv<uint32_t>(tokens[1]);
             else if (tokens[0] == "HasAlignment")
                has_alignments = conv<bool>(tokens[1]);
+            else if (tokens[0] == "IndexFormat") {
+               const uint32_t format = conv<uint32_t>(tokens[1]);
+               if (format != TIGHT_INDEX && format != BLOCK_INDEX)
+                  cerr << efatal << "Unsupported index format " << format
+                       << " in TPPT config file " << filename << exit_1;
+               if (index_format) *index_format = format;
+            }
             else
                cerr << efatal << "Unknown identifier in config file " << filename
                     << ": " << tokens[0] << exit_1;
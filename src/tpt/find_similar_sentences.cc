@@ -26,17 +26,20 @@
  * but only once in a reference candidate, both occurrences are counted.
  */
 #include <vector>
-#include <cmath>
-#include <queue>
+#include <unistd.h>
 
-#include <boost/dynamic_bitset.hpp>
 #include <boost/program_options.hpp>
 
 #include "tpt_typedefs.h"
 #include "tpt_tokenindex.h"
-#include "tpt_tightindex.h"
 #include "ug_mm_ctrack.h"
 #include "ug_mm_sufa.h"
+#include "ug_mm_ngram_index.h"
+#include "ug_similar_sentences.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 using namespace ugdiss;
@@ -49,6 +52,14 @@ find_similar_sentences [options] BASE_NAME\n\
   Read tokenized sentences from stdin, find similar sentences in a corpus\n\
   loaded from files BASE_NAME.tdx, BASE_NAME.mct, BASE_NAME.msa, and report\n\
   the results to stdout.\n\
+\n\
+  If the corpus has an n-gram index for the n-gram size used (see\n\
+  mmngramindex.build), candidates are retrieved from it: the posting lists\n\
+  of the most frequent n-grams of each sentence are only probed for the\n\
+  candidates that could still make it into the top N, which gives the same\n\
+  results as the suffix array much faster.  Sentences shorter than the\n\
+  n-gram size are always looked up in the suffix array.  An index built\n\
+  before the corpus was last rebuilt is ignored, with a warning.\n\
 \n\
 ";
 
@@ -59,16 +70,19 @@ inline ostream& help_message(ostream& os)
   return os << base_help_message << options_help.str();
 }
 
-mmSufa     S;
-mmCtrack   C;
-TokenIndex T;
+mmSufa       S;
+mmCtrack     C;
+TokenIndex   T;
+mmNgramIndex X;
 
 bool   quiet;
+bool   noIndex;
 string bname; // common base name of .tdx .mct .msa
 
 size_t topN;   // print topN matches
 size_t ngSize; // size of ngrams used to find candidates
 float  minSim; // threshold for similarity measure
+size_t numThreads;
 
 void 
 interpret_args(int ac, char* av[])
@@ -84,6 +98,9 @@ interpret_args(int ac, char* av[])
      "size of ngrams used for initial filtering")
     ("min-sim,s", po::value<float>(&minSim)->default_value(.5),
      "minimum similarity for a candidate to be considered a match in range (0.0-1.0]")
+    ("threads,j", po::value<size_t>(&numThreads)->default_value(1),
+     "number of sentences to process in parallel (0 = one per CPU)")
+    ("no-index", "use the suffix array even if an n-gram index exists")
     ;
   options_help << o;
 
@@ -117,55 +134,35 @@ interpret_args(int ac, char* av[])
     cerr << efatal << "Minimum similarity must be > 0.0 and <= 1.0." << endl
          << help_message << exit_1;
 
-  quiet  = vm.count("quiet");
+  quiet   = vm.count("quiet");
+  noIndex = vm.count("no-index");
+#ifdef _OPENMP
+  if (numThreads > 0)
+    omp_set_num_threads(numThreads);
+#endif
 }
 
-void
-findCandidates(vector<id_type> const& snt)
+/// Process one input line: its id sequence and its matches, in output format.
+string
+processLine(SimilarSentenceFinder const& finder, string const& line)
 {
-  const size_t ngs = min(ngSize,snt.size());
-  if (ngs == 0) return;
+  vector<id_type> snt;
+  T.toIdSeq(snt, line);
+  vector<SimilarSentenceFinder::Match> best;
+  finder.find(snt, best);
 
-  map<id_type,short> ngmatch;
-  
-  typedef std::vector<id_type>::const_iterator iter;
-  for (iter p = snt.begin(); p+ngs <= snt.end(); ++p)
-    {
-      char const* x = S.lower_bound(p,p+ngs);
-      if (!x) continue;
-      boost::dynamic_bitset<uint64_t> check(S.getCorpusSize());
-      id_type sid,off;
-      for (char const* const z = S.upper_bound(p,p+ngs); x < z;)
-        {
-          x = tightread(x,z,sid);
-          x = tightread(x,z,off);
-          if (check[sid]) continue;
-          check.set(sid);
-          ngmatch[sid]++;
-        }
-    }
-  priority_queue<pair<float,id_type> > Q;
-  typedef map<id_type,short>::iterator miter;
-  for (miter m = ngmatch.begin(); m != ngmatch.end(); ++m)
-    {
-      size_t olen = C.sntEnd(m->first)-C.sntStart(m->first);
-      float x = (2.*m->second)/(snt.size()+olen-2*(ngs-1));
-      if (x > minSim)
-        {
-          // float y = 2*lcss(snt,(*S.corpus)[m->first]);
-          // y /= snt.size()+(*S.corpus)[m->first].size();
-          Q.push(pair<float,id_type>(x,m->first));
-        }
-    }
-  for (size_t i = 1; Q.size() && i <= topN; ++i)
+  ostringstream out;
+  out << line << endl;
+  for (size_t i = 0; i < best.size(); ++i)
     {
       // surround the float by whitespace for diff-round.pl processing.
-      cout << "[" << i << ": "
-           << Q.top().first 
-           << " :" << Q.top().second << "] "
-           << C.str(Q.top().second,T) << endl;
-      Q.pop();
-   }
+      out << "[" << i+1 << ": "
+          << best[i].first
+          << " :" << best[i].second << "] "
+          << C.str(best[i].second,T) << endl;
+    }
+  out << endl;
+  return out.str();
 }
 
 int MAIN(argc, argv)
@@ -173,15 +170,39 @@ int MAIN(argc, argv)
   interpret_args(argc, (char **)argv);
 
   open_memory_mapped_suffix_array(bname, T, C, S);
+  const string ixFile = ngram_index_filename(bname, ngSize);
+  if (!noIndex && !access(ixFile.c_str(), F_OK))
+    {
+      X.open(ixFile);
+      if (X.numSentences() != C.size() ||
+          !X.matchesCorpusTrack(memory_mapped_suffix_array_base(bname) + "mct"))
+        {
+          cerr << ewarn << "Ignoring n-gram index '" << ixFile
+               << "': the corpus changed since it was built; rebuild it with"
+               << " mmngramindex.build." << endl;
+          X.close();
+        }
+      else if (!quiet)
+        cerr << "Using n-gram index " << ixFile << endl;
+    }
+  const SimilarSentenceFinder finder(C, S, X, topN, ngSize, minSim);
 
+  // Process the input in blocks of lines, in parallel, then print in order.
+  const size_t blockSize = 10000;
+  vector<string> lines, results;
   string line;
-  vector<id_type> snt;
-  while (getline(cin,line))
+  bool more = true;
+  while (more)
     {
-      cout << line << endl;
-      T.toIdSeq(snt, line);
-      findCandidates(snt);
-      cout << endl;
+      lines.clear();
+      while (lines.size() < blockSize && (more = getline(cin,line)))
+        lines.push_back(line);
+      results.resize(lines.size());
+#pragma omp parallel for schedule(dynamic,1)
+      for (long i = 0; i < long(lines.size()); ++i)
+        results[i] = processLine(finder, lines[i]);
+      for (size_t i = 0; i < results.size(); ++i)
+        cout << results[i];
     }
 }
 END_MAIN
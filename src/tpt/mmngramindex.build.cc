@@ -0,0 +1,238 @@
+/**
+ * @file mmngramindex.build.cc
+ * @brief Build the memory mapped n-gram index (ngiN) of a memory mapped
+ *        suffix array.
+ *
+ * The suffix array already lists the occurrences of each n-gram
+ * contiguously, in key order, so the index is written in a single pass over
+ * it, holding only one posting list in memory at a time.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+#include <boost/program_options.hpp>
+
+#include "tpt_typedefs.h"
+#include "tpt_tokenindex.h"
+#include "tpt_pickler.h"
+#include "tpt_utils.h"
+#include "ug_mm_ctrack.h"
+#include "ug_mm_sufa.h"
+#include "ug_mm_ngram_index.h"
+
+using namespace std;
+using namespace ugdiss;
+namespace po=boost::program_options;
+
+static char base_help_message[] = "\n\
+mmngramindex.build [options] BASE_NAME\n\
+\n\
+  Build the inverted n-gram index of the corpus in the memory mapped suffix\n\
+  array BASE_NAME, i.e., files BASE_NAME.tdx, BASE_NAME.mct, BASE_NAME.msa,\n\
+  or in directory BASE_NAME.tpsa or BASE_NAME, and write it next to them as\n\
+  file ngiN, for n-gram order N.  For each n-gram in the corpus, the index\n\
+  lists the sentences that contain it.\n\
+\n\
+  find_similar_sentences uses this index when it exists for its n-gram size.\n\
+\n\
+";
+
+static stringstream options_help;       // set by interpret_args()
+
+inline ostream& help_message(ostream& os)
+{
+  return os << base_help_message << options_help.str();
+}
+
+bool   quiet;
+string bname;  // common base name of .tdx .mct .msa
+size_t ngSize; // n-gram order
+
+void
+interpret_args(int ac, char* av[])
+{
+  po::variables_map vm;
+  po::options_description o("Options");
+  o.add_options()
+    ("help,h",    "print this message")
+    ("quiet,q",   "don't print progress information")
+    ("ngram-size,n", po::value<size_t>(&ngSize)->default_value(3),
+     "n-gram order of the index")
+    ;
+  options_help << o;
+
+  po::options_description h("Hidden Options");
+  h.add_options()
+    ("bname", po::value<string>(&bname), "base name for corpus files")
+    ;
+  h.add(o);
+
+  po::positional_options_description a;
+  a.add("bname",1);
+
+  try {
+    po::store(po::command_line_parser(ac,av).options(h).positional(a).run(), vm);
+    po::notify(vm);
+  } catch(std::exception& e) {
+    cerr << efatal << e.what() << endl << help_message << exit_1;
+  }
+
+  if (vm.count("help"))
+    {
+      cerr << help_message << endl;
+      exit(0);
+    }
+
+  if (bname.empty())
+    cerr << efatal << "Base name for corpus files (BASE_NAME) required." << endl
+         << help_message << exit_1;
+
+  if (ngSize == 0)
+    cerr << efatal << "N-gram size must be at least 1." << endl
+         << help_message << exit_1;
+
+  quiet  = vm.count("quiet");
+}
+
+/// Copy the contents of file fname to out, then delete it.
+static void
+append_file(ostream& out, const string& fname)
+{
+  {
+    ifstream in(fname.c_str(), ios::binary);
+    if (in.fail())
+      cerr << efatal << "Unable to reopen temporary file '" << fname << "'." << exit_1;
+    out << in.rdbuf();
+  }
+  remove(fname.c_str());
+}
+
+int MAIN(argc, argv)
+{
+  interpret_args(argc, (char **)argv);
+
+  TokenIndex T;
+  mmCtrack   C;
+  mmSufa     S;
+  open_memory_mapped_suffix_array(bname, T, C, S);
+
+  // The index is written to a temporary file, renamed at the end, so that
+  // find_similar_sentences never sees a partial index.
+  const string ixFile = ngram_index_filename(bname, ngSize);
+  const string tmpFile = ixFile + ".tmp";
+  const string keysFile = ixFile + ".keys.tmp";
+  const string offsetsFile = ixFile + ".offsets.tmp";
+  ofstream out(tmpFile.c_str(), ios::binary);
+  ofstream keysOut(keysFile.c_str(), ios::binary);
+  ofstream offsetsOut(offsetsFile.c_str(), ios::binary);
+  if (out.fail() || keysOut.fail() || offsetsOut.fail())
+    cerr << efatal << "Unable to open temporary files for n-gram index file '"
+         << ixFile << "' for writing." << exit_1;
+
+  // Header, with place holders for the values known only at the end.  The
+  // size and modification time of the corpus track let find_similar_sentences
+  // detect an index made stale by rebuilding the corpus.
+  const string mctFile = memory_mapped_suffix_array_base(bname) + "mct";
+  out.write(mmNgramIndex::magic, 8);
+  numwrite(out, uint64_t(ngSize));
+  numwrite(out, uint64_t(C.size()));
+  numwrite(out, getFileSize(mctFile));
+  numwrite(out, getFileMTime(mctFile));
+  uint64_t numKeys = 0, keysStart = 0, offsetsStart = 0;
+  numwrite(out, numKeys);
+  numwrite(out, keysStart);
+  numwrite(out, offsetsStart);
+
+  // Walk the suffix array; the suffixes that start with the same n-gram are
+  // contiguous, and n-grams come in increasing key order.
+  uint64_t numPostings = 0;
+  vector<id_type> key;   // the current n-gram
+  vector<id_type> sids;  // the sentences it occurs in
+  numwrite(offsetsOut, numPostings);
+  char const* p = S.arrayStart();
+  char const* const z = S.arrayEnd();
+  size_t numSuffixes = 0;
+  while (true)
+    {
+      id_type sid = 0;
+      uint16_t offset = 0;
+      id_type const* ng = NULL;
+      if (p < z)
+        {
+          p = S.readSid(p, z, sid);
+          p = S.readOffset(p, z, offset);
+          if (!quiet && ++numSuffixes % 10000000 == 0)
+            cerr << numSuffixes/1000000 << "M suffixes processed" << endl;
+          if (C.sntStart(sid) + offset + ngSize > C.sntEnd(sid))
+            continue; // suffix shorter than an n-gram
+          ng = C.sntStart(sid) + offset;
+        }
+
+      // Flush the current n-gram when reaching a different one, or the end.
+      if (!key.empty() && (!ng || !equal(key.begin(), key.end(), ng)))
+        {
+          sort(sids.begin(), sids.end());
+          sids.erase(unique(sids.begin(), sids.end()), sids.end());
+          for (size_t i = 0; i < sids.size(); ++i)
+            numwrite(out, sids[i]);
+          numPostings += sids.size();
+          for (size_t i = 0; i < ngSize; ++i)
+            numwrite(keysOut, key[i]);
+          numwrite(offsetsOut, numPostings);
+          ++numKeys;
+          if (ng && !lexicographical_compare(key.begin(), key.end(), ng, ng + ngSize))
+            cerr << efatal << "Suffix array '" << bname
+                 << "' is not sorted by token id; can't index it." << exit_1;
+          key.clear();
+          sids.clear();
+        }
+      if (!ng) break;
+      if (key.empty())
+        key.assign(ng, ng + ngSize);
+      sids.push_back(sid);
+    }
+
+  keysOut.close();
+  offsetsOut.close();
+  if (keysOut.fail() || offsetsOut.fail())
+    cerr << efatal << "Writing temporary files for n-gram index '" << ixFile
+         << "' failed." << exit_1;
+  keysStart = out.tellp();
+  append_file(out, keysFile);
+  while (out.tellp() % 8 != 0)
+    out.put(0);
+  offsetsStart = out.tellp();
+  append_file(out, offsetsFile);
+
+  out.seekp(8 + 4 * sizeof(uint64_t));
+  numwrite(out, numKeys);
+  numwrite(out, keysStart);
+  numwrite(out, offsetsStart);
+  out.close();
+  if (out.fail())
+    {
+      remove(tmpFile.c_str());
+      cerr << efatal << "Writing n-gram index file '" << ixFile << "' failed."
+           << exit_1;
+    }
+  if (rename(tmpFile.c_str(), ixFile.c_str()) != 0)
+    {
+      remove(tmpFile.c_str());
+      cerr << efatal << "Unable to rename '" << tmpFile << "' to '" << ixFile
+           << "'." << exit_1;
+    }
+  if (!quiet)
+    cerr << "Indexed " << numKeys << " distinct " << ngSize << "-grams, with "
+         << numPostings << " postings, in " << ixFile << endl;
+}
+END_MAIN
@@ -29,6 +29,10 @@
 #include "tpt_pickler.h"
 
 #include <boost/program_options.hpp>
+#ifdef _OPENMP
+#include <parallel/algorithm>
+#include <omp.h>
+#endif
 
 using namespace std;
 using namespace ugdiss;
@@ -41,6 +45,7 @@ mmsufa.build [options] MMCTRACK_FILE MMSUFA_FILE\n\
   binary memory mapped suffix array MMSUFA_FILE (.msa).\n\
 \n\
   This is the final step in creating a memory mapped suffix array for a corpus.\n\
+  Suffixes are sorted in parallel; by default all available CPUs are used.\n\
   This program is called from build-tp-suffix-array.sh.\n\
 \n\
 ";
@@ -54,6 +59,7 @@ inline ostream& help_message(ostream& os)
 
 string ctrackFile, sufaFile;
 bool quiet = false;
+int num_threads = 0;
 
 void interpret_args(int ac, char* av[])
 {
@@ -62,6 +68,8 @@ void interpret_args(int ac, char* av[])
   o.add_options()
     ("help,h",  "print this message")
     ("quiet,q", "don't print progress information")
+    ("threads,t", po::value<int>(&num_threads),
+     "number of threads to use for sorting [0, i.e., all available]")
     ;
   options_help << o;
 
@@ -99,6 +107,11 @@ void interpret_args(int ac, char* av[])
 
   if (vm.count("quiet"))
     quiet=true;
+
+#ifdef _OPENMP
+  if (num_threads > 0)
+    omp_set_num_threads(num_threads);
+#endif
 }
 
 mmCtrack C;
@@ -231,19 +244,34 @@ int MAIN(argc, argv)
         cerr << C.size() << " sentences processed in total." << ELAPSED << endl;
         cerr << "Sorting ..." << endl;
       }
+    // Token::operator< is a total order, so the result does not depend on
+    // the sort algorithm or on the order in which buckets are sorted.  Large
+    // buckets are sorted one at a time, each with all threads; the other
+    // buckets are spread over the threads and sorted sequentially.
+    const size_t parallel_sort_threshold = 100000;
     for (size_t i = batch_start; i < batch_end; i++)
-      {
-        if (sufa[i].size() > 5000 && !quiet)
-          cerr << "Sorting " << sufa[i].size() << " items for id " << i << "."<< ELAPSED << endl;
+      if (sufa[i].size() >= parallel_sort_threshold)
+        {
+          if (!quiet)
+            cerr << "Sorting " << sufa[i].size() << " items for id " << i << "."<< ELAPSED << endl;
+#ifdef _OPENMP
+          __gnu_parallel::sort(sufa[i].begin(),sufa[i].end(),less<Token>());
+#else
+          sort(sufa[i].begin(),sufa[i].end(),less<Token>());
+#endif
+        }
+#pragma omp parallel for schedule(dynamic,1)
+    for (long i = batch_start; i < long(batch_end); i++)
+      if (sufa[i].size() < parallel_sort_threshold)
         sort(sufa[i].begin(),sufa[i].end(),less<Token>());
-        #if 0
-          // debugging code; can be removed once the thing is stable
-          // Sanity check ...
-          typedef vector<Token>::iterator iter;
-          for (iter m = sufa[i].begin(); m != sufa[i].end(); ++m)
-            assert(*(C.sntStart(m->sid)+m->offset) == i);
-        #endif
-      }
+    #if 0
+      // debugging code; can be removed once the thing is stable
+      // Sanity check ...
+      typedef vector<Token>::iterator iter;
+      for (size_t i = batch_start; i < batch_end; i++)
+        for (iter m = sufa[i].begin(); m != sufa[i].end(); ++m)
+          assert(*(C.sntStart(m->sid)+m->offset) == i);
+    #endif
 
     if (!quiet)
       cerr << "Writing data..." << ELAPSED << endl;
@@ -28,8 +28,12 @@
 #include "ug_mm_ttrack.h"
 #include "ug_mm_tsa.h"
 #include "timer.h"
+#include "fisher_exact_test.h"
 //#include "vector_map.h"
 #include <tr1/unordered_map>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace ugdiss {
   typedef L2R_Token<SimpleWordId> Token;
@@ -57,6 +61,15 @@ phrasepair-contingency [options] BASE_NAME L1 L2\n\
   or\n\
     BASE_NAME.L1.tdx, BASE_NAME.L1.mct, BASE_NAME.L1.msa\n\
   Similarly for language L2.\n\
+\n\
+  Phrase pairs are processed in blocks, in parallel over the distinct source\n\
+  phrases of each block: the occurrences of each source phrase are looked up\n\
+  once for all its translations, so the input should be sorted by source\n\
+  phrase, as phrase tables normally are.  Output is in input order.\n\
+\n\
+  With -fet, significance levels are calculated in-process, with the same\n\
+  output as phrasepair-contingency -sigfet | sigprune_fet.  This is only\n\
+  meaningful if BASE_NAME indexes the whole training corpus.\n\
 \n\
 ";
 
@@ -69,6 +82,10 @@ inline ostream& help_message(ostream& os)
 
 bool   quiet;
 bool   sigfet = false;
+bool   fet = false;
+bool   no_cap = false;
+unsigned min_flag = 0;
+int    threads = 1;
 bool   timer = false;
 string bname;
 string L1;
@@ -83,6 +100,15 @@ interpret_args(int ac, char* av[])
     ("help,h",    "print this message")
     ("quiet,q",   "don't print progress information")
     ("sigfet,s",  "output in a format compatible with sigprune_fet")
+    ("fet,f",     "calculate significance levels in-process, as sigprune_fet "
+                  "would on the -sigfet output")
+    ("no-cap,c",  "with -fet, don't cap anti-linked p-values at 0.5 "
+                  "(as sigprune_fet -c)")
+    ("min-flag,l", po::value<unsigned>(&min_flag)->default_value(0),
+                  "with -fet, minimum flag value to output (as sigprune_fet -l)")
+    ("threads,j", po::value<int>(&threads)->default_value(1),
+                  "number of threads to use; 0 means use OMP_NUM_THREADS or "
+                  "all CPUs")
     ("time,t",    "track the time taken for each phrase pair")
     ;
   options_help << o;
@@ -126,8 +152,13 @@ interpret_args(int ac, char* av[])
          << help_message << exit_1;
 
   quiet  = vm.count("quiet");
-  sigfet = vm.count("sigfet");
+  fet    = vm.count("fet");
+  sigfet = vm.count("sigfet") || fet;
+  no_cap = vm.count("no-cap");
   timer  = vm.count("time");
+
+  if (threads < 0)
+    cerr << efatal << "-threads must be >= 0." << endl << exit_1;
 }
 
 template <class SetT>
@@ -190,126 +221,140 @@ void chooseAndFillCachedSet(mmTSufa const& S,
 {
   static const int min_cache_size = S.getCorpus()->size() / 100;
   if (u-l > min_cache_size) { // arbitrary threshold for caching bitsets
-    pair<char const*,ushort> key(l,key_size);
-    setp = &(B[key]);
+    // The cache is shared by all threads; a cached bitset is only written
+    // while it is being filled, inside this critical section.
+#pragma omp critical(phrasepair_contingency_cache)
+    {
+      pair<char const*,ushort> key(l,key_size);
+      setp = &(B[key]);
+      if (setp->empty()) {
+        setp->resize(S.getCorpus()->size());
+        fillBitSet(l,u,*setp);
+      }
+    }
   } else {
     setp = &non_cached;
-  }
-  if (setp->empty()) {
     setp->resize(S.getCorpus()->size());
     fillBitSet(l,u,*setp);
   }
 }
 
-void contingency(vector<Token> const& p1,
-                 vector<Token> const& p2,
-                 mmTSufa const& S1, 
-                 mmTSufa const& S2,
-                 size_t& jj, size_t& m1, size_t& m2)
+// vector_map is trivially faster for small to medium cases:
+//typedef vector_map<id_type,bool> SmallMapT;
+// unordered_map is a faster (up to 5%) for very large cases, and allows
+// a larger max_vector_map_size to remain competitive.
+typedef tr1::unordered_map<id_type,bool> SmallMapT;
+
+/**
+ * The set of sentences a phrase occurs in.  Choosing the data structure by
+ * size speeds up contingency calculations by an order of magnitude: a hash
+ * set for rare phrases, a bitset over the corpus (cached for very frequent
+ * phrases) otherwise.
+ */
+struct OccurrenceSet
 {
-  char const* l1 = S1.lower_bound(p1.begin(),p1.end());
-  char const* u1 = S1.upper_bound(p1.begin(),p1.end());
-
-  char const* l2 = S2.lower_bound(p2.begin(),p2.end());
-  char const* u2 = S2.upper_bound(p2.begin(),p2.end());
-
-  static const int max_vector_map_size = S1.getCorpus()->size() / 500;
-
-  // vector_map is trivially faster for small to medium cases:
-  //typedef vector_map<id_type,bool> SmallMapT;
-  // unordered_map is a faster (up to 5%) for very large cases, and allows
-  // a larger max_vector_map_size to remain competitive.
-  typedef tr1::unordered_map<id_type,bool> SmallMapT;
-
-  // Uglier code, yes, but choosing data structure by size speeds this code
-  // up an order of magnitude.
-  if (!l1) {
-    m1 = jj = 0;
-    if (!l2) {
-      m2 = 0;
-    } else if (u2-l2 < max_vector_map_size) {
-      SmallMapT set2;
-      fillSet(l2,u2,set2);
-      m2 = set2.size();
+  SmallMapT small;
+  boost::dynamic_bitset<uint64_t> non_cached;
+  boost::dynamic_bitset<uint64_t>* bits;  ///< NULL if small is used
+  size_t count;
+
+  OccurrenceSet() : bits(NULL), count(0) {}
+
+  void fill(mmTSufa const& S, vector<Token> const& p)
+  {
+    static const int max_vector_map_size = S.getCorpus()->size() / 500;
+    char const* l = S.lower_bound(p.begin(),p.end());
+    if (!l) return;
+    char const* u = S.upper_bound(p.begin(),p.end());
+    if (u-l < max_vector_map_size) {
+      fillSet(l,u,small);
+      count = small.size();
     } else {
-      boost::dynamic_bitset<uint64_t> set2, *set2p(NULL);
-      chooseAndFillCachedSet(S2, l2, u2, p2.size(), set2, set2p);
-      m2 = set2p->count();
-    }
-  } else if (u1-l1 < max_vector_map_size) {
-    SmallMapT set1;
-    fillSet(l1,u1,set1);
-    m1 = set1.size();
-    if (!l2) {
-      m2 = jj = 0;
-    } else if (u2-l2 < max_vector_map_size) {
-      SmallMapT set2;
-      fillSet(l2,u2,set2);
-      m2 = set2.size();
-      if (m1 < m2)
-        jj = intersection_size(set1,set2);
-      else
-        jj = intersection_size(set2,set1);
-    } else {
-      boost::dynamic_bitset<uint64_t> set2, *set2p(NULL);
-      chooseAndFillCachedSet(S2, l2, u2, p2.size(), set2, set2p);
-      m2 = set2p->count();
-      jj = intersection_size(set1,*set2p);
-    }
-  } else {
-    boost::dynamic_bitset<uint64_t> set1, *set1p(NULL);
-    chooseAndFillCachedSet(S1, l1, u1, p1.size(), set1, set1p);
-    m1 = set1p->count();
-    if (!l2) {
-      m2 = jj = 0;
-    } else if (u2-l2 < max_vector_map_size) {
-      SmallMapT set2;
-      fillSet(l2,u2,set2);
-      m2 = set2.size();
-      jj = intersection_size(set2,*set1p);
-    } else {
-      boost::dynamic_bitset<uint64_t> set2, *set2p(NULL);
-      chooseAndFillCachedSet(S2, l2, u2, p2.size(), set2, set2p);
-      m2 = set2p->count();
-      jj = ((*set1p)&(*set2p)).count();
+      chooseAndFillCachedSet(S, l, u, p.size(), non_cached, bits);
+      count = bits->count();
     }
   }
+};
 
-/*
-  boost::dynamic_bitset<uint64_t> bs1(S1.getCorpus()->size());
-  boost::dynamic_bitset<uint64_t> bs2(S2.getCorpus()->size());
-  boost::dynamic_bitset<uint64_t>* bsptr1 = &bs1;
-  boost::dynamic_bitset<uint64_t>* bsptr2 = &bs2;
-
-  if (l1 && u1-l1 > 4096*1024) // arbitrary threshold for caching bitsets
-    {
-      pair<char const*,ushort> key(l1,p1.size());
-      bsptr1 = &(B[key]);
-      if (bsptr1->size() == 0)
-        bsptr1->resize(bs1.size());
-    }
-  if (l1 && bsptr1->count() == 0)
-    fillBitSet(l1,u1,*bsptr1);
+/// Number of sentences in which both phrases occur
+size_t joint_count(OccurrenceSet const& set1, OccurrenceSet const& set2)
+{
+  if (set1.count == 0 || set2.count == 0)
+    return 0;
+  else if (!set1.bits && !set2.bits)
+    return set1.count < set2.count ? intersection_size(set1.small,set2.small)
+                                   : intersection_size(set2.small,set1.small);
+  else if (!set1.bits)
+    return intersection_size(set1.small,*set2.bits);
+  else if (!set2.bits)
+    return intersection_size(set2.small,*set1.bits);
+  else
+    return ((*set1.bits)&(*set2.bits)).count();
+}
 
-  if (l2 && u2-l2 > 4096*1024) // arbitrary threshold for caching bitsets
-    {
-      pair<char const*,ushort> key(l2,p2.size());
-      bsptr2 = &(B[key]);
-      if (bsptr2->size() == 0)
-        bsptr2->resize(bs2.size());
-    }
-  if (l2 && bsptr2->count() == 0)
-    fillBitSet(l2,u2,*bsptr2);
+/// A phrase pair read from the input, with its contingency counts
+struct PhrasePair
+{
+  string line;
+  size_t key_end;
+  vector<Token> p1,p2;
+  size_t jj,m1,m2;
+  double secs;
+};
+
+void parse(PhrasePair& pp, TokenIndex const& V1, TokenIndex const& V2)
+{
+  string const& line = pp.line;
+  pp.p1.clear();
+  pp.p2.clear();
+  pp.key_end = 0;
+  size_t q(0), p(0);
+  int part = 0;
+  while (true) {
+     p = line.find_first_not_of(" \t", q);
+     if (p == string::npos) break;
+     q = line.find_first_of(" \t", p);
+
+     string token = line.substr(p,q-p);
+     if (token == "|||") {
+        if (part == 1) { pp.key_end = q; break;    }
+        else           { ++part;         continue; }
+     }
+     if (part == 0) pp.p1.push_back(V1[token]);
+     else           pp.p2.push_back(V2[token]);
+
+     if (q == string::npos) break;
+  }
+}
 
-  jj = (*bsptr1&*bsptr2).count();
-  m1 = bsptr1->count();
-  m2 = bsptr2->count();
-*/
+/**
+ * Calculate the contingency counts of block[begin,end), which all have the
+ * same source phrase, looking up the source phrase occurrences only once.
+ */
+void contingency(vector<PhrasePair>& block, size_t begin, size_t end,
+                 mmTSufa const& S1, mmTSufa const& S2)
+{
+  Timer t;
+  OccurrenceSet set1;
+  set1.fill(S1, block[begin].p1);
+  for (size_t i = begin; i < end; ++i) {
+    PhrasePair& pp = block[i];
+    if (timer && i > begin) t.reset();
+    OccurrenceSet set2;
+    set2.fill(S2, pp.p2);
+    pp.m1 = set1.count;
+    pp.m2 = set2.count;
+    pp.jj = joint_count(set1, set2);
+    if (timer) pp.secs = t.secsElapsed(1);
+  }
 }
 
 int MAIN(argc, argv)
 {
   interpret_args(argc, (char **)argv);
+#ifdef _OPENMP
+  if (threads > 0) omp_set_num_threads(threads);
+#endif
 
   TokenIndex V1, V2;
   mmTTtrack C1, C2;
@@ -317,61 +362,66 @@ int MAIN(argc, argv)
   open_mm_tsa(bname + "." + L1, V1, C1, S1);
   open_mm_tsa(bname + "." + L2, V2, C2, S2);
 
-  string line,w;
+  // Phrase pairs are read in blocks, which are processed in parallel, one
+  // source phrase (i.e., one run of identical source phrases) per task.
+  const size_t block_size = 100000;
+  vector<PhrasePair> block(block_size);
+  vector<size_t> groups;  // start index of each source phrase in block
+
   id_type cnt = 0;
-  Timer t, t1, t2;
+  Timer t1, t2;
   t1.reset();
   t2.reset();
-  while (getline(cin,line))
-    {
-      if (timer) t.reset();
-      vector<Token> p1,p2;
-      //boost::dynamic_bitset<uint64_t> bs1,bs2;
-
-      size_t q(0), p(0), key_end(0);
-      int part = 0;
-      while (true) {
-         p = line.find_first_not_of(" \t", q);
-         if (p == string::npos) break;
-         q = line.find_first_of(" \t", p);
-
-         string token = line.substr(p,q-p);
-         if (token == "|||") {
-            if (part == 1) { key_end = q; break;    }
-            else           { ++part;      continue; }
-         }
-         if (part == 0) p1.push_back(V1[token]);
-         else           p2.push_back(V2[token]);
-
-         if (q == string::npos) break;
+  while (cin) {
+    size_t n = 0;
+    while (n < block_size && getline(cin,block[n].line))
+      parse(block[n++], V1, V2);
+    if (n == 0) break;
+
+    groups.clear();
+    for (size_t i = 0; i < n; ++i)
+      if (i == 0 || block[i].p1 != block[i-1].p1)
+        groups.push_back(i);
+    groups.push_back(n);
+
+#pragma omp parallel for schedule(dynamic)
+    for (long g = 0; g < long(groups.size())-1; ++g)
+      contingency(block, groups[g], groups[g+1], S1, S2);
+
+    for (size_t i = 0; i < n; ++i) {
+      if (!quiet && (++cnt)%500000==0) {
+        cerr << cnt/1000 << "K phrase pairs processed in " << t1.secsElapsed(1) << "s." << endl;
+        t1.reset();
       }
-
-      size_t jj,m1,m2;
-      contingency(p1,p2,S1,S2,jj,m1,m2);
-      if (timer) cout << t.secsElapsed(1) << "s\t";
+      PhrasePair const& pp = block[i];
+      if (fet) {
+        double scaled_ln_p;
+        const Uint flag = fetSignificance(pp.jj, pp.m1, pp.m2, C1.size(),
+                                          no_cap, scaled_ln_p);
+        if (flag < min_flag) continue;
+        fetWriteFields(cout, scaled_ln_p, flag);
+      }
+      if (timer) cout << pp.secs << "s\t";
       if (sigfet) {
-         cout << "\t" << jj
-            << "\t" << m1
-            << "\t" << m2
+         cout << "\t" << pp.jj
+            << "\t" << pp.m1
+            << "\t" << pp.m2
             << "\t" << C1.size()
-            << "\t" << line
-            << endl;
+            << "\t" << pp.line
+            << "\n";
       }
       else {
          cout
-            << line.substr(0,key_end) << " " // << " ||| "
-            << jj << " " // joint count
-            << m1 << " " // marginal count for p1
-            << m2 << " " // marginal count for p2
-            << C1.size() 
-            // << " " << V1.toString(p1) << " ::: " << V2.toString(p2) 
-            << endl;
-      }
-      if (!quiet && (++cnt)%500000==0) {
-        cerr << cnt/1000 << "K phrase pairs processed in " << t1.secsElapsed(1) << "s." << endl;
-        t1.reset();
+            << pp.line.substr(0,pp.key_end) << " " // << " ||| "
+            << pp.jj << " " // joint count
+            << pp.m1 << " " // marginal count for p1
+            << pp.m2 << " " // marginal count for p2
+            << C1.size()
+            << "\n";
       }
     }
+    cout.flush();
+  }
 
   if (!quiet)
       cerr << cnt << " phrase pairs processed in total, in " << t2.secsElapsed(1) << "s." << endl;
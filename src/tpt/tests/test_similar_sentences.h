@@ -0,0 +1,156 @@
+/**
+ * @file test_similar_sentences.h
+ * @brief Test suite for SimilarSentenceFinder and the n-gram index
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "portage_defs.h"
+#include "tpt_tokenindex.h"
+#include "ug_mm_ctrack.h"
+#include "ug_mm_sufa.h"
+#include "ug_mm_ngram_index.h"
+#include "ug_similar_sentences.h"
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <unistd.h>
+#include <utime.h>
+
+using namespace Portage;
+
+namespace Portage {
+
+using namespace ugdiss;
+
+class TestSimilarSentences : public CxxTest::TestSuite
+{
+   static const Uint maxOrder = 4;
+   string tmpdir;
+   string bname;    // base name of the corpus files
+   vector<string> queries;
+
+   static string randSentence(Uint maxLen) {
+      const char* words[] = { "a", "b", "c", "d", "e", "f", "g", "h" };
+      ostringstream s;
+      const Uint len = 1 + rand() % maxLen;
+      for (Uint i = 0; i < len; ++i)
+         s << (i ? " " : "") << words[rand() % ARRAY_SIZE(words)];
+      return s.str();
+   }
+
+   bool run(const string& cmd) {
+      if (system(cmd.c_str()) == 0) return true;
+      TS_FAIL("command failed: " + cmd);
+      return false;
+   }
+
+   /// @return the ngi file of order n, or "" if building it failed.
+   string buildIndex(Uint n) {
+      ostringstream cmd;
+      cmd << "./mmngramindex.build -q -n " << n << " " << bname;
+      return run(cmd.str()) ? ngram_index_filename(bname, n) : "";
+   }
+
+public:
+   void setUp() {
+      srand(11);
+      char tmpdirname[] = "/tmp/testSimilarSentences.XXXXXX";
+      tmpdir = mkdtemp(tmpdirname);
+      bname = tmpdir + "/corpus";
+
+      // A small vocabulary, so that sentences share many n-grams, and
+      // repeated sentences, so that matches tie.
+      vector<string> corpus;
+      for (Uint i = 0; i < 400; ++i)
+         corpus.push_back(i % 5 == 4 ? corpus[rand() % corpus.size()]
+                                     : randSentence(12));
+      {
+         ofstream out((bname + ".txt").c_str());
+         for (Uint i = 0; i < corpus.size(); ++i)
+            out << corpus[i] << endl;
+      }
+      run("./vocab.build -q --tdx " + bname + ".tdx < " + bname + ".txt");
+      run("./mmctrack.build -q " + bname + ".tdx " + bname + ".mct < " + bname + ".txt");
+      run("./mmsufa.build -q -t 1 " + bname + ".mct " + bname + ".msa");
+
+      // Corpus sentences, altered corpus sentences, and random sentences.
+      queries.clear();
+      for (Uint i = 0; i < 20; ++i) {
+         queries.push_back(corpus[rand() % corpus.size()]);
+         queries.push_back(corpus[rand() % corpus.size()] + " " + randSentence(3));
+         queries.push_back(randSentence(12));
+      }
+   }
+
+   void tearDown() {
+      run("rm -rf " + tmpdir);
+   }
+
+   void testIndexSameAsSuffixArray() {
+      TokenIndex T;
+      mmCtrack C;
+      mmSufa S;
+      open_memory_mapped_suffix_array(bname, T, C, S);
+
+      const size_t topNs[] = { 1, 3, 10 };
+      const float minSims[] = { 0.1, 0.3, 0.5, 0.8, 1.0 };
+      Uint numTies = 0, numMatches = 0;
+      for (Uint n = 1; n <= maxOrder; ++n) {
+         const string ixFile = buildIndex(n);
+         if (ixFile.empty()) return;
+         TS_ASSERT_EQUALS(access((ixFile + ".tmp").c_str(), F_OK), -1);
+         mmNgramIndex X;
+         X.open(ixFile);
+         TS_ASSERT_EQUALS(X.order(), n);
+         TS_ASSERT_EQUALS(X.numSentences(), C.size());
+         TS_ASSERT(X.matchesCorpusTrack(bname + ".mct"));
+
+         for (Uint ti = 0; ti < ARRAY_SIZE(topNs); ++ti)
+            for (Uint si = 0; si < ARRAY_SIZE(minSims); ++si) {
+               const SimilarSentenceFinder finder(C, S, X, topNs[ti], n, minSims[si]);
+               for (Uint qi = 0; qi < queries.size(); ++qi) {
+                  vector<id_type> snt;
+                  T.toIdSeq(snt, queries[qi]);
+                  if (snt.size() < n) continue;
+                  vector<SimilarSentenceFinder::Match> fromSufa, fromIndex;
+                  finder.findCandidates(snt, fromSufa);
+                  finder.findCandidatesInIndex(snt, fromIndex);
+                  TS_ASSERT(fromSufa == fromIndex);
+                  numMatches += fromIndex.size();
+                  for (Uint i = 1; i < fromIndex.size(); ++i)
+                     if (fromIndex[i].first == fromIndex[i-1].first)
+                        ++numTies;
+               }
+            }
+      }
+      // Make sure the test exercises ties, and not only empty results.
+      TS_ASSERT(numMatches > 100);
+      TS_ASSERT(numTies > 10);
+   }
+
+   void testStaleIndex() {
+      const string ixFile = buildIndex(2);
+      if (ixFile.empty()) return;
+      mmNgramIndex X;
+      X.open(ixFile);
+      TS_ASSERT(X.isOpen());
+      TS_ASSERT(X.matchesCorpusTrack(bname + ".mct"));
+
+      // Rebuilding the corpus changes the modification time of its track.
+      struct utimbuf times;
+      times.actime = times.modtime = time(NULL) - 3600;
+      TS_ASSERT_EQUALS(utime((bname + ".mct").c_str(), &times), 0);
+      TS_ASSERT(!X.matchesCorpusTrack(bname + ".mct"));
+
+      X.close();
+      TS_ASSERT(!X.isOpen());
+   }
+};
+
+} // namespace Portage
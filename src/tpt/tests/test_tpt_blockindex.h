@@ -0,0 +1,114 @@
+/**
+ * @file test_tpt_blockindex.h
+ * @brief Test suite for the block encoding of trie node indices
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "portage_defs.h"
+#include "tpt_blockindex.h"
+#include <sstream>
+#include <cstdlib>
+
+using namespace Portage;
+
+namespace Portage {
+
+using namespace ugdiss;
+
+class TestTptBlockIndex : public CxxTest::TestSuite
+{
+   typedef vector<pair<uint64_t,uint64_t> > entries_t;
+
+   /// Random flagged entries: keys (id << FLAGBITS) + flags, ids increasing.
+   static entries_t randEntries(Uint n, Uint max_gap, uint64_t max_val) {
+      entries_t e;
+      uint64_t id = rand() % max_gap;
+      for (Uint i = 0; i < n; ++i) {
+         e.push_back(make_pair((id << FLAGBITS) + rand() % 4,
+                               uint64_t(rand()) * rand() % max_val));
+         id += 1 + rand() % max_gap;
+      }
+      return e;
+   }
+
+   static string tightEncode(const entries_t& e) {
+      ostringstream os;
+      for (Uint i = 0; i < e.size(); ++i) {
+         tightwrite(os, e[i].first, false);
+         tightwrite(os, e[i].second, true);
+      }
+      return os.str();
+   }
+
+   static string blockEncode(const entries_t& e) {
+      ostringstream os;
+      const size_t size = blockwrite(os, e);
+      TS_ASSERT_EQUALS(size, os.str().size());
+      return os.str();
+   }
+
+public:
+   void setUp() { srand(7); }
+
+   void testEmpty() {
+      const string s = blockEncode(entries_t());
+      TS_ASSERT(s.empty());
+      uchar flags;
+      filepos_type val;
+      TS_ASSERT(!blockfind(s.data(), s.data(), 3, flags, val));
+      TS_ASSERT(!blockfind_noflags(s.data(), s.data(), 3, val));
+   }
+
+   void testSameAsTight() {
+      const Uint sizes[] = { 1, 2, 17, 63, 64, 65, 128, 129, 1000, 5000 };
+      const uint64_t max_vals[] = { 200, 60000, 4000000000ull, 1ull << 40 };
+      for (Uint si = 0; si < ARRAY_SIZE(sizes); ++si) {
+         const entries_t e = randEntries(sizes[si], si % 2 ? 3 : 200,
+                                         max_vals[si % ARRAY_SIZE(max_vals)]);
+         const string tight = tightEncode(e), block = blockEncode(e);
+         const char* tstart = tight.data(), *tstop = tstart + tight.size();
+         const char* bstart = block.data(), *bstop = bstart + block.size();
+
+         entries_t read;
+         readindex(BLOCK_INDEX, bstart, bstop, read);
+         TS_ASSERT(read == e);
+         readindex(TIGHT_INDEX, tstart, tstop, read);
+         TS_ASSERT(read == e);
+
+         const id_type max_id = (e.back().first >> FLAGBITS) + 2;
+         for (id_type id = 0; id <= max_id; ++id) {
+            uchar tflags = 99, bflags = 99;
+            filepos_type tval = 0, bval = 0;
+            const bool tfound = indexfind(TIGHT_INDEX, tstart, tstop, id, tflags, tval);
+            const bool bfound = indexfind(BLOCK_INDEX, bstart, bstop, id, bflags, bval);
+            TS_ASSERT_EQUALS(bfound, tfound);
+            if (tfound && bfound) {
+               TS_ASSERT_EQUALS(bflags, tflags);
+               TS_ASSERT_EQUALS(bval, tval);
+            }
+         }
+      }
+   }
+
+   void testNoFlags() {
+      entries_t e;
+      for (Uint i = 0; i < 300; ++i)
+         e.push_back(make_pair(uint64_t(3*i + 1), uint64_t(i)));
+      const string block = blockEncode(e);
+      const char* start = block.data(), *stop = start + block.size();
+      for (id_type key = 0; key < 1000; ++key) {
+         filepos_type val = 12345;
+         const bool found = indexfind_noflags(BLOCK_INDEX, start, stop, key, val);
+         TS_ASSERT_EQUALS(found, key % 3 == 1 && key < 900);
+         if (found) TS_ASSERT_EQUALS(val, filepos_type(key / 3));
+      }
+   }
+}; // TestTptBlockIndex
+
+} // Portage
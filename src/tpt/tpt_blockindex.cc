@@ -0,0 +1,225 @@
+/**
+ * @file tpt_blockindex.cc
+ * @brief Version 2 encoding of trie node indices, with fixed-stride keys and
+ *        values.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "tpt_blockindex.h"
+#include "tpt_error.h"
+#include <cassert>
+#include <algorithm>
+
+namespace ugdiss
+{
+  /// Number of bytes (1, 2, 4 or 8) needed to store x.
+  static uchar
+  width(uint64_t x)
+  {
+    return x <= 0xFFu ? 1 : x <= 0xFFFFu ? 2 : x <= 0xFFFFFFFFu ? 4 : 8;
+  }
+
+  /// Write x in w bytes, in native byte order like numwrite().
+  static void
+  putfixed(std::ostream& out, uint64_t x, uchar w)
+  {
+    switch (w) {
+    case 1: { uint8_t  y = x; out.write(reinterpret_cast<char*>(&y), 1); break; }
+    case 2: { uint16_t y = x; out.write(reinterpret_cast<char*>(&y), 2); break; }
+    case 4: { uint32_t y = x; out.write(reinterpret_cast<char*>(&y), 4); break; }
+    default: out.write(reinterpret_cast<char*>(&x), 8); break;
+    }
+  }
+
+  /// Entry i of a fixed-stride array of K, not necessarily aligned.
+  template<typename K>
+  static inline uint64_t
+  getfixed(char const* base, size_t i)
+  {
+    K k;
+    memcpy(&k, base + i*sizeof(K), sizeof(K));
+    return k;
+  }
+
+  static inline uint64_t
+  getfixed(char const* base, size_t i, uchar w)
+  {
+    switch (w) {
+    case 1:  return getfixed<uint8_t>(base, i);
+    case 2:  return getfixed<uint16_t>(base, i);
+    case 4:  return getfixed<uint32_t>(base, i);
+    default: return getfixed<uint64_t>(base, i);
+    }
+  }
+
+  /// Number of entries < k in the sorted fixed-stride array base[0,n).
+  template<typename K>
+  static size_t
+  count_less(char const* base, size_t n, uint64_t k)
+  {
+    // Binary search down to a short range, then count without branches.
+    size_t first = 0;
+    while (n > 16) {
+      const size_t half = n / 2;
+      if (getfixed<K>(base, first + half) < k) {
+        first += half + 1;
+        n -= half + 1;
+      } else
+        n = half;
+    }
+    size_t cnt = 0;
+    for (size_t i = 0; i < n; ++i)
+      cnt += getfixed<K>(base, first + i) < k;
+    return first + cnt;
+  }
+
+  static size_t
+  count_less(char const* base, size_t n, uint64_t k, uchar w)
+  {
+    switch (w) {
+    case 1:  return count_less<uint8_t>(base, n, k);
+    case 2:  return count_less<uint16_t>(base, n, k);
+    case 4:  return count_less<uint32_t>(base, n, k);
+    default: return count_less<uint64_t>(base, n, k);
+    }
+  }
+
+  size_t
+  blockwrite(std::ostream& out,
+             std::vector<std::pair<uint64_t,uint64_t> > const& entries)
+  {
+    const size_t n = entries.size();
+    if (n == 0) return 0;
+
+    uint64_t maxval = 0;
+    for (size_t i = 0; i < n; ++i) {
+      if (i > 0) assert(entries[i-1].first < entries[i].first);
+      if (entries[i].second > maxval) maxval = entries[i].second;
+    }
+    const uchar kw = width(entries.back().first);
+    const uchar vw = width(maxval);
+
+    size_t cnt = 1;
+    out.put(char(kw | (vw << 4)));
+    for (size_t x = n; ; x >>= 7) {
+      ++cnt;
+      if (x < 128) { out.put(char(x)); break; }
+      out.put(char((x & 127) | 128));
+    }
+
+    const size_t nskips = n > BLOCK_INDEX_STRIDE ? (n-1) / BLOCK_INDEX_STRIDE : 0;
+    for (size_t j = 1; j <= nskips; ++j)
+      putfixed(out, entries[j*BLOCK_INDEX_STRIDE].first, kw);
+    for (size_t i = 0; i < n; ++i)
+      putfixed(out, entries[i].first, kw);
+    for (size_t i = 0; i < n; ++i)
+      putfixed(out, entries[i].second, vw);
+    return cnt + (nskips + n) * kw + n * vw;
+  }
+
+  BlockIndex::
+  BlockIndex(char const* start, char const* stop)
+    : skips(NULL), keys(NULL), vals(NULL), n(0), nskips(0), kw(1), vw(1)
+  {
+    if (start == stop) return;
+    char const* p = start;
+    kw = uchar(*p) & 15;
+    vw = uchar(*p) >> 4;
+    ++p;
+    for (int shift = 0; p < stop; shift += 7) {
+      const uchar c = *p++;
+      n += size_t(c & 127) << shift;
+      if (c < 128) break;
+    }
+    nskips = n > BLOCK_INDEX_STRIDE ? (n-1) / BLOCK_INDEX_STRIDE : 0;
+    skips = p;
+    keys = skips + nskips * kw;
+    vals = keys + n * kw;
+    if ((kw != 1 && kw != 2 && kw != 4 && kw != 8) ||
+        (vw != 1 && vw != 2 && vw != 4 && vw != 8) ||
+        vals + n * vw != stop)
+      cerr << efatal << "Corrupt block index at " << (void*)start << "." << exit_1;
+  }
+
+  uint64_t
+  BlockIndex::
+  key(size_t i) const
+  {
+    assert(i < n);
+    return getfixed(keys, i, kw);
+  }
+
+  uint64_t
+  BlockIndex::
+  value(size_t i) const
+  {
+    assert(i < n);
+    return getfixed(vals, i, vw);
+  }
+
+  size_t
+  BlockIndex::
+  lower_bound(uint64_t k) const
+  {
+    // Skip entry j-1 is the first key of block j, so the number of skip
+    // entries < k is the block where the first key >= k, if any, starts.
+    const size_t b = nskips ? count_less(skips, nskips, k, kw) : 0;
+    const size_t first = b * BLOCK_INDEX_STRIDE;
+    const size_t len = std::min(BLOCK_INDEX_STRIDE, n - first);
+    return first + count_less(keys + first * kw, len, k, kw);
+  }
+
+  bool
+  blockfind(char const* start, char const* stop, id_type key,
+            unsigned char& flags, filepos_type& val)
+  {
+    if (start == stop) return false;
+    BlockIndex idx(start, stop);
+    const uint64_t k = uint64_t(key) << FLAGBITS;
+    const size_t i = idx.lower_bound(k);
+    if (i == idx.size()) return false;
+    const uint64_t found = idx.key(i);
+    if ((found >> FLAGBITS) != key) return false;
+    flags = found & FLAGMASK;
+    val = idx.value(i);
+    return true;
+  }
+
+  bool
+  blockfind_noflags(char const* start, char const* stop, id_type key,
+                    filepos_type& val)
+  {
+    if (start == stop) return false;
+    BlockIndex idx(start, stop);
+    const size_t i = idx.lower_bound(key);
+    if (i == idx.size() || idx.key(i) != key) return false;
+    val = idx.value(i);
+    return true;
+  }
+
+  void
+  readindex(int fmt, char const* start, char const* stop,
+            std::vector<std::pair<uint64_t,uint64_t> >& entries)
+  {
+    entries.clear();
+    if (fmt == BLOCK_INDEX) {
+      if (start == stop) return;
+      BlockIndex idx(start, stop);
+      entries.reserve(idx.size());
+      for (size_t i = 0; i < idx.size(); ++i)
+        entries.push_back(std::make_pair(idx.key(i), idx.value(i)));
+    } else {
+      uint64_t key, val;
+      for (char const* p = start; p < stop;) {
+        p = tightread(p, stop, key);
+        p = tightread(p, stop, val);
+        entries.push_back(std::make_pair(key, val));
+      }
+    }
+  }
+}
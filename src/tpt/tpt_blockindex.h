@@ -0,0 +1,149 @@
+/**
+ * @file tpt_blockindex.h
+ * @brief Version 2 encoding of trie node indices, with fixed-stride keys and
+ *        values.
+ *
+ * The original ("tight") node index, written by tightwrite(), interleaves
+ * keys and values as 7-bit varints, so tightfind() has to resynchronize on
+ * the flag bits after each jump and finishes with a byte-at-a-time linear
+ * search.  On cold pages, every probe costs a page fault.
+ *
+ * A block index stores the same sorted (key, value) pairs as:
+ *    - one control byte: key width in the low nibble, value width in the high
+ *      nibble, in bytes (1, 2, 4 or 8, chosen per node from its largest key
+ *      and value);
+ *    - the number of entries n, as a 7-bit varint;
+ *    - if n > BLOCK_INDEX_STRIDE, a skip array holding the first key of each
+ *      block of BLOCK_INDEX_STRIDE keys except the first block;
+ *    - the n keys, then the n values, each array at a fixed stride.
+ * A lookup searches the skip array, then a single block of keys, and reads
+ * its value directly, so it touches at most three small contiguous areas.
+ * Within a block and at the end of each search, keys are compared with a
+ * branch-free linear count that the compiler can vectorize.
+ *
+ * The index format of a TPPT/TPLDM is recorded in its config file, and that
+ * of a TPLM in its optional config file; models without a format marker use
+ * the tight index.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef __ugBlockIndex
+#define __ugBlockIndex
+
+#include <iostream>
+#include <vector>
+#include <utility>
+#include <cstring>
+#include "tpt_typedefs.h"
+#include "tpt_tightindex.h"
+
+namespace ugdiss
+{
+  /// On-disk encodings of the trie node indices.
+  enum IndexFormat {
+    TIGHT_INDEX = 1, ///< original interleaved varints (tightwrite())
+    BLOCK_INDEX = 2  ///< fixed-stride keys and values with skip blocks
+  };
+
+  /// Number of keys per skip block in a block index.
+  static const size_t BLOCK_INDEX_STRIDE = 64;
+
+  /** Write a node index in block format.
+   *  @param out      output stream
+   *  @param entries  (key, value) pairs, sorted by key, keys unique
+   *  @return number of bytes written; 0 if entries is empty
+   */
+  size_t
+  blockwrite(std::ostream& out,
+             std::vector<std::pair<uint64_t,uint64_t> > const& entries);
+
+  /** Read-only view of a block node index in [start,stop). */
+  class BlockIndex
+  {
+    char const* skips;
+    char const* keys;
+    char const* vals;
+    size_t n;        ///< number of entries
+    size_t nskips;   ///< number of entries in the skip array
+    uchar kw;        ///< key width in bytes
+    uchar vw;        ///< value width in bytes
+  public:
+    BlockIndex(char const* start, char const* stop);
+
+    size_t size() const { return n; }
+
+    /// Key of entry i.
+    uint64_t key(size_t i) const;
+
+    /// Value of entry i.
+    uint64_t value(size_t i) const;
+
+    /// Index of the first entry whose key is >= k; size() if none.
+    size_t lower_bound(uint64_t k) const;
+  };
+
+  /** Find key in the block index [start,stop) of a trie with flag bits in the
+   *  low FLAGBITS of its keys, as tightfind() does for tight indices.
+   *  @param flags  set to the flags of the entry found
+   *  @param val    set to the value of the entry found
+   *  @return true iff key was found
+   */
+  bool
+  blockfind(char const* start, char const* stop, id_type key,
+            unsigned char& flags, filepos_type& val);
+
+  /** Find key in the block index [start,stop) of a trie without flag bits,
+   *  as tightfind_noflags() does for tight indices.
+   *  @param val    set to the value of the entry found
+   *  @return true iff key was found
+   */
+  bool
+  blockfind_noflags(char const* start, char const* stop, id_type key,
+                    filepos_type& val);
+
+  /** Find key in the node index [start,stop) written in format fmt.
+   *  Same as blockfind() or tightfind() followed by tightread().
+   */
+  inline bool
+  indexfind(int fmt, char const* start, char const* stop, id_type key,
+            unsigned char& flags, filepos_type& val)
+  {
+    if (fmt == BLOCK_INDEX)
+      return blockfind(start, stop, key, flags, val);
+    char const* p = tightfind(start, stop, key, flags);
+    if (!p) return false;
+    tightread(p, stop, val);
+    return true;
+  }
+
+  /** Find key in the flagless node index [start,stop) written in format fmt.
+   *  Same as blockfind_noflags() or tightfind_noflags() followed by
+   *  tightread().
+   */
+  inline bool
+  indexfind_noflags(int fmt, char const* start, char const* stop, id_type key,
+                    filepos_type& val)
+  {
+    if (fmt == BLOCK_INDEX)
+      return blockfind_noflags(start, stop, key, val);
+    char const* p = tightfind_noflags(start, stop, key);
+    if (!p) return false;
+    tightread(p, stop, val);
+    return true;
+  }
+
+  /** Read all the entries of the node index [start,stop) written in format
+   *  fmt, in key order.
+   *  @param entries  cleared, then filled with the (key, value) pairs
+   */
+  void
+  readindex(int fmt, char const* start, char const* stop,
+            std::vector<std::pair<uint64_t,uint64_t> >& entries);
+
+}
+#endif
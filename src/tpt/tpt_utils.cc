@@ -48,6 +48,15 @@ getFileSize(const std::string& fname)
   return buf.st_size;
 }
 
+uint64_t
+getFileMTime(const std::string& fname)
+{
+  struct stat64 buf;
+  if (stat64(fname.c_str(),&buf) < 0)
+    return -1;
+  return buf.st_mtime;
+}
+
 void
 open_mapped_file_source(bio::mapped_file_source& mfs, const string& fname)
 {
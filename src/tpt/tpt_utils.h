@@ -37,6 +37,10 @@ namespace ugdiss {
 /// @return the size of file fname, or -1 in case of error.
 uint64_t getFileSize(const std::string& fname);
 
+/// @return the last modification time of file fname, in seconds since the
+/// epoch, or -1 in case of error.
+uint64_t getFileMTime(const std::string& fname);
+
 /**
  * Open a memory mapped file for reading, outputting an error if not successful.
  * @param mfs   memory mapped file source
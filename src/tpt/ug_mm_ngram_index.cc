@@ -0,0 +1,117 @@
+/**
+ * @file ug_mm_ngram_index.cc
+ * @brief Memory mapped inverted index from n-grams to sentences.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cstring>
+#include <sstream>
+
+#include "ug_mm_ngram_index.h"
+#include "ug_mm_sufa.h"
+#include "tpt_pickler.h"
+#include "tpt_utils.h"
+
+namespace ugdiss
+{
+  using namespace std;
+
+  char const* const mmNgramIndex::magic = "mmNgIdx2";
+
+  mmNgramIndex::
+  mmNgramIndex()
+    : n(0), numSent(0), ctSize(0), ctMTime(0), numKeys(0), postings(NULL), keys(NULL), offsets(NULL)
+  {}
+
+  void
+  mmNgramIndex::
+  open(const string& fname)
+  {
+    open_mapped_file_source(file, fname);
+    const uint64_t fSize = getFileSize(fname);
+    char const* p = file.data();
+    if (fSize < headerSize || strncmp(p, magic, 8) != 0)
+      cerr << efatal << "Bad n-gram index file '" << fname << "', or index"
+           << " built by an older version; rebuild it with mmngramindex.build."
+           << exit_1;
+    p += 8;
+    uint64_t order, sents, mctSize, mctMTime, nkeys, keysStart, offsetsStart;
+    p = numread(p, order);
+    p = numread(p, sents);
+    p = numread(p, mctSize);
+    p = numread(p, mctMTime);
+    p = numread(p, nkeys);
+    p = numread(p, keysStart);
+    p = numread(p, offsetsStart);
+    if (order == 0 || keysStart < headerSize || offsetsStart % 8 != 0 ||
+        offsetsStart < keysStart + nkeys * order * sizeof(id_type) ||
+        fSize != offsetsStart + (nkeys + 1) * sizeof(uint64_t))
+      cerr << efatal << "Bad n-gram index file '" << fname << "'." << exit_1;
+    n        = order;
+    numSent  = sents;
+    ctSize   = mctSize;
+    ctMTime  = mctMTime;
+    numKeys  = nkeys;
+    postings = reinterpret_cast<id_type const*>(file.data() + headerSize);
+    keys     = reinterpret_cast<id_type const*>(file.data() + keysStart);
+    offsets  = reinterpret_cast<uint64_t const*>(file.data() + offsetsStart);
+    if (offsets[numKeys] * sizeof(id_type) != keysStart - headerSize)
+      cerr << efatal << "Bad n-gram index file '" << fname << "'." << exit_1;
+  }
+
+  void
+  mmNgramIndex::
+  close()
+  {
+    if (file.is_open()) file.close();
+    n = numSent = numKeys = 0;
+    ctSize = ctMTime = 0;
+    postings = keys = NULL;
+    offsets = NULL;
+  }
+
+  bool
+  mmNgramIndex::
+  matchesCorpusTrack(const string& mctFile) const
+  {
+    return getFileSize(mctFile) == ctSize && getFileMTime(mctFile) == ctMTime;
+  }
+
+  bool
+  mmNgramIndex::
+  find(id_type const* ngram, id_type const*& start, id_type const*& stop) const
+  {
+    // binary search for ngram among the keys, compared lexicographically
+    size_t lo = 0, hi = numKeys;
+    while (lo < hi)
+      {
+        const size_t mid = lo + (hi - lo) / 2;
+        id_type const* k = keys + mid * n;
+        size_t i = 0;
+        while (i < n && k[i] == ngram[i]) ++i;
+        if (i == n)
+          {
+            start = postings + offsets[mid];
+            stop  = postings + offsets[mid+1];
+            return true;
+          }
+        if (k[i] < ngram[i]) lo = mid + 1;
+        else hi = mid;
+      }
+    start = stop = postings;
+    return false;
+  }
+
+  string
+  ngram_index_filename(const string& basename, size_t n)
+  {
+    ostringstream fname;
+    fname << memory_mapped_suffix_array_base(basename) << "ngi" << n;
+    return fname.str();
+  }
+}
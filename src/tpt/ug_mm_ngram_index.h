@@ -0,0 +1,103 @@
+/**
+ * @file ug_mm_ngram_index.h
+ * @brief Memory mapped inverted index from n-grams to the sentences of a
+ *        corpus track that contain them.
+ *
+ * The index is a companion to a memory mapped suffix array: it is built from
+ * the corpus track and the suffix array by mmngramindex.build, for one n-gram
+ * order, and stored next to them as file ngiN (e.g., ngi3 for trigrams).  For
+ * each distinct n-gram of the corpus, it holds the sorted list of the ids of
+ * the sentences that contain it (its posting list), each id once.  Ranked
+ * retrieval, e.g., find_similar_sentences, can then walk or probe the posting
+ * lists of a query's n-grams directly.
+ *
+ * File layout, in native byte order:
+ *    - the header: the 8-byte magic string "mmNgIdx2", then the n-gram order,
+ *      the number of sentences in the corpus track, the size and the
+ *      modification time of the corpus track file (mct), the number of
+ *      distinct n-grams K, and the file positions of the keys and of the
+ *      offsets, each as a uint64_t;
+ *    - the posting lists, as id_type arrays;
+ *    - the keys: the K n-grams as n id_type each, in the suffix array order,
+ *      i.e., sorted lexicographically by token id;
+ *    - padding to a multiple of 8 bytes, then K+1 uint64_t offsets: posting
+ *      list i is at positions [offsets[i], offsets[i+1]) of the postings.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef __ug_mm_ngram_index
+#define __ug_mm_ngram_index
+
+#include <string>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "tpt_typedefs.h"
+
+namespace ugdiss
+{
+  using namespace std;
+  namespace bio=boost::iostreams;
+
+  class mmNgramIndex
+  {
+  public:
+    /// Identifies n-gram index files, and their format version.
+    static char const* const magic;
+    /// Size of the file header, in bytes.
+    static const size_t headerSize = 8 + 7 * sizeof(uint64_t);
+
+  private:
+    bio::mapped_file_source file;
+    size_t          n;         // n-gram order
+    size_t          numSent;   // number of sentences in the corpus track
+    uint64_t        ctSize;    // size of the corpus track file
+    uint64_t        ctMTime;   // modification time of the corpus track file
+    size_t          numKeys;   // number of distinct n-grams
+    id_type const*  postings;  // all the posting lists
+    id_type const*  keys;      // numKeys n-grams, n ids each
+    uint64_t const* offsets;   // numKeys+1 positions in postings
+
+  public:
+    mmNgramIndex();
+    /// Open index file fname.
+    void open(const string& fname);
+    /// Close the index, if open.
+    void close();
+    /// @return true iff an index is open
+    bool isOpen() const { return keys != NULL; }
+
+    /// @return the n-gram order of the index
+    size_t order() const { return n; }
+    /// @return the number of sentences of the indexed corpus track
+    size_t numSentences() const { return numSent; }
+    /// @return the number of distinct n-grams in the index
+    size_t size() const { return numKeys; }
+
+    /** Check that the index was built from corpus track file mctFile as it
+     *  is now, i.e., that the file has the size and modification time it had
+     *  then.
+     *  @return false if the index is stale and must be rebuilt
+     */
+    bool matchesCorpusTrack(const string& mctFile) const;
+
+    /** Find the posting list of an n-gram.
+     *  @param ngram  order() token ids
+     *  @param start  set to the first sentence id of the list
+     *  @param stop   set to the end of the list
+     *  @return false, with start == stop, if ngram does not occur
+     */
+    bool find(id_type const* ngram, id_type const*& start, id_type const*& stop) const;
+  };
+
+  /** @return the name of the order-n n-gram index file of the memory mapped
+   *  suffix array basename, resolved as open_memory_mapped_suffix_array()
+   *  does for the other files.
+   */
+  string ngram_index_filename(const string& basename, size_t n);
+}
+#endif
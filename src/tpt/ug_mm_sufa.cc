@@ -410,19 +410,24 @@ namespace ugdiss
     cerr << "OK\n";
   }
 
+  string
+  memory_mapped_suffix_array_base(const string& basename)
+  {
+     if (!access((basename + ".tpsa/msa").c_str(), F_OK))
+       return basename + ".tpsa/";
+     else if (!access((basename + "/msa").c_str(), F_OK))
+       return basename + "/";
+     else
+       return basename + ".";
+  }
+
   void
   open_memory_mapped_suffix_array(const string& basename,
                                   TokenIndex& token_index,
                                   mmCtrack& corpus_track,
                                   mmSufa& suffix_array)
   {
-     string base;
-     if (!access((basename + ".tpsa/msa").c_str(), F_OK))
-       base = basename + ".tpsa/";
-     else if (!access((basename + "/msa").c_str(), F_OK))
-       base = basename + "/";
-     else
-       base = basename + ".";
+     const string base = memory_mapped_suffix_array_base(basename);
 
      token_index.open(base+"tdx");
      token_index.iniReverseIndex();
@@ -84,6 +84,13 @@ namespace ugdiss
     bool over();
   };
 
+  /** @return the common prefix of the names of the files of the memory
+   *  mapped suffix array basename: basename.tpsa/, basename/ or basename.,
+   *  depending on which exists.
+   */
+  string
+  memory_mapped_suffix_array_base(const string& basename);
+
   /** Open the three memory mapped files associated with a suffix array.
    * @param basename base name for the file
    * @param token_index return TokenIndex for the corpus.
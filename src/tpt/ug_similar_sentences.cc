@@ -0,0 +1,239 @@
+/**
+ * @file ug_similar_sentences.cc
+ * @brief Retrieval of the corpus sentences most similar to a query sentence.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <queue>
+#include <map>
+#include <algorithm>
+#include <functional>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include "ug_similar_sentences.h"
+#include "tpt_tightindex.h"
+
+namespace ugdiss
+{
+  using namespace std;
+
+  typedef SimilarSentenceFinder::Match Match;
+
+  namespace
+  {
+    /// Best topN matches, kept as a min-heap: the worst of them is on top.
+    class TopMatches
+    {
+      vector<Match> heap;
+      size_t topN;
+    public:
+      TopMatches(size_t topN) : topN(topN) {}
+      bool full() const { return heap.size() >= topN; }
+      /// @return the similarity a new match must reach to get in, once full()
+      float worst() const { return heap.front().first; }
+      void add(Match const& m)
+      {
+        heap.push_back(m);
+        push_heap(heap.begin(), heap.end(), greater<Match>());
+        if (heap.size() > topN)
+          {
+            pop_heap(heap.begin(), heap.end(), greater<Match>());
+            heap.pop_back();
+          }
+      }
+      /// Move the matches to v, best first.
+      void get(vector<Match>& v)
+      {
+        sort_heap(heap.begin(), heap.end(), greater<Match>());
+        v.swap(heap);
+      }
+    };
+
+    /// A query n-gram's posting list, with a cursor.
+    struct Posting
+    {
+      id_type const* cur;
+      id_type const* stop;
+      size_t weight;       // number of occurrences of the n-gram in the query
+      bool operator<(Posting const& other) const
+      { return stop-cur > other.stop-other.cur; }
+    };
+
+    /// Advance p.cur to the first sentence id >= sid, by galloping.
+    inline void
+    seek(Posting& p, id_type sid)
+    {
+      if (p.cur == p.stop || *p.cur >= sid) return;
+      size_t step = 1;
+      id_type const* lo = p.cur;
+      while (lo + step < p.stop && lo[step] < sid)
+        {
+          lo += step;
+          step *= 2;
+        }
+      p.cur = lower_bound(lo + 1, min(lo + step + 1, p.stop), sid);
+    }
+  }
+
+  /// Similarity of a sentence with matches n-gram matches, for query and
+  /// candidate sentence lengths qlen and olen.
+  static inline float
+  similarity(size_t matches, size_t qlen, size_t olen, size_t ngs)
+  {
+    return (2.*matches)/(qlen+olen-2*(ngs-1));
+  }
+
+  SimilarSentenceFinder::
+  SimilarSentenceFinder(mmCtrack const& C, mmSufa const& S,
+                        mmNgramIndex const& X,
+                        size_t topN, size_t ngSize, float minSim)
+    : C(C), S(S), X(X), topN(topN), ngSize(ngSize), minSim(minSim)
+  {}
+
+  void
+  SimilarSentenceFinder::
+  find(vector<id_type> const& snt, vector<Match>& best) const
+  {
+    if (X.isOpen() && snt.size() >= X.order())
+      findCandidatesInIndex(snt, best);
+    else
+      findCandidates(snt, best);
+  }
+
+  void
+  SimilarSentenceFinder::
+  findCandidates(vector<id_type> const& snt, vector<Match>& best) const
+  {
+    best.clear();
+    const size_t ngs = min(ngSize,snt.size());
+    if (ngs == 0) return;
+
+    map<id_type,short> ngmatch;
+
+    typedef std::vector<id_type>::const_iterator iter;
+    for (iter p = snt.begin(); p+ngs <= snt.end(); ++p)
+      {
+        char const* x = S.lower_bound(p,p+ngs);
+        if (!x) continue;
+        boost::dynamic_bitset<uint64_t> check(S.getCorpusSize());
+        id_type sid,off;
+        for (char const* const z = S.upper_bound(p,p+ngs); x < z;)
+          {
+            x = tightread(x,z,sid);
+            x = tightread(x,z,off);
+            if (check[sid]) continue;
+            check.set(sid);
+            ngmatch[sid]++;
+          }
+      }
+    priority_queue<Match> Q;
+    typedef map<id_type,short>::iterator miter;
+    for (miter m = ngmatch.begin(); m != ngmatch.end(); ++m)
+      {
+        size_t olen = C.sntEnd(m->first)-C.sntStart(m->first);
+        float x = similarity(m->second, snt.size(), olen, ngs);
+        if (x > minSim)
+          Q.push(Match(x,m->first));
+      }
+    for (size_t i = 1; Q.size() && i <= topN; ++i)
+      {
+        best.push_back(Q.top());
+        Q.pop();
+      }
+  }
+
+  /* A candidate sentence with m matching query n-grams has similarity
+   * 2m/(q+s), where q and s are the numbers of n-grams in the query and in
+   * the candidate, s >= 1; it needs similarity > minSim, and at least that of
+   * the worst match so far once topN have been found.  The posting lists are
+   * sorted longest first; the longest ones, whose total weight W can't give a
+   * high enough similarity on its own, i.e., 2W/(q+1) is too low, are not
+   * traversed ("non-essential" lists, as in MaxScore).  Candidates come from
+   * the other lists, traversed in parallel in sentence id order, and are
+   * looked up in the non-essential lists only while their similarity can
+   * still be high enough.  Since candidates come in increasing sentence id
+   * order, as in findCandidates() a later candidate wins a tie.
+   */
+  void
+  SimilarSentenceFinder::
+  findCandidatesInIndex(vector<id_type> const& snt, vector<Match>& best) const
+  {
+    const size_t ngs = X.order();
+    const size_t q = snt.size() - ngs + 1;
+    TopMatches top(topN);
+
+    vector<Posting> lists;
+    {
+      map<vector<id_type>, size_t> weights;
+      for (size_t i = 0; i < q; ++i)
+        ++weights[vector<id_type>(snt.begin()+i, snt.begin()+i+ngs)];
+      for (map<vector<id_type>, size_t>::const_iterator w = weights.begin();
+           w != weights.end(); ++w)
+        {
+          Posting p;
+          p.weight = w->second;
+          if (X.find(&w->first[0], p.cur, p.stop))
+            lists.push_back(p);
+        }
+    }
+    sort(lists.begin(), lists.end());
+
+    // lists[0,numNonEssential) are non-essential, with total weight nonEssentialWeight.
+    size_t numNonEssential = 0, nonEssentialWeight = 0;
+    for (;;)
+      {
+        // Move lists to the non-essential set while that keeps it hopeless.
+        while (numNonEssential < lists.size())
+          {
+            const size_t w = nonEssentialWeight + lists[numNonEssential].weight;
+            const float bound = similarity(w, q, 1, 1);
+            if (bound > minSim && !(top.full() && bound < top.worst()))
+              break;
+            nonEssentialWeight = w;
+            ++numNonEssential;
+          }
+
+        // Next candidate: the smallest sentence id in the essential lists.
+        id_type sid = 0;
+        bool found = false;
+        for (size_t i = numNonEssential; i < lists.size(); ++i)
+          if (lists[i].cur < lists[i].stop && (!found || *lists[i].cur < sid))
+            {
+              sid = *lists[i].cur;
+              found = true;
+            }
+        if (!found) break;
+        size_t m = 0;
+        for (size_t i = numNonEssential; i < lists.size(); ++i)
+          if (lists[i].cur < lists[i].stop && *lists[i].cur == sid)
+            {
+              m += lists[i].weight;
+              ++lists[i].cur;
+            }
+
+        // Probe the non-essential lists, shortest first, while it can pay off.
+        const size_t s = C.sntEnd(sid) - C.sntStart(sid) - ngs + 1;
+        size_t remaining = nonEssentialWeight;
+        bool hopeless = false;
+        for (size_t i = numNonEssential; !hopeless; )
+          {
+            const float bound = similarity(m + remaining, q, s, 1);
+            hopeless = bound <= minSim || (top.full() && bound < top.worst());
+            if (hopeless || i == 0) break;
+            Posting& p = lists[--i];
+            seek(p, sid);
+            if (p.cur < p.stop && *p.cur == sid) m += p.weight;
+            remaining -= p.weight;
+          }
+        if (!hopeless)
+          top.add(Match(similarity(m, q, s, 1), sid));
+      }
+    top.get(best);
+  }
+}
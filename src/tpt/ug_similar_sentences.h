@@ -0,0 +1,76 @@
+/**
+ * @file ug_similar_sentences.h
+ * @brief Retrieval of the corpus sentences most similar to a query sentence,
+ *        for find_similar_sentences.
+ *
+ * Similarity is the Dice coefficient of the n-grams of the two sentences,
+ * i.e., the number of query n-grams that occur in the corpus sentence, times
+ * two, divided by the total number of n-grams in both sentences.  A query
+ * n-gram that occurs twice is counted twice.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef __ug_similar_sentences
+#define __ug_similar_sentences
+
+#include <vector>
+#include <utility>
+
+#include "tpt_typedefs.h"
+#include "ug_mm_ctrack.h"
+#include "ug_mm_sufa.h"
+#include "ug_mm_ngram_index.h"
+
+namespace ugdiss
+{
+  using namespace std;
+
+  class SimilarSentenceFinder
+  {
+  public:
+    typedef pair<float,id_type> Match;  // (similarity, sentence id)
+
+  private:
+    mmCtrack const&     C;
+    mmSufa const&       S;
+    mmNgramIndex const& X;
+    size_t topN;   // number of matches to return
+    size_t ngSize; // n-gram size
+    float  minSim; // a match must have a similarity > minSim
+
+  public:
+    /** @param C       the corpus track
+     *  @param S       its suffix array
+     *  @param X       its n-gram index; not used unless open
+     *  @param topN    number of matches to return
+     *  @param ngSize  n-gram size; must be X.order() if X is open
+     *  @param minSim  minimum similarity, not included
+     */
+    SimilarSentenceFinder(mmCtrack const& C, mmSufa const& S,
+                          mmNgramIndex const& X,
+                          size_t topN, size_t ngSize, float minSim);
+
+    /** Find the topN most similar sentences to snt, with the n-gram index
+     *  when it is open and snt has at least ngSize tokens, with the suffix
+     *  array otherwise.
+     *  @param snt   the query, as token ids
+     *  @param best  set to the matches, best first; among matches with the
+     *               same similarity, the higher sentence id comes first
+     */
+    void find(vector<id_type> const& snt, vector<Match>& best) const;
+
+    /// Same as find(), with the suffix array.
+    void findCandidates(vector<id_type> const& snt, vector<Match>& best) const;
+
+    /// Same as find(), with the n-gram index, which must be open;
+    /// snt must have at least ngSize tokens.
+    void findCandidatesInIndex(vector<id_type> const& snt,
+                               vector<Match>& best) const;
+  };
+}
+#endif
@@ -180,6 +180,9 @@ namespace ugdiss
     char const* 
     upper_bound(id_type const* keyStart, id_type const* keyStop) const;
 
+    /** @return the beginning and end of the whole index, in suffix order */
+    char const* arrayStart() const { return data;    }
+    char const* arrayEnd()   const { return endData; }
 
     /** sample one element randomly in [p,q) */
     virtual
@@ -85,6 +85,9 @@ Getopt::Long::GetOptions(
    'lmorder=i'       => \my $lmOrder,     # LM order for target language TC LM
    'srclm=s'         => \my $srclm_file,  # source language NC1 LM
 
+   # Use canoe instead of truecase_decode for basic truecasing
+   'canoe!'          => \my $use_canoe,
+
    # Flags for basic truecasing target language text using SRILM
    'uselmonly!'      => \my $use_lmOnly,
    'srilm!'          => \my $use_srilm,
@@ -237,6 +240,14 @@ if ($use_srilm) { # using disambig
                 . ($use_lmOnly ? "" : " -map $map_file")
                 . " -keep-unk"
                 . ($use_viterbi ? "" : " -fb");
+} elsif (!$use_canoe) { # using truecase_decode
+   print STDERR "truecase.pl: using truecase_decode.\n" if $verbose;
+   $cmd_part1 = "set -o pipefail; "
+                . "truecase_decode" . ($verbose > 1 ? " -v" : "")
+                . " -lm " . (defined $tplm ? $tplm : $lm_file)
+                . " -map " . (defined $tppt ? $tppt : $map_file)
+                . (defined $lmOrder ? " -lmorder $lmOrder" : "")
+                . " -beam 100 -variants 100 $in_file";
 } else { # using canoe
    my ($ttable_type, $ttable_file, $model_file);
    if (defined $tplm) {
@@ -472,12 +483,12 @@ the heuristic otherwise.
 =item -lm LM_FILE
 
 Target language truecasing Language Model (NGram file) to use.
-Can be in text or binlm format (with canoe), GZIP or uncompressed;
+Can be in text or binlm format (without SRILM), GZIP or uncompressed;
 (use -tplm for tplm format). One of -lm or -tplm is required.
 
 =item -map MAP_FILE
 
-V1 to V2 vocabulary mapping model. One of -map or -tppt is required with canoe.
+V1 to V2 vocabulary mapping model. One of -map or -tppt is required without SRILM.
 
 =item -lmOrder N
 
@@ -486,12 +497,12 @@ Effective N-gram order used by the target language TC LM model.
 =item -tplm TPLM_FILE
 
 Target language TC Language Model in TPLM format.
-Valid with canoe only, not SRILM. -tplm and -tppt must be used together.
+Not valid with SRILM. -tplm and -tppt must be used together.
 
 =item -tppt TPPT_FILE
 
 V1 to V2 phrase table in TPPT format. (Use vocabMap2tpt.sh to create the TPPT).
-Valid with canoe only, not SRILM. -tplm and -tppt must be used together.
+Not valid with SRILM. -tplm and -tppt must be used together.
 
 =item -srclm SRC_NC1_LM_FILE
 
@@ -544,8 +555,8 @@ encoding (e.g. C<utf8>). Correctly uppercases accented characters.
 
 =item -useSRILM
 
-Use SRILM disambig instead of canoe to perform the truecasing.
-The default is to use canoe.
+Use SRILM disambig instead of truecase_decode to perform the truecasing.
+The default is to use truecase_decode.
 
 =item -useViterbi
 
@@ -561,6 +572,11 @@ Use only the given NGram model with SRILM disambig; no V1-to-V2 mapping used.
 
 =over 12
 
+=item -canoe
+
+Truecase with a canoe process, as previous versions did, instead of the
+equivalent but much faster truecase_decode.
+
 =item -xtra-cm-opts OPTS
 
 Specify additional C<casemark.py -r> options. Valid only with -src.
@@ -0,0 +1,114 @@
+/**
+ * @file truecase_decode.cc
+ * @brief Truecase lowercase text with a casing map and a truecasing LM.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "truecaser.h"
+#include "file_utils.h"
+#include "arg_reader.h"
+#include "printCopyright.h"
+#include "exception_dump.h"  // MAIN
+
+using namespace Portage;
+using namespace std;
+
+static char help_message[] = "\n\
+truecase_decode [options] -lm LM -map MAP [INFILE [OUTFILE]]\n\
+\n\
+  Truecase the tokenized lowercase text in INFILE [-], one sentence per line,\n\
+  writing the result to OUTFILE [-].  Each token is replaced by the casing\n\
+  variant from MAP that maximizes the product of the map probabilities and\n\
+  the LM probability of the whole sentence, found with a monotone Viterbi\n\
+  search; tokens not in MAP are left unchanged.\n\
+\n\
+  This is the first step of truecase.pl, done without starting canoe, and\n\
+  with the same results as its canoe-based implementation.\n\
+\n\
+Options:\n\
+\n\
+  -v             Write progress reports to cerr.\n\
+  -lm LM         Truecasing LM, in any format canoe accepts (required).\n\
+  -map MAP       Casing map produced by compile_truecase_map, or a TPPT built\n\
+                 from it (required).\n\
+  -lmorder N     Limit the LM order to N [0: no limit].\n\
+  -beam B        Keep the B best hypotheses at each position [100].\n\
+  -variants V    Consider the V most probable variants of each token [100].\n\
+  -flush         Flush the output after each line, e.g., to use as a\n\
+                 co-process.\n\
+";
+
+static bool verbose = false;
+static bool flush_lines = false;
+static string lm_file;
+static string map_file;
+static Uint lm_order = 0;
+static Uint beam = 100;
+static Uint max_variants = 100;
+static string infile("-");
+static string outfile("-");
+static void getArgs(int argc, const char* const argv[]);
+
+int MAIN(argc, argv)
+{
+   printCopyright(2026, "truecase_decode");
+   getArgs(argc, argv);
+
+   if (verbose) cerr << "Loading models" << endl;
+   TrueCaser tc(lm_file, map_file, lm_order, beam, max_variants);
+   if (verbose) cerr << "Truecasing " << infile << endl;
+
+   iSafeMagicStream in(infile);
+   oSafeMagicStream out(outfile);
+   string line;
+   vector<string> tokens;
+   Uint line_num = 0;
+   while (getline(in, line)) {
+      tokens.clear();
+      split(line, tokens);
+      tc.truecase(tokens);
+      out << join(tokens) << '\n';
+      if (flush_lines) out.flush();
+      ++line_num;
+      if (verbose && line_num % 1000 == 0)
+         cerr << "[" << line_num << "]" << endl;
+   }
+   if (verbose) cerr << "Truecased " << line_num << " lines" << endl;
+
+   return 0;
+}
+END_MAIN
+
+// arg processing
+
+void getArgs(int argc, const char* const argv[])
+{
+   const char* switches[] = {"v", "flush", "lm:", "map:", "lmorder:", "beam:",
+                             "variants:"};
+   ArgReader arg_reader(ARRAY_SIZE(switches), switches, 0, 2, help_message);
+   arg_reader.read(argc-1, argv+1);
+
+   arg_reader.testAndSet("v", verbose);
+   arg_reader.testAndSet("flush", flush_lines);
+   arg_reader.testAndSet("lm", lm_file);
+   arg_reader.testAndSet("map", map_file);
+   arg_reader.testAndSet("lmorder", lm_order);
+   arg_reader.testAndSet("beam", beam);
+   arg_reader.testAndSet("variants", max_variants);
+   arg_reader.testAndSet(0, "infile", infile);
+   arg_reader.testAndSet(1, "outfile", outfile);
+
+   if (lm_file.empty())
+      error(ETFatal, "-lm is required");
+   if (map_file.empty())
+      error(ETFatal, "-map is required");
+   if (beam == 0)
+      error(ETFatal, "-beam must be at least 1");
+   if (max_variants == 0)
+      error(ETFatal, "-variants must be at least 1");
+}
@@ -0,0 +1,204 @@
+/**
+ * @file truecaser.cc
+ * @brief In-process monotone truecasing with a casing map and a truecasing LM.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "truecaser.h"
+#include "lm.h"
+#include "tppt.h"
+#include "file_utils.h"
+#include "str_utils.h"
+#include <tr1/unordered_set>
+#include <algorithm>
+#include <cmath>
+
+using namespace Portage;
+
+static const Uint NONE = Uint(-1);
+
+/// log10 unigram prob for LM OOVs, same as canoe's LOG_ALMOST_0
+static const float OOV_UNIGRAM_PROB = -18;
+
+struct TrueCaser::HypScoreGreater {
+   bool operator()(const Hyp& a, const Hyp& b) const { return a.score > b.score; }
+};
+
+TrueCaser::TrueCaser(const string& lm_file, const string& map_file, Uint lm_order,
+                     Uint beam, Uint max_variants)
+   : vocab(0)
+   , beam(beam ? beam : 1)
+   , max_variants(max_variants ? max_variants : 1)
+   , ctx_size(0)
+{
+   if (is_directory(map_file))
+      tppt.reset(new ugdiss::TpPhraseTable(map_file));
+   else
+      readMap(map_file);
+
+   lm.reset(PLM::Create(lm_file, &vocab, PLM::SimpleAutoVoc, OOV_UNIGRAM_PROB,
+                        false, lm_order, NULL));
+   if (!lm)
+      error(ETFatal, "Unable to load truecasing LM %s", lm_file.c_str());
+   ctx_size = lm->getOrder() ? lm->getOrder() - 1 : 0;
+}
+
+TrueCaser::~TrueCaser()
+{
+}
+
+void TrueCaser::readMap(const string& map_file)
+{
+   iSafeMagicStream is(map_file);
+   string line;
+   vector<string> toks;
+   while (getline(is, line)) {
+      splitZ(line, toks, "\t");
+      if (toks.empty() || toks[0].empty()) continue;
+      if (toks.size() % 2 != 1)
+         error(ETFatal, "Bad line in casing map %s: %s", map_file.c_str(), line.c_str());
+      vector<Variant>& v = variants[toks[0]];
+      v.clear();
+      for (Uint i = 1; i + 1 < toks.size(); i += 2) {
+         float prob;
+         if (!conv(toks[i+1], prob))
+            error(ETFatal, "Bad probability in casing map %s: %s",
+                  map_file.c_str(), line.c_str());
+         v.push_back(Variant(vocab.add(toks[i].c_str()), log10(prob)));
+      }
+      stable_sort(v.begin(), v.end());
+      if (v.size() > max_variants)
+         v.erase(v.begin() + max_variants, v.end());
+   }
+}
+
+void TrueCaser::getVariants(const string& token)
+{
+   token_variants.clear();
+   if (tppt) {
+      const vector<string> phrase(1, token);
+      ugdiss::TpPhraseTable::val_ptr_t cands = tppt->lookup(phrase, 0, 1);
+      if (cands) {
+         for (vector<ugdiss::TpPhraseTable::TCand>::const_iterator
+                 it(cands->begin()), end(cands->end()); it != end; ++it) {
+            // The map probability is in the forward column: "lc ||| tc ||| 1 p"
+            if (it->words.size() != 1 || it->score.size() < 2) continue;
+            token_variants.push_back(Variant(vocab.add(it->words[0].c_str()),
+                                             log10(it->score[it->score.size()/2])));
+         }
+         stable_sort(token_variants.begin(), token_variants.end());
+         if (token_variants.size() > max_variants)
+            token_variants.erase(token_variants.begin() + max_variants,
+                                 token_variants.end());
+      }
+   } else {
+      unordered_map<string, vector<Variant> >::const_iterator it = variants.find(token);
+      if (it != variants.end())
+         token_variants = it->second;
+   }
+   if (token_variants.empty())
+      token_variants.push_back(Variant(vocab.add(token.c_str()), 0));
+}
+
+void TrueCaser::recombineAndPrune(vector<Hyp>& stack)
+{
+   sort(stack.begin(), stack.end(), HypScoreGreater());
+   // Keep the best hypothesis for each LM state, up to the beam size
+   tr1::unordered_set<string> states;
+   Uint kept = 0;
+   for (Uint i = 0; i < stack.size() && kept < beam; ++i) {
+      const Hyp& h = stack[i];
+      const string state(contexts.empty() ? "" :
+                            reinterpret_cast<const char*>(&contexts[h.ctx_start]),
+                         h.ctx_len * sizeof(Uint));
+      if (states.insert(state).second)
+         stack[kept++] = h;
+   }
+   stack.resize(kept);
+}
+
+void TrueCaser::truecase(vector<string>& tokens)
+{
+   if (tokens.empty()) return;
+
+   const Uint n = tokens.size();
+   if (stacks.size() < n+1) stacks.resize(n+1);
+   contexts.clear();
+
+   // Initial hypothesis: just <s>
+   stacks[0].clear();
+   Hyp start = { 0.0, NONE, vocab.add(PLM::SentStart), 0, 0 };
+   if (ctx_size > 0) {
+      contexts.push_back(start.word);
+      start.ctx_len = 1;
+   }
+   stacks[0].push_back(start);
+
+   for (Uint i = 0; i < n; ++i) {
+      getVariants(tokens[i]);
+      vector<Hyp>& prev = stacks[i];
+      vector<Hyp>& next = stacks[i+1];
+      next.clear();
+      for (Uint p = 0; p < prev.size(); ++p) {
+         const Hyp& h = prev[p];
+         for (Uint v = 0; v < token_variants.size(); ++v) {
+            const Variant& var = token_variants[v];
+            Hyp e;
+            e.score = h.score + var.logprob +
+               lm->cachedWordProb(var.word,
+                  contexts.empty() ? NULL : &contexts[0] + h.ctx_start, h.ctx_len);
+            e.back = p;
+            e.word = var.word;
+            // New LM state: this word, then the previous state, trimmed to
+            // what the LM can use.
+            context.clear();
+            if (ctx_size > 0) {
+               context.push_back(var.word);
+               for (Uint k = 0; k < h.ctx_len && context.size() < ctx_size; ++k)
+                  context.push_back(contexts[h.ctx_start + k]);
+            }
+            e.ctx_len = context.empty() ? 0 :
+               lm->minContextSize(&context[0], context.size());
+            e.ctx_start = contexts.size();
+            contexts.insert(contexts.end(), context.begin(), context.begin() + e.ctx_len);
+            next.push_back(e);
+         }
+      }
+      recombineAndPrune(next);
+   }
+
+   // Add </s> and pick the best complete hypothesis
+   const Uint sent_end = vocab.add(PLM::SentEnd);
+   const vector<Hyp>& last = stacks[n];
+   Uint best = 0;
+   double best_score = 0;
+   for (Uint p = 0; p < last.size(); ++p) {
+      const Hyp& h = last[p];
+      const double score = h.score +
+         lm->cachedWordProb(sent_end,
+            contexts.empty() ? NULL : &contexts[0] + h.ctx_start, h.ctx_len);
+      if (p == 0 || score > best_score) {
+         best = p;
+         best_score = score;
+      }
+   }
+
+   for (Uint i = n; i > 0; --i) {
+      const Hyp& h = stacks[i][best];
+      tokens[i-1] = vocab.word(h.word);
+      best = h.back;
+   }
+}
+
+string TrueCaser::truecase(const string& line)
+{
+   vector<string> tokens;
+   split(line, tokens);
+   truecase(tokens);
+   return join(tokens);
+}
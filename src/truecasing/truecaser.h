@@ -0,0 +1,118 @@
+/**
+ * @file truecaser.h
+ * @brief In-process monotone truecasing with a casing map and a truecasing LM.
+ *
+ * TrueCaser replaces the canoe call in truecase.pl: each lowercase token is
+ * rewritten as one of its casing variants from the map compiled by
+ * compile_truecase_map (or the TPPT built from it), and the best sequence of
+ * variants is found with a monotone beam-pruned Viterbi search scoring
+ *    log10 p(variant | token) + log10 p_LM(variant | history).
+ * These are the scores canoe uses with "-ftm 1.0 -lm 2.302585 -tm 0.0", with
+ * hypotheses recombined on their LM state, so results match the canoe-based
+ * pipeline without the cost of starting a decoder for each request.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef TRUECASER_H
+#define TRUECASER_H
+
+#include "portage_defs.h"
+#include "string_hash.h"
+#include "vocab_filter.h"
+#include <boost/scoped_ptr.hpp>
+#include <vector>
+#include <string>
+
+namespace ugdiss { class TpPhraseTable; }
+
+namespace Portage {
+
+class PLM;
+
+class TrueCaser : private NonCopyable
+{
+public:
+   /**
+    * Load the models.
+    * @param lm_file       truecasing LM, in any format PLM::Create() accepts
+    * @param map_file      casing map: text format from compile_truecase_map,
+    *                      or a TPPT built from it
+    * @param lm_order      limit on the LM order; 0 for no limit
+    * @param beam          max number of hypotheses kept at each position
+    * @param max_variants  max number of casing variants considered per token,
+    *                      the most probable ones
+    */
+   TrueCaser(const string& lm_file, const string& map_file, Uint lm_order = 0,
+             Uint beam = 100, Uint max_variants = 100);
+
+   /// Destructor.
+   ~TrueCaser();
+
+   /**
+    * Truecase a tokenized sentence.  Tokens missing from the map are kept
+    * as is.
+    * @param tokens  lowercase tokens; replaced by their truecased form
+    */
+   void truecase(vector<string>& tokens);
+
+   /**
+    * Truecase a whitespace-tokenized line.
+    * @param line  lowercase line
+    * @return truecased line, with tokens separated by single spaces
+    */
+   string truecase(const string& line);
+
+private:
+   /// A casing variant of a token.
+   struct Variant {
+      Uint word;     ///< index in vocab
+      float logprob; ///< log10 p(variant | token)
+      Variant(Uint word, float logprob) : word(word), logprob(logprob) {}
+      bool operator<(const Variant& o) const { return logprob > o.logprob; }
+   };
+
+   /// A hypothesis: a cased prefix of the sentence.
+   struct Hyp {
+      double score;     ///< total log10 score
+      Uint back;        ///< index of the previous hypothesis, or NONE
+      Uint word;        ///< last word
+      Uint ctx_start;   ///< LM state: offset of its words in contexts
+      Uint ctx_len;     ///< LM state: number of words
+   };
+
+   /// Order hypotheses by decreasing score.
+   struct HypScoreGreater;
+
+   VocabFilter vocab;                         ///< LM vocabulary
+   boost::scoped_ptr<PLM> lm;                 ///< truecasing LM
+   boost::scoped_ptr<ugdiss::TpPhraseTable> tppt;  ///< TPPT casing map
+   /// Text casing map: lowercase token -> variants, best first
+   unordered_map<string, vector<Variant> > variants;
+   const Uint beam;
+   const Uint max_variants;
+   Uint ctx_size;                             ///< LM order - 1
+
+   // Workspace for truecase()
+   vector<vector<Hyp> > stacks;               ///< hypotheses at each position
+   vector<Uint> contexts;                     ///< LM states of all hypotheses
+   vector<Variant> token_variants;            ///< variants of the current token
+   vector<Uint> context;                      ///< LM state being built
+
+   /// Load a text casing map.
+   void readMap(const string& map_file);
+
+   /// Get the variants of token into token_variants.
+   void getVariants(const string& token);
+
+   /// Prune stack to the beam, recombining hypotheses with the same LM state.
+   void recombineAndPrune(vector<Hyp>& stack);
+};
+
+} // Portage
+
+#endif // TRUECASER_H
@@ -1,13 +1,13 @@
 /**
  * @author Samuel Larkin
  * @file MagicStream.cc  A stream that can be transparently used for cin/cout,
- *                       .txt, .{Z,z,gz} and pipes.
+ *                       .txt, .{Z,z,gz}, .bz2, .lzma, .xz, .zst and pipes.
  *
  *
  * COMMENTS: These classes we permit easy integration of a stream that
  *           can be used in the following ways:
  *             - to read from standard in or to write to standard out
- *             - to read/write to a compress gzip file
+ *             - to read/write to a compressed file, in-process
  *             - to read/write to a plain text file
  *             - to read/write from a pipe
  *
@@ -20,9 +20,20 @@
                
 #include <MagicStream.h>
 #include <errors.h>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#include <boost/iostreams/filter/symmetric.hpp>
 #include <boost/iostreams/device/file.hpp>
+#ifdef MAGIC_STREAM_ZSTD
+#include <boost/iostreams/filter/zstd.hpp>
+#endif
+#ifdef USE_LZMA
+#include <lzma.h>
+#endif
 
 
 using namespace Portage;
@@ -131,19 +142,164 @@ namespace MagicStream
       }
    };
 
-   /// A callable entity that properly closes a gzip_compressor.
-   struct gzip_deleter {
-      /// Properly close a gzip_compressor.
+   /// A callable entity that properly closes a compressor, writing a valid
+   /// compressed file even if nothing was written to it.
+   template<class Compressor>
+   struct compressor_deleter {
+      /// Properly close a compressor.
       /// @param p file buffer to close
       void operator()(filtering_streambuf<output>* p) {
          if (p) {
-            log("Closing gzip compressor");
+            log("Closing compressor");
             static char dummy = 'b';
-            p->component<gzip_compressor>(0)->write(*(p->component<file_sink>(1)), &dummy, 0);
+            p->component<Compressor>(0)->write(*(p->component<file_sink>(1)), &dummy, 0);
             delete p;
          }
       }
    };
+
+   /// Buffer size for in-process (de)compression; boost's default of 4K
+   /// makes for many small reads and writes.
+   const std::streamsize zip_buffer_size = 64 * 1024;
+
+   /// True iff the environment asks for external (de)compression programs.
+   bool useExternalZip()
+   {
+      const char* env = getenv("PORTAGE_MAGICSTREAM_PIPES");
+      return env && *env && strcmp(env, "0") != 0;
+   }
+
+   /// True iff filename can be opened for reading.
+   bool canRead(const string& filename)
+   {
+      std::filebuf tmp;
+      return tmp.open(filename.c_str(), ios_base::in) != NULL;
+   }
+
+   /// Buffer decompressing filename with decompressor.
+   template<class Decompressor>
+   filtering_streambuf<input>* makeDecompressor(const Decompressor& decompressor,
+                                                const string& filename)
+   {
+      filtering_streambuf<input>* in = new filtering_streambuf<input>();
+      assert(in != NULL);
+      in->push(decompressor, zip_buffer_size);
+      in->push(file_source(filename.c_str(), ios_base::in | ios_base::binary),
+               zip_buffer_size);
+      return in;
+   }
+
+   /// Buffer compressing into filename with compressor; NULL if filename
+   /// cannot be created.
+   template<class Compressor>
+   filtering_streambuf<output>* makeCompressor(const Compressor& compressor,
+                                               const string& filename)
+   {
+      file_sink sink(filename.c_str(), ios_base::out | ios_base::binary);
+      if (!sink.is_open()) return NULL;
+      filtering_streambuf<output>* out = new filtering_streambuf<output>();
+      assert(out != NULL);
+      out->push(compressor, zip_buffer_size);
+      out->push(sink, zip_buffer_size);
+      return out;
+   }
+
+#ifdef USE_LZMA
+   /**
+    * liblzma codec for .lzma and .xz files, as a boost::iostreams
+    * SymmetricFilter implementation.  boost's own lzma filters only handle
+    * .xz files, which the lzma program does not read, and always decompress
+    * in a single thread.
+    */
+   class lzma_impl {
+      lzma_stream strm;
+      const bool compress;   ///< compress or decompress
+      const bool xz;         ///< .xz format rather than the legacy .lzma one
+      const uint32_t threads;
+      bool initialized;
+
+      void init() {
+         const lzma_stream init_strm = LZMA_STREAM_INIT;
+         strm = init_strm;
+         const uint32_t preset = 6;   // the lzma and xz programs' default
+         lzma_ret ret;
+         lzma_mt mt;
+         memset(&mt, 0, sizeof(mt));
+         mt.threads = threads;
+         if (compress) {
+            if (!xz) {
+               lzma_options_lzma opt;
+               lzma_lzma_preset(&opt, preset);
+               ret = lzma_alone_encoder(&strm, &opt);
+            } else if (threads > 1) {
+               mt.preset = preset;
+               mt.check = LZMA_CHECK_CRC64;
+               ret = lzma_stream_encoder_mt(&strm, &mt);
+            } else {
+               ret = lzma_easy_encoder(&strm, preset, LZMA_CHECK_CRC64);
+            }
+         } else {
+#if LZMA_VERSION >= 50040002
+            // Multi-threaded decoding works on .xz files with several blocks,
+            // such as those written by xz -T or by this class.
+            if (xz && threads > 1) {
+               mt.flags = LZMA_CONCATENATED;
+               mt.memlimit_threading = lzma_physmem() / 4;
+               mt.memlimit_stop = UINT64_MAX;
+               ret = lzma_stream_decoder_mt(&strm, &mt);
+            } else
+#endif
+            ret = lzma_auto_decoder(&strm, UINT64_MAX, LZMA_CONCATENATED);
+         }
+         if (ret != LZMA_OK)
+            throw std::ios_base::failure("lzma initialization error");
+         initialized = true;
+      }
+
+   public:
+      typedef char char_type;
+
+      lzma_impl(bool compress, bool xz, uint32_t threads)
+         : compress(compress), xz(xz), threads(threads), initialized(false) {}
+      ~lzma_impl() { close(); }
+
+      bool filter(const char*& src_begin, const char* src_end,
+                  char*& dest_begin, char* dest_end, bool flush)
+      {
+         if (!initialized) init();
+         strm.next_in = reinterpret_cast<const uint8_t*>(src_begin);
+         strm.avail_in = src_end - src_begin;
+         strm.next_out = reinterpret_cast<uint8_t*>(dest_begin);
+         strm.avail_out = dest_end - dest_begin;
+         const lzma_ret ret = lzma_code(&strm, flush ? LZMA_FINISH : LZMA_RUN);
+         src_begin = reinterpret_cast<const char*>(strm.next_in);
+         dest_begin = reinterpret_cast<char*>(strm.next_out);
+         if (ret == LZMA_STREAM_END)
+            return false;
+         if (ret == LZMA_OK || (ret == LZMA_BUF_ERROR && !flush))
+            return true;
+         // LZMA_BUF_ERROR when flushing means the input is truncated.
+         throw std::ios_base::failure("lzma data error");
+      }
+
+      void close() {
+         if (initialized) lzma_end(&strm);
+         initialized = false;
+      }
+   };
+
+   /// .lzma/.xz filter, usable as compressor or decompressor.
+   typedef symmetric_filter<lzma_impl> lzma_symmetric_filter;
+
+   /// Threads for .xz (de)compression: OMP_NUM_THREADS if set, otherwise
+   /// the number of CPUs, at most 8.
+   uint32_t lzmaThreads()
+   {
+      const char* env = getenv("OMP_NUM_THREADS");
+      const int n = env && *env ? atoi(env) : int(lzma_cputhreads());
+      return std::min(std::max(n, 1), 8);
+   }
+#endif
 } // ends namespace MagicStream;
 } // ends namespace Portage;
 using namespace Portage::MagicStream;
@@ -261,6 +417,24 @@ bool MagicStreamBase::isLzma(const string& cmd)
           && cmd.substr(dot_pos) == ".lzma";
 }
 
+bool MagicStreamBase::isXz(const string& cmd)
+{
+   const size_t dot_pos = cmd.rfind(".");
+   return dot_pos != string::npos
+          && cmd.substr(dot_pos) == ".xz";
+}
+
+bool MagicStreamBase::isZstd(const string& cmd)
+{
+   const size_t dot_pos = cmd.rfind(".");
+   if ( dot_pos == string::npos ) {
+      return false;
+   } else {
+      const string suffix(cmd.substr(dot_pos));
+      return suffix == ".zst" || suffix == ".zstd";
+   }
+}
+
 bool MagicStreamBase::isBzip2(const string& cmd)
 {
    const size_t dot_pos = cmd.rfind(".");
@@ -332,45 +506,43 @@ void iMagicStream::open(const string& s)
    else if (s.length()>0 && *s.rbegin() == '|') {
       makePipe(s.substr(0, s.length()-1));
    }
-   else if (isLzma(s)) {
+   else if (isLzma(s) || isXz(s)) {
 #ifdef USE_LZMA
-      std::filebuf* tmp = new std::filebuf;
-      assert(tmp);
-      if (tmp->open(s.c_str(), bufferMode())) {
-         tmp->close(); // File exists we must close it to now use it with gzip
-         delete tmp; tmp = NULL;
-         makePipe("lzma -4 -cqdf " + s);
+      if (canRead(s)) {
+         if (useExternalZip())
+            makePipe((isXz(s) ? "xz -cqdf " : "lzma -4 -cqdf ") + s);
+         else
+            stream = stream_type(makeDecompressor(
+               lzma_symmetric_filter(zip_buffer_size, false, isXz(s), lzmaThreads()), s));
       }
 #else
       error(ETFatal, "Portage was not compiled with lzma support!");
 #endif
    }
    else if (isBzip2(s)) {
-      std::filebuf* tmp = new std::filebuf;
-      assert(tmp);
-      if (tmp->open(s.c_str(), bufferMode())) {
-         tmp->close(); // File exists we must close it to now use it with gzip
-         delete tmp; tmp = NULL;
-         makePipe("bzip2 -cqdf " + s);
+      if (canRead(s)) {
+         if (useExternalZip())
+            makePipe("bzip2 -cqdf " + s);
+         else
+            stream = stream_type(makeDecompressor(bzip2_decompressor(), s));
+      }
+   }
+   else if (isZstd(s)) {
+      if (canRead(s)) {
+#ifdef MAGIC_STREAM_ZSTD
+         if (!useExternalZip())
+            stream = stream_type(makeDecompressor(zstd_decompressor(), s));
+         else
+#endif
+            makePipe("zstd -cqdf " + s);
       }
    }
    else if (isZip(s)) {
-      std::filebuf* tmp = new std::filebuf;
-      assert(tmp);
-      if (tmp->open(s.c_str(), bufferMode())) {
-         tmp->close(); // File exists we must close it to now use it with gzip
-         delete tmp; tmp = NULL;
-         if (1 /* !makePipe("gzip -cqdf " + s)*/) {
-            //log("Fallback for iMagicstream.gz");
-
-            using namespace boost::iostreams::gzip;
-            filtering_streambuf<input>* in = new filtering_streambuf<input>();
-            assert(in != NULL);
-            in->push(gzip_decompressor());
-            in->push(file_source(s.c_str()));
-
-            stream = stream_type(in);
-         }
+      if (canRead(s)) {
+         if (useExternalZip())
+            makePipe("gzip -cqdf " + s);
+         else
+            stream = stream_type(makeDecompressor(gzip_decompressor(), s));
       }
    }
    else {
@@ -389,17 +561,10 @@ void iMagicStream::open(const string& s)
             //      s.c_str(), s.c_str());
             tmp->close(); // File exists we must close it to now use it with gzip
             delete tmp; tmp = NULL;
-            if (0) {
+            if (useExternalZip())
                makePipe("gzip -cqdf " + filename);
-            } else {
-               using namespace boost::iostreams::gzip;
-               filtering_streambuf<input>* in = new filtering_streambuf<input>();
-               assert(in != NULL);
-               in->push(gzip_decompressor());
-               in->push(file_source(filename.c_str()));
-
-               stream = stream_type(in);
-            }
+            else
+               stream = stream_type(makeDecompressor(gzip_decompressor(), filename));
          }
       }
    }
@@ -459,35 +624,43 @@ void oMagicStream::open(const string& s)
    else if (s.length()>0 && s[0] == '|') {
       makePipe(s.substr(1));
    }
-   else if (isLzma(s)) {
+   else if (isLzma(s) || isXz(s)) {
 #ifdef USE_LZMA
-      string command("lzma -cqf > ");
-      command += s;
-      makePipe(command);
+      if (useExternalZip()) {
+         makePipe((isXz(s) ? "xz -cqf > " : "lzma -cqf > ") + s);
+      } else {
+         filtering_streambuf<output>* out =
+            makeCompressor(lzma_symmetric_filter(zip_buffer_size, true, isXz(s), lzmaThreads()), s);
+         if (out) stream = stream_type(out, compressor_deleter<lzma_symmetric_filter>());
+      }
 #else
       error(ETFatal, "Portage was not compiled with lzma support!");
 #endif
    }
    else if (isBzip2(s)) {
-      string command("bzip2 -cqf > ");
-      command += s;
-      makePipe(command);
+      if (useExternalZip()) {
+         makePipe("bzip2 -cqf > " + s);
+      } else {
+         filtering_streambuf<output>* out = makeCompressor(bzip2_compressor(), s);
+         if (out) stream = stream_type(out, compressor_deleter<bzip2_compressor>());
+      }
+   }
+   else if (isZstd(s)) {
+#ifdef MAGIC_STREAM_ZSTD
+      if (!useExternalZip()) {
+         filtering_streambuf<output>* out = makeCompressor(zstd_compressor(), s);
+         if (out) stream = stream_type(out, compressor_deleter<zstd_compressor>());
+      } else
+#endif
+         makePipe("zstd -cqf > " + s);
    }
    else if (isZip(s)) {
-      //string command("gzip -cqf > ");
-      //command += s;
-      if (1 /* !makePipe(command) */) {
-         log("Fallback for oMagicstream.gz");
-
-         using namespace boost::iostreams::gzip;
-         filtering_streambuf<output>* out = new filtering_streambuf<output>();
-         assert(out != NULL);
-         out->push(gzip_compressor());
-         file_sink sink(s.c_str());
-         if (!sink.is_open()) return;
-         out->push(sink);
-
-         stream = stream_type(out, gzip_deleter());
+      if (useExternalZip()) {
+         makePipe("gzip -cqf > " + s);
+      } else {
+         log("In-process gzip compression");
+         filtering_streambuf<output>* out = makeCompressor(gzip_compressor(), s);
+         if (out) stream = stream_type(out, compressor_deleter<gzip_compressor>());
       }
    }
    else {
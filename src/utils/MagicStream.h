@@ -1,7 +1,7 @@
 /**
  * @author Samuel Larkin
  * @file MagicStream.h A stream that can be transparently used for cin/cout,
- *                     .txt, .{Z,z,gz}, .bz2, .lzma and pipes.
+ *                     .txt, .{Z,z,gz}, .bz2, .lzma, .xz, .zst and pipes.
  *
  *
  * COMMENTS: These classes we permit easy integration of a stream that can be
@@ -9,10 +9,18 @@
  *           - to read from standard in or to write to standard out
  *           - to read/write to a compress gzip file
  *           - to read/write to a compress bzip2 file
- *           - to read/write to a compress lzma file
+ *           - to read/write to a compress lzma or xz file
+ *           - to read/write to a compress zstd file
  *           - to read/write to a plain text file
  *           - to read/write from a pipe
  *
+ *           Compressed files are (de)compressed in-process, with zlib, libbz2,
+ *           liblzma and libzstd; .xz files are (de)compressed with up to
+ *           OMP_NUM_THREADS threads (default: the number of CPUs, at most 8).
+ *           If the environment variable PORTAGE_MAGICSTREAM_PIPES is set to
+ *           a non-empty value other than 0, the gzip, bzip2, lzma, xz and
+ *           zstd programs are used through pipes instead, as in the past.
+ *
  * Technologies langagieres interactives / Interactive Language Technologies
  * Inst. de technologie de l'information / Institute for Information Technology
  * Conseil national de recherches Canada / National Research Council Canada
@@ -26,11 +34,18 @@
 #include "portage_defs.h"
 #include <iostream>
 #include <boost/shared_ptr.hpp>
+#include <boost/version.hpp>
 #include <ext/stdio_filebuf.h>
 #include <fstream>
 #include <string>
 #include <cerrno>
 
+#if BOOST_VERSION >= 107000
+/// Defined when zstd files are (de)compressed in process, with boost's zstd
+/// filter; otherwise the zstd program is used through pipes.
+#define MAGIC_STREAM_ZSTD
+#endif
+
 
 namespace Portage {
 
@@ -135,6 +150,20 @@ class MagicStreamBase : private NonCopyable
        */
       static bool isLzma(const std::string& cmd);
 
+      /**
+       * Determines if the cmd is an xz operation.
+       * @param cmd command to check if it ends in .xz
+       * @return Returns true if cmd ends with .xz
+       */
+      static bool isXz(const std::string& cmd);
+
+      /**
+       * Determines if the cmd is a zstd operation.
+       * @param cmd command to check if it ends in .zst or .zstd
+       * @return Returns true if cmd ends with .zst or .zstd
+       */
+      static bool isZstd(const std::string& cmd);
+
       /**
        * Opens the proper stream.  This virtual function must be declared by
        * oMagicStream and iMagicStream since opening is different in both
@@ -0,0 +1,393 @@
+/**
+ * @file binary_jpt.cc
+ * @brief Block-compressed, vocabulary-encoded binary format for sorted joint
+ *        phrase tables.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "binary_jpt.h"
+#include "file_utils.h"
+#include "errors.h"
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+using namespace Portage;
+namespace io = boost::iostreams;
+
+static const char magic[] = "PortageBJPT1\n";
+static const Uint magic_len = sizeof(magic) - 1;
+static const char* const psep = "|||";
+
+/// Largest integer value written as a varint rather than as a double.
+static const double max_int_value = 9007199254740992.0; // 2^53
+
+static void writeUint32(ostream& os, Uint v)
+{
+   char buf[4];
+   for (Uint i = 0; i < 4; ++i) buf[i] = char((v >> (8*i)) & 0xFF);
+   os.write(buf, 4);
+}
+
+static bool readUint32(istream& is, Uint& v)
+{
+   unsigned char buf[4];
+   if (!is.read(reinterpret_cast<char*>(buf), 4)) return false;
+   v = buf[0] | (buf[1] << 8) | (buf[2] << 16) | (Uint(buf[3]) << 24);
+   return true;
+}
+
+void Portage::appendJPTValue(string& s, double v)
+{
+   char buf[32];
+   if (v >= 0 && v < max_int_value && v == floor(v))
+      snprintf(buf, sizeof(buf), "%llu", (unsigned long long)v);
+   else {
+      // Use the shortest of 15 or 17 significant digits that reads back as
+      // v, so values survive a trip through text, e.g., in merge_counts.
+      snprintf(buf, sizeof(buf), "%.15g", v);
+      if (strtod(buf, NULL) != v)
+         snprintf(buf, sizeof(buf), "%.17g", v);
+   }
+   s += buf;
+}
+
+static void appendTokens(string& s, const vector<Uint>& toks, const Voc& voc)
+{
+   for (Uint i = 0; i < toks.size(); ++i) {
+      if (i) s += ' ';
+      s += voc.word(toks[i]);
+   }
+}
+
+void BinaryJPTEntry::appendKey(string& key, const Voc& voc) const
+{
+   appendTokens(key, phrase1, voc);
+   key += " ||| ";
+   appendTokens(key, phrase2, voc);
+   key += " |||";
+}
+
+void BinaryJPTEntry::appendLine(string& line, const Voc& voc) const
+{
+   appendKey(line, voc);
+   for (Uint i = 0; i < values.size(); ++i) {
+      line += ' ';
+      appendJPTValue(line, values[i]);
+   }
+   for (Uint i = 0; i < extras.size(); ++i) {
+      line += ' ';
+      line += voc.word(extras[i]);
+   }
+}
+
+/*---------------------------------------------------------------------------------------------
+  BinaryJPTReader
+  -------------------------------------------------------------------------------------------*/
+
+BinaryJPTReader::BinaryJPTReader(const string& filename)
+   : in(new iSafeMagicStream(filename)), pos(0), done(false), num_entries(0)
+   , filename(filename)
+{
+   char buf[magic_len];
+   if (!in->read(buf, magic_len) || memcmp(buf, magic, magic_len) != 0)
+      error(ETFatal, "%s is not a binary JPT", filename.c_str());
+}
+
+BinaryJPTReader::~BinaryJPTReader()
+{
+   delete in;
+}
+
+bool BinaryJPTReader::readBlock()
+{
+   Uint raw_size = 0, comp_size = 0;
+   if (!readUint32(*in, raw_size) || !readUint32(*in, comp_size))
+      error(ETFatal, "Binary JPT %s is truncated", filename.c_str());
+   if (raw_size == 0) {
+      done = true;
+      return false;
+   }
+   string compressed(comp_size, '\0');
+   if (!in->read(&compressed[0], comp_size))
+      error(ETFatal, "Binary JPT %s is truncated", filename.c_str());
+   block.resize(raw_size);
+   io::filtering_istream is;
+   is.push(io::zlib_decompressor());
+   is.push(io::array_source(compressed.data(), compressed.size()));
+   if (!is.read(&block[0], raw_size))
+      error(ETFatal, "Corrupt block in binary JPT %s", filename.c_str());
+   pos = 0;
+   return true;
+}
+
+Uint64 BinaryJPTReader::readVarint()
+{
+   Uint64 v = 0;
+   for (Uint shift = 0; ; shift += 7) {
+      if (pos >= block.size() || shift > 63)
+         error(ETFatal, "Corrupt entry in binary JPT %s", filename.c_str());
+      const unsigned char c = block[pos++];
+      v |= Uint64(c & 0x7F) << shift;
+      if (!(c & 0x80)) break;
+   }
+   return v;
+}
+
+Uint BinaryJPTReader::readToken()
+{
+   const Uint64 id = readVarint();
+   if (id == voc.size()) {
+      const Uint len = readVarint();
+      if (pos + len > block.size())
+         error(ETFatal, "Corrupt entry in binary JPT %s", filename.c_str());
+      const string word(block, pos, len);
+      pos += len;
+      voc.add(word.c_str());
+   } else if (id > voc.size()) {
+      error(ETFatal, "Corrupt entry in binary JPT %s", filename.c_str());
+   }
+   return id;
+}
+
+void BinaryJPTReader::readTokens(vector<Uint>& toks)
+{
+   const Uint n = readVarint();
+   toks.resize(n);
+   for (Uint i = 0; i < n; ++i)
+      toks[i] = readToken();
+}
+
+bool BinaryJPTReader::next()
+{
+   if (done) return false;
+   if (pos >= block.size() && !readBlock())
+      return false;
+
+   readTokens(current.phrase1);
+   readTokens(current.phrase2);
+   const Uint nv = readVarint();
+   current.values.resize(nv);
+   for (Uint i = 0; i < nv; ++i) {
+      if (pos >= block.size())
+         error(ETFatal, "Corrupt entry in binary JPT %s", filename.c_str());
+      const char tag = block[pos++];
+      if (tag == 0) {
+         current.values[i] = double(readVarint());
+      } else if (tag == 1 && pos + sizeof(double) <= block.size()) {
+         memcpy(&current.values[i], &block[pos], sizeof(double));
+         pos += sizeof(double);
+      } else {
+         error(ETFatal, "Corrupt entry in binary JPT %s", filename.c_str());
+      }
+   }
+   readTokens(current.extras);
+   ++num_entries;
+   return true;
+}
+
+/*---------------------------------------------------------------------------------------------
+  BinaryJPTWriter
+  -------------------------------------------------------------------------------------------*/
+
+BinaryJPTWriter::BinaryJPTWriter(const string& filename, Uint block_size)
+   : out(new oSafeMagicStream(filename)), num_written_words(0)
+   , block_size(block_size), num_entries(0), closed(false), filename(filename)
+{
+   out->write(magic, magic_len);
+   block.reserve(block_size + 4096);
+}
+
+BinaryJPTWriter::~BinaryJPTWriter()
+{
+   close();
+   delete out;
+}
+
+void BinaryJPTWriter::flushBlock()
+{
+   if (block.empty()) return;
+   string compressed;
+   {
+      io::filtering_ostream os;
+      os.push(io::zlib_compressor());
+      os.push(io::back_inserter(compressed));
+      os.write(block.data(), block.size());
+   }
+   writeUint32(*out, block.size());
+   writeUint32(*out, compressed.size());
+   out->write(compressed.data(), compressed.size());
+   if (!*out)
+      error(ETFatal, "Error writing binary JPT %s", filename.c_str());
+   block.clear();
+}
+
+void BinaryJPTWriter::writeVarint(Uint64 v)
+{
+   while (v >= 0x80) {
+      block += char((v & 0x7F) | 0x80);
+      v >>= 7;
+   }
+   block += char(v);
+}
+
+void BinaryJPTWriter::writeTokens(const vector<Uint>& toks)
+{
+   writeVarint(toks.size());
+   for (Uint i = 0; i < toks.size(); ++i) {
+      const Uint id = toks[i];
+      if (id >= file_index.size())
+         file_index.resize(voc.size(), undefined);
+      if (file_index[id] != undefined) {
+         writeVarint(file_index[id]);
+      } else {
+         // First use: define the word with the next file index.
+         const char* word = voc.word(id);
+         const Uint len = strlen(word);
+         file_index[id] = num_written_words++;
+         writeVarint(file_index[id]);
+         writeVarint(len);
+         block.append(word, len);
+      }
+   }
+}
+
+void BinaryJPTWriter::write(const BinaryJPTEntry& entry)
+{
+   assert(!closed);
+   key.clear();
+   entry.appendKey(key, voc);
+   if (key < prev_key)
+      error(ETFatal, "Binary JPT %s: entries not in LC_ALL=C order:\n%s\n%s",
+            filename.c_str(), prev_key.c_str(), key.c_str());
+   prev_key.swap(key);
+
+   writeTokens(entry.phrase1);
+   writeTokens(entry.phrase2);
+   writeVarint(entry.values.size());
+   for (Uint i = 0; i < entry.values.size(); ++i) {
+      const double v = entry.values[i];
+      if (v >= 0 && v < max_int_value && v == floor(v)) {
+         block += char(0);
+         writeVarint(Uint64(v));
+      } else {
+         block += char(1);
+         block.append(reinterpret_cast<const char*>(&v), sizeof(double));
+      }
+   }
+   writeTokens(entry.extras);
+   ++num_entries;
+
+   if (block.size() >= block_size)
+      flushBlock();
+}
+
+bool BinaryJPTWriter::writeLine(const string& line, BinaryJPTEntry& entry)
+{
+   entry.clear();
+   char buffer[line.size()+1];
+   strcpy(buffer, line.c_str());
+   Uint field = 0;   // 0: phrase1, 1: phrase2, 2: values, 3: extras
+   char* save = NULL;
+   for (char* tok = strtok_r(buffer, " \t\n", &save); tok; tok = strtok_r(NULL, " \t\n", &save)) {
+      if (field < 2 && strcmp(tok, psep) == 0) {
+         ++field;
+         continue;
+      }
+      if (field == 2) {
+         char* end;
+         const double v = strtod(tok, &end);
+         if (*end == '\0' && end != tok) {
+            entry.values.push_back(v);
+            continue;
+         }
+         field = 3;
+      }
+      const Uint id = voc.add(tok);
+      switch (field) {
+         case 0: entry.phrase1.push_back(id); break;
+         case 1: entry.phrase2.push_back(id); break;
+         default: entry.extras.push_back(id); break;
+      }
+   }
+   if (field < 2)
+      return false;
+   write(entry);
+   return true;
+}
+
+void BinaryJPTWriter::close()
+{
+   if (closed) return;
+   flushBlock();
+   writeUint32(*out, 0);
+   writeUint32(*out, 0);
+   out->flush();
+   if (!*out)
+      error(ETFatal, "Error writing binary JPT %s", filename.c_str());
+   closed = true;
+}
+
+/*---------------------------------------------------------------------------------------------
+  Detection and text view
+  -------------------------------------------------------------------------------------------*/
+
+bool Portage::isBinaryJPT(const string& filename)
+{
+   if (filename == "-") return false;
+   // Read through the decompressor, so compressed binary JPTs are detected.
+   iSafeMagicStream in(filename, true);
+   char buf[magic_len];
+   return in.read(buf, magic_len) && memcmp(buf, magic, magic_len) == 0;
+}
+
+namespace {
+
+/// Stream buffer that decodes a binary JPT into text JPT lines.
+class BinaryJPTTextBuf : public streambuf {
+   BinaryJPTReader reader;
+   string buf;
+public:
+   explicit BinaryJPTTextBuf(const string& filename) : reader(filename) {}
+protected:
+   virtual int_type underflow() {
+      buf.clear();
+      while (buf.size() < 65536 && reader.next()) {
+         reader.entry().appendLine(buf, reader.getVoc());
+         buf += '\n';
+      }
+      if (buf.empty())
+         return traits_type::eof();
+      setg(&buf[0], &buf[0], &buf[0] + buf.size());
+      return traits_type::to_int_type(buf[0]);
+   }
+};
+
+/// istream view of a binary JPT as a text JPT.
+class BinaryJPTTextStream : public istream {
+   BinaryJPTTextBuf sb;
+public:
+   explicit BinaryJPTTextStream(const string& filename)
+      : istream(NULL), sb(filename) { init(&sb); }
+};
+
+} // anonymous namespace
+
+istream* Portage::openJPTAsText(const string& filename)
+{
+   if (isBinaryJPT(filename))
+      return new BinaryJPTTextStream(filename);
+   else
+      return new iSafeMagicStream(filename);
+}
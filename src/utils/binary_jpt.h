@@ -0,0 +1,174 @@
+/**
+ * @file binary_jpt.h
+ * @brief Block-compressed, vocabulary-encoded binary format for sorted joint
+ *        phrase tables (and other sorted "p1 ||| p2 ||| values" tables).
+ *
+ * A binary JPT holds the same entries as a LC_ALL=C sorted text JPT, but each
+ * word is written once, in a vocabulary definition, and then referred to by
+ * index; counts are written as integers or doubles rather than text; and the
+ * whole is zlib-compressed in independent blocks.  Reading it back requires
+ * no tokenization and no number parsing.
+ *
+ * File layout:
+ *   - the magic string "PortageBJPT1\n";
+ *   - a sequence of blocks, each one a 32 bit raw size, a 32 bit compressed
+ *     size and the zlib-compressed entries, the last block having raw size 0.
+ *
+ * Each entry is four varint-prefixed lists: phrase1 tokens, phrase2 tokens,
+ * values and extra tokens (any non-numeric fields following the values, e.g.,
+ * "a=0_1:3").  A token is a varint vocabulary index; the first use of a word
+ * is written as the next unused index followed by the varint length and bytes
+ * of the word.  A value is a tag byte: 0 for an unsigned integer, written as
+ * a varint, or 1 for a double, written as 8 raw bytes.  Varints are LEB128.
+ *
+ * Entries are in increasing order of their key, "p1 ||| p2 |||", compared as
+ * with LC_ALL=C sort, so binary and text JPTs can be merged together.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef __BINARY_JPT_H__
+#define __BINARY_JPT_H__
+
+#include "portage_defs.h"
+#include "voc.h"
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace Portage {
+
+/// One entry of a binary JPT, with tokens as indexes in a Voc.
+struct BinaryJPTEntry {
+   vector<Uint> phrase1;   ///< lang1 phrase
+   vector<Uint> phrase2;   ///< lang2 phrase
+   vector<double> values;  ///< counts or other values
+   vector<Uint> extras;    ///< fields following the values, e.g., alignments
+
+   void clear() { phrase1.clear(); phrase2.clear(); values.clear(); extras.clear(); }
+
+   /// Append the key "p1 ||| p2 |||" to key.
+   void appendKey(string& key, const Voc& voc) const;
+
+   /// Append the entry, as a text JPT line without the newline, to line.
+   void appendLine(string& line, const Voc& voc) const;
+};
+
+/// Sequential reader for binary JPT files.
+class BinaryJPTReader : private NonCopyable {
+   istream* in;                ///< underlying file stream
+   Voc voc;                    ///< words defined so far
+   string block;               ///< current uncompressed block
+   Uint pos;                   ///< read position in block
+   bool done;                  ///< true once the end block has been read
+   BinaryJPTEntry current;     ///< current entry
+   Uint64 num_entries;         ///< entries read so far
+   const string filename;
+
+   bool readBlock();
+   Uint64 readVarint();
+   Uint readToken();
+   void readTokens(vector<Uint>& toks);
+
+public:
+   /**
+    * Open filename, which must be a binary JPT.
+    * @param filename  file name; "-" for stdin
+    */
+   explicit BinaryJPTReader(const string& filename);
+   ~BinaryJPTReader();
+
+   /// Read the next entry; return false at the end of the file.
+   bool next();
+
+   /// Current entry, valid after next() returned true.
+   const BinaryJPTEntry& entry() const { return current; }
+
+   /// Vocabulary for the tokens in entry(); grows as entries are read.
+   const Voc& getVoc() const { return voc; }
+
+   /// Number of entries read so far.
+   Uint64 numEntries() const { return num_entries; }
+};
+
+/// Writer for binary JPT files.
+class BinaryJPTWriter : private NonCopyable {
+   ostream* out;               ///< underlying file stream
+   Voc voc;                    ///< words defined so far
+   vector<Uint> file_index;    ///< voc index -> index in the file, if defined
+   Uint num_written_words;     ///< number of words defined in the file
+   static const Uint undefined = ~0u;
+   string block;               ///< current uncompressed block
+   const Uint block_size;      ///< flush block when it reaches this size
+   string prev_key, key;       ///< to check the entry order
+   Uint64 num_entries;         ///< entries written so far
+   bool closed;
+   const string filename;
+
+   void flushBlock();
+   void writeVarint(Uint64 v);
+   void writeTokens(const vector<Uint>& toks);
+
+public:
+   /**
+    * Create filename as a binary JPT.
+    * @param filename    file name; "-" for stdout
+    * @param block_size  approximate size of uncompressed blocks, in bytes
+    */
+   explicit BinaryJPTWriter(const string& filename, Uint block_size = 1 << 20);
+
+   /// Destructor; calls close().
+   ~BinaryJPTWriter();
+
+   /// Index of word in the writer's vocabulary, adding it if necessary.
+   Uint wordIndex(const char* word) { return voc.add(word); }
+
+   /// Writer's vocabulary.
+   const Voc& getVoc() const { return voc; }
+
+   /**
+    * Write an entry, whose tokens are indexes in getVoc().  Entries must be
+    * written in increasing key order; equal keys are allowed.
+    */
+   void write(const BinaryJPTEntry& entry);
+
+   /**
+    * Parse a text JPT line and write it.
+    * @param line  "p1 ||| p2 ||| values [extras]"
+    * @param entry workspace
+    * @return false if line is not a valid JPT line
+    */
+   bool writeLine(const string& line, BinaryJPTEntry& entry);
+
+   /// Number of entries written so far.
+   Uint64 numEntries() const { return num_entries; }
+
+   /// Write the end block and close the file.  Idempotent.
+   void close();
+};
+
+/**
+ * Append value v to s as in text output of binary JPTs: integers exactly,
+ * other values with enough significant digits (at most 17) to be read back
+ * exactly.
+ */
+void appendJPTValue(string& s, double v);
+
+/// Return true iff filename is a binary JPT; "-" is never considered one.
+bool isBinaryJPT(const string& filename);
+
+/**
+ * Open filename for reading as a text JPT: a binary JPT is decoded on the fly
+ * into text lines; other files are opened with iSafeMagicStream.  Lets any
+ * line-oriented JPT reader accept binary JPTs.
+ * @return new stream, to be deleted by the caller
+ */
+istream* openJPTAsText(const string& filename);
+
+} // namespace Portage
+
+#endif // __BINARY_JPT_H__
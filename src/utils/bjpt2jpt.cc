@@ -0,0 +1,63 @@
+/**
+ * @file bjpt2jpt.cc
+ * @brief Convert a binary joint phrase table back to text.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "binary_jpt.h"
+#include "file_utils.h"
+#include "arg_reader.h"
+#include "printCopyright.h"
+#include "exception_dump.h"  // MAIN
+
+using namespace Portage;
+using namespace std;
+
+static char help_message[] = "\n\
+bjpt2jpt [INFILE [OUTFILE]]\n\
+\n\
+  Convert binary joint phrase table INFILE, as written by jpt2bjpt or\n\
+  merge_counts, to a LC_ALL=C sorted text joint phrase table.\n\
+\n\
+  Integer values are written as such; other values with 9 significant digits.\n\
+";
+
+static string infile("-");
+static string outfile("-");
+static void getArgs(int argc, const char* const argv[]);
+
+int MAIN(argc, argv)
+{
+   printCopyright(2026, "bjpt2jpt");
+   getArgs(argc, argv);
+
+   BinaryJPTReader reader(infile);
+   oSafeMagicStream os(outfile);
+   string line;
+   while (reader.next()) {
+      line.clear();
+      reader.entry().appendLine(line, reader.getVoc());
+      line += '\n';
+      os.write(line.data(), line.size());
+   }
+
+   return 0;
+}
+END_MAIN
+
+// arg processing
+
+void getArgs(int argc, const char* const argv[])
+{
+   const char* switches[] = {};
+   ArgReader arg_reader(ARRAY_SIZE(switches), switches, 0, 2, help_message);
+   arg_reader.read(argc-1, argv+1);
+
+   arg_reader.testAndSet(0, "infile", infile);
+   arg_reader.testAndSet(1, "outfile", outfile);
+}
@@ -13,11 +13,81 @@
 #define __EM_H__
 
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include "portage_defs.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace Portage
 {
 
+/**
+ * Training instances for EM, stored as a dense matrix of the probabilities
+ * that each model assigns to each instance, plus an optional frequency per
+ * instance. Filling this once and calling EM::countAll() on each iteration
+ * avoids re-querying the models on every EM pass.
+ *
+ * Rows are instances, so the probabilities for an instance are contiguous.
+ * Rows and frequencies may be set in parallel, once the instances have been
+ * added.
+ */
+class EMMatrix {
+
+   Uint num_models;
+   bool with_freqs;
+   vector<double> probs;        // instance-major: probs[i*num_models + m]
+   vector<double> freqs;        // instance -> freq; empty unless with_freqs
+
+public:
+
+   /**
+    * Construct an empty matrix.
+    * @param num_models  number of models, i.e., of columns
+    * @param with_freqs  store a frequency for each instance; if false, all
+    *                    instances have frequency 1
+    */
+   EMMatrix(Uint num_models, bool with_freqs = false) :
+      num_models(num_models), with_freqs(with_freqs) {}
+
+   /// Number of models, i.e., of columns.
+   Uint numModels() const {return num_models;}
+
+   /// Number of instances, i.e., of rows.
+   Uint numInstances() const {return num_models ? probs.size() / num_models : 0;}
+
+   /// Remove all instances.
+   void clear() {probs.clear(); freqs.clear();}
+
+   /**
+    * Add n instances, with probabilities set to 0.
+    * @param freq  frequency of the new instances; must be 1 unless with_freqs
+    * @return index of the first new instance
+    */
+   Uint add(Uint n = 1, double freq = 1.0) {
+      assert(with_freqs || freq == 1.0);
+      const Uint first = numInstances();
+      probs.resize(probs.size() + n * num_models, 0.0);
+      if (with_freqs)
+         freqs.resize(first + n, freq);
+      return first;
+   }
+
+   /// Probabilities for instance i, one per model.
+   double* row(Uint i) {return &probs[i * num_models];}
+   const double* row(Uint i) const {return &probs[i * num_models];}
+
+   /// Frequency of instance i.
+   double freq(Uint i) const {return with_freqs ? freqs[i] : 1.0;}
+
+   /// Set the frequency of instance i; requires with_freqs.
+   void setFreq(Uint i, double freq) {
+      assert(with_freqs);
+      freqs[i] = freq;
+   }
+};
+
 /**
  * Use this when you have a set of models, and you want to estimate weights for
  * them from some training data. Iterate over the data some number of times,
@@ -69,6 +139,19 @@ public:
       Uint freq = 1;
       return count(probs, freq);
    }   
+
+   /**
+    * Count all instances in a matrix: same as calling count() on each row of
+    * m, with its frequency, but in parallel when compiled with OpenMP.
+    * Instances are counted in fixed-size blocks whose partial counts are
+    * added in order, so the results do not depend on the number of threads.
+    * @param m          instances to count
+    * @param num_zeros  if not NULL, set to the number of instances with
+    *                   probability 0 under the current weights
+    * @return the sum of freq * log(p) over instances with probability p > 0
+    *         under the current weights
+    */
+   double countAll(const EMMatrix& m, Uint* num_zeros = NULL);
    
    /**
     * Estimate weights from counts. The M-step.
@@ -89,6 +172,55 @@ public:
    
 };
 
+// Defined inline so that it runs in parallel in programs compiled with OpenMP,
+// even though the utils library itself is not.
+inline double EM::countAll(const EMMatrix& m, Uint* num_zeros)
+{
+   assert(m.numModels() == numModels());
+   const Uint nm = numModels();
+   const Uint block_size = 4096;
+   const Uint num_blocks = (m.numInstances() + block_size - 1) / block_size;
+
+   // per block: nm partial counts, then the log-likelihood and zero count
+   vector<double> block_counts(num_blocks * (nm + 2), 0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+   for (int b = 0; b < int(num_blocks); ++b) {
+      double* bc = &block_counts[b * (nm + 2)];
+      vector<double> post(nm);
+      const Uint end = min(m.numInstances(), (b + 1) * block_size);
+      for (Uint i = b * block_size; i < end; ++i) {
+         const double* probs = m.row(i);
+         double sum = 0.0;
+         for (Uint k = 0; k < nm; ++k) {
+            post[k] = weights[k] * probs[k];
+            sum += post[k];
+         }
+         if (sum != 0.0) {
+            const double freq = m.freq(i);
+            for (Uint k = 0; k < nm; ++k)
+               bc[k] += freq * post[k] / sum;
+            bc[nm] += freq * log(sum);
+         } else
+            ++bc[nm + 1];
+      }
+   }
+
+   double logprob = 0.0;
+   Uint zeros = 0;
+   for (Uint b = 0; b < num_blocks; ++b) {
+      const double* bc = &block_counts[b * (nm + 2)];
+      for (Uint k = 0; k < nm; ++k)
+         counts[k] += bc[k];
+      logprob += bc[nm];
+      zeros += Uint(bc[nm + 1]);
+   }
+   if (num_zeros) *num_zeros = zeros;
+   return logprob;
+}
+
 } // Portage
 
 #endif // __EM_H__
@@ -0,0 +1,156 @@
+/**
+ * @author J Howard Johnson
+ * @file fisher_exact_test.cc
+ * @brief Fisher's exact test significance levels for 2x2 contingency tables.
+ *
+ * Technologies langagieres interactives / Interactive Language Technologies
+ * Inst. de technologie de l'information / Institute for Information Technology
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2006-2011, Sa Majeste la Reine du Chef du Canada /
+ * Copyright 2006-2011, Her Majesty in Right of Canada
+ */
+
+#include "fisher_exact_test.h"
+#include <cmath>
+#include <iomanip>
+#include <algorithm>
+
+using namespace Portage;
+
+typedef long double quad;
+
+static quad lnfact( double x )
+{
+   return lgamma( (quad) x + 1.0 );
+}
+
+double Portage::fetLnHyper( double C_xy, double C_x, double C_y, double nn )
+{
+   quad result =
+      - lnfact( C_xy )
+      + lnfact( C_x )
+      - lnfact( C_x - C_xy )
+      + lnfact( C_y )
+      - lnfact( C_y - C_xy )
+      + lnfact( nn - C_x )
+      - lnfact( nn - C_x - C_y + C_xy )
+      + lnfact( nn - C_y )
+      - lnfact( nn );
+   return result;
+}
+
+static double lnsum( double ln_x, double ln_y )
+{
+   if ( ln_x < ln_y ) swap( ln_x, ln_y );
+   double del = ln_y - ln_x;
+   double eps = exp( del );
+   if ( del < 10.0 ) return ln_x + log( 1.0 + eps );
+   double last_result = 0.0;
+   double result = ln_x;
+   double power = eps;
+   double i = 1.0;
+   while ( result != last_result ) {
+      last_result = result;
+      result = last_result + power / i;
+      power *= -eps;
+      ++i;
+   }
+   return result;
+//   return ln_x + log( exp( ln_y - ln_x ) + 1.0 );
+}
+
+double Portage::fetLnPValue( double C_xy, double C_x, double C_y, double nn )
+{
+   double ln_p = fetLnHyper( C_xy, C_x, C_y, nn );
+   double result = ln_p;
+   double C_xY = C_x - C_xy;
+   double C_Xy = C_y - C_xy;
+   double C_XY = nn - C_x - C_y + C_xy;
+   double C_xy_lim = ( ( C_x < C_y ) ? C_x : C_y );
+   double last_result = 0.0;
+   for ( ++C_xy;
+         C_xy <= C_xy_lim && result != last_result;
+         ++C_xy ) {
+      last_result = result;
+      ln_p +=   ( log( C_Xy-- ) + log( C_xY-- ) )
+              - ( log( C_xy   ) + log( ++C_XY ) );
+      result = lnsum( result, ln_p );
+   }
+   return result;
+}
+
+Uint Portage::fetSignificance( double C_xy, double C_x, double C_y, double nn,
+                               bool no_cap, double& scaled_ln_p )
+{
+   double minus_ln_nn = -log( nn );
+   Uint flag;
+   double p_value;
+
+// Anti-linked
+   if ( C_xy * nn < C_x * C_y ) {
+      flag = 0;
+      p_value = no_cap ? fetLnPValue( C_xy, C_x, C_y, nn ) : -log( 2.0 );
+   }
+
+// 1-1-1 's
+   else if ( C_xy == 1.0 && C_x == 1.0 && C_y == 1.0 ) {
+      flag = 2;
+      p_value = minus_ln_nn;
+   }
+
+// Associated less strongly than 1-1-1's
+   else {
+      p_value = fetLnPValue( C_xy, C_x, C_y, nn );
+      if ( p_value > minus_ln_nn ) {
+         flag = 1;
+      }
+
+// Associated more strongly than 1-1-1's
+      else {
+         flag = 3;
+      }
+   }
+
+   scaled_ln_p = floor( p_value * 1.0e8 + 0.5 );
+   return flag;
+}
+
+string Portage::fetSortKey( double i )
+{
+   string result;
+   int nd = 0;
+   int digit;
+   int d[ 20 ];
+   if ( i > 0 ) {
+      while ( nd < 20 && i > 0 ) {
+         digit = fmod( i, 64.0 );
+         d[ nd++ ] = digit;
+         i = ( i - digit ) / 64.0;
+      }
+      result.push_back( 'P' + nd );
+      while ( nd > 0 ) {
+         result.push_back( '0' + d[ --nd ] );
+      }
+   } else {
+      i = -i;
+      while ( nd < 20 && i > 0 ) {
+         digit = fmod( i, 64.0 );
+         d[ nd++ ] = digit;
+         i = ( i - digit ) / 64.0;
+      }
+      result.push_back( 'O' - nd );
+      while ( nd > 0 ) {
+         result.push_back( 'o' - d[ --nd ] );
+      }
+   }
+   return result;
+}
+
+void Portage::fetWriteFields( ostream& os, double scaled_ln_p, Uint flag )
+{
+   const streamsize prec = os.precision( 14 );
+   os << fetSortKey( scaled_ln_p ) << '\t';
+   os << scaled_ln_p * 1.0e-8 << '\t';
+   os << flag << '\t';
+   os.precision( prec );
+}
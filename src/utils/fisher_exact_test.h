@@ -0,0 +1,80 @@
+/**
+ * @author J Howard Johnson
+ * @file fisher_exact_test.h
+ * @brief Fisher's exact test significance levels for 2x2 contingency tables,
+ *        as used for significance pruning of phrase tables.
+ *
+ * These functions used to live in sigprune_fet.cc; they are now shared by
+ * sigprune_fet and phrasepair-contingency, which can compute significance
+ * levels in-process.
+ *
+ * Technologies langagieres interactives / Interactive Language Technologies
+ * Inst. de technologie de l'information / Institute for Information Technology
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2006-2011, Sa Majeste la Reine du Chef du Canada /
+ * Copyright 2006-2011, Her Majesty in Right of Canada
+ */
+
+#ifndef __FISHER_EXACT_TEST_H__
+#define __FISHER_EXACT_TEST_H__
+
+#include <string>
+#include <ostream>
+#include "portage_defs.h"
+
+namespace Portage {
+
+/**
+ * Log of the hypergeometric probability of joint count C_xy given marginals
+ * C_x and C_y in a sample of size nn.
+ */
+double fetLnHyper(double C_xy, double C_x, double C_y, double nn);
+
+/**
+ * Log of the one-sided p-value of Fisher's exact test: the log of the sum of
+ * the hypergeometric probabilities of joint counts >= C_xy.
+ */
+double fetLnPValue(double C_xy, double C_x, double C_y, double nn);
+
+/**
+ * Check that C_xy, C_x, C_y and nn form a legal contingency table.
+ */
+inline bool fetLegalTable(double C_xy, double C_x, double C_y, double nn)
+{
+   return 0.0 <= C_xy && C_xy <= C_x && C_xy <= C_y && C_x <= nn && C_y <= nn;
+}
+
+/**
+ * Calculate the significance level of a contingency table, as sigprune_fet
+ * reports it.
+ * @param C_xy   joint count
+ * @param C_x    marginal count of x
+ * @param C_y    marginal count of y
+ * @param nn     sample size
+ * @param no_cap don't cap the p-value of anti-linked pairs at 0.5
+ * @param[out] scaled_ln_p  log p-value, scaled by 1e8 and rounded to the
+ *               nearest integer
+ * @return flag: 0 : anti-linked (p-value > 0.5);
+ *               1 : linked with log p-value > alpha;
+ *               2 : linked with log p-value = alpha (1-1-1's);
+ *               3 : linked with log p-value < alpha,
+ *         where alpha = -log(nn) is the log p-value of 1-1-1's.
+ */
+Uint fetSignificance(double C_xy, double C_x, double C_y, double nn,
+                     bool no_cap, double& scaled_ln_p);
+
+/**
+ * Encode a scaled log p-value as a string whose lexicographic order is the
+ * same as the numerical order of the values, for use as a sort key.
+ */
+string fetSortKey(double scaled_ln_p);
+
+/**
+ * Write the three fields sigprune_fet adds in front of each line:
+ * sort key, log p-value and flag, each followed by a tab.
+ */
+void fetWriteFields(ostream& os, double scaled_ln_p, Uint flag);
+
+} // Portage
+
+#endif // __FISHER_EXACT_TEST_H__
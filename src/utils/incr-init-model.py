@@ -59,7 +59,18 @@ def get_args():
    one weight is given, it is used for all four columns; if four weights are
    provided, then each column is given its own weight. The incremental TM is
    given INCR_TM_WT as its weight and the main TM is given 1-INCR_TM_WT as its
-   weight."""
+   weight.
+
+   With -dynamic-lm, the incremental LM is a dynamic LM (.dynlm) counting its
+   corpus in memory, instead of a TPLM: incr-update.sh then only needs to
+   replace that corpus, and running decoders recount it at their next
+   sentence instead of reloading a retrained LM.
+
+   With -incremental-tm, the incremental TM is an incremental TM (.incrtm)
+   keeping its phrase pair counts in memory, instead of a TPPT: incr-update.sh
+   then only aligns the new sentence pairs and adds them to its counts with
+   incr_tm_update, and running decoders reload the counts at their next
+   sentence instead of reloading a retrained TPPT."""
 
    # Use the argparse module, not the deprecated optparse module.
    parser = ArgumentParser(usage=usage, description=help, add_help=False,
@@ -79,6 +90,12 @@ def get_args():
                        help="""incremental component TM model weights (1: same
                               for all columns, or 4: separate weight for each column)
                               between 0.0 and 1.0 [%(default)s]""")
+   parser.add_argument("-dynamic-lm", "--dynamic-lm", dest="dynamic_lm",
+                       action='store_true', default=False,
+                       help="use a dynamic LM as the incremental LM. [%(default)s]")
+   parser.add_argument("-incremental-tm", "--incremental-tm", dest="incremental_tm",
+                       action='store_true', default=False,
+                       help="use an incremental TM (.incrtm) as the incremental TM. [%(default)s]")
    parser.add_argument("-force", "--force-init", dest="force_init",
                        action='store_true', default=False,
                        help="force model initialization even if files exist. [%(default)s]")
@@ -323,7 +340,25 @@ def create_starter_incr_cmpt_lm(incr_cmpt_lm_name, force_init=False):
    verbose("Creating the starter incremental component TPLM:", incr_cmpt_lm_name+".tplm")
    run_command("arpalm2tplm.sh {} &> tp.{}.log".format(incr_cmpt_lm_name,incr_cmpt_lm_name))
 
-def create_incr_mixlm(incr_mixlm_name, main_lm_name, incr_cmpt_lm_name, incr_cmpt_lm_wt, force_init=False):
+def create_starter_incr_cmpt_dynlm(incr_cmpt_lm_name, force_init=False):
+   """"Create the starter incremental component dynamic LM, with an empty corpus.
+
+   incr_cmpt_lm_name: name of the incremental component LM.
+   force_init: if true, force model initialization even if models already exist.
+   """
+   dynlm_name = incr_cmpt_lm_name + ".dynlm"
+   corpus_name = incr_cmpt_lm_name + ".corpus"
+   if not force_init and os.path.exists(dynlm_name):
+      fatal_error("Incremental component dynamic LM already exists:", dynlm_name)
+   verbose("Creating the starter incremental component dynamic LM:", dynlm_name)
+   with open(dynlm_name, 'w') as dynlm_fd:
+      print("Dynamic LM v1.0 (NRC)", file=dynlm_fd)
+      print("order=3", file=dynlm_fd)
+      print("corpus={}".format(os.path.basename(corpus_name)), file=dynlm_fd)
+   open(corpus_name, 'w').close()
+
+def create_incr_mixlm(incr_mixlm_name, main_lm_name, incr_cmpt_lm_name, incr_cmpt_lm_wt,
+                      force_init=False, lm_ext=".tplm"):
    """ Create the incremental mixLM.
    
    incr_mixlm_name: name of the incremental mixLM file
@@ -331,12 +366,13 @@ def create_incr_mixlm(incr_mixlm_name, main_lm_name, incr_cmpt_lm_name, incr_cmp
    incr_cmpt_lm_name: name of the incremental component LM file
    incr_cmpt_lm_wt: incremental component LM model weight between 0.0 and 1.0
    force_init: if true, force model initialization even if models already exist.
+   lm_ext: extension of the incremental component LM file used in the mixLM
    """
    if not force_init and os.path.exists(incr_mixlm_name):
       fatal_error("Incremental mixLM already exists:", incr_mixlm_name)
    verbose("Creating the incremental mixLM:", incr_mixlm_name)
-   if not incr_cmpt_lm_name.endswith(".tplm"):
-      incr_cmpt_lm_name+=".tplm"
+   if not incr_cmpt_lm_name.endswith(lm_ext):
+      incr_cmpt_lm_name+=lm_ext
    with open(incr_mixlm_name, 'w') as incr_mixlm_fd:
       if main_lm_name.endswith(".mixlm"):
          main_lm_dir = os.path.dirname(main_lm_name)
@@ -371,7 +407,34 @@ def create_starter_incr_cmpt_tm(incr_cmpt_tm_name, force_init=False):
    verbose("Creating the starter incremental component TPPT:", incr_cmpt_tm_name+".tppt")
    run_command("textpt2tppt.sh {} &> tp.{}.log".format(incr_cmpt_tm_name,incr_cmpt_tm_name))
 
-def create_incr_mixtm(incr_mixtm_name, main_tm_name, incr_cmpt_tm_name, incr_cmpt_tm_wts, force_init=False):
+def create_starter_incr_cmpt_incrtm(config, force_init=False):
+   """"Create the starter incremental component TM as an incremental TM, with
+   empty counts.
+
+   config: incremental Config object
+   force_init: if true, force model initialization even if models already exist.
+   """
+   incr_cmpt_tm_name = config.get_incr_cmpt_tm_name()
+   incrtm_name = incr_cmpt_tm_name + ".incrtm"
+   counts_name = incr_cmpt_tm_name + ".jpt"
+   if not force_init and os.path.exists(incrtm_name):
+      fatal_error("Incremental component incremental TM already exists:", incrtm_name)
+   # Same word alignment models and options as incr-update.sh's gen_phrase_tables
+   al_base = "models/tm/hmm3.tm-train."
+   if "ALIGNMENT_MODEL_BASE" in config:
+      al_base = config.get_unquoted_value("ALIGNMENT_MODEL_BASE")
+   src_lang = config.get_unquoted_value("SRC_LANG")
+   tgt_lang = config.get_unquoted_value("TGT_LANG")
+   verbose("Creating the starter incremental component incremental TM:", incrtm_name)
+   with open(incrtm_name, 'w') as incrtm_fd:
+      print("Portage incremental TM v1.0", file=incrtm_fd)
+      print("counts\t{}".format(counts_name), file=incrtm_fd)
+      print("extractor\t-hmm -a GDFA -m 8 {b}{t}_given_{s}.gz {b}{s}_given_{t}.gz".format(
+            b=al_base, s=src_lang, t=tgt_lang), file=incrtm_fd)
+   open(counts_name, 'w').close()
+
+def create_incr_mixtm(incr_mixtm_name, main_tm_name, incr_cmpt_tm_name, incr_cmpt_tm_wts,
+                      force_init=False, tm_ext=".tppt"):
    """ Create the incremental mixTM.
    
    incr_mixtm_name: name of the incremental mixTM file
@@ -380,12 +443,13 @@ def create_incr_mixtm(incr_mixtm_name, main_tm_name, incr_cmpt_tm_name, incr_cmp
    incr_cmpt_tm_wts: list of incremental component TM model weights (1 or 4),
       each between 0.0 and 1.0
    force_init: if true, force model initialization even if models already exist.
+   tm_ext: extension of the incremental component TM file used in the mixTM
    """
    if not force_init and os.path.exists(incr_mixtm_name):
       fatal_error("Incremental mixTM already exists:", incr_mixtm_name)
    verbose("Creating the incremental mixTM:", incr_mixtm_name)
-   if not incr_cmpt_tm_name.endswith(".tppt"):
-      incr_cmpt_tm_name+=".tppt"
+   if not incr_cmpt_tm_name.endswith(tm_ext):
+      incr_cmpt_tm_name+=tm_ext
    if len(incr_cmpt_tm_wts) == 1:
       incr_cmpt_tm_wts.extend(incr_cmpt_tm_wts[0] for i in range(3))
    with open(incr_mixtm_name, 'w') as incr_mixtm_fd:
@@ -488,17 +552,25 @@ def main():
       warn("Incremental training supports only 4 column TMs.", main_tm_name,
            "is expected to have 4 columns." )
 
-   create_starter_incr_cmpt_lm(config.get_incr_cmpt_lm_name(), cmd_args.force_init)
+   if cmd_args.dynamic_lm:
+      create_starter_incr_cmpt_dynlm(config.get_incr_cmpt_lm_name(), cmd_args.force_init)
+   else:
+      create_starter_incr_cmpt_lm(config.get_incr_cmpt_lm_name(), cmd_args.force_init)
    
    create_incr_mixlm(config.get_incr_mixlm_name(), main_lm_name,
                      config.get_incr_cmpt_lm_name(), cmd_args.incr_cmpt_lm_wt,
-                     cmd_args.force_init)
+                     cmd_args.force_init,
+                     ".dynlm" if cmd_args.dynamic_lm else ".tplm")
 
-   create_starter_incr_cmpt_tm(config.get_incr_cmpt_tm_name(), cmd_args.force_init)
+   if cmd_args.incremental_tm:
+      create_starter_incr_cmpt_incrtm(config, cmd_args.force_init)
+   else:
+      create_starter_incr_cmpt_tm(config.get_incr_cmpt_tm_name(), cmd_args.force_init)
    
    create_incr_mixtm(config.get_incr_mixtm_name(), main_tm_name,
                      config.get_incr_cmpt_tm_name(), cmd_args.incr_cmpt_tm_wts,
-                     cmd_args.force_init)
+                     cmd_args.force_init,
+                     ".incrtm" if cmd_args.incremental_tm else ".tppt")
 
    config.write_local_config_file(cmd_args.force_init)
 
@@ -107,6 +107,17 @@ Usage: $PROG [options] [-c CANOE_INI] INCREMENTAL_CORPUS [SRC_BLOCK_CORPUS TGT_B
   contain the same number of marker lines consisting of just __BLOCK_END__ .
   WARNING: *** The two block files will be deleted once processed. ***
 
+  Incremental TM:
+  If the incremental TM is an incremental TM (INCREMENTAL_TM_BASE.L12L2.incrtm,
+  see incr-init-model.py -incremental-tm), only the sentence pairs added to
+  INCREMENTAL_CORPUS since the last update are aligned and added to its counts
+  with incr_tm_update; the number of lines already counted is kept in
+  INCREMENTAL_TM_BASE.L12L2.incrtm.done.  When the rolling window drops old
+  sentence pairs, they are aligned again and their counts subtracted, so the
+  cost of an update stays proportional to the number of sentence pairs added
+  and dropped; the counts are only rebuilt from the whole window if that
+  fails, e.g., because the word alignment models were changed.
+
 Options:
 
   -c CANOE_INI a canoe.ini to build incremental on-top of
@@ -251,19 +262,51 @@ if [[ $CORPUS_SIZE -eq 0 ]]; then
    exit 0
 fi
 
+# With an incremental TM, find out how many sentence pairs are new.
+INCREMENTAL_TM_DONE=$INCREMENTAL_TM.incrtm.done
+if [[ -e $INCREMENTAL_TM.incrtm ]]; then
+   DONE_SIZE=0
+   [[ -s $INCREMENTAL_TM_DONE ]] && DONE_SIZE=$(< $INCREMENTAL_TM_DONE)
+   NEW_SIZE=$(( $CORPUS_SIZE - $DONE_SIZE ))
+   INCRTM_RESET=
+   if [[ $NEW_SIZE -lt 0 ]]; then
+      verbose 1 "Incremental corpus was replaced, rebuilding the incremental TM"
+      INCRTM_RESET=1
+   fi
+fi
+
 # Apply the rolling window
+OLD_SIZE=0
 if [[ $CORPUS_SIZE -gt $MAX_INCR_CORPUS_SIZE ]]; then
+   if [[ -e $INCREMENTAL_TM.incrtm && ! $INCRTM_RESET ]]; then
+      # Keep the dropped sentence pairs already counted in the incremental TM,
+      # so their counts can be subtracted from it.
+      OLD_SIZE=$(( $CORPUS_SIZE - $MAX_INCR_CORPUS_SIZE ))
+      [[ $OLD_SIZE -gt $DONE_SIZE ]] && OLD_SIZE=$DONE_SIZE
+      [[ $NEW_SIZE -gt $MAX_INCR_CORPUS_SIZE ]] && NEW_SIZE=$MAX_INCR_CORPUS_SIZE
+      run_cmd -notime "head -n $OLD_SIZE < $INCREMENTAL_CORPUS > $WD/corpus.old"
+   fi
    TMP_CORPUS=`mktemp $INCREMENTAL_CORPUS.truncated.XXX`
    verbose 1 Truncating corpus via $TMP_CORPUS to max size $MAX_INCR_CORPUS_SIZE
    run_cmd -notime "tail -$MAX_INCR_CORPUS_SIZE < $INCREMENTAL_CORPUS > $TMP_CORPUS"
    run_cmd -notime "mv $TMP_CORPUS $INCREMENTAL_CORPUS"
+   CORPUS_SIZE=$MAX_INCR_CORPUS_SIZE
+fi
+[[ $INCRTM_RESET ]] && NEW_SIZE=$CORPUS_SIZE
+
+# The dropped sentence pairs are preprocessed along with the window, in front
+# of it, and split off again after lowercasing.
+PREP_CORPUS=$INCREMENTAL_CORPUS
+if [[ $OLD_SIZE -gt 0 ]]; then
+   run_cmd -notime "cat $WD/corpus.old $INCREMENTAL_CORPUS > $WD/corpus.all"
+   PREP_CORPUS=$WD/corpus.all
 fi
 
 # Separate the tab-separated corpus file into clean OSPL source and target files
 # Warning: don't call clean-utf8-text.pl before cut, since it replaces tab characters by spaces.
 verbose 1 Split the corpus into source and target
-run_cmd "cut -f 2 $INCREMENTAL_CORPUS | $SRC_PREPROCESS_CMD > $WD/source.raw"
-run_cmd "cut -f 3 $INCREMENTAL_CORPUS | $TGT_PREPROCESS_CMD > $WD/target.raw"
+run_cmd "cut -f 2 $PREP_CORPUS | $SRC_PREPROCESS_CMD > $WD/source.raw"
+run_cmd "cut -f 3 $PREP_CORPUS | $TGT_PREPROCESS_CMD > $WD/target.raw"
 
 # Tokenize
 verbose 1 Tokenize the source and target
@@ -275,46 +318,73 @@ verbose 1 Lowercase source and target
 run_cmd "$SRC_LOWERCASE_CMD < $WD/source.tok > $WD/source.lc"
 run_cmd "$TGT_LOWERCASE_CMD < $WD/target.tok > $WD/target.lc"
 
+if [[ $OLD_SIZE -gt 0 ]]; then
+   for side in source target; do
+      run_cmd -notime "head -n $OLD_SIZE $WD/$side.lc > $WD/$side.old.lc"
+      run_cmd -notime "tail -n +$(( $OLD_SIZE + 1 )) $WD/$side.lc > $WD/$side.window.lc"
+      run_cmd -notime "mv $WD/$side.window.lc $WD/$side.lc"
+   done
+fi
+
 # LM
-verbose 1 Train the incremental LM on target
-set +o errexit
-ulimit -c 0 # suppress estimate-ngram's core dump files (when corpus is too small)
-ESTIMATE_FILTER="perl -ple 's/^\\s+//; s/\\s+\$//; s/\\s+/ /g;' | fold -s -w 4095"
-ESTIMATE_CMD="estimate-ngram -s ML -text /dev/stdin -write-lm $WD/$INCREMENTAL_LM"
-run_cmd "cat $WD/target.lc | $ESTIMATE_FILTER | $ESTIMATE_CMD"
-RC=$?
-set -o errexit
-#echo RC=$RC
-if [[ $RC == 139 ]]; then
-   echo "Warning: estimate-ngram core dumped; adding dummy tokens to the document LM corpus and trying again"
-   { echo __DUMMY__ __DUMMY__ __DUMMY__ __DUMMY__; cat $WD/target.lc; } > $WD/target.lc.forLM
-   run_cmd "cat $WD/target.lc.forLM | $ESTIMATE_FILTER | $ESTIMATE_CMD" ||
-      error_exit "Cannot train document LM with added dummy tokens"
-elif [[ $RC != 0 ]]; then
-   error_exit "Cannot train document LM"
+if [[ -e $INCREMENTAL_LM.dynlm ]]; then
+   # A dynamic LM counts its corpus itself, and running decoders recount it as
+   # soon as it is replaced, so there is nothing to train.
+   verbose 1 Install the target as the dynamic incremental LM corpus
+   run_cmd -notime "cp $WD/target.lc $WD/$INCREMENTAL_LM.corpus"
+   INCREMENTAL_LM_FILES=$INCREMENTAL_LM.corpus
+else
+   INCREMENTAL_LM_FILES="$INCREMENTAL_LM $INCREMENTAL_LM.tplm"
+   verbose 1 Train the incremental LM on target
+   set +o errexit
+   ulimit -c 0 # suppress estimate-ngram's core dump files (when corpus is too small)
+   ESTIMATE_FILTER="perl -ple 's/^\\s+//; s/\\s+\$//; s/\\s+/ /g;' | fold -s -w 4095"
+   ESTIMATE_CMD="estimate-ngram -s ML -text /dev/stdin -write-lm $WD/$INCREMENTAL_LM"
+   run_cmd "cat $WD/target.lc | $ESTIMATE_FILTER | $ESTIMATE_CMD"
+   RC=$?
+   set -o errexit
+   #echo RC=$RC
+   if [[ $RC == 139 ]]; then
+      echo "Warning: estimate-ngram core dumped; adding dummy tokens to the document LM corpus and trying again"
+      { echo __DUMMY__ __DUMMY__ __DUMMY__ __DUMMY__; cat $WD/target.lc; } > $WD/target.lc.forLM
+      run_cmd "cat $WD/target.lc.forLM | $ESTIMATE_FILTER | $ESTIMATE_CMD" ||
+         error_exit "Cannot train document LM with added dummy tokens"
+   elif [[ $RC != 0 ]]; then
+      error_exit "Cannot train document LM"
+   fi
+   verbose 1 Tightly pack the incremental LM
+   run_cmd "(cd $WD; arpalm2tplm.sh $INCREMENTAL_LM)" ||
+      error_exit "Cannot tightly pack document LM"
 fi
-verbose 1 Tightly pack the incremental LM
-run_cmd "(cd $WD; arpalm2tplm.sh $INCREMENTAL_LM)" ||
-   error_exit "Cannot tightly pack document LM"
 
 # TM
-verbose 1 Train the incremental TM from source and target
-run_cmd "gen_phrase_tables -o $WD/$INCREMENTAL_TM_BASE -1 $SRC_LANG -2 $TGT_LANG -multipr fwd \
-   -s RFSmoother -s ZNSmoother -write-count -write-al top -whole -m 8 -a GDFA \
-   $ALIGNMENT_MODEL_BASE${TGT_LANG}_given_$SRC_LANG.gz \
-   $ALIGNMENT_MODEL_BASE${SRC_LANG}_given_$TGT_LANG.gz \
-   $WD/source.lc $WD/target.lc" ||
-   error_exit "Cannot generated document TM"
-
-if [[ ! -s $WD/$INCREMENTAL_TM ]]; then
-   verbose 1 Generated TM is empty, putting a dummy phrase pair in it
-   echo '__DUMMY__ ||| __DUMMY__ ||| 1 1.17549e-38 1 1.17549e-38 a=0 c=1' > $WD/$INCREMENTAL_TM
-fi
+if [[ -e $INCREMENTAL_TM.incrtm ]]; then
+   # An incremental TM only needs the new sentence pairs, which are added to
+   # its counts once we hold the update lock, below.
+   verbose 1 Select the $NEW_SIZE new sentence pairs for the incremental TM
+   run_cmd -notime "tail -n $NEW_SIZE $WD/source.lc > $WD/source.new.lc"
+   run_cmd -notime "tail -n $NEW_SIZE $WD/target.lc > $WD/target.new.lc"
+   INCREMENTAL_TM_FILES=
+else
+   INCREMENTAL_TM_FILES="$INCREMENTAL_TM $INCREMENTAL_TM.tppt"
+   verbose 1 Train the incremental TM from source and target
+   run_cmd "gen_phrase_tables -o $WD/$INCREMENTAL_TM_BASE -1 $SRC_LANG -2 $TGT_LANG -multipr fwd \
+      -s RFSmoother -s ZNSmoother -write-count -write-al top -whole -m 8 -a GDFA \
+      $ALIGNMENT_MODEL_BASE${TGT_LANG}_given_$SRC_LANG.gz \
+      $ALIGNMENT_MODEL_BASE${SRC_LANG}_given_$TGT_LANG.gz \
+      $WD/source.lc $WD/target.lc" ||
+      error_exit "Cannot generated document TM"
+
+   if [[ ! -s $WD/$INCREMENTAL_TM ]]; then
+      verbose 1 Generated TM is empty, putting a dummy phrase pair in it
+      echo '__DUMMY__ ||| __DUMMY__ ||| 1 1.17549e-38 1 1.17549e-38 a=0 c=1' > $WD/$INCREMENTAL_TM
+   fi
 
-ls $WD
-verbose 1 Tightly pack the incremental TM
-run_cmd "(cd $WD; textpt2tppt.sh $INCREMENTAL_TM)" ||
-   error_exit "Cannot tightly pack document TM"
+   ls $WD
+   verbose 1 Tightly pack the incremental TM
+   run_cmd "(cd $WD; textpt2tppt.sh $INCREMENTAL_TM)" ||
+      error_exit "Cannot tightly pack document TM"
+fi
 
 (
    # Get the lock to update the models
@@ -326,7 +396,7 @@ run_cmd "(cd $WD; textpt2tppt.sh $INCREMENTAL_TM)" ||
    rm -rf $BK
    mkdir $BK
    #ls -l $WD $BK .
-   time for model in $INCREMENTAL_TM $INCREMENTAL_TM.tppt $INCREMENTAL_LM $INCREMENTAL_LM.tplm; do
+   time for model in $INCREMENTAL_TM_FILES $INCREMENTAL_LM_FILES; do
       if [[ -e $model ]]; then
          run_cmd -notime "mv $model $BK"
       fi
@@ -340,13 +410,32 @@ run_cmd "(cd $WD; textpt2tppt.sh $INCREMENTAL_TM)" ||
       verbose 1 "All good"
    else
       verbose 1 "Problem with final canoe config, rolling back update"
-      for model in $INCREMENTAL_TM $INCREMENTAL_TM.tppt $INCREMENTAL_LM $INCREMENTAL_LM.tplm; do
+      for model in $INCREMENTAL_TM_FILES $INCREMENTAL_LM_FILES; do
          run_cmd -notime "mv $model $WD" || true
          run_cmd -notime "mv $BK/$model ." || true
       done
       exit 1
    fi
 
+   if [[ -e $INCREMENTAL_TM.incrtm ]]; then
+      if [[ $OLD_SIZE -gt 0 ]]; then
+         verbose 1 Replace the $OLD_SIZE sentence pairs dropped from the window by the new ones in the incremental TM
+         if ! run_cmd "incr_tm_update -remove-src $WD/source.old.lc -remove-tgt $WD/target.old.lc \
+                  $INCREMENTAL_TM.incrtm $WD/source.new.lc $WD/target.new.lc"
+         then
+            warn "Cannot remove the dropped sentence pairs from the incremental TM, rebuilding it"
+            run_cmd "incr_tm_update -reset $INCREMENTAL_TM.incrtm $WD/source.lc $WD/target.lc" ||
+               error_exit "Cannot update the incremental TM"
+         fi
+      else
+         verbose 1 Add the new sentence pairs to the incremental TM
+         run_cmd "incr_tm_update ${INCRTM_RESET:+-reset} $INCREMENTAL_TM.incrtm \
+                  $WD/source.new.lc $WD/target.new.lc" ||
+            error_exit "Cannot update the incremental TM"
+      fi
+      echo $CORPUS_SIZE > $INCREMENTAL_TM_DONE
+   fi
+
    # sleep 5 # insert this to test whether the locking is really working
    verbose 1 "Releasing update lock"
 ) 202<$incr_canoe_ini
@@ -0,0 +1,80 @@
+/**
+ * @file jpt2bjpt.cc
+ * @brief Convert a sorted text joint phrase table to the binary JPT format.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "binary_jpt.h"
+#include "file_utils.h"
+#include "arg_reader.h"
+#include "printCopyright.h"
+#include "exception_dump.h"  // MAIN
+
+using namespace Portage;
+using namespace std;
+
+static char help_message[] = "\n\
+jpt2bjpt [-v] [INFILE [OUTFILE]]\n\
+\n\
+  Convert text joint phrase table INFILE, which must be LC_ALL=C sorted, to\n\
+  the binary JPT format.  Each line of INFILE has the form\n\
+  'p1 ||| p2 ||| values [extras]', where extras are any non-numeric fields\n\
+  following the values, e.g., alignments.\n\
+\n\
+  Binary JPTs are vocabulary-encoded and block-compressed: they are smaller\n\
+  than gzipped text JPTs and much faster to read.  merge_counts merges them\n\
+  directly, and merge_multi_column_counts and the joint table readers (e.g.,\n\
+  joint2cond_phrase_tables) accept them.  Use bjpt2jpt to convert back.\n\
+\n\
+Options:\n\
+\n\
+  -v    Write progress reports to cerr.\n\
+";
+
+static bool verbose = false;
+static string infile("-");
+static string outfile("-");
+static void getArgs(int argc, const char* const argv[]);
+
+int MAIN(argc, argv)
+{
+   printCopyright(2026, "jpt2bjpt");
+   getArgs(argc, argv);
+
+   iSafeMagicStream is(infile);
+   BinaryJPTWriter writer(outfile);
+   BinaryJPTEntry entry;
+   string line;
+   Uint64 lineno = 0;
+   while (getline(is, line)) {
+      ++lineno;
+      if (!writer.writeLine(line, entry))
+         error(ETFatal, "Invalid JPT line %llu in %s: %s",
+               (unsigned long long)lineno, infile.c_str(), line.c_str());
+   }
+   writer.close();
+   if (verbose)
+      cerr << "Converted " << writer.numEntries() << " entries, "
+           << writer.getVoc().size() << " distinct tokens" << endl;
+
+   return 0;
+}
+END_MAIN
+
+// arg processing
+
+void getArgs(int argc, const char* const argv[])
+{
+   const char* switches[] = {"v"};
+   ArgReader arg_reader(ARRAY_SIZE(switches), switches, 0, 2, help_message);
+   arg_reader.read(argc-1, argv+1);
+
+   arg_reader.testAndSet("v", verbose);
+   arg_reader.testAndSet(0, "infile", infile);
+   arg_reader.testAndSet(1, "outfile", outfile);
+}
@@ -11,6 +11,10 @@
  * because the compiler will output funny linker errors if a separate .cc or
  * .cpp file is created
  *
+ * Distances with unit costs are calculated with the bit-parallel algorithm in
+ * BitParallelLevenshtein; the O(n*m) dynamic programming with back-pointers is
+ * only used when an alignment or non-unit costs are requested.
+ *
  * Technologies langagieres interactives / Interactive Language Technologies
  * Inst. de technologie de l'information / Institute for Information Technology
  * Conseil national de recherches Canada / National Research Council Canada
@@ -25,6 +29,7 @@
 #include "portage_defs.h"
 #include <boost/dynamic_bitset.hpp>
 #include <iostream>
+#include <algorithm>
 #include <sys/types.h>
 
 namespace Portage {
@@ -70,6 +75,142 @@ class bkp {
 };
 
 
+/**
+ * Bit-parallel Levenshtein distance with unit costs, after Myers (1999), "A
+ * fast bit-vector algorithm for approximate string matching based on dynamic
+ * programming", with the blocks of 64 reference positions described there.
+ * Each column of the distance matrix is encoded as vertical +1/-1 deltas in
+ * bit vectors and updated in O(ceil(m/64)) word operations per hyp token, so
+ * sentences up to 64 tokens take a handful of operations per token, and
+ * longer ones degrade gracefully instead of needing a separate banded method.
+ *
+ * T must support operator< and operator==: the reference tokens are sorted to
+ * build the match bit vectors.  The workspace is kept between calls to avoid
+ * allocations.
+ */
+template<class T> class BitParallelLevenshtein {
+private:
+  typedef Uint64 Word;
+  static const Uint W = 64;  ///< bits per block
+
+  /// Order pointers to tokens by token.
+  struct PtrLess {
+    bool operator()(const T* a, const T* b) const { return *a < *b; }
+  };
+  /// Compare pointers to tokens by token.
+  struct PtrEqual {
+    bool operator()(const T* a, const T* b) const { return *a == *b; }
+  };
+
+  vector<const T*> keys;  ///< distinct reference tokens, sorted
+  vector<Word> peq;       ///< match vectors, for each key, then no match
+  vector<Word> P, M;      ///< vertical +1 and -1 deltas of the current column
+
+public:
+  /**
+   * Calculate the Levenshtein distance between hyp and ref with unit costs.
+   * Same semantics as Levenshtein<T>::LevenDist() with default costs.
+   * @param hyp            a vector representing the tokens in the hypothesis
+   * @param ref            a vector representing the tokens in the reference
+   * @param incompleteRef  how much of the reference has to be covered:
+   *                       0 : complete ref.
+   *                       1 : start from beginning, end anywhere
+   *                       2 : start anywhere, end anywhere
+   * @param column         if non-NULL, set to the last column of the
+   *                       distance matrix: (*column)[i] is the distance to
+   *                       ref[0..i-1], or to its best suffix if incompleteRef==2
+   * @return the distance; for incompleteRef != 0, the minimum over column
+   */
+  int distance(const vector<T>& hyp, const vector<T>& ref,
+               const int incompleteRef = 0, vector<int>* column = NULL);
+};
+
+template<class T>
+int BitParallelLevenshtein<T>::distance(const vector<T>& hyp, const vector<T>& ref,
+                                        const int incompleteRef, vector<int>* column)
+{
+  const Uint n = hyp.size();
+  const Uint m = ref.size();
+  if (m == 0) {
+    if (column) column->assign(1, n);
+    return n;
+  }
+  const Uint blocks = (m + W - 1) / W;
+
+  /**
+   * Match vectors: bit i of peq[k*blocks + i/W] is set iff ref[i] == keys[k];
+   * the all-zero vector after the last key is for tokens not in ref.
+   */
+  keys.resize(m);
+  for (Uint i = 0; i < m; ++i)
+    keys[i] = &ref[i];
+  sort(keys.begin(), keys.end(), PtrLess());
+  keys.erase(unique(keys.begin(), keys.end(), PtrEqual()), keys.end());
+  peq.assign((keys.size() + 1) * blocks, 0);
+  for (Uint i = 0; i < m; ++i) {
+    const Uint k = lower_bound(keys.begin(), keys.end(), &ref[i], PtrLess()) - keys.begin();
+    peq[k * blocks + i / W] |= Word(1) << (i % W);
+  }
+
+  /**
+   * Column 0: D[i][0] = i (all deltas +1), or 0 if the ref can start anywhere.
+   * Row 0: D[0][j] = j, i.e., a +1 horizontal delta enters the first block.
+   */
+  P.assign(blocks, incompleteRef == 2 ? Word(0) : ~Word(0));
+  M.assign(blocks, 0);
+  const Word last_high = Word(1) << ((m - 1) % W);
+  const Word high = Word(1) << (W - 1);
+  int score = incompleteRef == 2 ? 0 : m;  // D[m][0]
+
+  for (Uint j = 0; j < n; ++j) {
+    const typename vector<const T*>::const_iterator it =
+      lower_bound(keys.begin(), keys.end(), &hyp[j], PtrLess());
+    const Uint k = (it != keys.end() && **it == hyp[j]) ? it - keys.begin() : keys.size();
+    const Word* eq = &peq[k * blocks];
+    int hin = 1;
+    for (Uint b = 0; b < blocks; ++b) {
+      const Word Pv = P[b], Mv = M[b];
+      Word Eq = eq[b];
+      const Word Xv = Eq | Mv;
+      if (hin < 0) Eq |= 1;
+      const Word Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+      Word Ph = Mv | ~(Xh | Pv);
+      Word Mh = Pv & Xh;
+      const Word h = b + 1 == blocks ? last_high : high;
+      const int hout = (Ph & h) ? 1 : (Mh & h) ? -1 : 0;
+      Ph <<= 1;
+      Mh <<= 1;
+      if (hin < 0) Mh |= 1;
+      else if (hin > 0) Ph |= 1;
+      P[b] = Mh | ~(Xv | Ph);
+      M[b] = Ph & Xv;
+      hin = hout;
+    }
+    score += hin;
+  }
+
+  if (incompleteRef == 0 && !column)
+    return score;
+
+  // Unroll the deltas of the last column from D[0][n] = n.
+  int d = n;
+  int best = d;
+  if (column) {
+    column->resize(m + 1);
+    (*column)[0] = d;
+  }
+  for (Uint i = 0; i < m; ++i) {
+    const Word bit = Word(1) << (i % W);
+    if (P[i / W] & bit) ++d;
+    else if (M[i / W] & bit) --d;
+    if (d < best) best = d;
+    if (column) (*column)[i + 1] = d;
+  }
+  assert(d == score);
+  return incompleteRef == 0 ? score : best;
+}
+
+
 /**
  * Class for Levenshtein alignment.
  * Elements: matrix storing the best predecessor of each point
@@ -82,6 +223,16 @@ private:
   int                   costs;
   int                   verbose;
   int                   subcost;
+  BitParallelLevenshtein<T> bitpar;
+
+  /// Whether the distance can be calculated by bitpar, i.e., with unit costs.
+  bool unitCosts(const vector<int>* ins_costs, const vector<int>* del_costs) const {
+    return !ins_costs && !del_costs && subcost == 1 && verbose == 0;
+  }
+
+  void        LevenDP(const vector<T> &hyp, const vector<T> &ref,
+                      const int incompleteRef, const vector<int>* ins_costs,
+                      const vector<int>* del_costs, bool backpointers);
 
 public:
   typedef vector<T>                          Tv;
@@ -170,8 +321,23 @@ void Levenshtein<T>::LevenAlign(const Tv &hyp, const Tv &ref,
                                 const int incompleteRef,
                                 const vector<int>* ins_costs,
                                 const vector<int>* del_costs)
+{
+  LevenDP(hyp, ref, incompleteRef, ins_costs, del_costs, true);
+}
+
+/**
+ * Dynamic programming for LevenAlign(), leaving the last column of the
+ * Levenshtein matrix in Q, and filling 'Book' only if backpointers is true.
+ */
+template<class T>
+void Levenshtein<T>::LevenDP(const Tv &hyp, const Tv &ref,
+                             const int incompleteRef,
+                             const vector<int>* ins_costs,
+                             const vector<int>* del_costs,
+                             bool backpointers)
 {
   clear();
+  const bool bk = backpointers || verbose > 3;
 
   if (ins_costs) assert(ins_costs->size() == hyp.size());
   if (del_costs) assert(del_costs->size() == ref.size());
@@ -189,16 +355,18 @@ void Levenshtein<T>::LevenAlign(const Tv &hyp, const Tv &ref,
   /**
    * init
    */
-  bkp dummy(-1,-1,4);
-  vector<bkp> dummyvec(ref.size()+1,dummy);
-  Book.resize(hyp.size()+1,dummyvec);
-  /**
-   * Backpointers for deleting/inserting all ref/hyp words.
-   */
-  for (uint i=1; i<=ref.size(); i++)
-    Book[0][i] = bkp(0,i-1,del);
-  for (uint j=1; j<=hyp.size(); j++)
-    Book[j][0] = bkp(j-1,0,ins);
+  if (bk) {
+    bkp dummy(-1,-1,4);
+    vector<bkp> dummyvec(ref.size()+1,dummy);
+    Book.resize(hyp.size()+1,dummyvec);
+    /**
+     * Backpointers for deleting/inserting all ref/hyp words.
+     */
+    for (uint i=1; i<=ref.size(); i++)
+      Book[0][i] = bkp(0,i-1,del);
+    for (uint j=1; j<=hyp.size(); j++)
+      Book[j][0] = bkp(j-1,0,ins);
+  }
 
   /**
    * store current column of the Levenshtein matrix in 'Q', and previous column
@@ -232,7 +400,7 @@ void Levenshtein<T>::LevenAlign(const Tv &hyp, const Tv &ref,
      * position 0 in reference corresponds to insertion of all hyp words
      */
     Q[0] = Q_old[0] + (ins_costs ? (*ins_costs)[j-1] : 1);
-    Book[j][0] = bkp(j-1,0,ins);
+    if (bk) Book[j][0] = bkp(j-1,0,ins);
 
     for (uint i=1; i<=ref.size(); i++) {
 
@@ -252,7 +420,7 @@ void Levenshtein<T>::LevenAlign(const Tv &hyp, const Tv &ref,
       if (qsub <= qdel) {
         if (qsub <= qins) {
           Q[i]       = qsub;
-          Book[j][i] = bkp(j-1,i-1,subcosts);
+          if (bk) Book[j][i] = bkp(j-1,i-1,subcosts);
           if (verbose>5) {
             cerr << "  sub, bkp: " << Book[j][i];
             cerr << " " << Book[j-1][i-1];
@@ -261,7 +429,7 @@ void Levenshtein<T>::LevenAlign(const Tv &hyp, const Tv &ref,
         } // substitution
         else {
           Q[i]       = qins;
-          Book[j][i] = bkp(j-1,i,ins);
+          if (bk) Book[j][i] = bkp(j-1,i,ins);
           if (verbose>5) {
             cerr << "  ins, bkp: " << Book[j][i];
             cerr << " " << Book[j-1][i];
@@ -271,7 +439,7 @@ void Levenshtein<T>::LevenAlign(const Tv &hyp, const Tv &ref,
       }
       else if (qdel <= qins) {
         Q[i]       = qdel;
-        Book[j][i] = bkp(j,i-1,del);
+        if (bk) Book[j][i] = bkp(j,i-1,del);
           if (verbose>5) {
             cerr << "  del, bkp: " << Book[j][i];
             cerr << " " << Book[j][i-1];
@@ -280,7 +448,7 @@ void Levenshtein<T>::LevenAlign(const Tv &hyp, const Tv &ref,
       } // deletion
       else {
         Q[i]       = qins;
-        Book[j][i] = bkp(j-1,i,ins);
+        if (bk) Book[j][i] = bkp(j-1,i,ins);
         if (verbose>5) {
           cerr << "  ins, bkp: " << Book[j][i];
           cerr << " " << Book[j-1][i];
@@ -433,7 +601,10 @@ template<class T>
                                 const vector<int>* ins_costs,
                                 const vector<int>* del_costs) {
 
-  LevenAlign(hyp, ref, incompleteRef, ins_costs, del_costs);
+  if (unitCosts(ins_costs, del_costs))
+    costs = bitpar.distance(hyp, ref, incompleteRef);
+  else
+    LevenDP(hyp, ref, incompleteRef, ins_costs, del_costs, false);
 
   return costs;
 }
@@ -465,7 +636,10 @@ template<class T>
         boost::dynamic_bitset<>* min_positions,
         const vector<int>* ins_costs, const vector<int>* del_costs) {
 
-  LevenAlign(hyp, ref, incompleteRef, ins_costs, del_costs);
+  if (unitCosts(ins_costs, del_costs))
+    costs = bitpar.distance(hyp, ref, incompleteRef, &Q);
+  else
+    LevenDP(hyp, ref, incompleteRef, ins_costs, del_costs, false);
 
 
   if (verbose>1) {
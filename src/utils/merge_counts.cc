@@ -17,21 +17,32 @@
 #include "file_utils.h"
 #include "arg_reader.h"
 #include "merge_stream.h"
+#include "binary_jpt.h"
+#include "vector_map.h"
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <queue>
+#include <cstdio>
 
 using namespace Portage;
 using namespace std;
 
 static char help_message[] = "\n\
-merge_counts [-v][-d] OUTFILE INFILE(S)\n\
+merge_counts [-v][-d][-b] OUTFILE INFILE(S)\n\
 \n\
 Merge count files.  The count must be at the end of each line, seperated by at\n\
 least one space.  Input files must be LC_ALL=C sorted.\n\
 \n\
+Input files may also be binary joint phrase tables (see jpt2bjpt).  When all\n\
+of them are, they are merged directly, without any text parsing: all value\n\
+columns are summed, alignment fields (a=...) are merged as in\n\
+merge_multi_column_counts -a, and other extra fields are kept from the first\n\
+file with the phrase pair.\n\
+\n\
 Options:\n\
 \n\
+-b  Write OUTFILE as a binary joint phrase table. [write text]\n\
 -t  Use a tab character instead of a space as delimiter.\n\
 -d  Write debugging info. [don't]\n\
 -v  Write progress reports to cerr. [don't]\n\
@@ -41,6 +52,7 @@ Options:\n\
 
 static bool bDebug = false;
 static bool verbose = false;
+static bool binary_out = false;
 static char delimiter = ' ';
 static vector<string> infiles;
 static string outfile("-");
@@ -101,6 +113,180 @@ struct Datum {
 
 
 
+/**
+ * One binary JPT input for mergeBinaryJPTs().
+ */
+struct BinaryInput : private NonCopyable {
+   BinaryJPTReader reader;
+   const Uint index;      ///< position on the command line
+   string key;            ///< key of the current entry
+   vector<Uint> remap;    ///< reader voc index -> writer voc index + 1; 0 if unmapped
+
+   BinaryInput(const string& file, Uint index) : reader(file), index(index) {}
+
+   /// Read the next entry; return false at the end of the file.
+   bool next() {
+      if (!reader.next()) return false;
+      key.clear();
+      reader.entry().appendKey(key, reader.getVoc());
+      return true;
+   }
+
+   /// Map tokens from the reader's vocabulary to the writer's.
+   void mapTokens(const vector<Uint>& in, vector<Uint>& out, BinaryJPTWriter& writer) {
+      out.resize(in.size());
+      for (Uint i = 0; i < in.size(); ++i) {
+         if (in[i] >= remap.size())
+            remap.resize(reader.getVoc().size(), 0);
+         Uint& m = remap[in[i]];
+         if (m == 0) m = writer.wordIndex(reader.getVoc().word(in[i])) + 1;
+         out[i] = m - 1;
+      }
+   }
+
+   /// Min-heap order on (key, index)
+   struct Greater {
+      bool operator()(const BinaryInput* a, const BinaryInput* b) const {
+         const int c = a->key.compare(b->key);
+         return c == 0 ? a->index > b->index : c > 0;
+      }
+   };
+};
+
+/**
+ * Tally alignment field a=<align>[:<count>](;<align>[:<count>])* into
+ * alignments.
+ */
+static void tallyAlignments(const char* field, vector_map<string,double>& alignments)
+{
+   vector<string> all_alignments;
+   split(field+2, all_alignments, ";");
+   for (Uint i = 0; i < all_alignments.size(); ++i) {
+      const string::size_type colon_pos = all_alignments[i].find(':');
+      double count = 1;
+      if (colon_pos != string::npos &&
+          !conv(all_alignments[i].substr(colon_pos+1), count))
+         error(ETWarn, "Count is not a number in %s", field);
+      alignments[all_alignments[i].substr(0, colon_pos)] += count;
+   }
+}
+
+/// Format alignments as merge_multi_column_counts -a does.
+static void formatAlignments(const vector_map<string,double>& alignments, string& field)
+{
+   field = "a=";
+   char buf[32];
+   for (vector_map<string,double>::const_iterator it(alignments.begin()), end(alignments.end());
+        it != end; ) {
+      field += it->first;
+      if (it->second != 1 || alignments.size() != 1) {
+         snprintf(buf, sizeof(buf), ":%g", it->second);
+         field += buf;
+      }
+      if (++it != end) field += ';';
+   }
+}
+
+/**
+ * Merge binary JPTs by streaming k-way merge, writing a text or binary JPT.
+ */
+static void mergeBinaryJPTs()
+{
+   priority_queue<BinaryInput*, vector<BinaryInput*>, BinaryInput::Greater> heap;
+   vector<BinaryInput*> inputs;
+   for (Uint i = 0; i < infiles.size(); ++i) {
+      inputs.push_back(new BinaryInput(infiles[i], i));
+      if (inputs.back()->next())
+         heap.push(inputs.back());
+      else
+         cerr << "Ignoring empty input file: " << infiles[i] << endl;
+   }
+
+   BinaryJPTWriter* writer = binary_out ? new BinaryJPTWriter(outfile) : NULL;
+   oSafeMagicStream* out = binary_out ? NULL : new oSafeMagicStream(outfile);
+
+   string key, line, field;
+   BinaryJPTEntry merged;
+   vector<double> values;
+   vector<string> extras;
+   vector_map<string,double> alignments;
+   Uint64 num_merged = 0;
+   while (!heap.empty()) {
+      BinaryInput* first = heap.top();
+      key = first->key;
+      if (writer) {
+         first->mapTokens(first->reader.entry().phrase1, merged.phrase1, *writer);
+         first->mapTokens(first->reader.entry().phrase2, merged.phrase2, *writer);
+      }
+      values.clear();
+      extras.clear();
+      alignments.clear();
+      bool has_alignments = false;
+
+      BinaryInput* in;
+      while (!heap.empty() && (in = heap.top(), in->key == key)) {
+         heap.pop();
+         const BinaryJPTEntry& e = in->reader.entry();
+         if (values.empty())
+            values = e.values;
+         else if (values.size() != e.values.size())
+            error(ETFatal, "Different numbers of values for %s in %s",
+                  key.c_str(), infiles[in->index].c_str());
+         else
+            for (Uint i = 0; i < values.size(); ++i)
+               values[i] += e.values[i];
+         for (Uint i = 0; i < e.extras.size(); ++i) {
+            const char* x = in->reader.getVoc().word(e.extras[i]);
+            if (x[0] == 'a' && x[1] == '=') {
+               has_alignments = true;
+               tallyAlignments(x, alignments);
+            } else if (in == first) {
+               extras.push_back(x);
+            }
+         }
+         if (bDebug) {
+            line.clear();
+            e.appendLine(line, in->reader.getVoc());
+            cerr << "IN " << in->index << "\t" << line << endl;
+         }
+         if (in->next())
+            heap.push(in);
+      }
+      if (has_alignments) {
+         formatAlignments(alignments, field);
+         extras.push_back(field);
+      }
+
+      if (writer) {
+         merged.values = values;
+         merged.extras.clear();
+         for (Uint i = 0; i < extras.size(); ++i)
+            merged.extras.push_back(writer->wordIndex(extras[i].c_str()));
+         writer->write(merged);
+      } else {
+         line = key;
+         for (Uint i = 0; i < values.size(); ++i) {
+            line += ' ';
+            appendJPTValue(line, values[i]);
+         }
+         for (Uint i = 0; i < extras.size(); ++i) {
+            line += ' ';
+            line += extras[i];
+         }
+         line += '\n';
+         out->write(line.data(), line.size());
+      }
+      ++num_merged;
+   }
+
+   delete writer;
+   delete out;
+   for (Uint i = 0; i < inputs.size(); ++i)
+      delete inputs[i];
+   if (verbose)
+      cerr << "Wrote " << num_merged << " merged entries" << endl;
+}
+
 // main
 int main(int argc, char* argv[])
 {
@@ -109,11 +295,30 @@ int main(int argc, char* argv[])
 
    cerr << "Merging: " << endl << join(infiles) << endl;
 
-   mergeStream<Datum>  ms(infiles);
-   oSafeMagicStream    out(outfile);
+   bool all_binary = true;
+   for (Uint i = 0; i < infiles.size() && all_binary; ++i)
+      all_binary = isBinaryJPT(infiles[i]);
+   if (all_binary) {
+      mergeBinaryJPTs();
+      return 0;
+   }
 
-   while (!ms.eof()) {
-      ms.next().print(out);
+   mergeStream<Datum>  ms(infiles);
+   if (binary_out) {
+      BinaryJPTWriter writer(outfile);
+      BinaryJPTEntry entry;
+      ostringstream oss;
+      while (!ms.eof()) {
+         oss.str("");
+         ms.next().print(oss);
+         if (!writer.writeLine(oss.str(), entry))
+            error(ETFatal, "Not a JPT line: %s", oss.str().c_str());
+      }
+   } else {
+      oSafeMagicStream    out(outfile);
+      while (!ms.eof()) {
+         ms.next().print(out);
+      }
    }
 }
 
@@ -121,12 +326,13 @@ int main(int argc, char* argv[])
 
 void getArgs(int argc, char* argv[])
 {
-   const char* switches[] = {"v", "d", "t"};
+   const char* switches[] = {"v", "d", "t", "b"};
    ArgReader arg_reader(ARRAY_SIZE(switches), switches, 2, -1, help_message);
    arg_reader.read(argc-1, argv+1);
 
    arg_reader.testAndSet("v", verbose);
    arg_reader.testAndSet("d", bDebug);
+   arg_reader.testAndSet("b", binary_out);
    bool tab_delim(false);
    arg_reader.testAndSet("t", tab_delim);
    if ( tab_delim ) delimiter = '\t';
@@ -17,6 +17,7 @@
 #define __MERGE_STREAM_H__
 
 #include "file_utils.h"
+#include "binary_jpt.h"
 #include <queue>  // priority_queue
 #include <string>
 
@@ -53,7 +54,7 @@ class mergeStream : private NonCopyable
          private:
             const string       file;   ///< Filename
             Uint               lineno; ///< Current line number
-            iSafeMagicStream   input;  ///< file stream
+            istream* const     input;  ///< file stream; binary JPTs are read as text
             Datum*             _data;  ///< Datum
             string             buffer; ///< line buffer
             /// We need a placeholder to keep track of the entries to check if
@@ -66,7 +67,7 @@ class mergeStream : private NonCopyable
             Stream(const string& file, Uint pId)
             : file(file)
             , lineno(0)
-            , input(file)
+            , input(openJPTAsText(file))
             , _data(new Datum)
             , positional_id(pId)
             {
@@ -76,10 +77,10 @@ class mergeStream : private NonCopyable
             }
 
             /// Destructor.
-            ~Stream() { delete _data; }
+            ~Stream() { delete _data; delete input; }
 
             /// eof returns true on eof and other errors
-            bool eof() const { return !input; }
+            bool eof() const { return !*input; }
 
             /**
              * Swaps this stream's buffer with spare.
@@ -93,7 +94,7 @@ class mergeStream : private NonCopyable
             }
 
             void get() {
-               if (getline(input, buffer)) {
+               if (getline(*input, buffer)) {
                   ++lineno;
                   if (!_data->parse(buffer, positional_id)) {
                      error(ETFatal, "Error parsing line %d of %s\n", file.c_str(), lineno);
@@ -106,7 +107,7 @@ class mergeStream : private NonCopyable
                   }
                   previous_key = _data->getKey();
                }
-               if (input.bad())
+               if (input->bad())
                   error(ETFatal, "Problem after line %d of %s.  File may be corrupt.\n",
                         lineno, file.c_str());
             }
@@ -0,0 +1,169 @@
+/**
+ * @file mm_voc.cc
+ * @brief An immutable, memory mapped vocabulary with a perfect hash index.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "mm_voc.h"
+#include "voc.h"
+#include "errors.h"
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <algorithm>
+#include <fstream>
+#include <cerrno>
+
+using namespace Portage;
+
+const char* const MMVoc::version = "Portage MMVoc-1.0";
+const uint32_t MMVoc::NO_WORD;
+
+/*
+ * File layout, after the magic line padded with NULs to a multiple of 8 bytes:
+ *    uint32_t num_words, num_buckets, num_slots, seed, strings_size, reserved
+ *    uint32_t displacements[num_buckets]
+ *    uint32_t slots[num_slots]
+ *    uint32_t offsets[num_words]
+ *    char     strings[strings_size]
+ * All integers are in native byte order, like TPT files.
+ */
+
+Uint MMVoc::headerOffset()
+{
+   return (strlen(version) + 1 + 7) & ~7u;
+}
+
+MMVoc::MMVoc(const string& filename)
+   : file(new boost::iostreams::mapped_file_source)
+{
+   if (!isMMVoc(filename))
+      error(ETFatal, "%s is not an MMVoc file: expected magic line '%s'",
+            filename.c_str(), version);
+   try {
+      file->open(filename);
+   }
+   catch (std::exception& e) {
+      error(ETFatal, "Unable to open memory mapped file '%s' for reading (errno=%d, %s).",
+            filename.c_str(), errno, strerror(errno));
+   }
+   if (!file->is_open())
+      error(ETFatal, "Unable to open memory mapped file '%s'.", filename.c_str());
+
+   const Uint hdr = headerOffset();
+   const uint32_t* header = reinterpret_cast<const uint32_t*>(file->data() + hdr);
+   if (file->size() < hdr + 6 * sizeof(uint32_t))
+      error(ETFatal, "Truncated MMVoc file %s", filename.c_str());
+   num_words = header[0];
+   num_buckets = header[1];
+   num_slots = header[2];
+   seed = header[3];
+   const uint32_t strings_size = header[4];
+   if (num_buckets == 0 || num_slots < num_words || num_slots == 0 ||
+       file->size() != hdr + sizeof(uint32_t) *
+          (6 + Uint64(num_buckets) + num_slots + num_words) + strings_size ||
+       (strings_size > 0 && file->data()[file->size()-1] != '\0'))
+      error(ETFatal, "Corrupt MMVoc file %s", filename.c_str());
+
+   displacements = header + 6;
+   slots = displacements + num_buckets;
+   offsets = slots + num_slots;
+   strings = reinterpret_cast<const char*>(offsets + num_words);
+}
+
+MMVoc::~MMVoc() {}
+
+bool MMVoc::isMMVoc(const string& filename)
+{
+   ifstream is(filename.c_str(), ios::in | ios::binary);
+   string line;
+   return is && getline(is, line) && line == version;
+}
+
+void MMVoc::write(const Voc& voc, ostream& os)
+{
+   const uint32_t n = voc.size();
+   const uint32_t num_buckets = n / 3 + 1;
+   const uint32_t num_slots = n + n / 4 + 1;
+
+   vector<uint32_t> offsets(n);
+   Uint64 strings_size = 0;
+   for (uint32_t i = 0; i < n; ++i) {
+      offsets[i] = uint32_t(strings_size);
+      strings_size += strlen(voc.word(i)) + 1;
+   }
+   if (strings_size > 0xFFFFFFFFu)
+      error(ETFatal, "Vocabulary too large for the MMVoc format: %lu bytes of words",
+            (unsigned long)strings_size);
+
+   // Hash and displace: place the buckets from the largest to the smallest,
+   // finding for each one the first displacement that sends all its words to
+   // distinct free slots.  If some bucket can't be placed, which only happens
+   // with a bad seed, start over with another one.
+   vector<uint32_t> displacements;
+   vector<uint32_t> slots;
+   uint32_t seed = 0;
+   for (;; ++seed) {
+      if (seed == 100)
+         error(ETFatal, "Could not build a perfect hash for the vocabulary: "
+               "does it contain duplicate words?");
+      vector<uint64_t> hashes(n);
+      vector<vector<uint32_t> > buckets(num_buckets);
+      for (uint32_t i = 0; i < n; ++i) {
+         hashes[i] = hash(voc.word(i), seed);
+         buckets[hashes[i] % num_buckets].push_back(i);
+      }
+      vector<pair<Uint,uint32_t> > order(num_buckets);
+      for (uint32_t b = 0; b < num_buckets; ++b)
+         order[b] = make_pair(Uint(buckets[b].size()), b);
+      sort(order.rbegin(), order.rend());
+
+      displacements.assign(num_buckets, 0);
+      slots.assign(num_slots, NO_WORD);
+      vector<uint32_t> bucket_slots;
+      const uint32_t max_d = 1u << 20;
+      bool ok = true;
+      for (uint32_t o = 0; ok && o < num_buckets && order[o].first > 0; ++o) {
+         const vector<uint32_t>& bucket = buckets[order[o].second];
+         uint32_t d = 0;
+         for (; d < max_d; ++d) {
+            bucket_slots.clear();
+            for (Uint k = 0; k < bucket.size(); ++k) {
+               const uint32_t s = slot(hashes[bucket[k]], d, num_slots);
+               if (slots[s] != NO_WORD ||
+                   find(bucket_slots.begin(), bucket_slots.end(), s) != bucket_slots.end())
+                  break;
+               bucket_slots.push_back(s);
+            }
+            if (bucket_slots.size() == bucket.size())
+               break;
+         }
+         if (d == max_d) {
+            ok = false;
+         } else {
+            displacements[order[o].second] = d;
+            for (Uint k = 0; k < bucket.size(); ++k)
+               slots[bucket_slots[k]] = bucket[k];
+         }
+      }
+      if (ok) break;
+   }
+
+   os << version << '\n';
+   for (Uint pad = strlen(version) + 1; pad < headerOffset(); ++pad)
+      os << '\0';
+   const uint32_t header[6] = { n, num_buckets, num_slots, seed, uint32_t(strings_size), 0 };
+   os.write(reinterpret_cast<const char*>(header), sizeof(header));
+   os.write(reinterpret_cast<const char*>(&displacements[0]),
+            num_buckets * sizeof(uint32_t));
+   os.write(reinterpret_cast<const char*>(&slots[0]), num_slots * sizeof(uint32_t));
+   if (n > 0)
+      os.write(reinterpret_cast<const char*>(&offsets[0]), n * sizeof(uint32_t));
+   for (uint32_t i = 0; i < n; ++i)
+      os.write(voc.word(i), strlen(voc.word(i)) + 1);
+   if (!os)
+      error(ETFatal, "Error writing MMVoc file");
+}
@@ -0,0 +1,136 @@
+/**
+ * @file mm_voc.h
+ * @brief An immutable, memory mapped vocabulary with a perfect hash index.
+ *
+ * An MMVoc file holds a fixed list of words and a minimal-probe perfect hash
+ * over them (hash and displace: each word's bucket stores the displacement
+ * that sends all the bucket's words to distinct slots), so index() costs one
+ * hash of the word and one string comparison.  The file is used in place
+ * through a read-only memory map, so several processes using the same file
+ * share a single copy of it in memory, and threads can query it without any
+ * locking.
+ *
+ * Build MMVoc files with voc2mmvoc, and see Voc::mapFile() to use one as the
+ * fixed base of a vocabulary that can still grow.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#ifndef __MM_VOC_H__
+#define __MM_VOC_H__
+
+#include "portage_defs.h"
+#include <boost/scoped_ptr.hpp>
+#include <cstring>
+#include <iostream>
+#include <stdint.h>
+
+namespace boost { namespace iostreams { class mapped_file_source; } }
+
+namespace Portage {
+
+class Voc;
+
+/// Immutable memory mapped vocabulary: maps words <-> [0,size()).
+class MMVoc : private NonCopyable {
+public:
+   /// Magic first line of MMVoc files.
+   static const char* const version;
+
+   /**
+    * Map an MMVoc file in memory.  Dies with an error message if filename is
+    * not a valid MMVoc file.
+    * @param filename  MMVoc file, as built by voc2mmvoc
+    */
+   explicit MMVoc(const string& filename);
+
+   /// Destructor unmaps the file.
+   ~MMVoc();
+
+   /**
+    * Check whether a file is an MMVoc file, by looking at its first line.
+    * @param filename  file to check
+    * @return true iff filename exists and starts with the MMVoc magic line
+    */
+   static bool isMMVoc(const string& filename);
+
+   /// Returns the number of words.
+   Uint size() const { return num_words; }
+
+   /**
+    * Get the word associated with an index in [0,size()-1].
+    * @param index  index of the required word
+    * @return the word, which remains valid as long as this MMVoc exists
+    */
+   const char* word(Uint index) const {
+      assert(index < num_words);
+      return strings + offsets[index];
+   }
+
+   /**
+    * Get the index of a word.
+    * @param word  word to look up
+    * @return index of word, or size() if not there
+    */
+   Uint index(const char* word) const {
+      const uint64_t h = hash(word, seed);
+      const uint32_t d = displacements[h % num_buckets];
+      const uint32_t i = slots[slot(h, d, num_slots)];
+      return (i < num_words && strcmp(strings + offsets[i], word) == 0)
+         ? i : num_words;
+   }
+
+   /**
+    * Write voc in MMVoc format; the words keep their index from voc.
+    * @param voc  vocabulary to write
+    * @param os   binary stream to write to: must not be compressed if the
+    *             result is to be mapped
+    */
+   static void write(const Voc& voc, ostream& os);
+
+private:
+   /// Slot value for an empty slot.
+   static const uint32_t NO_WORD = 0xFFFFFFFFu;
+
+   boost::scoped_ptr<boost::iostreams::mapped_file_source> file;  ///< the mapped file
+   uint32_t num_words;               ///< number of words
+   uint32_t num_buckets;             ///< number of hash buckets
+   uint32_t num_slots;               ///< number of slots, >= num_words
+   uint32_t seed;                    ///< hash seed that yielded a perfect hash
+   const uint32_t* displacements;    ///< displacement for each bucket
+   const uint32_t* slots;            ///< word index in each slot, or NO_WORD
+   const uint32_t* offsets;          ///< offset of each word in strings
+   const char* strings;              ///< NUL-terminated words
+
+   /// Seeded 64-bit FNV-1a hash of word, with a final avalanche so that all
+   /// its bits can be used.
+   static uint64_t hash(const char* word, uint32_t seed) {
+      uint64_t h = 14695981039346656037ULL ^ seed;
+      for (const unsigned char* p = (const unsigned char*)word; *p; ++p) {
+         h ^= *p;
+         h *= 1099511628211ULL;
+      }
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      return h;
+   }
+
+   /// Slot of a word with hash h in bucket with displacement d.
+   static uint32_t slot(uint64_t h, uint32_t d, uint32_t num_slots) {
+      const uint32_t h1 = uint32_t(h >> 32);
+      const uint32_t h2 = uint32_t(h * 0xc4ceb9fe1a85ec53ULL >> 32) | 1;
+      return uint32_t((h1 + uint64_t(d) * h2) % num_slots);
+   }
+
+   /// Size of the magic line, padded so the tables are aligned.
+   static Uint headerOffset();
+}; // class MMVoc
+
+} // Portage
+
+#endif // __MM_VOC_H__
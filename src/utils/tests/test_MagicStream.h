@@ -264,6 +264,119 @@ public:
 #endif
    }
 
+   // zstd files need either in-process zstd support or the zstd program.
+   static bool haveZstd() {
+#ifdef MAGIC_STREAM_ZSTD
+      return true;
+#else
+      return system("which zstd > /dev/null 2>&1") == 0;
+#endif
+   }
+
+   // Testing xz and zstd Files
+   void writeAndReadBack(const string& filename, const string& msg, unsigned n) {
+      {
+         oMagicStream os(filename);
+         TS_ASSERT(os);
+         TS_ASSERT(os << msg << endl);
+         TS_ASSERT_THROWS_NOTHING(printMatrice(os, msg, n, 5u));
+      }
+      iMagicStream is(filename);
+      TS_ASSERT(is);
+      TS_ASSERT(getline(is, m_read_msg));
+      TS_ASSERT_EQUALS(m_read_msg, msg);
+      TS_ASSERT_THROWS_NOTHING(checkMatrice(is, msg, n, 5u));
+      TS_ASSERT(!(is >> m_read_msg));
+      TS_ASSERT(!is.bad());
+   }
+   void testXzFile() {
+#ifdef USE_LZMA
+      writeAndReadBack(base_name_test + "Xz.xz", "Testing_xz_file_MagicStream", 3u);
+      // Large enough to exercise buffer refills, with several threads.
+      const char* omp_num_threads = getenv("OMP_NUM_THREADS");
+      const string saved(omp_num_threads ? omp_num_threads : "");
+      setenv("OMP_NUM_THREADS", "4", 1);
+      writeAndReadBack(base_name_test + "XzLarge.xz", "Testing_large_xz_file", 50000u);
+      if (omp_num_threads)
+         setenv("OMP_NUM_THREADS", saved.c_str(), 1);
+      else
+         unsetenv("OMP_NUM_THREADS");
+#endif
+   }
+   void testZstdFile() {
+      if (!haveZstd()) {
+         TS_WARN("zstd is not available, skipping the zstd file test");
+         return;
+      }
+      writeAndReadBack(base_name_test + "Zstd.zst", "Testing_zstd_file_MagicStream", 3u);
+      writeAndReadBack(base_name_test + "ZstdLarge.zst", "Testing_large_zstd_file", 50000u);
+   }
+   void testLargeBzip2File() {
+      writeAndReadBack(base_name_test + "Bzip2Large.bz2", "Testing_large_bzip2_file", 50000u);
+   }
+
+   // In-process and external (de)compression must be interchangeable.
+   void testExternalPipes() {
+      vector<string> filenames;
+      filenames.push_back(base_name_test + "Pipes.gz");
+      filenames.push_back(base_name_test + "Pipes.bz2");
+#ifdef USE_LZMA
+      filenames.push_back(base_name_test + "Pipes.lzma");
+      if (system("which xz > /dev/null 2>&1") == 0)
+         filenames.push_back(base_name_test + "Pipes.xz");
+#endif
+      if (system("which zstd > /dev/null 2>&1") == 0)
+         filenames.push_back(base_name_test + "Pipes.zst");
+      const string msg("Testing_external_pipes");
+      for (Uint i = 0; i < filenames.size(); ++i) {
+         for (Uint write_with_pipes = 0; write_with_pipes < 2; ++write_with_pipes) {
+            {
+               setenv("PORTAGE_MAGICSTREAM_PIPES", write_with_pipes ? "1" : "0", 1);
+               oMagicStream os(filenames[i]);
+               TS_ASSERT(os << msg << endl);
+            }
+            setenv("PORTAGE_MAGICSTREAM_PIPES", write_with_pipes ? "0" : "1", 1);
+            iMagicStream is(filenames[i]);
+            TS_ASSERT(getline(is, m_read_msg));
+            TS_ASSERT_EQUALS(m_read_msg, msg);
+         }
+      }
+      unsetenv("PORTAGE_MAGICSTREAM_PIPES");
+   }
+
+   // Empty compressed files must still be valid compressed files.
+   void testWriteEmptyCompressedFiles() {
+      vector<string> filenames;
+      filenames.push_back(base_name_test + "Empty.bz2");
+      if (haveZstd())
+         filenames.push_back(base_name_test + "Empty.zst");
+#ifdef USE_LZMA
+      filenames.push_back(base_name_test + "Empty.lzma");
+      filenames.push_back(base_name_test + "Empty.xz");
+#endif
+      for (Uint i = 0; i < filenames.size(); ++i) {
+         {
+            oMagicStream os(filenames[i]);
+         }
+         struct stat filestatus;
+         TS_ASSERT_EQUALS(stat(filenames[i].c_str(), &filestatus), 0);
+         TS_ASSERT_LESS_THAN(0, filestatus.st_size);
+         iMagicStream is(filenames[i]);
+         TS_ASSERT(!getline(is, m_read_msg));
+         TS_ASSERT(!is.bad());
+      }
+   }
+
+   // A truncated compressed file must be reported as an error.
+   void testTruncatedFile() {
+      const string filename(base_name_test + "Truncated.bz2");
+      writeAndReadBack(filename, "Testing_truncated_file", 5000u);
+      TS_ASSERT(truncate(filename.c_str(), 1000) == 0);
+      iMagicStream is(filename);
+      while (getline(is, m_read_msg)) {}
+      TS_ASSERT(is.bad());
+   }
+
    // Testing failing to open files for various external reasons
    void testOpenFails() {
       iMagicStream is;
@@ -285,9 +398,9 @@ public:
       TS_ASSERT(!os);
       os.close();
       os.open("/not-allowed-to-write-here.bz2");
-      // Just like we can't detect pipe failures until close(), we can't detect
-      // failing to write to .bz2 until close()
-      //TS_ASSERT(!os);
+      // .bz2 files are now written in-process, so failures are detected
+      // right away, as for .gz files.
+      TS_ASSERT(!os);
       os.close();
 
       using namespace Portage::Error_ns;
@@ -297,8 +410,8 @@ public:
       iSafeMagicStream is4("no-such-file.bz2");
       oSafeMagicStream os2("/not-allowed-to-write-here");
       oSafeMagicStream os3("/not-allowed-to-write-here.gz");
-      TS_ASSERT_EQUALS(ErrorCounts::Total, 5u);
-      oSafeMagicStream os4("/not-allowed-to-write-here.bz2"); // does not fail
+      oSafeMagicStream os4("/not-allowed-to-write-here.bz2");
+      TS_ASSERT_EQUALS(ErrorCounts::Total, 6u);
    }
 
    // Testing File Descriptor
@@ -522,6 +635,13 @@ public:
       TS_ASSERT(MagicStreamBase::isLzma("file.lzma"));
       TS_ASSERT(!MagicStreamBase::isLzma("file.LZMA"));
       TS_ASSERT(!MagicStreamBase::isLzma("file.lzma.txt"));
+      TS_ASSERT(MagicStreamBase::isXz("file.xz"));
+      TS_ASSERT(!MagicStreamBase::isXz("file.xz.txt"));
+   }
+   void testExtensionDetectionZstd() {
+      TS_ASSERT(MagicStreamBase::isZstd("file.zst"));
+      TS_ASSERT(MagicStreamBase::isZstd("file.zstd"));
+      TS_ASSERT(!MagicStreamBase::isZstd("file.zst.txt"));
    }
 
    // Test if a file exists
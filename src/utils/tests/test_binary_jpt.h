@@ -0,0 +1,115 @@
+/**
+ * @file test_binary_jpt.h  Test suite for binary_jpt.{h,cc}
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "binary_jpt.h"
+#include "file_utils.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestBinaryJPT : public CxxTest::TestSuite
+{
+   string tmpfile;
+   vector<string> lines;
+
+public:
+   void setUp() {
+      char tmpfilename[] = "/tmp/testBinaryJPT.XXXXXX";
+      int fd = mkstemp(tmpfilename);
+      FOR_ASSERT(fd);
+      assert(fd != -1);
+      close(fd);
+      tmpfile = tmpfilename;
+
+      lines.clear();
+      lines.push_back("a b ||| x ||| 3 a=0_1");
+      lines.push_back("a ||| x y ||| 1 0.25 a=0_0:2;0_1:1");
+      lines.push_back("a ||| x y ||| 2 0.5");
+      lines.push_back("b ||| y ||| 1e+20 0.123456789");
+   }
+   void tearDown() {
+      unlink(tmpfile.c_str());
+   }
+
+   void testRoundTrip() {
+      TS_ASSERT(!isBinaryJPT(tmpfile));
+      {
+         BinaryJPTWriter writer(tmpfile, 16); // tiny blocks, to use several
+         BinaryJPTEntry e;
+         for (Uint i = 0; i < lines.size(); ++i)
+            TS_ASSERT(writer.writeLine(lines[i], e));
+         TS_ASSERT(!writer.writeLine("no separators 1", e));
+         TS_ASSERT_EQUALS(writer.numEntries(), 4u);
+      }
+      TS_ASSERT(isBinaryJPT(tmpfile));
+
+      BinaryJPTReader reader(tmpfile);
+      TS_ASSERT(reader.next());
+      const BinaryJPTEntry& e = reader.entry();
+      TS_ASSERT_EQUALS(e.phrase1.size(), 2u);
+      TS_ASSERT_EQUALS(e.values.size(), 1u);
+      TS_ASSERT_EQUALS(e.values[0], 3.0);
+      TS_ASSERT_EQUALS(e.extras.size(), 1u);
+      TS_ASSERT_EQUALS(string(reader.getVoc().word(e.extras[0])), "a=0_1");
+
+      istream* in = openJPTAsText(tmpfile);
+      string line;
+      for (Uint i = 0; i < lines.size(); ++i) {
+         TS_ASSERT(getline(*in, line));
+         TS_ASSERT_EQUALS(line, lines[i]);
+      }
+      TS_ASSERT(!getline(*in, line));
+      delete in;
+   }
+
+   void testValueFormat() {
+      string s;
+      appendJPTValue(s, 42);
+      s += ' ';
+      appendJPTValue(s, 0.1);
+      s += ' ';
+      appendJPTValue(s, -3);
+      TS_ASSERT_EQUALS(s, "42 0.1 -3");
+
+      // Values must survive the trip through text exactly.
+      const double values[] = { 1.0/3, 0.123456789012345678, 2.5e-300, -7.1 };
+      for (Uint i = 0; i < ARRAY_SIZE(values); ++i) {
+         s.clear();
+         appendJPTValue(s, values[i]);
+         TS_ASSERT_EQUALS(strtod(s.c_str(), NULL), values[i]);
+      }
+      s.clear();
+      appendJPTValue(s, 1.0/3);
+      TS_ASSERT_EQUALS(s, "0.33333333333333331");
+   }
+
+   void testCompressedDetection() {
+      const string gzfile = tmpfile + ".gz";
+      {
+         BinaryJPTWriter writer(gzfile);
+         BinaryJPTEntry e;
+         for (Uint i = 0; i < lines.size(); ++i)
+            TS_ASSERT(writer.writeLine(lines[i], e));
+      }
+      TS_ASSERT(isBinaryJPT(gzfile));
+      istream* in = openJPTAsText(gzfile);
+      string line;
+      TS_ASSERT(getline(*in, line));
+      TS_ASSERT_EQUALS(line, lines[0]);
+      delete in;
+      unlink(gzfile.c_str());
+   }
+}; // TestBinaryJPT
+
+} // Portage
@@ -0,0 +1,92 @@
+/**
+ * @file test_em.h  Test suite for em.h
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "em.h"
+#include <cmath>
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestEM : public CxxTest::TestSuite
+{
+   // Fill m with n instances whose probabilities favour the first model.
+   void fill(EMMatrix& m, Uint n) {
+      m.add(n);
+      for (Uint i = 0; i < n; ++i) {
+         m.row(i)[0] = (i % 3 == 0) ? 0.0 : 0.5;
+         m.row(i)[1] = 0.1 + 0.01 * (i % 7);
+         m.row(i)[2] = (i % 5 == 0) ? 0.0 : 0.2;
+         if (i % 11 == 0) m.row(i)[1] = 0.0, m.row(i)[2] = 0.0;
+         if (i % 2) m.setFreq(i, 1 + i % 4);
+      }
+   }
+
+public:
+   void testEstimate() {
+      // Two equally probable instances, each of which only one model can
+      // explain: weights must be equal.
+      EM em(2);
+      vector<double> probs(2);
+      probs[0] = 1.0; probs[1] = 0.0;
+      em.count(probs);
+      probs[0] = 0.0; probs[1] = 0.5;
+      em.count(probs);
+      em.estimate();
+      TS_ASSERT_DELTA(em.getWeights()[0], 0.5, 1e-12);
+      TS_ASSERT_DELTA(em.getWeights()[1], 0.5, 1e-12);
+   }
+
+   void testCountAll() {
+      // countAll() on a matrix must match count() on each of its rows,
+      // including over several blocks and with zero-probability instances.
+      const Uint n = 10000;
+      EMMatrix m(3, true);
+      fill(m, n);
+      TS_ASSERT_EQUALS(m.numInstances(), n);
+      TS_ASSERT_EQUALS(m.freq(0), 1.0);
+      TS_ASSERT_EQUALS(m.freq(3), 4.0);
+
+      EM em1(3), em2(3);
+      vector<double> probs(3);
+      for (Uint iter = 0; iter < 5; ++iter) {
+         double lp1 = 0.0;
+         Uint zeros1 = 0;
+         for (Uint i = 0; i < n; ++i) {
+            probs.assign(m.row(i), m.row(i) + 3);
+            double freq = m.freq(i);
+            const double p = em1.count(probs, freq);
+            if (p) lp1 += freq * log(p); else ++zeros1;
+         }
+         Uint zeros2 = 0;
+         const double lp2 = em2.countAll(m, &zeros2);
+         TS_ASSERT_EQUALS(zeros1, zeros2);
+         TS_ASSERT_DELTA(lp1, lp2, 1e-8 * fabs(lp1));
+         em1.estimate();
+         em2.estimate();
+         for (Uint k = 0; k < 3; ++k)
+            TS_ASSERT_DELTA(em1.getWeights()[k], em2.getWeights()[k], 1e-12);
+      }
+      TS_ASSERT_LESS_THAN(em2.getWeights()[1], em2.getWeights()[0]);
+   }
+
+   void testUnitFreqs() {
+      EMMatrix m(2);
+      TS_ASSERT_EQUALS(m.add(3), 0u);
+      TS_ASSERT_EQUALS(m.add(), 3u);
+      TS_ASSERT_EQUALS(m.numInstances(), 4u);
+      TS_ASSERT_EQUALS(m.freq(2), 1.0);
+      m.clear();
+      TS_ASSERT_EQUALS(m.numInstances(), 0u);
+   }
+}; // TestEM
+
+} // Portage
@@ -0,0 +1,64 @@
+/**
+ * @file test_fisher_exact_test.h  Test suite for fisher_exact_test.{h,cc}
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "fisher_exact_test.h"
+#include <cmath>
+#include <sstream>
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestFisherExactTest : public CxxTest::TestSuite
+{
+public:
+   void testLnPValue() {
+      // 1-1-1: the only possible joint count
+      TS_ASSERT_DELTA(fetLnPValue(1, 1, 1, 100), -log(100.0), 1e-10);
+      // P(X=2) = C(2,2)C(2,0)/C(4,2) = 1/6; P(X>=1) = 1 - P(X=0) = 5/6
+      TS_ASSERT_DELTA(fetLnPValue(2, 2, 2, 4), -log(6.0), 1e-10);
+      TS_ASSERT_DELTA(fetLnPValue(1, 2, 2, 4), log(5.0/6.0), 1e-10);
+      TS_ASSERT_DELTA(fetLnHyper(1, 2, 2, 4), log(4.0/6.0), 1e-10);
+   }
+
+   void testSignificance() {
+      double s;
+      TS_ASSERT_EQUALS(fetSignificance(1, 1, 1, 8992, false, s), 2u);
+      TS_ASSERT_EQUALS(s, floor(-log(8992.0) * 1e8 + 0.5));
+      TS_ASSERT_EQUALS(fetSignificance(2, 50, 50, 8992, false, s), 1u);
+      TS_ASSERT_EQUALS(fetSignificance(2, 5, 15, 8992, false, s), 3u);
+      // anti-linked
+      TS_ASSERT_EQUALS(fetSignificance(0, 50, 50, 100, false, s), 0u);
+      TS_ASSERT_EQUALS(s, floor(-log(2.0) * 1e8 + 0.5));
+      TS_ASSERT_EQUALS(fetSignificance(0, 50, 50, 100, true, s), 0u);
+      TS_ASSERT_DELTA(s, 0.0, 1.0);
+
+      TS_ASSERT(fetLegalTable(1, 2, 3, 4));
+      TS_ASSERT(!fetLegalTable(3, 2, 3, 4));
+      TS_ASSERT(!fetLegalTable(1, 2, 5, 4));
+   }
+
+   void testSortKey() {
+      // Lexicographic order of keys follows numerical order
+      const double v[] = { -1e12, -800547828, -4096, -64, -63, -1, 0, 1, 63, 64, 1e12 };
+      for (Uint i = 1; i < sizeof(v)/sizeof(v[0]); ++i)
+         TS_ASSERT_LESS_THAN(fetSortKey(v[i-1]), fetSortKey(v[i]));
+   }
+
+   void testWriteFields() {
+      ostringstream os;
+      fetWriteFields(os, -800547828, 1);
+      os << 0.123456789;
+      TS_ASSERT_EQUALS(os.str(), "J@B9`;\t-8.00547828\t1\t0.123457");
+   }
+}; // TestFisherExactTest
+
+} // Portage
@@ -0,0 +1,91 @@
+/**
+ * @file test_levenshtein.h  Test suite for Levenshtein and BitParallelLevenshtein
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "portage_defs.h"
+#include "levenshtein.h"
+#include "str_utils.h"
+#include <cstdlib>
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestLevenshtein : public CxxTest::TestSuite
+{
+   /// Random sequence of length len over an alphabet of size voc.
+   static vector<Uint> randSeq(Uint len, Uint voc) {
+      vector<Uint> s(len);
+      for (Uint i = 0; i < len; ++i)
+         s[i] = rand() % voc;
+      return s;
+   }
+
+   /// Make seq a perturbed copy of orig.
+   static vector<Uint> perturb(const vector<Uint>& orig, Uint voc) {
+      vector<Uint> s;
+      for (Uint i = 0; i < orig.size(); ++i) {
+         const Uint r = rand() % 10;
+         if (r == 0) continue;                    // delete
+         s.push_back(r == 1 ? rand() % voc : orig[i]);  // substitute
+         if (r == 2) s.push_back(rand() % voc);   // insert
+      }
+      return s;
+   }
+
+public:
+   void setUp() { srand(42); }
+
+   void testSmall() {
+      Levenshtein<string> lev;
+      vector<string> a, b;
+      TS_ASSERT_EQUALS(lev.LevenDist(a, b), 0);
+      split("the cat sat on the mat", a);
+      TS_ASSERT_EQUALS(lev.LevenDist(a, b), 6);
+      TS_ASSERT_EQUALS(lev.LevenDist(b, a), 6);
+      split("a cat sat on the mat .", b);
+      TS_ASSERT_EQUALS(lev.LevenDist(a, b), 2);
+      TS_ASSERT_EQUALS(lev.getLevenDist(), 2);
+      TS_ASSERT_EQUALS(lev.LevenDist(a, b, 1), 1);
+      b.assign(a.begin() + 2, a.end() - 1);
+      TS_ASSERT_EQUALS(lev.LevenDist(b, a, 2), 0);
+   }
+
+   void testAgainstDP() {
+      Levenshtein<Uint> lev;
+      const Uint lengths[] = { 0, 1, 5, 30, 63, 64, 65, 127, 128, 129, 200 };
+      for (Uint li = 0; li < ARRAY_SIZE(lengths); ++li) {
+         for (Uint trial = 0; trial < 20; ++trial) {
+            const Uint voc = trial % 2 ? 5 : 1000;
+            const vector<Uint> ref = randSeq(lengths[li], voc);
+            const vector<Uint> hyp = trial % 3 ? perturb(ref, voc) : randSeq(rand() % 150, voc);
+            const vector<int> unit_ins(hyp.size(), 1), unit_del(ref.size(), 1);
+            for (int incomplete = 0; incomplete < 3; ++incomplete) {
+               // Non-NULL costs force the dynamic programming.
+               const int dp = lev.LevenDist(hyp, ref, incomplete, &unit_ins, &unit_del);
+               TS_ASSERT_EQUALS(lev.LevenDist(hyp, ref, incomplete), dp);
+               if (incomplete == 0) {
+                  lev.LevenAlig(hyp, ref);
+                  TS_ASSERT_EQUALS(lev.getLevenDist(), dp);
+               }
+
+               boost::dynamic_bitset<> pos_dp, pos_bp;
+               const int min_dp = lev.LevenDistIncompleteRef(hyp, ref, incomplete,
+                                                             &pos_dp, &unit_ins, &unit_del);
+               const int min_bp = lev.LevenDistIncompleteRef(hyp, ref, incomplete, &pos_bp);
+               TS_ASSERT_EQUALS(min_bp, min_dp);
+               TS_ASSERT_EQUALS(pos_bp, pos_dp);
+            }
+         }
+      }
+   }
+}; // TestLevenshtein
+
+} // Portage
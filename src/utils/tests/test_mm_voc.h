@@ -0,0 +1,111 @@
+/**
+ * @file test_mm_voc.h  Test suite for MMVoc and memory mapped Vocs
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include <cxxtest/TestSuite.h>
+#include "voc.h"
+#include "mm_voc.h"
+#include <fstream>
+#include <cstdio>
+
+using namespace Portage;
+
+namespace Portage {
+
+class TestMMVoc : public CxxTest::TestSuite
+{
+   string filename;
+   Voc voc;
+
+public:
+   void setUp() {
+      filename = "test_mm_voc.tmp.mmvoc";
+      voc.clear();
+      char buf[32];
+      for (Uint i = 0; i < 5000; ++i) {
+         sprintf(buf, "w%u", i * 7919);
+         voc.add(buf);
+      }
+      voc.add("");
+      voc.add("été");
+      ofstream os(filename.c_str(), ios::out | ios::binary);
+      MMVoc::write(voc, os);
+   }
+   void tearDown() { remove(filename.c_str()); }
+
+   void testLookup() {
+      TS_ASSERT(MMVoc::isMMVoc(filename));
+      MMVoc mm(filename);
+      TS_ASSERT_EQUALS(mm.size(), voc.size());
+      for (Uint i = 0; i < voc.size(); ++i) {
+         TS_ASSERT_EQUALS(string(mm.word(i)), string(voc.word(i)));
+         TS_ASSERT_EQUALS(mm.index(voc.word(i)), i);
+      }
+      TS_ASSERT_EQUALS(mm.index("w1"), mm.size());
+      TS_ASSERT_EQUALS(mm.index("nope"), mm.size());
+   }
+
+   void testEmpty() {
+      Voc empty;
+      {
+         ofstream os(filename.c_str(), ios::out | ios::binary);
+         MMVoc::write(empty, os);
+      }
+      MMVoc mm(filename);
+      TS_ASSERT_EQUALS(mm.size(), 0u);
+      TS_ASSERT_EQUALS(mm.index("w0"), 0u);
+   }
+
+   void testMappedVoc() {
+      Voc v;
+      v.add("gone");
+      v.mapFile(filename);
+      TS_ASSERT_EQUALS(v.size(), voc.size());
+      TS_ASSERT_EQUALS(v.mappedSize(), voc.size());
+      TS_ASSERT_EQUALS(v.index("gone"), v.size());
+      TS_ASSERT_EQUALS(v.index("w7919"), 1u);
+
+      // Additions go into the overlay, after the mapped words.
+      const Uint n = voc.size();
+      TS_ASSERT_EQUALS(v.add("w7919"), 1u);
+      TS_ASSERT_EQUALS(v.add("new"), n);
+      TS_ASSERT_EQUALS(v.add("newer"), n+1);
+      TS_ASSERT_EQUALS(v.add("new"), n);
+      TS_ASSERT_EQUALS(v.size(), n+2);
+      TS_ASSERT_EQUALS(v.index("newer"), n+1);
+      TS_ASSERT_EQUALS(string(v.word(n+1)), "newer");
+      TS_ASSERT_EQUALS(string(v.word(2)), "w15838");
+
+      // Only overlay words can be remapped.
+      TS_ASSERT(!v.remap(0u, "zero"));
+      TS_ASSERT(v.remap(n, "NEW"));
+      TS_ASSERT_EQUALS(string(v.word(n)), "NEW");
+
+      // Copies share the mapped words and copy the overlay.
+      Voc v2(v);
+      TS_ASSERT_EQUALS(v2.size(), n+2);
+      TS_ASSERT_EQUALS(v.word(3), v2.word(3));
+      TS_ASSERT_DIFFERS(v.word(n+1), v2.word(n+1));
+      TS_ASSERT_EQUALS(v2.index("newer"), n+1);
+
+      ostringstream oss1, oss2;
+      v.write(oss1);
+      for (Uint i = 0; i < v.size(); ++i)
+         oss2 << v.word(i) << "\n";
+      TS_ASSERT_EQUALS(oss1.str(), oss2.str());
+
+      v.clear();
+      TS_ASSERT(v.empty());
+      TS_ASSERT_EQUALS(v.mappedSize(), 0u);
+      TS_ASSERT_EQUALS(v.add("w0"), 0u);
+      TS_ASSERT_EQUALS(v2.index("w0"), 0u);
+   }
+}; // TestMMVoc
+
+} // Portage
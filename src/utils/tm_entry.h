@@ -70,6 +70,30 @@ public:
    /// @param line  Next line in the input file to parse
    void newline(const string& line);
 
+   /**
+    * Count a line that the caller knows belongs to the same source phrase as
+    * the previous one, and wants to ignore, without parsing it.  All the
+    * accessors keep returning the previous line's values.
+    */
+   void skipline() {
+      if (++lineno % 1000000 == 0)
+         cerr << '.' << flush;
+   }
+
+   /**
+    * Check if line starts with the same source phrase as the last line
+    * parsed, without parsing it.  Always false for reversed tables and after
+    * an empty source phrase.
+    * @param line  Next line in the input file
+    */
+   bool sameSrc(const string& line) const {
+      if (reversed_table || !src || !*src) return false;
+      const size_t len = strlen(src);
+      return src == buffer &&
+             line.compare(0, len, src) == 0 &&
+             line.compare(len, sep_len, sep) == 0;
+   }
+
    // ===================== Destructive accessors ===================== 
    /**
     * Parse the third column into a vector of T, destroying the internal
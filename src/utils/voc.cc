@@ -27,7 +27,7 @@ void Voc::deleteWords()
       delete[] words[i];
 }
 
-Voc::Voc() {
+Voc::Voc() : mapped_size(0) {
 }
 
 Voc::~Voc() {
@@ -50,6 +50,8 @@ void Voc::write(const string& filename, const char* delim) const {
 }
 
 void Voc::write(ostream& os, const char* delim) const {
+   for (Uint i = 0; i < mapped_size; ++i)
+      os << mapped->word(i) << delim;
    ostream_iterator<const char *> outStr(os, delim);
    copy(words.begin(), words.end(), outStr);
 }
@@ -118,6 +120,10 @@ Uint Voc::add(const char* word) {
    // significantly.  But re-adding an existing word is much faster this way.
    // We often re-add the same words many times, so this implementation choice
    // makes the Voc class fastest overall.
+   if (mapped_size) {
+      const Uint i = mapped->index(word);
+      if (i < mapped_size) return i;
+   }
    MapIter p = map.find(word);
    if ( p == map.end() ) {
       const char* w = strdup_new(word);
@@ -146,23 +152,36 @@ void Voc::clear() {
    deleteWords();
    words.clear();
    map.clear();
+   mapped.reset();
+   mapped_size = 0;
+}
+
+void Voc::mapFile(const string& filename) {
+   clear();
+   mapped.reset(new MMVoc(filename));
+   mapped_size = mapped->size();
 }
 
 void Voc::swap(Voc& that) {
+   mapped.swap(that.mapped);
+   std::swap(mapped_size, that.mapped_size);
    words.swap(that.words);
    map.swap(that.map);
 }
 
-Voc::Voc(const Voc& that) {
+Voc::Voc(const Voc& that) : mapped_size(0) {
    *this = that;
 }
 
 Voc& Voc::operator=(const Voc& that) {
+   if (this == &that) return *this;
    clear();
+   mapped = that.mapped;
+   mapped_size = that.mapped_size;
    words.resize(that.words.size(), NULL);
    for ( Uint i(0); i < words.size(); ++i ) {
       words[i] = strdup_new(that.words[i]);
-      pair<MapIter,bool> res = map.insert(make_pair(words[i], i));
+      pair<MapIter,bool> res = map.insert(make_pair(words[i], mapped_size + i));
       FOR_ASSERT(res);
       assert(res.second);
    }
@@ -170,13 +189,13 @@ Voc& Voc::operator=(const Voc& that) {
 }
 
 bool Voc::remap(Uint index, const char* newToken) {
-   // Obviously an invalid index.
-   if (index >= words.size()) return false;
+   // Obviously an invalid index; memory mapped words can't be changed.
+   if (index >= size() || index < mapped_size) return false;
 
    // If this new token is already part of the vocabulary and hasn't been
    // itself remapped, refuse to do the remapping.
-   MapIter it = map.find(newToken);
-   if (it != map.end() && 0 == strcmp(words[it->second], newToken) )
+   const Uint new_index = this->index(newToken);
+   if (new_index < size() && 0 == strcmp(word(new_index), newToken) )
       return false;
 
    /*
@@ -197,17 +216,17 @@ bool Voc::remap(Uint index, const char* newToken) {
    // when converting to an index() and getting the new string when converting
    // back from an index.
    //delete [] words[index]; //memory leak: we still need the old string, for map, so we can't delete it now!
-   words[index] = strdup_new(newToken);
+   words[index - mapped_size] = strdup_new(newToken);
 
    return true;
 }
 
 bool Voc::remap(const char* oldToken, const char* newToken) {
    // This old token is not part of the vocabulary.
-   MapIter it = map.find(oldToken);
-   if (it == map.end()) return false;
+   const Uint old_index = index(oldToken);
+   if (old_index == size()) return false;
 
-   return remap(it->second, newToken);
+   return remap(old_index, newToken);
 }
 
 bool Voc::test() {
@@ -21,15 +21,28 @@
 
 #include "string_hash.h"
 #include "file_utils.h"
+#include "mm_voc.h"
+#include <boost/shared_ptr.hpp>
 #include <numeric> // for accumulate
 #include <algorithm> // for sort
 
 namespace Portage {
 
-/// Used to convert string tokens to integer value.
+/**
+ * Used to convert string tokens to integer value.
+ *
+ * A Voc can be based on a memory mapped MMVoc (see mapFile()): the mapped
+ * words keep their MMVoc indices, and words added afterwards go into an
+ * in-memory overlay, with indices starting at the MMVoc's size.
+ */
 class Voc : private NonCopyable {
 protected:
-   /// When you have the index and you want to convert it back to a word.
+   /// Memory mapped base vocabulary, if any, shared with copies of this Voc.
+   boost::shared_ptr<const MMVoc> mapped;
+   /// Number of words in mapped, i.e., index of the first overlay word.
+   Uint mapped_size;
+   /// When you have the index and you want to convert it back to a word;
+   /// words[i] is word(mapped_size+i).
    vector<const char*> words;
    /// When you have a word and you want to find its index.
    unordered_map<const char*, Uint, hash<const char*>, str_equal> map;
@@ -155,6 +168,10 @@ public:
     * @return index of word, or size() if not there
     */
    Uint index(const char* word) const {
+      if (mapped_size) {
+         const Uint i = mapped->index(word);
+         if (i < mapped_size) return i;
+      }
       ConstMapIter p = map.find(word);
       return p == map.end() ? size() : p->second;
    };
@@ -172,13 +189,26 @@ public:
     * @param index index of the required word
     * @return Returns the word associated with index
     */
-   const char* word(Uint index) const { return words[index]; }
+   const char* word(Uint index) const {
+      return index < mapped_size ? mapped->word(index) : words[index - mapped_size];
+   }
 
    /// Returns the vocabulary size.
-   Uint size() const { return words.size(); }
+   Uint size() const { return mapped_size + words.size(); }
 
    /// Returns whether the vocabulary is empty.
-   bool empty() const { return words.empty(); }
+   bool empty() const { return size() == 0; }
+
+   /**
+    * Use a memory mapped MMVoc file, as built by voc2mmvoc, as the base of
+    * this vocabulary: its words get its indices, and words added later go
+    * into an overlay.  Clears any preexisting contents.
+    * @param filename  MMVoc file
+    */
+   void mapFile(const string& filename);
+
+   /// Returns the number of words coming from a memory mapped MMVoc, if any.
+   Uint mappedSize() const { return mapped_size; }
 
    /// Clear the vocabulary.
    virtual void clear();
@@ -193,8 +223,8 @@ public:
     * index(oldToken) will continue to find index.
     * @param  index  index to remap.
     * @param  newToken new token for index.
-    * @return false if index is invalid or newToken already in voc and not
-    *         previously remapped.
+    * @return false if index is invalid or memory mapped, or newToken already
+    *         in voc and not previously remapped.
     */
    bool remap(Uint index, const char* newToken);
 
@@ -212,11 +242,12 @@ public:
    bool remap(const char* oldToken, const char* newToken);
 
    /// Copy constructor does a deep copy - expensive since it must reallocate
-   /// all the memory.
+   /// all the memory.  A memory mapped base is shared, not copied.
    Voc(const Voc& that);
 
    /// Assignment operator does a deep copy - expensive since it must
-   /// free all existing memory and reallocate all the memory for the result
+   /// free all existing memory and reallocate all the memory for the result.
+   /// A memory mapped base is shared, not copied.
    Voc& operator=(const Voc& that);
 
    /**
@@ -360,6 +391,7 @@ public:
     * external object is using the indices of this vocabulary.
     */
    void sortReverseFreq() {
+      assert(mapped_size == 0);
       assert(counts.size() == words.size());
       assert(counts.size() == size());
       // given new index i, ordering[i] has the old index for the same word
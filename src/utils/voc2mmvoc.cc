@@ -0,0 +1,111 @@
+/**
+ * @file voc2mmvoc.cc
+ * @brief Build a memory mapped perfect-hash vocabulary (MMVoc) file.
+ *
+ * Traitement multilingue de textes / Multilingual Text Processing
+ * Tech. de l'information et des communications / Information and Communications Tech.
+ * Conseil national de recherches Canada / National Research Council Canada
+ * Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+ * Copyright 2026, His Majesty the King in Right of Canada
+ */
+
+#include "voc.h"
+#include "mm_voc.h"
+#include "str_utils.h"
+#include "file_utils.h"
+#include "arg_reader.h"
+#include "printCopyright.h"
+#include "exception_dump.h"  // MAIN
+#include <fstream>
+
+using namespace Portage;
+using namespace std;
+
+static char help_message[] = "\n\
+voc2mmvoc [-v] [-tok] OUTFILE [INFILE1 [INFILE2 ...]]\n\
+\n\
+  Build the memory mapped vocabulary OUTFILE from the words listed one per\n\
+  line in INFILE1, INFILE2, etc. [-].  Words keep the order of their first\n\
+  occurrence, and duplicates are ignored.  An INFILE can also be an existing\n\
+  memory mapped vocabulary, whose words then keep their indices in OUTFILE if\n\
+  it is given first.\n\
+\n\
+  Memory mapped vocabularies are immutable and use a perfect hash, so they are\n\
+  ready to use as soon as they are mapped, and all the processes using the\n\
+  same file share a single copy of it in memory.  Build one offline with the\n\
+  target vocabularies of a model set and give it to canoe with -Voc-file.\n\
+\n\
+Options:\n\
+\n\
+  -v    Write progress reports to cerr.\n\
+  -tok  INFILEs contain tokenized text: add each whitespace-separated token\n\
+        instead of each line.\n\
+";
+
+static bool verbose = false;
+static bool tokenized = false;
+static string outfile;
+static vector<string> infiles;
+static void getArgs(int argc, const char* const argv[]);
+
+int MAIN(argc, argv)
+{
+   printCopyright(2026, "voc2mmvoc");
+   getArgs(argc, argv);
+
+   Voc voc;
+   for (Uint i = 0; i < infiles.size(); ++i) {
+      if (infiles[i] != "-" && MMVoc::isMMVoc(infiles[i])) {
+         MMVoc mmvoc(infiles[i]);
+         for (Uint w = 0; w < mmvoc.size(); ++w)
+            voc.add(mmvoc.word(w));
+      } else {
+         iSafeMagicStream is(infiles[i]);
+         string line;
+         vector<string> toks;
+         while (getline(is, line)) {
+            if (tokenized) {
+               toks.clear();
+               split(line, toks);
+               for (Uint t = 0; t < toks.size(); ++t)
+                  voc.add(toks[t].c_str());
+            } else if (!line.empty()) {
+               voc.add(line.c_str());
+            }
+         }
+      }
+      if (verbose)
+         cerr << "Read " << infiles[i] << ": " << voc.size() << " words" << endl;
+   }
+
+   ofstream os(outfile.c_str(), ios::out | ios::binary);
+   if (!os)
+      error(ETFatal, "Unable to open %s for writing", outfile.c_str());
+   MMVoc::write(voc, os);
+   os.close();
+   if (!os)
+      error(ETFatal, "Error writing %s", outfile.c_str());
+   if (verbose)
+      cerr << "Wrote " << voc.size() << " words to " << outfile << endl;
+
+   return 0;
+}
+END_MAIN
+
+// arg processing
+
+void getArgs(int argc, const char* const argv[])
+{
+   const char* switches[] = {"v", "tok"};
+   ArgReader arg_reader(ARRAY_SIZE(switches), switches, 1, -1, help_message);
+   arg_reader.read(argc-1, argv+1);
+
+   arg_reader.testAndSet("v", verbose);
+   arg_reader.testAndSet("tok", tokenized);
+   arg_reader.testAndSet(0, "outfile", outfile);
+   arg_reader.getVars(1, infiles);
+   if (infiles.empty())
+      infiles.push_back("-");
+   if (outfile == "-")
+      error(ETFatal, "OUTFILE must be a file, since it is meant to be memory mapped");
+}
@@ -0,0 +1,11 @@
+#!/bin/bash
+# run-test.sh - Run this test suite, with a non-zero exit status if it fails
+#
+# Traitement multilingue de textes / Multilingual Text Processing
+# Tech. de l'information et des communications / Information and Communications Tech.
+# Conseil national de recherches Canada / National Research Council Canada
+# Copyright 2026, Sa Majeste le Roi du Chef du Canada /
+# Copyright 2026, His Majesty the King in Right of Canada
+
+make clean
+make all